@@ -63,13 +63,29 @@ enum {
 	DEVICE_NEEDS_RESET = 64
 };
 
+// Feature bits that are handled by the transport (i.e., not device specific).
+enum {
+	VIRTIO_F_RING_EVENT_IDX = 29,
+	VIRTIO_F_VERSION_1 = 32,
+	VIRTIO_F_RING_PACKED = 34
+};
+
 enum {
 	// Bits of the spec::Descriptor::flags field.
 	VIRTQ_DESC_F_NEXT = 1, // descriptor is part of a chain
 	VIRTQ_DESC_F_WRITE = 2, // buffer is written by device
 
 	// Bits of the spec::UsedRing::flags field.
-	VIRTQ_USED_F_NO_NOTIFY = 1 // no need to notify the device
+	VIRTQ_USED_F_NO_NOTIFY = 1, // no need to notify the device
+
+	// Bits of the spec::PackedDescriptor::flags field (in addition to NEXT and WRITE).
+	VIRTQ_DESC_F_AVAIL = 1 << 7,
+	VIRTQ_DESC_F_USED = 1 << 15,
+
+	// Values of the spec::EventSuppression::flags field.
+	RING_EVENT_FLAGS_ENABLE = 0,
+	RING_EVENT_FLAGS_DISABLE = 1,
+	RING_EVENT_FLAGS_DESC = 2 // requires VIRTIO_F_RING_EVENT_IDX
 };
 
 namespace spec {
@@ -91,6 +107,7 @@ namespace spec {
 	};
 	static_assert(sizeof(AvailableRing) == 4);
 
+	// Contains used_event, i.e., the used index at which the driver wants an interrupt.
 	struct AvailableExtra {
 		static AvailableExtra *get(AvailableRing *ring, size_t queue_size) {
 			return reinterpret_cast<AvailableExtra *>(ring->elements + queue_size);
@@ -110,6 +127,7 @@ namespace spec {
 	};
 	static_assert(sizeof(UsedRing) == 4);
 
+	// Contains avail_event, i.e., the available index at which the device wants a notification.
 	struct UsedExtra {
 		static UsedExtra *get(UsedRing *ring, size_t queue_size) {
 			return reinterpret_cast<UsedExtra *>(ring->elements + queue_size);
@@ -117,6 +135,23 @@ namespace spec {
 
 		arch::scalar_variable<uint16_t> eventIndex;
 	};
+
+	// Descriptor of a packed virtq (VIRTIO_F_RING_PACKED).
+	struct PackedDescriptor {
+		arch::scalar_variable<uint64_t> address;
+		arch::scalar_variable<uint32_t> length;
+		arch::scalar_variable<uint16_t> id;
+		arch::scalar_variable<uint16_t> flags;
+	};
+	static_assert(sizeof(PackedDescriptor) == 16);
+
+	// Driver and device areas of a packed virtq.
+	struct EventSuppression {
+		// Bits 0-14: ring offset, bit 15: wrap counter.
+		arch::scalar_variable<uint16_t> offsetWrap;
+		arch::scalar_variable<uint16_t> flags;
+	};
+	static_assert(sizeof(EventSuppression) == 4);
 };
 
 struct DeviceSpace;
@@ -136,7 +171,8 @@ struct QueueInfo {
  * Usual initialization works as follows:
  * - Call discover() to obtain a transport.
  * - Negotiate features via Transport::checkDeviceFeature() / acknowledgeDriverFeature().
- * - Call Transport::finalizeFeatures().
+ * - Call Transport::finalizeFeatures(). This also negotiates transport features
+ *   such as VIRTIO_F_RING_EVENT_IDX.
  * - Call Transport::claimQueues().
  * - Call Transport::setupQueue() for each virtq.
  * - Call Transport::runDevice().
@@ -281,14 +317,24 @@ async::result<void> scatterGather(DeviceToHostType, Chain &chain, Queue *queue,
 
 struct Request {
 	void (*complete)(Request *);
+
+	// Number of bytes that the device wrote to the device-to-host buffers of the chain.
+	// Valid once complete() is called.
+	size_t written = 0;
 };
 
 // Represents a single virtq.
 struct Queue {
 	friend struct Handle;
 
+	// Constructs a split virtq.
 	Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *table,
-			spec::AvailableRing *available, spec::UsedRing *used);
+			spec::AvailableRing *available, spec::UsedRing *used, bool event_index);
+
+	// Constructs a packed virtq. Drivers see the same interface as for split virtqs.
+	Queue(unsigned int queue_index, size_t queue_size, spec::PackedDescriptor *ring,
+			spec::EventSuppression *driver_event, spec::EventSuppression *device_event,
+			bool event_index);
 protected:
 	~Queue() = default;
 
@@ -304,16 +350,21 @@ public:
 
 	// Allocates a single descriptor.
 	// The descriptor is automatically freed when the device returns it.
+	// If no descriptor is free, outstanding posts are flushed via notify() before waiting.
 	async::result<Handle> obtainDescriptor();
 
 	// Posts a descriptor to the virtq's available ring.
+	// This does not notify the device; callers can post a batch of descriptors
+	// and then call notify() once.
 	void postDescriptor(Handle descriptor, Request *request,
 			void (*complete)(Request *));
 
-	// Notifies the device that new descriptors have been posted.
+	// Notifies the device that new descriptors have been posted (if it asked for that).
 	void notify();
 
-	async::result<void> submitDescriptor(Handle descriptor) {
+	// Posts a descriptor, notifies the device and waits until the device returns it.
+	// Returns the number of bytes that the device wrote.
+	async::result<size_t> submitDescriptor(Handle descriptor) {
 		struct PromiseRequest : Request {
 			async::promise<void> promise;
 		} promise_req;
@@ -326,6 +377,7 @@ public:
 		notify();
 
 		co_await promise_req.promise.async_get();
+		co_return promise_req.written;
 	}
 
 	// Processes interrupts for this virtq.
@@ -336,6 +388,13 @@ protected:
 	virtual void notifyTransport() = 0;
 
 private:
+	void _postPacked(Handle handle);
+	void _notifyPacked();
+	void _processPacked();
+
+	// Returns a descriptor chain to _descriptorStack and completes its request.
+	void _retire(size_t table_index, size_t written);
+
 	// Index of this queue as part of its owning device.
 	unsigned int _queueIndex;
 
@@ -343,11 +402,13 @@ private:
 	size_t _queueSize;
 
 	// Pointers to different data structures of this virtq.
+	// For packed virtqs, _table points to _shadowTable (which is not visible to the device);
+	// descriptors are only copied to the ring by postDescriptor().
 	spec::Descriptor *_table;
-	spec::AvailableRing *_availableRing;
-	spec::UsedRing *_usedRing;
-	spec::AvailableExtra *_availableExtra;
-	spec::UsedExtra *_usedExtra;
+	spec::AvailableRing *_availableRing = nullptr;
+	spec::UsedRing *_usedRing = nullptr;
+	spec::AvailableExtra *_availableExtra = nullptr;
+	spec::UsedExtra *_usedExtra = nullptr;
 
 	// Keeps track of unused descriptor indices.
 	std::vector<uint16_t> _descriptorStack;
@@ -358,6 +419,27 @@ private:
 
 	// Keeps track of which entries in the used ring have already been processed.
 	uint16_t _progressHead;
+
+	// True if VIRTIO_F_RING_EVENT_IDX was negotiated.
+	bool _eventIndex;
+
+	// Value of the available ring's headIndex at the time of the last notify().
+	uint16_t _notifiedHead;
+
+	// State of packed virtqs.
+	bool _packed = false;
+	std::vector<spec::Descriptor> _shadowTable;
+	spec::PackedDescriptor *_packedRing = nullptr;
+	spec::EventSuppression *_driverEvent = nullptr;
+	spec::EventSuppression *_deviceEvent = nullptr;
+	uint16_t _nextAvail = 0;
+	bool _availWrap = true;
+	uint16_t _nextUsed = 0;
+	bool _usedWrap = true;
+	// Number of ring entries that were made available since the last notify().
+	uint16_t _postedSinceNotify = 0;
+	// Number of ring entries that each chain (indexed by its head) occupies.
+	std::vector<uint16_t> _chainLengths;
 };
 
 } // namespace virtio_core
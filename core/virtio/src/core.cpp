@@ -105,12 +105,15 @@ private:
 	helix::UniqueDescriptor _irq;
 
 	std::vector<std::unique_ptr<LegacyPciQueue>> _queues;
+
+	bool _eventIndex = false;
 };
 
 struct LegacyPciQueue final : Queue {
 	LegacyPciQueue(LegacyPciTransport *transport,
 			unsigned int queue_index, size_t queue_size,
-			spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used);
+			spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
+			bool event_index);
 
 protected:
 	void notifyTransport() override;
@@ -152,7 +155,10 @@ void LegacyPciTransport::acknowledgeDriverFeature(unsigned int feature) {
 }
 
 void LegacyPciTransport::finalizeFeatures() {
-	// Does nothing for now.
+	if(checkDeviceFeature(VIRTIO_F_RING_EVENT_IDX)) {
+		acknowledgeDriverFeature(VIRTIO_F_RING_EVENT_IDX);
+		_eventIndex = true;
+	}
 }
 
 void LegacyPciTransport::claimQueues(unsigned int max_index) {
@@ -197,7 +203,7 @@ Queue *LegacyPciTransport::setupQueue(unsigned int queue_index) {
 	auto available = reinterpret_cast<spec::AvailableRing *>((char *)window + available_offset);
 	auto used = reinterpret_cast<spec::UsedRing *>((char *)window + used_offset);
 	_queues[queue_index] = std::make_unique<LegacyPciQueue>(this, queue_index, queue_size,
-			table, available, used);
+			table, available, used, _eventIndex);
 
 	// Hand the queue to the device.
 	uintptr_t table_physical;
@@ -251,8 +257,10 @@ async::detached LegacyPciTransport::_processIrqs() {
 
 LegacyPciQueue::LegacyPciQueue(LegacyPciTransport *transport,
 		unsigned int queue_index, size_t queue_size,
-		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used)
-: Queue{queue_index, queue_size, table, available, used}, _transport{transport} { }
+		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
+		bool event_index)
+: Queue{queue_index, queue_size, table, available, used, event_index},
+		_transport{transport} { }
 
 void LegacyPciQueue::notifyTransport() {
 	_transport->_legacySpace.store(PCI_L_QUEUE_NOTIFY, queueIndex());
@@ -299,6 +307,9 @@ private:
 	arch::mem_space _isrSpace() { return arch::mem_space{_isrMapping.get()}; }
 	arch::mem_space _deviceSpace() { return arch::mem_space{_deviceMapping.get()}; }
 
+	Queue *_setupPackedQueue(unsigned int queue_index, size_t queue_size,
+			unsigned int notify_index);
+
 	async::detached _processIrqs();
 
 	protocols::hw::Device _hwDevice;
@@ -310,13 +321,22 @@ private:
 	helix::UniqueDescriptor _irq;
 
 	std::vector<std::unique_ptr<StandardPciQueue>> _queues;
+
+	bool _eventIndex = false;
+	bool _packed = false;
 };
 
 struct StandardPciQueue final : Queue {
 	StandardPciQueue(StandardPciTransport *transport,
 			unsigned int queue_index, size_t queue_size,
 			spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
-			arch::scalar_register<uint16_t> notify_register);
+			bool event_index, arch::scalar_register<uint16_t> notify_register);
+
+	StandardPciQueue(StandardPciTransport *transport,
+			unsigned int queue_index, size_t queue_size,
+			spec::PackedDescriptor *ring, spec::EventSuppression *driver_event,
+			spec::EventSuppression *device_event,
+			bool event_index, arch::scalar_register<uint16_t> notify_register);
 
 protected:
 	void notifyTransport() override;
@@ -360,8 +380,17 @@ void StandardPciTransport::acknowledgeDriverFeature(unsigned int feature) {
 }
 
 void StandardPciTransport::finalizeFeatures() {
-	assert(checkDeviceFeature(32));
-	acknowledgeDriverFeature(32);
+	assert(checkDeviceFeature(VIRTIO_F_VERSION_1));
+	acknowledgeDriverFeature(VIRTIO_F_VERSION_1);
+
+	if(checkDeviceFeature(VIRTIO_F_RING_EVENT_IDX)) {
+		acknowledgeDriverFeature(VIRTIO_F_RING_EVENT_IDX);
+		_eventIndex = true;
+	}
+	if(checkDeviceFeature(VIRTIO_F_RING_PACKED)) {
+		acknowledgeDriverFeature(VIRTIO_F_RING_PACKED);
+		_packed = true;
+	}
 
 	_commonSpace().store(PCI_DEVICE_STATUS, _commonSpace().load(PCI_DEVICE_STATUS) | FEATURES_OK);
 	auto confirm = _commonSpace().load(PCI_DEVICE_STATUS);
@@ -381,6 +410,9 @@ Queue *StandardPciTransport::setupQueue(unsigned int queue_index) {
 	auto notify_index = _commonSpace().load(PCI_QUEUE_NOTIFY);
 	assert(queue_size);
 
+	if(_packed)
+		return _setupPackedQueue(queue_index, queue_size, notify_index);
+
 	// TODO: Ensure that the queue size is indeed a power of 2.
 
 	// Determine the queue size in bytes.
@@ -411,7 +443,7 @@ Queue *StandardPciTransport::setupQueue(unsigned int queue_index) {
 	auto available = reinterpret_cast<spec::AvailableRing *>((char *)window + available_offset);
 	auto used = reinterpret_cast<spec::UsedRing *>((char *)window + used_offset);
 	_queues[queue_index] = std::make_unique<StandardPciQueue>(this, queue_index, queue_size,
-			table, available, used,
+			table, available, used, _eventIndex,
 			arch::scalar_register<uint16_t>{_notifyMultiplier * notify_index});
 
 	// Hand the queue to the device.
@@ -430,6 +462,48 @@ Queue *StandardPciTransport::setupQueue(unsigned int queue_index) {
 	return _queues[queue_index].get();
 }
 
+Queue *StandardPciTransport::_setupPackedQueue(unsigned int queue_index,
+		size_t queue_size, unsigned int notify_index) {
+	// Determine the queue size in bytes.
+	// The ring needs 16-byte alignment, the event suppression structures need 4-byte alignment.
+	auto driver_offset = queue_size * sizeof(spec::PackedDescriptor);
+	auto device_offset = driver_offset + sizeof(spec::EventSuppression);
+	auto region_size = device_offset + sizeof(spec::EventSuppression);
+
+	// Allocate physical memory for the virtq structs.
+	assert(region_size < 0x4000); // FIXME: do not hardcode 0x4000
+	HelHandle memory;
+	void *window;
+	HEL_CHECK(helAllocateMemory(0x4000, kHelAllocContinuous, nullptr, &memory));
+	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
+			0, 0x4000, kHelMapProtRead | kHelMapProtWrite, &window));
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, memory));
+
+	// Setup the memory region.
+	auto ring = reinterpret_cast<spec::PackedDescriptor *>((char *)window);
+	auto driver_event = reinterpret_cast<spec::EventSuppression *>((char *)window + driver_offset);
+	auto device_event = reinterpret_cast<spec::EventSuppression *>((char *)window + device_offset);
+	_queues[queue_index] = std::make_unique<StandardPciQueue>(this, queue_index, queue_size,
+			ring, driver_event, device_event, _eventIndex,
+			arch::scalar_register<uint16_t>{_notifyMultiplier * notify_index});
+
+	// Hand the queue to the device.
+	// The available and used registers hold the driver and device areas for packed virtqs.
+	uintptr_t ring_physical, driver_physical, device_physical;
+	HEL_CHECK(helPointerPhysical(ring, &ring_physical));
+	HEL_CHECK(helPointerPhysical(driver_event, &driver_physical));
+	HEL_CHECK(helPointerPhysical(device_event, &device_physical));
+	_commonSpace().store(PCI_QUEUE_TABLE[0], ring_physical);
+	_commonSpace().store(PCI_QUEUE_TABLE[1], ring_physical >> 32);
+	_commonSpace().store(PCI_QUEUE_AVAILABLE[0], driver_physical);
+	_commonSpace().store(PCI_QUEUE_AVAILABLE[1], driver_physical >> 32);
+	_commonSpace().store(PCI_QUEUE_USED[0], device_physical);
+	_commonSpace().store(PCI_QUEUE_USED[1], device_physical >> 32);
+	_commonSpace().store(PCI_QUEUE_ENABLE, 1);
+
+	return _queues[queue_index].get();
+}
+
 void StandardPciTransport::runDevice() {
 	// Finally set the DRIVER_OK bit to finish the configuration.
 	_commonSpace().store(PCI_DEVICE_STATUS, _commonSpace().load(PCI_DEVICE_STATUS) | DRIVER_OK);
@@ -517,8 +591,16 @@ async::detached StandardPciTransport::_processIrqs() {
 StandardPciQueue::StandardPciQueue(StandardPciTransport *transport,
 		unsigned int queue_index, size_t queue_size,
 		spec::Descriptor *table, spec::AvailableRing *available, spec::UsedRing *used,
-		arch::scalar_register<uint16_t> notify_register)
-: Queue{queue_index, queue_size, table, available, used},
+		bool event_index, arch::scalar_register<uint16_t> notify_register)
+: Queue{queue_index, queue_size, table, available, used, event_index},
+		_transport{transport}, _notifyRegister{notify_register} { }
+
+StandardPciQueue::StandardPciQueue(StandardPciTransport *transport,
+		unsigned int queue_index, size_t queue_size,
+		spec::PackedDescriptor *ring, spec::EventSuppression *driver_event,
+		spec::EventSuppression *device_event,
+		bool event_index, arch::scalar_register<uint16_t> notify_register)
+: Queue{queue_index, queue_size, ring, driver_event, device_event, event_index},
 		_transport{transport}, _notifyRegister{notify_register} { }
 
 void StandardPciQueue::notifyTransport() {
@@ -687,8 +769,9 @@ async::result<void> scatterGather(DeviceToHostType, Chain &chain, Queue *queue,
 // --------------------------------------------------------
 
 Queue::Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *table,
-		spec::AvailableRing *available, spec::UsedRing *used)
-: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0} {
+		spec::AvailableRing *available, spec::UsedRing *used, bool event_index)
+: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0},
+		_eventIndex{event_index}, _notifiedHead{0} {
 	// Construct the hardware state.
 	_table = new (table) spec::Descriptor[_queueSize];
 	_availableRing = new (available) spec::AvailableRing;
@@ -717,9 +800,43 @@ Queue::Queue(unsigned int queue_index, size_t queue_size, spec::Descriptor *tabl
 	_activeRequests.resize(_queueSize);
 }
 
+Queue::Queue(unsigned int queue_index, size_t queue_size, spec::PackedDescriptor *ring,
+		spec::EventSuppression *driver_event, spec::EventSuppression *device_event,
+		bool event_index)
+: _queueIndex{queue_index}, _queueSize{queue_size}, _progressHead{0},
+		_eventIndex{event_index}, _notifiedHead{0}, _packed{true} {
+	// Construct the hardware state.
+	_packedRing = new (ring) spec::PackedDescriptor[_queueSize];
+	_driverEvent = new (driver_event) spec::EventSuppression;
+	_deviceEvent = new (device_event) spec::EventSuppression;
+
+	for(size_t i = 0; i < _queueSize; i++) {
+		_packedRing[i].address.store(0);
+		_packedRing[i].length.store(0);
+		_packedRing[i].id.store(0);
+		_packedRing[i].flags.store(0);
+	}
+
+	// With event indices, we request interrupts explicitly in processInterrupt().
+	_driverEvent->offsetWrap.store(1 << 15);
+	_driverEvent->flags.store(_eventIndex ? RING_EVENT_FLAGS_DESC : RING_EVENT_FLAGS_ENABLE);
+	_deviceEvent->offsetWrap.store(0);
+	_deviceEvent->flags.store(RING_EVENT_FLAGS_ENABLE);
+
+	// Construct the software state.
+	_shadowTable.resize(_queueSize);
+	_table = _shadowTable.data();
+	for(size_t i = 0; i < _queueSize; i++)
+		_descriptorStack.push_back(i);
+	_activeRequests.resize(_queueSize);
+	_chainLengths.resize(_queueSize);
+}
+
 async::result<Handle> Queue::obtainDescriptor() {
 	while(true) {
 		if(_descriptorStack.empty()) {
+			// The device can only return descriptors that it knows about.
+			notify();
 			co_await _descriptorDoorbell.async_wait();
 			continue;
 		}
@@ -744,6 +861,11 @@ void Queue::postDescriptor(Handle handle, Request *request,
 	assert(!_activeRequests[handle.tableIndex()]);
 	_activeRequests[handle.tableIndex()] = request;
 
+	if(_packed) {
+		_postPacked(handle);
+		return;
+	}
+
 	auto enqueue_head = _availableRing->headIndex.load();
 	auto ring_index = enqueue_head & (_queueSize - 1);
 	_availableRing->elements[ring_index].tableIndex.store(handle.tableIndex());
@@ -753,44 +875,188 @@ void Queue::postDescriptor(Handle handle, Request *request,
 }
 
 void Queue::notify() {
-	asm volatile ( "" : : : "memory" );
-	if(!(_usedRing->flags.load() & VIRTQ_USED_F_NO_NOTIFY))
-		notifyTransport();
+	if(_packed) {
+		_notifyPacked();
+		return;
+	}
+
+	auto head = _availableRing->headIndex.load();
+	auto previous = _notifiedHead;
+	if(head == previous)
+		return;
+	_notifiedHead = head;
+
+	// The device may read avail_event (or flags) concurrently to our update of headIndex.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	if(_eventIndex) {
+		// Notify iff avail_event lies within the range of descriptors posted since
+		// the last notification (see vring_need_event() in the virtio specification).
+		uint16_t event = _usedExtra->eventIndex.load();
+		if(static_cast<uint16_t>(head - event - 1) < static_cast<uint16_t>(head - previous))
+			notifyTransport();
+	}else{
+		if(!(_usedRing->flags.load() & VIRTQ_USED_F_NO_NOTIFY))
+			notifyTransport();
+	}
 }
 
 void Queue::processInterrupt() {
+	if(_packed) {
+		_processPacked();
+		return;
+	}
+
 	while(true) {
 		auto used_head = _usedRing->headIndex.load();
 
-		if((_progressHead & 0xFFFF) == used_head)
-			break;
+		if((_progressHead & 0xFFFF) == used_head) {
+			if(!_eventIndex)
+				break;
+
+			// Ask for an interrupt once the next element is used. As the device
+			// might have used more elements in the meantime, we have to check again.
+			_availableExtra->eventIndex.store(_progressHead);
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			if(_usedRing->headIndex.load() == _progressHead)
+				break;
+			continue;
+		}
 
 		asm volatile ( "" : : : "memory" );
 
 		auto ring_index = _progressHead & (_queueSize - 1);
 		auto table_index = _usedRing->elements[ring_index].tableIndex.load();
+		auto written = _usedRing->elements[ring_index].written.load();
 		assert(table_index < _queueSize);
 
-		// Dequeue the Request object.
-		auto request = _activeRequests[table_index];
-		assert(request);
-		_activeRequests[table_index] = nullptr;
-
-		// Free all descriptors in the descriptor chain.
-		auto chain_index = table_index;
-		while(_table[chain_index].flags.load() & VIRTQ_DESC_F_NEXT) {
-			auto successor = _table[chain_index].next.load();
-			_descriptorStack.push_back(chain_index);
-			chain_index = successor;
+		_progressHead++;
+		_retire(table_index, written);
+	}
+}
+
+void Queue::_postPacked(Handle handle) {
+	// Copy the chain from the shadow table to the ring.
+	auto head_position = _nextAvail;
+	uint16_t head_flags = 0;
+	uint16_t length = 0;
+	auto table_index = handle.tableIndex();
+	while(true) {
+		auto shadow = _table + table_index;
+		auto shadow_flags = shadow->flags.load();
+
+		uint16_t flags = shadow_flags & (VIRTQ_DESC_F_NEXT | VIRTQ_DESC_F_WRITE);
+		flags |= _availWrap ? VIRTQ_DESC_F_AVAIL : VIRTQ_DESC_F_USED;
+
+		auto descriptor = _packedRing + _nextAvail;
+		descriptor->address.store(shadow->address.load());
+		descriptor->length.store(shadow->length.load());
+		descriptor->id.store(handle.tableIndex());
+		if(!length) {
+			head_flags = flags;
+		}else{
+			descriptor->flags.store(flags);
 		}
-		_descriptorStack.push_back(chain_index);
-		_descriptorDoorbell.ring();
+		length++;
 
-		// Call the completion handler.
-		request->complete(request);
+		if(++_nextAvail == _queueSize) {
+			_nextAvail = 0;
+			_availWrap = !_availWrap;
+		}
 
-		_progressHead++;
+		if(!(shadow_flags & VIRTQ_DESC_F_NEXT))
+			break;
+		table_index = shadow->next.load();
+	}
+	_chainLengths[handle.tableIndex()] = length;
+
+	// The chain becomes visible to the device once the head's flags are written.
+	asm volatile ( "" : : : "memory" );
+	_packedRing[head_position].flags.store(head_flags);
+	_postedSinceNotify += length;
+}
+
+void Queue::_notifyPacked() {
+	if(!_postedSinceNotify)
+		return;
+	auto added = _postedSinceNotify;
+	_postedSinceNotify = 0;
+
+	// The device may read its event suppression area concurrently to our update of the ring.
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	auto flags = _deviceEvent->flags.load();
+	if(flags == RING_EVENT_FLAGS_DESC) {
+		// Same as for split virtqs but offsets are relative to the current wrap.
+		auto offset_wrap = _deviceEvent->offsetWrap.load();
+		uint16_t event = offset_wrap & 0x7FFF;
+		if(static_cast<bool>(offset_wrap >> 15) != _availWrap)
+			event -= _queueSize;
+		uint16_t head = _nextAvail;
+		if(static_cast<uint16_t>(head - event - 1) < added)
+			notifyTransport();
+	}else if(flags != RING_EVENT_FLAGS_DISABLE) {
+		notifyTransport();
+	}
+}
+
+void Queue::_processPacked() {
+	auto isUsed = [&] {
+		auto flags = _packedRing[_nextUsed].flags.load();
+		bool avail = flags & VIRTQ_DESC_F_AVAIL;
+		bool used = flags & VIRTQ_DESC_F_USED;
+		return avail == used && used == _usedWrap;
+	};
+
+	while(true) {
+		if(!isUsed()) {
+			if(!_eventIndex)
+				break;
+
+			// See processInterrupt() for split virtqs.
+			_driverEvent->offsetWrap.store(_nextUsed | (_usedWrap << 15));
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			if(!isUsed())
+				break;
+			continue;
+		}
+
+		asm volatile ( "" : : : "memory" );
+
+		auto table_index = _packedRing[_nextUsed].id.load();
+		auto written = _packedRing[_nextUsed].length.load();
+		assert(table_index < _queueSize);
+
+		// The device writes a single element for the whole chain.
+		_nextUsed += _chainLengths[table_index];
+		if(_nextUsed >= _queueSize) {
+			_nextUsed -= _queueSize;
+			_usedWrap = !_usedWrap;
+		}
+
+		_retire(table_index, written);
+	}
+}
+
+void Queue::_retire(size_t table_index, size_t written) {
+	// Dequeue the Request object.
+	auto request = _activeRequests[table_index];
+	assert(request);
+	_activeRequests[table_index] = nullptr;
+
+	// Free all descriptors in the descriptor chain.
+	auto chain_index = table_index;
+	while(_table[chain_index].flags.load() & VIRTQ_DESC_F_NEXT) {
+		auto successor = _table[chain_index].next.load();
+		_descriptorStack.push_back(chain_index);
+		chain_index = successor;
 	}
+	_descriptorStack.push_back(chain_index);
+	_descriptorDoorbell.ring();
+
+	// Call the completion handler.
+	request->written = written;
+	request->complete(request);
 }
 
 } // namespace virtio_core
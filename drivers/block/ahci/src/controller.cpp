@@ -0,0 +1,494 @@
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include <hel.h>
+#include <hel-syscalls.h>
+
+#include "controller.hpp"
+
+namespace block {
+namespace ahci {
+
+namespace {
+	constexpr bool logCommands = false;
+
+	constexpr size_t pageSize = 0x1000;
+	constexpr size_t sectorSize = 512;
+
+	// Limit the size of commands such that the PRDs always suffice,
+	// even if no two pages of the buffer are physically contiguous.
+	constexpr size_t maxSectorsPerCommand = (prdsPerCommand - 1) * (pageSize / sectorSize);
+
+	// Polls a condition every millisecond. Returns false on timeout.
+	template<typename F>
+	async::result<bool> pollUntil(F condition, uint64_t timeout) {
+		uint64_t start;
+		HEL_CHECK(helGetClock(&start));
+		while(!condition()) {
+			uint64_t tick;
+			HEL_CHECK(helGetClock(&tick));
+			if(tick - start > timeout)
+				co_return false;
+
+			helix::AwaitClock await_clock;
+			auto &&submit = helix::submitAwaitClock(&await_clock, tick + 1'000'000,
+					helix::Dispatcher::global());
+			co_await submit.async_wait();
+			HEL_CHECK(await_clock.error());
+		}
+		co_return true;
+	}
+
+	uintptr_t physicalPointer(void *ptr) {
+		uintptr_t physical;
+		HEL_CHECK(helPointerPhysical(ptr, &physical));
+		return physical;
+	}
+}
+
+// --------------------------------------------------------
+// Port
+// --------------------------------------------------------
+
+Port::Port(Controller *controller, int number, arch::mem_space space)
+: blockfs::BlockDevice{sectorSize}, _controller{controller}, _number{number},
+		_space{space}, _commandList{controller->memoryPool()},
+		_receivedFis{controller->memoryPool()} {
+	for(size_t i = 0; i < controller->numSlots(); i++)
+		_commandTables.emplace_back(controller->memoryPool());
+}
+
+async::result<void> Port::setup() {
+	// The HBA must be idle before we can change the command list and FIS area.
+	auto cmd = _space.load(port_regs::cmd);
+	if(cmd & (kPortCmdStart | kPortCmdListRunning)) {
+		_space.store(port_regs::cmd, cmd & ~kPortCmdStart);
+		if(!(co_await pollUntil([&] {
+			return !(_space.load(port_regs::cmd) & kPortCmdListRunning);
+		}, 500'000'000)))
+			std::cout << "block-ahci: Port " << _number
+					<< " does not stop command processing" << std::endl;
+	}
+	cmd = _space.load(port_regs::cmd);
+	if(cmd & (kPortCmdFisReceiveEnable | kPortCmdFisReceiveRunning)) {
+		_space.store(port_regs::cmd, cmd & ~kPortCmdFisReceiveEnable);
+		if(!(co_await pollUntil([&] {
+			return !(_space.load(port_regs::cmd) & kPortCmdFisReceiveRunning);
+		}, 500'000'000)))
+			std::cout << "block-ahci: Port " << _number
+					<< " does not stop FIS reception" << std::endl;
+	}
+
+	memset(_commandList.data(), 0, sizeof(CommandList));
+	memset(_receivedFis.data(), 0, sizeof(ReceivedFis));
+	for(size_t i = 0; i < _commandTables.size(); i++) {
+		auto table_physical = physicalPointer(_commandTables[i].data());
+		_commandList->slots[i].tableBase = table_physical;
+		_commandList->slots[i].tableBaseHigh = table_physical >> 32;
+	}
+
+	auto list_physical = physicalPointer(_commandList.data());
+	auto fis_physical = physicalPointer(_receivedFis.data());
+	_space.store(port_regs::clb, list_physical);
+	_space.store(port_regs::clbu, list_physical >> 32);
+	_space.store(port_regs::fb, fis_physical);
+	_space.store(port_regs::fbu, fis_physical >> 32);
+
+	cmd = _space.load(port_regs::cmd) | kPortCmdFisReceiveEnable | kPortCmdPowerOn;
+	if(_controller->supportsStaggeredSpinUp())
+		cmd |= kPortCmdSpinUp;
+	_space.store(port_regs::cmd, cmd);
+
+	// Clear all errors and pending IRQs.
+	_space.store(port_regs::serr, 0xFFFFFFFF);
+	_space.store(port_regs::is, 0xFFFFFFFF);
+	_space.store(port_regs::ie, kPortIrqD2hRegister | kPortIrqPioSetup | kPortIrqDmaSetup
+			| kPortIrqSetDeviceBits | kPortIrqDescriptorProcessed | kPortIrqErrors);
+}
+
+async::result<bool> Port::init() {
+	// Give the PHY some time to establish communication.
+	if(!(co_await pollUntil([&] {
+		return (_space.load(port_regs::ssts) & kPortSstsDetMask) == kPortSstsDetPresent;
+	}, 10'000'000)))
+		co_return false;
+
+	if(!(co_await pollUntil([&] {
+		return !(_space.load(port_regs::tfd) & (kPortTfdBsy | kPortTfdDrq));
+	}, 1'000'000'000))) {
+		std::cout << "block-ahci: Device on port " << _number << " stays busy" << std::endl;
+		co_return false;
+	}
+
+	auto signature = _space.load(port_regs::sig);
+	if(signature != sataSignature) {
+		std::cout << "block-ahci: Ignoring device with signature 0x" << std::hex << signature
+				<< std::dec << " on port " << _number << std::endl;
+		co_return false;
+	}
+
+	_space.store(port_regs::cmd, _space.load(port_regs::cmd) | kPortCmdStart);
+
+	co_return co_await _identify();
+}
+
+async::result<bool> Port::_identify() {
+	arch::dma_buffer buffer{_controller->memoryPool(), 512};
+
+	FisRegH2D fis{};
+	fis.command = kCommandIdentify;
+	if(!(co_await _submit(fis, false, false, buffer.data(), buffer.size()))) {
+		std::cout << "block-ahci: IDENTIFY failed on port " << _number << std::endl;
+		co_return false;
+	}
+
+	auto words = reinterpret_cast<uint16_t *>(buffer.data());
+
+	// The model name is stored as big endian 16-bit words.
+	char model[41];
+	for(int i = 0; i < 20; i++) {
+		model[2 * i] = words[27 + i] >> 8;
+		model[2 * i + 1] = words[27 + i] & 0xFF;
+	}
+	model[40] = 0;
+
+	if(!(words[83] & (1 << 10))) {
+		std::cout << "block-ahci: Ignoring '" << model << "' on port " << _number
+				<< ": no support for 48-bit LBA" << std::endl;
+		co_return false;
+	}
+
+	// Word 106 is only valid if bits 15:14 are 01. If bit 12 is set, the logical
+	// sector size is not 512 bytes but given (in words) by words 117-118.
+	// Devices with 4 KiB physical but 512 byte logical sectors are fine.
+	if((words[106] & 0xC000) == 0x4000 && (words[106] & (1 << 12))) {
+		auto logical_size = 2 * (static_cast<uint32_t>(words[117])
+				| (static_cast<uint32_t>(words[118]) << 16));
+		if(logical_size != sectorSize) {
+			std::cout << "block-ahci: Ignoring '" << model << "' on port " << _number
+					<< ": unsupported logical sector size " << logical_size << std::endl;
+			co_return false;
+		}
+	}
+	_numSectors = static_cast<uint64_t>(words[100])
+			| (static_cast<uint64_t>(words[101]) << 16)
+			| (static_cast<uint64_t>(words[102]) << 32)
+			| (static_cast<uint64_t>(words[103]) << 48);
+
+	// NCQ lets the device reorder up to 32 commands. Without it, DMA commands
+	// cannot overlap and we only use the first slot.
+	size_t depth = 1;
+	if(_controller->supportsNcq() && (words[76] & (1 << 8))) {
+		_useNcq = true;
+		depth = std::min(_controller->numSlots(), size_t{(words[75] & 0x1Fu) + 1});
+	}
+	_freeSlots = (depth == maxSlots) ? 0xFFFFFFFF : ((uint32_t{1} << depth) - 1);
+
+	std::cout << "block-ahci: Port " << _number << ": '" << model << "', "
+			<< _numSectors << " sectors, "
+			<< (_useNcq ? "NCQ" : "no NCQ") << ", queue depth " << depth << std::endl;
+	co_return true;
+}
+
+async::result<bool> Port::readSectors(uint64_t sector,
+		void *buffer, size_t num_sectors) {
+	return _transfer(false, sector, buffer, num_sectors);
+}
+
+async::result<bool> Port::writeSectors(uint64_t sector,
+		const void *buffer, size_t num_sectors) {
+	return _transfer(true, sector, const_cast<void *>(buffer), num_sectors);
+}
+
+async::result<bool> Port::_transfer(bool write, uint64_t sector,
+		void *buffer, size_t num_sectors) {
+	assert(sector + num_sectors <= _numSectors);
+
+	for(size_t progress = 0; progress < num_sectors; ) {
+		auto count = std::min(num_sectors - progress, maxSectorsPerCommand);
+		auto lba = sector + progress;
+
+		FisRegH2D fis{};
+		if(_useNcq) {
+			fis.command = write ? kCommandWriteFpdmaQueued : kCommandReadFpdmaQueued;
+			// FPDMA commands store the sector count in the feature field.
+			fis.featureLow = count & 0xFF;
+			fis.featureHigh = (count >> 8) & 0xFF;
+		}else{
+			fis.command = write ? kCommandWriteDmaExt : kCommandReadDmaExt;
+			fis.countLow = count & 0xFF;
+			fis.countHigh = (count >> 8) & 0xFF;
+		}
+		fis.device = kDeviceLba;
+		fis.lba0 = lba & 0xFF;
+		fis.lba1 = (lba >> 8) & 0xFF;
+		fis.lba2 = (lba >> 16) & 0xFF;
+		fis.lba3 = (lba >> 24) & 0xFF;
+		fis.lba4 = (lba >> 32) & 0xFF;
+		fis.lba5 = (lba >> 40) & 0xFF;
+
+		if(!(co_await _submit(fis, _useNcq, write,
+				reinterpret_cast<char *>(buffer) + progress * sectorSize, count * sectorSize)))
+			co_return false;
+		progress += count;
+	}
+	co_return true;
+}
+
+async::result<bool> Port::_submit(FisRegH2D fis, bool queued, bool write,
+		void *buffer, size_t size) {
+	while(!_freeSlots)
+		co_await _freeDoorbell.async_wait();
+	auto slot = __builtin_ctz(_freeSlots);
+	_freeSlots &= ~(uint32_t{1} << slot);
+
+	auto table = _commandTables[slot].data();
+	memset(table, 0, offsetof(CommandTable, prds));
+	fis.type = kFisTypeRegH2D;
+	fis.flags = kFisCommand;
+	if(queued)
+		fis.countLow = slot << 3;
+	memcpy(table->commandFis, &fis, sizeof(FisRegH2D));
+
+	auto header = &_commandList->slots[slot];
+	header->flags = (sizeof(FisRegH2D) / 4) | (write ? kHeaderWrite : 0);
+	header->prdtLength = _setupPrds(table, buffer, size);
+	header->prdByteCount = 0;
+
+	if(logCommands)
+		std::cout << "block-ahci: Issuing command 0x" << std::hex << int{fis.command}
+				<< std::dec << " in slot " << slot << " with "
+				<< header->prdtLength << " PRDs" << std::endl;
+
+	async::promise<bool> promise;
+	_completions[slot] = &promise;
+	_issuedSlots |= uint32_t{1} << slot;
+	if(queued)
+		_space.store(port_regs::sact, uint32_t{1} << slot);
+	_space.store(port_regs::ci, uint32_t{1} << slot);
+
+	auto success = co_await promise.async_get();
+
+	_freeSlots |= uint32_t{1} << slot;
+	_freeDoorbell.ring();
+	co_return success;
+}
+
+size_t Port::_setupPrds(CommandTable *table, void *buffer, size_t size) {
+	// PRDs can only describe word-aligned buffers.
+	assert(!(reinterpret_cast<uintptr_t>(buffer) & 1));
+	assert(!(size & 1));
+
+	size_t n = 0;
+	size_t progress = 0;
+	while(progress < size) {
+		auto ptr = reinterpret_cast<uintptr_t>(buffer) + progress;
+		auto chunk = std::min(size - progress, pageSize - (ptr & (pageSize - 1)));
+		auto physical = physicalPointer(reinterpret_cast<void *>(ptr));
+		assert(_controller->supports64Bit() || !(physical >> 32));
+
+		// Merge physically contiguous pages into a single entry.
+		if(n) {
+			auto &last = table->prds[n - 1];
+			auto last_size = (last.byteCount & (maxPrdBytes - 1)) + 1;
+			auto last_end = ((static_cast<uint64_t>(last.dataBaseHigh) << 32)
+					| last.dataBase) + last_size;
+			if(last_end == physical && last_size + chunk <= maxPrdBytes) {
+				last.byteCount += chunk;
+				progress += chunk;
+				continue;
+			}
+		}
+
+		assert(n < prdsPerCommand);
+		auto &prd = table->prds[n++];
+		prd.dataBase = physical;
+		prd.dataBaseHigh = physical >> 32;
+		prd.reserved = 0;
+		prd.byteCount = chunk - 1;
+		progress += chunk;
+	}
+
+	return n;
+}
+
+async::result<void> Port::handleIrq() {
+	auto status = _space.load(port_regs::is);
+	_space.store(port_regs::is, status);
+
+	// Queued commands complete once their PxSACT bit is cleared,
+	// non-queued commands once their PxCI bit is cleared.
+	auto outstanding = _space.load(port_regs::sact) | _space.load(port_regs::ci);
+	auto completed = _issuedSlots & ~outstanding;
+	uint32_t failed = 0;
+	if(status & kPortIrqErrors) {
+		std::cout << "\e[31m" "block-ahci: Error on port " << _number
+				<< ", PxIS: 0x" << std::hex << status
+				<< ", PxTFD: 0x" << _space.load(port_regs::tfd)
+				<< ", PxSERR: 0x" << _space.load(port_regs::serr)
+				<< std::dec << "\e[39m" << std::endl;
+
+		// We cannot tell which of the outstanding commands caused the error,
+		// hence all of them fail. Keep new commands from being issued until
+		// the port runs again.
+		failed = _issuedSlots & outstanding;
+		auto free_slots = std::exchange(_freeSlots, 0);
+		co_await _recover();
+		_freeSlots |= free_slots;
+		_freeDoorbell.ring();
+	}
+	_issuedSlots &= ~(completed | failed);
+
+	auto complete = [&] (uint32_t slots, bool success) {
+		while(slots) {
+			auto slot = __builtin_ctz(slots);
+			slots &= slots - 1;
+			auto promise = std::exchange(_completions[slot], nullptr);
+			assert(promise);
+			promise->set_value(success);
+		}
+	};
+	complete(completed, true);
+	complete(failed, false);
+}
+
+async::result<void> Port::_recover() {
+	// Clearing PxCMD.ST also clears PxCI and PxSACT.
+	_space.store(port_regs::cmd, _space.load(port_regs::cmd) & ~kPortCmdStart);
+	if(!(co_await pollUntil([&] {
+		return !(_space.load(port_regs::cmd) & kPortCmdListRunning);
+	}, 500'000'000)))
+		std::cout << "block-ahci: Port " << _number
+				<< " does not stop command processing" << std::endl;
+
+	// If the device did not finish the failed command, only a COMRESET gets it
+	// back into a usable state.
+	if(_space.load(port_regs::tfd) & (kPortTfdBsy | kPortTfdDrq)) {
+		std::cout << "block-ahci: Resetting device on port " << _number << std::endl;
+		auto sctl = _space.load(port_regs::sctl) & ~kPortSctlDetMask;
+		_space.store(port_regs::sctl, sctl | kPortSctlDetInit);
+		// DET must stay set for at least 1 ms.
+		co_await pollUntil([] { return false; }, 1'000'000);
+		_space.store(port_regs::sctl, sctl);
+		if(!(co_await pollUntil([&] {
+			return (_space.load(port_regs::ssts) & kPortSstsDetMask) == kPortSstsDetPresent
+					&& !(_space.load(port_regs::tfd) & (kPortTfdBsy | kPortTfdDrq));
+		}, 1'000'000'000)))
+			std::cout << "\e[31m" "block-ahci: Device on port " << _number
+					<< " does not recover from reset" "\e[39m" << std::endl;
+	}
+
+	_space.store(port_regs::serr, 0xFFFFFFFF);
+	_space.store(port_regs::is, 0xFFFFFFFF);
+	_space.store(port_regs::cmd, _space.load(port_regs::cmd) | kPortCmdStart);
+}
+
+// --------------------------------------------------------
+// Controller
+// --------------------------------------------------------
+
+Controller::Controller(protocols::hw::Device hw_device, helix::Mapping mapping,
+		helix::UniqueDescriptor mmio, helix::UniqueDescriptor irq)
+: _hwDevice{std::move(hw_device)}, _mapping{std::move(mapping)},
+		_mmio{std::move(mmio)}, _irq{std::move(irq)},
+		_space{_mapping.get()} { }
+
+async::detached Controller::run() {
+	co_await _hwDevice.enableBusmaster();
+
+	if(!(co_await _reset()))
+		co_return;
+
+	auto cap = _space.load(regs::cap);
+	_numSlots = ((cap >> kCapNumSlotsShift) & kCapNumSlotsMask) + 1;
+	auto version = _space.load(regs::vs);
+	std::cout << "block-ahci: AHCI " << (version >> 16) << "." << ((version >> 8) & 0xFF)
+			<< ", " << _numSlots << " command slots"
+			<< (supportsNcq() ? ", NCQ" : "")
+			<< (supports64Bit() ? ", 64-bit DMA" : "") << std::endl;
+
+	auto implemented = _space.load(regs::pi);
+	for(int i = 0; i < 32; i++) {
+		if(!(implemented & (uint32_t{1} << i)))
+			continue;
+		_ports[i] = std::make_unique<Port>(this, i,
+				_space.subspace(portRegsOffset + i * portRegsSize));
+		co_await _ports[i]->setup();
+	}
+
+	// TODO: Use MSI once the kernel supports it.
+	_space.store(regs::is, 0xFFFFFFFF);
+	_space.store(regs::ghc, kGhcAhciEnable | kGhcInterruptEnable);
+	co_await _hwDevice.enableBusIrq();
+	_handleIrqs();
+
+	bool have_device = false;
+	for(auto &port : _ports) {
+		if(!port || !(co_await port->init()))
+			continue;
+
+		// TODO: libblockfs only supports a single device.
+		if(have_device)
+			continue;
+		blockfs::runDevice(port.get());
+		have_device = true;
+	}
+}
+
+async::result<bool> Controller::_reset() {
+	// Request ownership of the HBA from the firmware.
+	if(_space.load(regs::cap2) & kCap2BiosHandoff) {
+		_space.store(regs::bohc, _space.load(regs::bohc) | kBohcOsOwned);
+		if(!(co_await pollUntil([&] {
+			auto bohc = _space.load(regs::bohc);
+			return !(bohc & kBohcBiosOwned) && !(bohc & kBohcBiosBusy);
+		}, 2'000'000'000)))
+			std::cout << "block-ahci: Firmware does not release the HBA" << std::endl;
+	}
+
+	_space.store(regs::ghc, kGhcAhciEnable);
+	_space.store(regs::ghc, kGhcAhciEnable | kGhcReset);
+	if(!(co_await pollUntil([&] {
+		return !(_space.load(regs::ghc) & kGhcReset);
+	}, 1'000'000'000))) {
+		std::cout << "\e[31m" "block-ahci: HBA reset timed out" "\e[39m" << std::endl;
+		co_return false;
+	}
+
+	// The reset clears GHC.AE.
+	_space.store(regs::ghc, kGhcAhciEnable);
+	co_return true;
+}
+
+async::detached Controller::_handleIrqs() {
+	uint64_t sequence = 0;
+	while(true) {
+		helix::AwaitEvent await;
+		auto &&submit = helix::submitAwaitEvent(_irq, &await, sequence,
+				helix::Dispatcher::global());
+		co_await submit.async_wait();
+		HEL_CHECK(await.error());
+		sequence = await.sequence();
+
+		auto pending = _space.load(regs::is);
+		if(!pending) {
+			HEL_CHECK(helAcknowledgeIrq(_irq.getHandle(), kHelAckNack, sequence));
+			continue;
+		}
+
+		// PxIS needs to be cleared before IS.
+		for(int i = 0; i < 32; i++) {
+			if((pending & (uint32_t{1} << i)) && _ports[i])
+				co_await _ports[i]->handleIrq();
+		}
+		_space.store(regs::is, pending);
+		HEL_CHECK(helAcknowledgeIrq(_irq.getHandle(), kHelAckAcknowledge, sequence));
+	}
+}
+
+} } // namespace block::ahci
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <arch/dma_pool.hpp>
+#include <arch/dma_structs.hpp>
+#include <arch/mem_space.hpp>
+#include <async/doorbell.hpp>
+#include <async/result.hpp>
+#include <blockfs.hpp>
+#include <helix/ipc.hpp>
+#include <helix/memory.hpp>
+#include <protocols/hw/client.hpp>
+
+#include "spec.hpp"
+
+namespace block {
+namespace ahci {
+
+struct Controller;
+
+// --------------------------------------------------------
+// Port
+// --------------------------------------------------------
+
+// A SATA disk that is attached to a port of the HBA.
+struct Port : blockfs::BlockDevice {
+	Port(Controller *controller, int number, arch::mem_space space);
+
+	// Stops the port and hands the command list and FIS area to the HBA.
+	async::result<void> setup();
+
+	// Starts the port and identifies the device.
+	// Returns false if no supported device is attached.
+	async::result<bool> init();
+
+	// Called by the controller when the port raises an IRQ.
+	// If a command failed, this restarts the port before it returns.
+	async::result<void> handleIrq();
+
+	async::result<bool> readSectors(uint64_t sector,
+			void *buffer, size_t num_sectors) override;
+
+	async::result<bool> writeSectors(uint64_t sector,
+			const void *buffer, size_t num_sectors) override;
+
+private:
+	async::result<bool> _transfer(bool write, uint64_t sector,
+			void *buffer, size_t num_sectors);
+
+	// Returns false if the device cannot be used by this driver.
+	async::result<bool> _identify();
+
+	// Issues a command and waits until it completes. If the command is queued (NCQ),
+	// the slot number is stored as tag in the FIS. Returns false if the command failed.
+	async::result<bool> _submit(FisRegH2D fis, bool queued, bool write,
+			void *buffer, size_t size);
+
+	// Stops and restarts command processing after an error. All issued commands
+	// are aborted by this; if the device stays busy, it is reset.
+	async::result<void> _recover();
+
+	// Fills the PRD table of a command. Returns the number of entries.
+	size_t _setupPrds(CommandTable *table, void *buffer, size_t size);
+
+	Controller *_controller;
+	int _number;
+	arch::mem_space _space;
+
+	arch::dma_object<CommandList> _commandList;
+	arch::dma_object<ReceivedFis> _receivedFis;
+	std::vector<arch::dma_object<CommandTable>> _commandTables;
+
+	// Whether commands are issued using NCQ. Otherwise, only one command is in flight.
+	bool _useNcq = false;
+	uint64_t _numSectors = 0;
+
+	// Bitmasks of command slots that are free and that are owned by the HBA.
+	uint32_t _freeSlots = 1;
+	uint32_t _issuedSlots = 0;
+	async::doorbell _freeDoorbell;
+
+	// Completion of the commands that are currently issued.
+	// The value is false if the command failed.
+	std::array<async::promise<bool> *, maxSlots> _completions{};
+};
+
+// --------------------------------------------------------
+// Controller
+// --------------------------------------------------------
+
+struct Controller {
+	Controller(protocols::hw::Device hw_device, helix::Mapping mapping,
+			helix::UniqueDescriptor mmio, helix::UniqueDescriptor irq);
+
+	async::detached run();
+
+	arch::dma_pool *memoryPool() {
+		return &_memoryPool;
+	}
+
+	size_t numSlots() {
+		return _numSlots;
+	}
+
+	bool supportsNcq() {
+		return _space.load(regs::cap) & kCapNcq;
+	}
+
+	bool supports64Bit() {
+		return _space.load(regs::cap) & kCap64Bit;
+	}
+
+	bool supportsStaggeredSpinUp() {
+		return _space.load(regs::cap) & kCapStaggeredSpinUp;
+	}
+
+private:
+	async::result<bool> _reset();
+	async::detached _handleIrqs();
+
+	protocols::hw::Device _hwDevice;
+	helix::Mapping _mapping;
+	helix::UniqueDescriptor _mmio;
+	helix::UniqueDescriptor _irq;
+	arch::mem_space _space;
+
+	arch::os::contiguous_pool _memoryPool;
+
+	size_t _numSlots = 1;
+	std::array<std::unique_ptr<Port>, 32> _ports;
+};
+
+} } // namespace block::ahci
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/register.hpp>
+
+namespace block {
+namespace ahci {
+
+// --------------------------------------------------------
+// HBA registers
+// --------------------------------------------------------
+
+namespace regs {
+	inline constexpr arch::scalar_register<uint32_t> cap{0x00};
+	inline constexpr arch::scalar_register<uint32_t> ghc{0x04};
+	inline constexpr arch::scalar_register<uint32_t> is{0x08};
+	inline constexpr arch::scalar_register<uint32_t> pi{0x0C};
+	inline constexpr arch::scalar_register<uint32_t> vs{0x10};
+	inline constexpr arch::scalar_register<uint32_t> cap2{0x24};
+	inline constexpr arch::scalar_register<uint32_t> bohc{0x28};
+}
+
+// Offset and size of the per-port register sets.
+constexpr ptrdiff_t portRegsOffset = 0x100;
+constexpr ptrdiff_t portRegsSize = 0x80;
+
+namespace port_regs {
+	inline constexpr arch::scalar_register<uint32_t> clb{0x00};
+	inline constexpr arch::scalar_register<uint32_t> clbu{0x04};
+	inline constexpr arch::scalar_register<uint32_t> fb{0x08};
+	inline constexpr arch::scalar_register<uint32_t> fbu{0x0C};
+	inline constexpr arch::scalar_register<uint32_t> is{0x10};
+	inline constexpr arch::scalar_register<uint32_t> ie{0x14};
+	inline constexpr arch::scalar_register<uint32_t> cmd{0x18};
+	inline constexpr arch::scalar_register<uint32_t> tfd{0x20};
+	inline constexpr arch::scalar_register<uint32_t> sig{0x24};
+	inline constexpr arch::scalar_register<uint32_t> ssts{0x28};
+	inline constexpr arch::scalar_register<uint32_t> sctl{0x2C};
+	inline constexpr arch::scalar_register<uint32_t> serr{0x30};
+	inline constexpr arch::scalar_register<uint32_t> sact{0x34};
+	inline constexpr arch::scalar_register<uint32_t> ci{0x38};
+}
+
+enum {
+	// CAP
+	kCapNumSlotsShift = 8,
+	kCapNumSlotsMask = 0x1F,
+	kCapStaggeredSpinUp = 1u << 27,
+	kCapNcq = 1u << 30,
+	kCap64Bit = 1u << 31,
+
+	// CAP2
+	kCap2BiosHandoff = 1u << 0,
+
+	// GHC
+	kGhcReset = 1u << 0,
+	kGhcInterruptEnable = 1u << 1,
+	kGhcAhciEnable = 1u << 31,
+
+	// BOHC
+	kBohcBiosOwned = 1u << 0,
+	kBohcOsOwned = 1u << 1,
+	kBohcBiosBusy = 1u << 4,
+};
+
+enum {
+	// PxIS and PxIE
+	kPortIrqD2hRegister = 1u << 0,
+	kPortIrqPioSetup = 1u << 1,
+	kPortIrqDmaSetup = 1u << 2,
+	kPortIrqSetDeviceBits = 1u << 3,
+	kPortIrqDescriptorProcessed = 1u << 5,
+	kPortIrqInterfaceFatal = 1u << 27,
+	kPortIrqHostBusData = 1u << 28,
+	kPortIrqHostBusFatal = 1u << 29,
+	kPortIrqTaskFile = 1u << 30,
+
+	kPortIrqErrors = kPortIrqInterfaceFatal | kPortIrqHostBusData
+			| kPortIrqHostBusFatal | kPortIrqTaskFile,
+
+	// PxCMD
+	kPortCmdStart = 1u << 0,
+	kPortCmdSpinUp = 1u << 1,
+	kPortCmdPowerOn = 1u << 2,
+	kPortCmdFisReceiveEnable = 1u << 4,
+	kPortCmdFisReceiveRunning = 1u << 14,
+	kPortCmdListRunning = 1u << 15,
+
+	// PxTFD
+	kPortTfdErr = 1u << 0,
+	kPortTfdDrq = 1u << 3,
+	kPortTfdBsy = 1u << 7,
+
+	// PxSSTS
+	kPortSstsDetMask = 0xF,
+	kPortSstsDetPresent = 3,
+
+	// PxSCTL
+	kPortSctlDetMask = 0xF,
+	kPortSctlDetInit = 1,
+};
+
+// Value of PxSIG for SATA disks.
+constexpr uint32_t sataSignature = 0x00000101;
+
+// --------------------------------------------------------
+// In-memory structures
+// --------------------------------------------------------
+
+constexpr size_t maxSlots = 32;
+
+// Number of scatter/gather entries per command.
+constexpr size_t prdsPerCommand = 128;
+
+// Maximal number of bytes that a single PRD can describe.
+constexpr size_t maxPrdBytes = size_t{4} << 20;
+
+struct CommandHeader {
+	uint16_t flags;
+	uint16_t prdtLength;
+	uint32_t prdByteCount;
+	uint32_t tableBase;
+	uint32_t tableBaseHigh;
+	uint32_t reserved[4];
+};
+static_assert(sizeof(CommandHeader) == 32, "Bad sizeof(CommandHeader)");
+
+enum {
+	// CommandHeader::flags. The low bits contain the length of the FIS in dwords.
+	kHeaderWrite = 1u << 6,
+	kHeaderPrefetchable = 1u << 7,
+	kHeaderClearBusy = 1u << 10,
+};
+
+struct alignas(1024) CommandList {
+	CommandHeader slots[maxSlots];
+};
+
+struct alignas(256) ReceivedFis {
+	uint8_t data[256];
+};
+
+struct PrdEntry {
+	uint32_t dataBase;
+	uint32_t dataBaseHigh;
+	uint32_t reserved;
+	// Bits 0 - 21 store the byte count minus one. Bit 31 requests an IRQ.
+	uint32_t byteCount;
+};
+static_assert(sizeof(PrdEntry) == 16, "Bad sizeof(PrdEntry)");
+
+struct alignas(128) CommandTable {
+	uint8_t commandFis[64];
+	uint8_t atapiCommand[16];
+	uint8_t reserved[48];
+	PrdEntry prds[prdsPerCommand];
+};
+
+// --------------------------------------------------------
+// FIS and ATA commands
+// --------------------------------------------------------
+
+struct FisRegH2D {
+	uint8_t type;
+	uint8_t flags;
+	uint8_t command;
+	uint8_t featureLow;
+	uint8_t lba0;
+	uint8_t lba1;
+	uint8_t lba2;
+	uint8_t device;
+	uint8_t lba3;
+	uint8_t lba4;
+	uint8_t lba5;
+	uint8_t featureHigh;
+	uint8_t countLow;
+	uint8_t countHigh;
+	uint8_t icc;
+	uint8_t control;
+	uint8_t reserved[4];
+};
+static_assert(sizeof(FisRegH2D) == 20, "Bad sizeof(FisRegH2D)");
+
+enum {
+	kFisTypeRegH2D = 0x27,
+
+	// FisRegH2D::flags
+	kFisCommand = 0x80,
+
+	// FisRegH2D::device
+	kDeviceLba = 0x40,
+};
+
+enum {
+	kCommandReadDmaExt = 0x25,
+	kCommandWriteDmaExt = 0x35,
+	kCommandReadFpdmaQueued = 0x60,
+	kCommandWriteFpdmaQueued = 0x61,
+	kCommandIdentify = 0xEC,
+};
+
+} } // namespace block::ahci
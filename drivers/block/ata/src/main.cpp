@@ -43,6 +43,8 @@ class Controller : public blockfs::BlockDevice {
 	enum class IoResult {
 		none,
 		timeout,
+		// The device reported an error (ERR or DF) or is not ready.
+		error,
 		noData,
 		withData
 	};
@@ -59,12 +61,13 @@ private:
 	async::detached _doRequestLoop();
 	async::result<IoResult> _pollForBsy();
 	async::result<IoResult> _waitForBsyIrq();
+	IoResult _checkStatus(uint8_t status);
 
 public:
-	async::result<void> readSectors(uint64_t sector, void *buffer,
+	async::result<bool> readSectors(uint64_t sector, void *buffer,
 			size_t num_sectors) override;
 
-	async::result<void> writeSectors(uint64_t sector, const void *buffer,
+	async::result<bool> writeSectors(uint64_t sector, const void *buffer,
 			size_t num_sectors) override;
 
 private:
@@ -92,10 +95,11 @@ private:
 		uint64_t sector;
 		size_t numSectors;
 		void *buffer;
-		async::promise<void> promise;
+		// The value is false if the device reports an error.
+		async::promise<bool> promise;
 	};
 
-	async::result<void> _performRequest(Request *request);
+	async::result<bool> _performRequest(Request *request);
 
 	async::result<bool> _detectDevice();
 
@@ -141,8 +145,8 @@ async::detached Controller::_doRequestLoop() {
 		}
 
 		auto request = _requestQueue.front().get();
-		co_await _performRequest(request);
-		request->promise.set_value();
+		auto success = co_await _performRequest(request);
+		request->promise.set_value(success);
 		_requestQueue.pop();
 	}
 }
@@ -152,11 +156,7 @@ auto Controller::_pollForBsy() -> async::result<IoResult> {
 		auto altStatus = _altSpace.load(alt_regs::inStatus);
 		if(altStatus & kStatusBsy)
 			continue; // TODO: sleep some time before continuing.
-		// TODO: Report those errors to the caller.
-		assert(altStatus & kStatusRdy); // Device was disconnected?
-		assert(!(altStatus & kStatusErr));
-		assert(!(altStatus & kStatusDf));
-		co_return ((altStatus & kStatusDrq) ? IoResult::withData : IoResult::noData);
+		co_return _checkStatus(altStatus);
 	}
 }
 
@@ -196,15 +196,26 @@ auto Controller::_waitForBsyIrq() -> async::result<IoResult> {
 		// When BSY is still set, all other bits are meaningless.
 		if(status & kStatusBsy)
 			co_return IoResult::timeout;
-		// TODO: Report those errors to the caller.
-		assert(status & kStatusRdy); // Device was disconnected?
-		assert(!(status & kStatusErr));
-		assert(!(status & kStatusDf));
-		co_return ((status & kStatusDrq) ? IoResult::withData : IoResult::noData);
+		co_return _checkStatus(status);
 	}
 }
 
-async::result<void> Controller::readSectors(uint64_t sector,
+// Must only be called once BSY is clear.
+auto Controller::_checkStatus(uint8_t status) -> IoResult {
+	if(status & (kStatusErr | kStatusDf)) {
+		std::cout << "\e[31m" "block/ata: Device reports an error, status: 0x"
+				<< std::hex << int{status} << std::dec << "\e[39m" << std::endl;
+		return IoResult::error;
+	}
+	if(!(status & kStatusRdy)) {
+		std::cout << "\e[31m" "block/ata: Device is not ready (disconnected?)"
+				"\e[39m" << std::endl;
+		return IoResult::error;
+	}
+	return (status & kStatusDrq) ? IoResult::withData : IoResult::noData;
+}
+
+async::result<bool> Controller::readSectors(uint64_t sector,
 		void *buffer, size_t numSectors) {
 	auto request = std::make_unique<Request>();
 	auto future = request->promise.async_get();
@@ -216,10 +227,10 @@ async::result<void> Controller::readSectors(uint64_t sector,
 	_requestQueue.push(std::move(request));
 	_doorbell.ring();
 
-	return future;
+	co_return co_await std::move(future);
 }
 
-async::result<void> Controller::writeSectors(uint64_t sector,
+async::result<bool> Controller::writeSectors(uint64_t sector,
 		const void *buffer, size_t numSectors) {
 	auto request = std::make_unique<Request>();
 	auto future = request->promise.async_get();
@@ -231,7 +242,7 @@ async::result<void> Controller::writeSectors(uint64_t sector,
 	_requestQueue.push(std::move(request));
 	_doorbell.ring();
 
-	return future;
+	co_return co_await std::move(future);
 }
 
 async::result<bool> Controller::_detectDevice() {
@@ -266,7 +277,7 @@ async::result<bool> Controller::_detectDevice() {
 	co_return true;
 }
 
-async::result<void> Controller::_performRequest(Request *request) {
+async::result<bool> Controller::_performRequest(Request *request) {
 	if(logRequests)
 		std::cout << "block/ata: Reading/writing " << request->numSectors
 				<< " sectors from " << request->sector << std::endl;
@@ -300,7 +311,8 @@ async::result<void> Controller::_performRequest(Request *request) {
 		// Receive the result for each sector.
 		for(size_t k = 0; k < request->numSectors; k++) {
 			auto ioRes = co_await _waitForBsyIrq();
-			assert(ioRes == IoResult::withData);
+			if(ioRes != IoResult::withData)
+				co_return false;
 
 			// Read the data.
 			// TODO: Do we have to be careful with endianess here?
@@ -317,7 +329,8 @@ async::result<void> Controller::_performRequest(Request *request) {
 
 		// Write requests do not generate an IRQ for the first sector.
 		auto ioRes = co_await _pollForBsy();
-		assert(ioRes == IoResult::withData);
+		if(ioRes != IoResult::withData)
+			co_return false;
 
 		// Receive the result for each sector.
 		for(size_t k = 0; k < request->numSectors; k++) {
@@ -330,17 +343,17 @@ async::result<void> Controller::_performRequest(Request *request) {
 
 			// Wait for the device to process the sector.
 			auto ioRes = co_await _waitForBsyIrq();
-			if(k + 1 < request->numSectors) {
-				assert(ioRes == IoResult::withData);
-			}else{
-				assert(ioRes == IoResult::noData);
-			}
+			auto expected = (k + 1 < request->numSectors) ? IoResult::withData
+					: IoResult::noData;
+			if(ioRes != expected)
+				co_return false;
 		}
 	}
 
 	if(logRequests)
 		std::cout << "block/ata: Reading/writing from " << request->sector
 				<< " complete" << std::endl;
+	co_return true;
 }
 
 std::vector<std::shared_ptr<Controller>> globalControllers;
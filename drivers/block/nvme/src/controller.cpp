@@ -0,0 +1,471 @@
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include <hel.h>
+#include <hel-syscalls.h>
+
+#include "controller.hpp"
+
+namespace block {
+namespace nvme {
+
+namespace {
+	constexpr bool logCommands = false;
+
+	constexpr size_t adminQueueDepth = 32;
+
+	// Each command has a single PRP list page, i.e., no chaining of PRP lists.
+	constexpr size_t prpsPerList = pageSize / sizeof(uint64_t);
+
+	// Polls a condition every millisecond. Returns false on timeout.
+	template<typename F>
+	async::result<bool> pollUntil(F condition, uint64_t timeout) {
+		uint64_t start;
+		HEL_CHECK(helGetClock(&start));
+		while(!condition()) {
+			uint64_t tick;
+			HEL_CHECK(helGetClock(&tick));
+			if(tick - start > timeout)
+				co_return false;
+
+			helix::AwaitClock await_clock;
+			auto &&submit = helix::submitAwaitClock(&await_clock, tick + 1'000'000,
+					helix::Dispatcher::global());
+			co_await submit.async_wait();
+			HEL_CHECK(await_clock.error());
+		}
+		co_return true;
+	}
+
+	uintptr_t physicalPointer(void *ptr) {
+		uintptr_t physical;
+		HEL_CHECK(helPointerPhysical(ptr, &physical));
+		return physical;
+	}
+
+	size_t pagesFor(size_t size) {
+		return (size + pageSize - 1) / pageSize;
+	}
+
+	template<typename T>
+	T readIdentify(const uint8_t *data, size_t offset) {
+		T value;
+		memcpy(&value, data + offset, sizeof(T));
+		return value;
+	}
+
+	// Strings in identify data are padded with spaces.
+	std::string identifyString(const uint8_t *data, size_t offset, size_t length) {
+		std::string s{reinterpret_cast<const char *>(data + offset), length};
+		return s.substr(0, s.find_last_not_of(' ') + 1);
+	}
+
+	// Returns false (and logs the status) if the command failed.
+	bool checkStatus(Completion completion, const char *what) {
+		if(!completion.status)
+			return true;
+		std::cout << "\e[31m" "block-nvme: " << what << " failed with status type "
+				<< ((completion.status >> 8) & 7) << ", code 0x"
+				<< std::hex << (completion.status & 0xFF) << std::dec
+				<< "\e[39m" << std::endl;
+		return false;
+	}
+}
+
+// --------------------------------------------------------
+// Queue
+// --------------------------------------------------------
+
+Queue::Queue(Controller *controller, unsigned int id, size_t depth)
+: _controller{controller}, _id{id}, _depth{depth},
+		_sqMemory{controller->memoryPool(), pagesFor(depth * sizeof(SubmissionEntry))},
+		_cqMemory{controller->memoryPool(), pagesFor(depth * sizeof(CompletionEntry))},
+		_sq{reinterpret_cast<SubmissionEntry *>(_sqMemory.data())},
+		_cq{reinterpret_cast<CompletionEntry *>(_cqMemory.data())},
+		_prpLists{controller->memoryPool(), depth - 1},
+		_pending(depth - 1, nullptr) {
+	memset(_sq, 0, depth * sizeof(SubmissionEntry));
+	memset(_cq, 0, depth * sizeof(CompletionEntry));
+	for(size_t i = 0; i < depth - 1; i++)
+		_freeIds.push_back(depth - 2 - i);
+}
+
+uintptr_t Queue::sqPhysical() {
+	return physicalPointer(_sq);
+}
+
+uintptr_t Queue::cqPhysical() {
+	return physicalPointer(_cq);
+}
+
+async::result<Completion> Queue::submit(SubmissionEntry command,
+		void *buffer, size_t size) {
+	while(_freeIds.empty())
+		co_await _freeDoorbell.async_wait();
+	auto id = _freeIds.back();
+	_freeIds.pop_back();
+
+	command.commandId = id;
+	if(size)
+		_setupPrps(command, buffer, size);
+
+	if(logCommands)
+		std::cout << "block-nvme: Submitting opcode 0x" << std::hex << int{command.opcode}
+				<< std::dec << " with ID " << id << " to queue " << _id << std::endl;
+
+	async::promise<Completion> promise;
+	_pending[id] = &promise;
+	_sq[_sqTail] = command;
+	_sqTail = (_sqTail + 1) % _depth;
+	_controller->ringSqDoorbell(this, _sqTail);
+
+	auto completion = co_await promise.async_get();
+
+	_freeIds.push_back(id);
+	_freeDoorbell.ring();
+	co_return completion;
+}
+
+void Queue::_setupPrps(SubmissionEntry &command, void *buffer, size_t size) {
+	// PRPs can only describe dword-aligned buffers.
+	auto ptr = reinterpret_cast<uintptr_t>(buffer);
+	assert(!(ptr & 3));
+	assert(!(size & 3));
+
+	// The first PRP may start at an offset into a page, all others are page-aligned.
+	auto first = std::min(size, pageSize - (ptr & (pageSize - 1)));
+	command.prp1 = physicalPointer(buffer);
+	command.prp2 = 0;
+	if(first == size)
+		return;
+
+	auto rest = size - first;
+	if(rest <= pageSize) {
+		command.prp2 = physicalPointer(reinterpret_cast<void *>(ptr + first));
+		return;
+	}
+
+	auto list = &_prpLists.data()[command.commandId];
+	size_t n = 0;
+	for(size_t progress = first; progress < size; progress += pageSize) {
+		assert(n < prpsPerList);
+		list->entries[n++] = physicalPointer(reinterpret_cast<void *>(ptr + progress));
+	}
+	command.prp2 = physicalPointer(list);
+}
+
+bool Queue::handleCompletions() {
+	bool any = false;
+	while(true) {
+		auto entry = _cq[_cqHead];
+		if((entry.status & 1) != _phase)
+			break;
+		any = true;
+
+		_cqHead++;
+		if(_cqHead == _depth) {
+			_cqHead = 0;
+			_phase ^= 1;
+		}
+
+		assert(entry.commandId < _pending.size());
+		auto promise = std::exchange(_pending[entry.commandId], nullptr);
+		assert(promise);
+		promise->set_value(Completion{static_cast<uint16_t>(entry.status >> 1), entry.result});
+	}
+
+	if(any)
+		_controller->ringCqDoorbell(this, _cqHead);
+	return any;
+}
+
+// --------------------------------------------------------
+// Namespace
+// --------------------------------------------------------
+
+Namespace::Namespace(Controller *controller, uint32_t id,
+		size_t sector_size, uint64_t num_sectors)
+: blockfs::BlockDevice{sector_size}, _controller{controller}, _id{id},
+		_numSectors{num_sectors} { }
+
+async::result<bool> Namespace::readSectors(uint64_t sector,
+		void *buffer, size_t num_sectors) {
+	return _transfer(false, sector, buffer, num_sectors);
+}
+
+async::result<bool> Namespace::writeSectors(uint64_t sector,
+		const void *buffer, size_t num_sectors) {
+	return _transfer(true, sector, const_cast<void *>(buffer), num_sectors);
+}
+
+async::result<bool> Namespace::_transfer(bool write, uint64_t sector,
+		void *buffer, size_t num_sectors) {
+	assert(sector + num_sectors <= _numSectors);
+
+	auto max_sectors = _controller->maxTransferSize() / sectorSize;
+	for(size_t progress = 0; progress < num_sectors; ) {
+		auto count = std::min(num_sectors - progress, max_sectors);
+		auto lba = sector + progress;
+
+		SubmissionEntry command{};
+		command.opcode = write ? kIoWrite : kIoRead;
+		command.namespaceId = _id;
+		command.cdw10 = lba;
+		command.cdw11 = lba >> 32;
+		command.cdw12 = count - 1;
+
+		auto completion = co_await _controller->ioQueue()->submit(command,
+				reinterpret_cast<char *>(buffer) + progress * sectorSize, count * sectorSize);
+		if(!checkStatus(completion, write ? "Write" : "Read"))
+			co_return false;
+		progress += count;
+	}
+	co_return true;
+}
+
+// --------------------------------------------------------
+// Controller
+// --------------------------------------------------------
+
+Controller::Controller(protocols::hw::Device hw_device, helix::Mapping mapping,
+		helix::UniqueDescriptor mmio, helix::UniqueDescriptor irq,
+		QueueConfig config)
+: _hwDevice{std::move(hw_device)}, _mapping{std::move(mapping)},
+		_mmio{std::move(mmio)}, _irq{std::move(irq)},
+		_space{_mapping.get()}, _config{config} { }
+
+async::detached Controller::run() {
+	co_await _hwDevice.enableBusmaster();
+
+	auto version = _space.load(regs::vs);
+	auto cap = _space.load(regs::cap);
+	_doorbellStride = size_t{4} << ((cap >> kCapStrideShift) & kCapStrideMask);
+	_maxQueueDepth = (cap & kCapMqesMask) + 1;
+	std::cout << "block-nvme: NVMe " << (version >> 16) << "." << ((version >> 8) & 0xFF)
+			<< ", maximal queue depth " << _maxQueueDepth << std::endl;
+
+	// We always use the host page size as memory page size.
+	if((cap >> kCapMinPageShift) & kCapMinPageMask) {
+		std::cout << "\e[31m" "block-nvme: Controller does not support 4 KiB pages"
+				"\e[39m" << std::endl;
+		co_return;
+	}
+
+	if(!(co_await _reset()))
+		co_return;
+
+	co_await _hwDevice.enableBusIrq();
+	_handleIrqs();
+
+	if(!(co_await _identifyController()))
+		co_return;
+	if(!(co_await _createIoQueues()))
+		co_return;
+	co_await _identifyNamespaces();
+
+	// TODO: libblockfs only supports a single device.
+	if(!_namespaces.empty())
+		blockfs::runDevice(_namespaces.front().get());
+}
+
+Queue *Controller::ioQueue() {
+	// Prefer the next queue in round-robin order unless another one is less busy.
+	auto queue = _ioQueues[_nextIoQueue].get();
+	_nextIoQueue = (_nextIoQueue + 1) % _ioQueues.size();
+	for(auto &other : _ioQueues) {
+		if(other->numInFlight() < queue->numInFlight())
+			queue = other.get();
+	}
+	return queue;
+}
+
+void Controller::ringSqDoorbell(Queue *queue, uint32_t tail) {
+	arch::scalar_register<uint32_t> doorbell(doorbellOffset
+			+ 2 * queue->id() * _doorbellStride);
+	_space.store(doorbell, tail);
+}
+
+void Controller::ringCqDoorbell(Queue *queue, uint32_t head) {
+	arch::scalar_register<uint32_t> doorbell(doorbellOffset
+			+ (2 * queue->id() + 1) * _doorbellStride);
+	_space.store(doorbell, head);
+}
+
+async::result<bool> Controller::_reset() {
+	// CAP.TO is given in units of 500ms.
+	uint64_t timeout = ((_space.load(regs::cap) >> kCapTimeoutShift) & kCapTimeoutMask)
+			* 500'000'000;
+
+	// The admin queue can only be changed while the controller is disabled.
+	_space.store(regs::cc, _space.load(regs::cc) & ~kCcEnable);
+	if(!(co_await pollUntil([&] {
+		return !(_space.load(regs::csts) & kCstsReady);
+	}, timeout))) {
+		std::cout << "\e[31m" "block-nvme: Controller does not become disabled"
+				"\e[39m" << std::endl;
+		co_return false;
+	}
+
+	_adminQueue = std::make_unique<Queue>(this, 0, adminQueueDepth);
+	_space.store(regs::aqa, ((adminQueueDepth - 1) << 16) | (adminQueueDepth - 1));
+	_space.store(regs::asq, _adminQueue->sqPhysical());
+	_space.store(regs::acq, _adminQueue->cqPhysical());
+
+	// Select the NVM command set, 4 KiB pages and round-robin arbitration.
+	_space.store(regs::cc, kCcEnable | (sqEntrySizeShift << kCcSqEntrySizeShift)
+			| (cqEntrySizeShift << kCcCqEntrySizeShift));
+	if(!(co_await pollUntil([&] {
+		return _space.load(regs::csts) & (kCstsReady | kCstsFatal);
+	}, timeout)) || (_space.load(regs::csts) & kCstsFatal)) {
+		std::cout << "\e[31m" "block-nvme: Controller does not become ready"
+				"\e[39m" << std::endl;
+		co_return false;
+	}
+
+	co_return true;
+}
+
+async::result<bool> Controller::_identifyController() {
+	arch::dma_buffer buffer{&_memoryPool, pageSize};
+	auto data = reinterpret_cast<const uint8_t *>(buffer.data());
+
+	SubmissionEntry command{};
+	command.opcode = kAdminIdentify;
+	command.cdw10 = kIdentifyController;
+	if(!checkStatus(co_await _submitAdmin(command, buffer.data(), buffer.size()), "Identify"))
+		co_return false;
+
+	std::cout << "block-nvme: Controller '"
+			<< identifyString(data, identify::controllerModel, 40) << "', serial '"
+			<< identifyString(data, identify::controllerSerial, 20) << "'" << std::endl;
+
+	// MDTS is a power of two in units of the minimal page size. Zero means no limit.
+	// Our PRP lists limit transfers further. The size of commands is reduced by one page
+	// as buffers do not need to be page-aligned.
+	size_t max_pages = prpsPerList;
+	auto mdts = readIdentify<uint8_t>(data, identify::controllerMdts);
+	if(mdts && mdts < 16)
+		max_pages = std::min(max_pages, size_t{1} << mdts);
+	if(max_pages < 2) {
+		std::cout << "\e[31m" "block-nvme: Maximal transfer size is too small"
+				"\e[39m" << std::endl;
+		co_return false;
+	}
+	_maxTransferSize = (max_pages - 1) * pageSize;
+
+	_numNamespaces = readIdentify<uint32_t>(data, identify::controllerNumNamespaces);
+	co_return true;
+}
+
+async::result<bool> Controller::_createIoQueues() {
+	// The controller reports the number of allocated queues, minus one.
+	SubmissionEntry features{};
+	features.opcode = kAdminSetFeatures;
+	features.cdw10 = kFeatureNumQueues;
+	features.cdw11 = ((_config.numIoQueues - 1) << 16) | (_config.numIoQueues - 1);
+	auto completion = co_await _submitAdmin(features);
+	if(!checkStatus(completion, "Set Features"))
+		co_return false;
+	size_t num_queues = std::min({_config.numIoQueues,
+			size_t{(completion.result & 0xFFFF) + 1},
+			size_t{(completion.result >> 16) + 1}});
+	auto depth = std::min(_config.ioQueueDepth, _maxQueueDepth);
+
+	for(size_t i = 0; i < num_queues; i++) {
+		auto queue = std::make_unique<Queue>(this, i + 1, depth);
+
+		// All queues share the pin-based IRQ, i.e., vector 0.
+		SubmissionEntry create_cq{};
+		create_cq.opcode = kAdminCreateCq;
+		create_cq.prp1 = queue->cqPhysical();
+		create_cq.cdw10 = ((depth - 1) << 16) | queue->id();
+		create_cq.cdw11 = kQueueIrqEnable | kQueuePhysicallyContiguous;
+		if(!checkStatus(co_await _submitAdmin(create_cq), "Create I/O CQ"))
+			co_return false;
+
+		SubmissionEntry create_sq{};
+		create_sq.opcode = kAdminCreateSq;
+		create_sq.prp1 = queue->sqPhysical();
+		create_sq.cdw10 = ((depth - 1) << 16) | queue->id();
+		create_sq.cdw11 = (queue->id() << 16) | kQueuePhysicallyContiguous;
+		if(!checkStatus(co_await _submitAdmin(create_sq), "Create I/O SQ"))
+			co_return false;
+
+		_ioQueues.push_back(std::move(queue));
+	}
+
+	std::cout << "block-nvme: Using " << num_queues << " I/O queues of depth "
+			<< depth << std::endl;
+	co_return true;
+}
+
+async::result<void> Controller::_identifyNamespaces() {
+	arch::dma_buffer buffer{&_memoryPool, pageSize};
+	auto data = reinterpret_cast<const uint8_t *>(buffer.data());
+
+	for(uint32_t id = 1; id <= _numNamespaces; id++) {
+		SubmissionEntry command{};
+		command.opcode = kAdminIdentify;
+		command.namespaceId = id;
+		command.cdw10 = kIdentifyNamespace;
+		auto completion = co_await _submitAdmin(command, buffer.data(), buffer.size());
+		if(completion.status)
+			continue;
+
+		// Inactive namespaces report a size of zero.
+		auto num_sectors = readIdentify<uint64_t>(data, identify::namespaceSize);
+		if(!num_sectors)
+			continue;
+
+		auto format = readIdentify<uint8_t>(data, identify::namespaceFormattedLba) & 0xF;
+		auto lba_format = readIdentify<uint32_t>(data,
+				identify::namespaceLbaFormats + 4 * format);
+		size_t sector_size = size_t{1} << ((lba_format >> 16) & 0xFF);
+
+		std::cout << "block-nvme: Namespace " << id << ": " << num_sectors
+				<< " sectors of " << sector_size << " bytes" << std::endl;
+		if(sector_size != 512) {
+			std::cout << "block-nvme: Ignoring namespace " << id
+					<< " with unsupported sector size" << std::endl;
+			continue;
+		}
+
+		_namespaces.push_back(std::make_unique<Namespace>(this, id, sector_size, num_sectors));
+	}
+}
+
+async::result<Completion> Controller::_submitAdmin(SubmissionEntry command,
+		void *buffer, size_t size) {
+	return _adminQueue->submit(command, buffer, size);
+}
+
+async::detached Controller::_handleIrqs() {
+	uint64_t sequence = 0;
+	while(true) {
+		helix::AwaitEvent await;
+		auto &&submit = helix::submitAwaitEvent(_irq, &await, sequence,
+				helix::Dispatcher::global());
+		co_await submit.async_wait();
+		HEL_CHECK(await.error());
+		sequence = await.sequence();
+
+		// Without MSI-X, all queues share the IRQ and we have to check each of them.
+		bool any = _adminQueue->handleCompletions();
+		for(auto &queue : _ioQueues)
+			any |= queue->handleCompletions();
+
+		if(!any) {
+			HEL_CHECK(helAcknowledgeIrq(_irq.getHandle(), kHelAckNack, sequence));
+			continue;
+		}
+		HEL_CHECK(helAcknowledgeIrq(_irq.getHandle(), kHelAckAcknowledge, sequence));
+	}
+}
+
+} } // namespace block::nvme
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <arch/dma_pool.hpp>
+#include <arch/dma_structs.hpp>
+#include <arch/mem_space.hpp>
+#include <async/doorbell.hpp>
+#include <async/result.hpp>
+#include <blockfs.hpp>
+#include <helix/ipc.hpp>
+#include <helix/memory.hpp>
+#include <protocols/hw/client.hpp>
+
+#include "spec.hpp"
+
+namespace block {
+namespace nvme {
+
+struct Controller;
+
+constexpr size_t pageSize = 0x1000;
+
+// Queues and PRP lists are allocated in units of pages, as they must be page-aligned.
+struct alignas(pageSize) QueuePage {
+	uint8_t data[pageSize];
+};
+
+struct alignas(pageSize) PrpList {
+	uint64_t entries[pageSize / sizeof(uint64_t)];
+};
+
+struct Completion {
+	uint16_t status;
+	uint32_t result;
+};
+
+// Parameters of the I/O queues. They can be changed on the command line.
+// The kernel cannot report the CPU that submits a request and it does not
+// support MSI-X, hence I/O queues are not bound to CPUs. Instead, commands are
+// distributed among all I/O queues. The controller may allocate fewer queues
+// or support only smaller queues.
+struct QueueConfig {
+	size_t numIoQueues = 4;
+	size_t ioQueueDepth = 64;
+};
+
+// --------------------------------------------------------
+// Queue
+// --------------------------------------------------------
+
+// A submission queue together with its completion queue.
+struct Queue {
+	Queue(Controller *controller, unsigned int id, size_t depth);
+
+	unsigned int id() {
+		return _id;
+	}
+
+	size_t depth() {
+		return _depth;
+	}
+
+	uintptr_t sqPhysical();
+	uintptr_t cqPhysical();
+
+	// Number of commands that were submitted but did not complete yet.
+	size_t numInFlight() {
+		return _depth - 1 - _freeIds.size();
+	}
+
+	// Submits a command that transfers data from/to the given buffer.
+	// Fills in the command ID and the PRPs and waits until the command completes.
+	async::result<Completion> submit(SubmissionEntry command, void *buffer, size_t size);
+
+	// Processes all new entries of the completion queue.
+	// Returns false if there were no new entries.
+	bool handleCompletions();
+
+private:
+	void _setupPrps(SubmissionEntry &command, void *buffer, size_t size);
+
+	Controller *_controller;
+	unsigned int _id;
+	size_t _depth;
+
+	arch::dma_array<QueuePage> _sqMemory;
+	arch::dma_array<QueuePage> _cqMemory;
+	SubmissionEntry *_sq;
+	CompletionEntry *_cq;
+	arch::dma_array<PrpList> _prpLists;
+
+	size_t _sqTail = 0;
+	size_t _cqHead = 0;
+	uint16_t _phase = 1;
+
+	// One slot of the SQ always stays empty, hence at most depth - 1 commands are in flight.
+	std::vector<uint16_t> _freeIds;
+	async::doorbell _freeDoorbell;
+	std::vector<async::promise<Completion> *> _pending;
+};
+
+// --------------------------------------------------------
+// Namespace
+// --------------------------------------------------------
+
+struct Namespace : blockfs::BlockDevice {
+	Namespace(Controller *controller, uint32_t id, size_t sector_size, uint64_t num_sectors);
+
+	async::result<bool> readSectors(uint64_t sector,
+			void *buffer, size_t num_sectors) override;
+
+	async::result<bool> writeSectors(uint64_t sector,
+			const void *buffer, size_t num_sectors) override;
+
+private:
+	async::result<bool> _transfer(bool write, uint64_t sector,
+			void *buffer, size_t num_sectors);
+
+	Controller *_controller;
+	uint32_t _id;
+	uint64_t _numSectors;
+};
+
+// --------------------------------------------------------
+// Controller
+// --------------------------------------------------------
+
+struct Controller {
+	Controller(protocols::hw::Device hw_device, helix::Mapping mapping,
+			helix::UniqueDescriptor mmio, helix::UniqueDescriptor irq,
+			QueueConfig config);
+
+	async::detached run();
+
+	arch::dma_pool *memoryPool() {
+		return &_memoryPool;
+	}
+
+	// Maximal size of a single data transfer, assuming that the buffer is not page-aligned.
+	size_t maxTransferSize() {
+		return _maxTransferSize;
+	}
+
+	// Returns the I/O queue that the next command should be submitted to.
+	Queue *ioQueue();
+
+	void ringSqDoorbell(Queue *queue, uint32_t tail);
+	void ringCqDoorbell(Queue *queue, uint32_t head);
+
+private:
+	async::result<bool> _reset();
+	async::result<bool> _identifyController();
+	async::result<bool> _createIoQueues();
+	async::result<void> _identifyNamespaces();
+	async::result<Completion> _submitAdmin(SubmissionEntry command,
+			void *buffer = nullptr, size_t size = 0);
+	async::detached _handleIrqs();
+
+	protocols::hw::Device _hwDevice;
+	helix::Mapping _mapping;
+	helix::UniqueDescriptor _mmio;
+	helix::UniqueDescriptor _irq;
+	arch::mem_space _space;
+
+	arch::os::contiguous_pool _memoryPool;
+
+	QueueConfig _config;
+	size_t _doorbellStride = 4;
+	size_t _maxQueueDepth = 2;
+	size_t _maxTransferSize = 0;
+	uint32_t _numNamespaces = 0;
+
+	std::unique_ptr<Queue> _adminQueue;
+	std::vector<std::unique_ptr<Queue>> _ioQueues;
+	size_t _nextIoQueue = 0;
+
+	std::vector<std::unique_ptr<Namespace>> _namespaces;
+};
+
+} } // namespace block::nvme
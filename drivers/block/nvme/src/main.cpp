@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+#include <async/result.hpp>
+#include <helix/ipc.hpp>
+#include <helix/memory.hpp>
+#include <protocols/hw/client.hpp>
+#include <protocols/mbus/client.hpp>
+
+#include "controller.hpp"
+
+std::vector<std::shared_ptr<block::nvme::Controller>> globalControllers;
+block::nvme::QueueConfig globalQueueConfig;
+
+// ------------------------------------------------------------------------
+// Freestanding discovery functions.
+// ------------------------------------------------------------------------
+
+async::detached bindController(mbus::Entity entity) {
+	protocols::hw::Device device(co_await entity.bind());
+	auto info = co_await device.getPciInfo();
+
+	// The controller registers are always in BAR 0.
+	assert(info.barInfo[0].ioType == protocols::hw::IoType::kIoTypeMemory);
+	auto bar = co_await device.accessBar(0);
+	auto irq = co_await device.accessIrq();
+
+	helix::Mapping mapping{bar, info.barInfo[0].offset, info.barInfo[0].length};
+
+	auto controller = std::make_shared<block::nvme::Controller>(std::move(device),
+			std::move(mapping), std::move(bar), std::move(irq), globalQueueConfig);
+	controller->run();
+	globalControllers.push_back(std::move(controller));
+}
+
+async::detached observeControllers() {
+	auto root = co_await mbus::Instance::global().getRoot();
+
+	auto filter = mbus::Conjunction({
+		mbus::EqualsFilter("pci-class", "01"),
+		mbus::EqualsFilter("pci-subclass", "08"),
+		mbus::EqualsFilter("pci-interface", "02")
+	});
+
+	auto handler = mbus::ObserverHandler{}
+	.withAttach([] (mbus::Entity entity, mbus::Properties) {
+		printf("block-nvme: Detected controller\n");
+		bindController(std::move(entity));
+	});
+
+	co_await root.linkObserver(std::move(filter), std::move(handler));
+}
+
+// --------------------------------------------------------
+// main() function
+// --------------------------------------------------------
+
+// Parses a numeric option value. Returns false if it is not in [min, max].
+static bool parseValue(const char *arg, size_t min, size_t max, size_t &value) {
+	char *end;
+	auto parsed = strtoul(arg, &end, 10);
+	if(!*arg || *end || parsed < min || parsed > max)
+		return false;
+	value = parsed;
+	return true;
+}
+
+// Supported options:
+//     --io-queues=N    Number of I/O queues (1 to 65535).
+//     --queue-depth=N  Number of entries per I/O queue (2 to 65536).
+// Invalid options are ignored; the defaults of QueueConfig are used instead.
+static void parseArgs(int argc, char **argv) {
+	for(int i = 1; i < argc; i++) {
+		bool valid;
+		if(!strncmp(argv[i], "--io-queues=", 12)) {
+			valid = parseValue(argv[i] + 12, 1, 65535, globalQueueConfig.numIoQueues);
+		}else if(!strncmp(argv[i], "--queue-depth=", 14)) {
+			valid = parseValue(argv[i] + 14, 2, 65536, globalQueueConfig.ioQueueDepth);
+		}else{
+			printf("block-nvme: Ignoring unknown option %s\n", argv[i]);
+			continue;
+		}
+		if(!valid)
+			printf("block-nvme: Ignoring invalid value in %s\n", argv[i]);
+	}
+}
+
+int main(int argc, char **argv) {
+	printf("block-nvme: Starting driver\n");
+	parseArgs(argc, argv);
+
+	{
+		async::queue_scope scope{helix::globalQueue()};
+		observeControllers();
+	}
+
+	async::run_forever(helix::globalQueue()->run_token(), helix::currentDispatcher);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <arch/register.hpp>
+
+namespace block {
+namespace nvme {
+
+// --------------------------------------------------------
+// Controller registers
+// --------------------------------------------------------
+
+namespace regs {
+	inline constexpr arch::scalar_register<uint64_t> cap{0x00};
+	inline constexpr arch::scalar_register<uint32_t> vs{0x08};
+	inline constexpr arch::scalar_register<uint32_t> intms{0x0C};
+	inline constexpr arch::scalar_register<uint32_t> intmc{0x10};
+	inline constexpr arch::scalar_register<uint32_t> cc{0x14};
+	inline constexpr arch::scalar_register<uint32_t> csts{0x1C};
+	inline constexpr arch::scalar_register<uint32_t> aqa{0x24};
+	inline constexpr arch::scalar_register<uint64_t> asq{0x28};
+	inline constexpr arch::scalar_register<uint64_t> acq{0x30};
+}
+
+// Offset of the first doorbell register. The stride is given by CAP.DSTRD.
+constexpr size_t doorbellOffset = 0x1000;
+
+enum {
+	// CAP
+	kCapMqesMask = 0xFFFF,
+	kCapTimeoutShift = 24,
+	kCapTimeoutMask = 0xFF,
+	kCapStrideShift = 32,
+	kCapStrideMask = 0xF,
+	kCapMinPageShift = 48,
+	kCapMinPageMask = 0xF,
+
+	// CC
+	kCcEnable = 1u << 0,
+	kCcSqEntrySizeShift = 16,
+	kCcCqEntrySizeShift = 20,
+
+	// CSTS
+	kCstsReady = 1u << 0,
+	kCstsFatal = 1u << 1,
+};
+
+// --------------------------------------------------------
+// Queue entries
+// --------------------------------------------------------
+
+struct SubmissionEntry {
+	uint8_t opcode;
+	uint8_t flags;
+	uint16_t commandId;
+	uint32_t namespaceId;
+	uint32_t reserved[2];
+	uint64_t metadataPointer;
+	uint64_t prp1;
+	uint64_t prp2;
+	uint32_t cdw10;
+	uint32_t cdw11;
+	uint32_t cdw12;
+	uint32_t cdw13;
+	uint32_t cdw14;
+	uint32_t cdw15;
+};
+static_assert(sizeof(SubmissionEntry) == 64, "Bad sizeof(SubmissionEntry)");
+
+struct CompletionEntry {
+	uint32_t result;
+	uint32_t reserved;
+	uint16_t sqHead;
+	uint16_t sqId;
+	uint16_t commandId;
+	// Bit 0 is the phase tag, the remaining bits contain the status.
+	uint16_t status;
+};
+static_assert(sizeof(CompletionEntry) == 16, "Bad sizeof(CompletionEntry)");
+
+// Queue entry sizes as powers of two, as required by CC.IOSQES and CC.IOCQES.
+constexpr unsigned int sqEntrySizeShift = 6;
+constexpr unsigned int cqEntrySizeShift = 4;
+
+// --------------------------------------------------------
+// Commands
+// --------------------------------------------------------
+
+enum {
+	// Admin commands.
+	kAdminDeleteSq = 0x00,
+	kAdminCreateSq = 0x01,
+	kAdminDeleteCq = 0x04,
+	kAdminCreateCq = 0x05,
+	kAdminIdentify = 0x06,
+	kAdminSetFeatures = 0x09,
+
+	// NVM commands.
+	kIoFlush = 0x00,
+	kIoWrite = 0x01,
+	kIoRead = 0x02,
+};
+
+enum {
+	// Create I/O SQ/CQ, cdw11.
+	kQueuePhysicallyContiguous = 1u << 0,
+	kQueueIrqEnable = 1u << 1,
+
+	// Identify, cdw10.
+	kIdentifyNamespace = 0x00,
+	kIdentifyController = 0x01,
+
+	// Set Features, cdw10.
+	kFeatureNumQueues = 0x07,
+};
+
+// Offsets into the identify data structures.
+namespace identify {
+	constexpr size_t controllerSerial = 4;
+	constexpr size_t controllerModel = 24;
+	constexpr size_t controllerMdts = 77;
+	constexpr size_t controllerNumNamespaces = 516;
+
+	constexpr size_t namespaceSize = 0;
+	constexpr size_t namespaceFormattedLba = 26;
+	constexpr size_t namespaceLbaFormats = 128;
+}
+
+} } // namespace block::nvme
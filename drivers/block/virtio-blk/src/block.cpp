@@ -1,6 +1,8 @@
 
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
 #include "block.hpp"
 
@@ -21,13 +23,28 @@ UserRequest::UserRequest(bool write_, uint64_t sector_, void *buffer_, size_t nu
 // --------------------------------------------------------
 
 Device::Device(std::unique_ptr<virtio_core::Transport> transport)
-: blockfs::BlockDevice{512}, _transport{std::move(transport)},
-		_requestQueue{nullptr} { }
+: blockfs::BlockDevice{512}, _transport{std::move(transport)} { }
 
 void Device::runDevice() {
+	unsigned int num_queues = 1;
+	if(_transport->checkDeviceFeature(VIRTIO_BLK_F_MQ)) {
+		_transport->acknowledgeDriverFeature(VIRTIO_BLK_F_MQ);
+		num_queues = std::max(1u,
+				static_cast<unsigned int>(_transport->space().load(spec::regs::numQueues)));
+		// Using more queues than CPUs does not increase the parallelism of the device.
+		auto num_cpus = std::thread::hardware_concurrency();
+		if(num_cpus)
+			num_queues = std::min(num_queues, num_cpus);
+	}
+
 	_transport->finalizeFeatures();
-	_transport->claimQueues(1);
-	_requestQueue = _transport->setupQueue(0);
+	_transport->claimQueues(num_queues);
+	for(unsigned int i = 0; i < num_queues; i++) {
+		auto rq = std::make_unique<RequestQueue>();
+		rq->queue = _transport->setupQueue(i);
+		_requestQueues.push_back(std::move(rq));
+	}
+	std::cout << "virtio: Using " << num_queues << " request queue(s)" << std::endl;
 
 	auto size = static_cast<uint64_t>(_transport->space().load(spec::regs::capacity[0]))
 			| (static_cast<uint64_t>(_transport->space().load(spec::regs::capacity[1])) << 32);
@@ -36,76 +53,88 @@ void Device::runDevice() {
 	_transport->runDevice();
 
 	// perform device specific setup
-	virtRequestBuffer = (VirtRequest *)malloc(_requestQueue->numDescriptors() * sizeof(VirtRequest));
-	statusBuffer = (uint8_t *)malloc(_requestQueue->numDescriptors());
+	for(auto &rq : _requestQueues) {
+		rq->virtRequestBuffer = (VirtRequest *)malloc(rq->queue->numDescriptors()
+				* sizeof(VirtRequest));
+		rq->statusBuffer = (uint8_t *)malloc(rq->queue->numDescriptors());
 
-	// natural alignment makes sure that request headers do not cross page boundaries
-	assert((uintptr_t)virtRequestBuffer % sizeof(VirtRequest) == 0);
-	
-	// setup an interrupt for the device
-	_processRequests();
+		// natural alignment makes sure that request headers do not cross page boundaries
+		assert((uintptr_t)rq->virtRequestBuffer % sizeof(VirtRequest) == 0);
+
+		_processRequests(rq.get());
+	}
 
 	blockfs::runDevice(this);
 }
 
-async::result<void> Device::readSectors(uint64_t sector,
+async::result<bool> Device::readSectors(uint64_t sector,
 		void *buffer, size_t num_sectors) {
-	// Natural alignment makes sure a sector does not cross a page boundary.
-	assert(!((uintptr_t)buffer % 512));
 //	printf("readSectors(%lu, %lu)\n", sector, num_sectors);
+	return _transfer(false, sector, buffer, num_sectors);
+}
 
-	// Limit to ensure that we don't monopolize the device.
-	auto max_sectors = _requestQueue->numDescriptors() / 4;
-	assert(max_sectors >= 1);
+async::result<bool> Device::writeSectors(uint64_t sector,
+		const void *buffer, size_t num_sectors) {
+//	printf("writeSectors(%lu, %lu)\n", sector, num_sectors);
+	return _transfer(true, sector, const_cast<void *>(buffer), num_sectors);
+}
 
-	for(size_t progress = 0; progress < num_sectors; progress += max_sectors) {
-		auto request = new UserRequest(false, sector + progress,
-				(char *)buffer + 512 * progress,
-				std::min(num_sectors - progress, max_sectors));
-		_pendingQueue.push(request);
-		_pendingDoorbell.ring();
-		co_await request->promise.async_get();
-		delete request;
+// All requests are issued from the same thread, hence we cannot steer them by
+// the submitting CPU. Instead, we pick the least loaded queue; this keeps all
+// queues busy whenever multiple clients issue requests concurrently.
+auto Device::_steerRequest() -> RequestQueue * {
+	RequestQueue *best = _requestQueues.front().get();
+	for(auto &rq : _requestQueues) {
+		if(rq->numOutstanding < best->numOutstanding)
+			best = rq.get();
 	}
+	return best;
 }
 
-async::result<void> Device::writeSectors(uint64_t sector,
-		const void *buffer, size_t num_sectors) {
+async::result<bool> Device::_transfer(bool write, uint64_t sector,
+		void *buffer, size_t num_sectors) {
 	// Natural alignment makes sure a sector does not cross a page boundary.
 	assert(!((uintptr_t)buffer % 512));
-//	printf("writeSectors(%lu, %lu)\n", sector, num_sectors);
 
-	// Limit to ensure that we don't monopolize the device.
-	auto max_sectors = _requestQueue->numDescriptors() / 4;
-	assert(max_sectors >= 1);
+	for(size_t progress = 0; progress < num_sectors; ) {
+		auto rq = _steerRequest();
 
-	for(size_t progress = 0; progress < num_sectors; progress += max_sectors) {
-		auto request = new UserRequest(true, sector + progress,
+		// Limit to ensure that we don't monopolize the device.
+		auto max_sectors = rq->queue->numDescriptors() / 4;
+		assert(max_sectors >= 1);
+
+		auto request = new UserRequest(write, sector + progress,
 				(char *)buffer + 512 * progress,
 				std::min(num_sectors - progress, max_sectors));
-		_pendingQueue.push(request);
-		_pendingDoorbell.ring();
-		co_await request->promise.async_get();
+		rq->numOutstanding++;
+		rq->pendingQueue.push(request);
+		rq->pendingDoorbell.ring();
+		auto success = co_await request->promise.async_get();
+		rq->numOutstanding--;
+		progress += request->numSectors;
 		delete request;
+		if(!success)
+			co_return false;
 	}
+	co_return true;
 }
 
-async::detached Device::_processRequests() {
+async::detached Device::_processRequests(RequestQueue *rq) {
 	while(true) {
-		if(_pendingQueue.empty()) {
-			co_await _pendingDoorbell.async_wait();
+		if(rq->pendingQueue.empty()) {
+			co_await rq->pendingDoorbell.async_wait();
 			continue;
 		}
 
-		auto request = _pendingQueue.front();
-		_pendingQueue.pop();
+		auto request = rq->pendingQueue.front();
+		rq->pendingQueue.pop();
 		assert(request->numSectors);
 
 		// Setup the descriptor for the request header.
 		virtio_core::Chain chain;
-		chain.append(co_await _requestQueue->obtainDescriptor());
+		chain.append(co_await rq->queue->obtainDescriptor());
 
-		VirtRequest *header = &virtRequestBuffer[chain.front().tableIndex()];
+		VirtRequest *header = &rq->virtRequestBuffer[chain.front().tableIndex()];
 		if(request->write) {
 			header->type = VIRTIO_BLK_T_OUT;
 		}else{
@@ -119,7 +148,7 @@ async::detached Device::_processRequests() {
 		
 		// Setup descriptors for the transfered data.
 		for(size_t i = 0; i < request->numSectors; i++) {
-			chain.append(co_await _requestQueue->obtainDescriptor());
+			chain.append(co_await rq->queue->obtainDescriptor());
 			if(request->write) {
 				chain.setupBuffer(virtio_core::hostToDevice, arch::dma_buffer_view{nullptr,
 						(char *)request->buffer + 512 * i, 512});
@@ -134,20 +163,28 @@ async::detached Device::_processRequests() {
 					<< " data descriptors" << std::endl;
 
 		// Setup a descriptor for the status byte.
-		chain.append(co_await _requestQueue->obtainDescriptor());
+		chain.append(co_await rq->queue->obtainDescriptor());
+		request->status = &rq->statusBuffer[chain.front().tableIndex()];
 		chain.setupBuffer(virtio_core::deviceToHost, arch::dma_buffer_view{nullptr,
-				&statusBuffer[chain.front().tableIndex()], 1});
+				request->status, 1});
 
 		// Submit the request to the device
-		_requestQueue->postDescriptor(chain.front(), request,
+		rq->queue->postDescriptor(chain.front(), request,
 				[] (virtio_core::Request *base_request) {
 			auto request = static_cast<UserRequest *>(base_request);
 			if(logInitiateRetire)
 				std::cout << "Retiring " << request->numSectors
 						<< " data descriptors" << std::endl;
-			request->promise.set_value();
+			if(*request->status != VIRTIO_BLK_S_OK)
+				std::cout << "\e[31m" "virtio-blk: Request for sector " << request->sector
+						<< " failed with status " << int{*request->status}
+						<< "\e[39m" << std::endl;
+			request->promise.set_value(*request->status == VIRTIO_BLK_S_OK);
 		});
-		_requestQueue->notify();
+
+		// Kick the device only once for all requests that are pending right now.
+		if(rq->pendingQueue.empty())
+			rq->queue->notify();
 	}
 }
 
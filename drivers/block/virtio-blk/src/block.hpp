@@ -1,5 +1,7 @@
 
+#include <memory>
 #include <queue>
+#include <vector>
 
 #include <blockfs.hpp>
 #include <core/virtio/core.hpp>
@@ -23,10 +25,24 @@ enum {
 	VIRTIO_BLK_T_OUT = 1
 };
 
+// Values of the status byte.
+enum {
+	VIRTIO_BLK_S_OK = 0,
+	VIRTIO_BLK_S_IOERR = 1,
+	VIRTIO_BLK_S_UNSUPP = 2
+};
+
+// Device feature bits.
+enum {
+	VIRTIO_BLK_F_MQ = 12
+};
+
 namespace spec::regs {
 	inline constexpr arch::scalar_register<uint32_t> capacity[] = {
 			arch::scalar_register<uint32_t>{0},
 			arch::scalar_register<uint32_t>{4}};
+	// Only valid if VIRTIO_BLK_F_MQ is negotiated.
+	inline constexpr arch::scalar_register<uint16_t> numQueues{34};
 }
 
 struct Device;
@@ -43,7 +59,11 @@ struct UserRequest : virtio_core::Request {
 	void *buffer;
 	size_t numSectors;
 
-	async::promise<void> promise;
+	// Points into the statusBuffer of the queue while the request is submitted.
+	uint8_t *status = nullptr;
+
+	// The value is false if the device reports an error.
+	async::promise<bool> promise;
 };
 
 // --------------------------------------------------------
@@ -55,29 +75,43 @@ struct Device : blockfs::BlockDevice {
 
 	void runDevice();
 
-	async::result<void> readSectors(uint64_t sector,
+	async::result<bool> readSectors(uint64_t sector,
 			void *buffer, size_t num_sectors) override;
 
-	async::result<void> writeSectors(uint64_t sector,
+	async::result<bool> writeSectors(uint64_t sector,
 			const void *buffer, size_t num_sectors) override;
 
 private:
-	// Submits requests from _pendingQueue to the device.
-	async::detached _processRequests();
-	
-	std::unique_ptr<virtio_core::Transport> _transport;
+	// State that is kept for each virtq of the device.
+	struct RequestQueue {
+		virtio_core::Queue *queue;
+
+		// Stores UserRequest objects that have not been submitted yet.
+		std::queue<UserRequest *> pendingQueue;
+		async::doorbell pendingDoorbell;
+
+		// Number of requests that were steered to this queue but did not complete yet.
+		size_t numOutstanding = 0;
+
+		// these two buffer store virtio-block request header and status bytes
+		// they are indexed by the index of the request's first descriptor
+		VirtRequest *virtRequestBuffer;
+		uint8_t *statusBuffer;
+	};
 
-	// The single virtq of this device.
-	virtio_core::Queue *_requestQueue;
+	// Picks the queue that the next request is submitted to.
+	RequestQueue *_steerRequest();
 
-	// Stores UserRequest objects that have not been submitted yet.
-	std::queue<UserRequest *> _pendingQueue;
-	async::doorbell _pendingDoorbell;
+	async::result<bool> _transfer(bool write, uint64_t sector,
+			void *buffer, size_t num_sectors);
+
+	// Submits requests from the pendingQueue of a virtq to the device.
+	async::detached _processRequests(RequestQueue *rq);
+	
+	std::unique_ptr<virtio_core::Transport> _transport;
 
-	// these two buffer store virtio-block request header and status bytes
-	// they are indexed by the index of the request's first descriptor
-	VirtRequest *virtRequestBuffer;
-	uint8_t *statusBuffer;
+	// One entry per virtq; there is more than one if VIRTIO_BLK_F_MQ is negotiated.
+	std::vector<std::unique_ptr<RequestQueue>> _requestQueues;
 };
 
 } } // namespace block::virtio
@@ -11,10 +11,11 @@ struct BlockDevice {
 
 	virtual ~BlockDevice() = default;
 
-	virtual async::result<void> readSectors(uint64_t sector, void *buffer,
+	// Both functions return false if the device reports an I/O error.
+	virtual async::result<bool> readSectors(uint64_t sector, void *buffer,
 			size_t num_sectors) = 0;
 
-	virtual async::result<void> writeSectors(uint64_t sector, const void *buffer,
+	virtual async::result<bool> writeSectors(uint64_t sector, const void *buffer,
 			size_t num_sectors) {
 		throw std::runtime_error("BlockDevice does not support writeSectors()");
 	}
@@ -1,9 +1,11 @@
 
+#include <dirent.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 
 #include <async/result.hpp>
 #include <helix/ipc.hpp>
@@ -19,6 +21,381 @@ namespace {
 
 	constexpr int pageShift = 12;
 	constexpr size_t pageSize = size_t{1} << pageShift;
+
+	// Bounds for the readahead window of sequentially read files.
+	constexpr size_t minReadahead = 16 * 1024;
+	constexpr size_t maxReadahead = 1024 * 1024;
+
+	// Amount of a directory that readEntryBatch() locks and maps at a time.
+	constexpr size_t entryWindowSize = 64 * 1024;
+
+	// The page cache cannot report errors to the users of the mapped pages,
+	// hence we give up if the device fails to transfer file system data.
+	void checkIo(bool success) {
+		if(!success)
+			throw std::runtime_error("ext2fs: I/O error");
+	}
+
+	uint8_t entryTypeToDirent(uint8_t type) {
+		switch(type) {
+		case 1: return DT_REG;
+		case 2: return DT_DIR;
+		case 3: return DT_CHR;
+		case 4: return DT_BLK;
+		case 5: return DT_FIFO;
+		case 6: return DT_SOCK;
+		case 7: return DT_LNK;
+		default: return DT_UNKNOWN;
+		}
+	}
+
+	// Mask of the block number in DiskDxEntry. The upper bits are reserved.
+	constexpr uint32_t dxBlockMask = 0x0FFFFFFF;
+
+	// Offset of the index entries in the root and interior blocks of a directory index.
+	constexpr size_t dxRootInfoOffset = 24;
+	constexpr size_t dxRootEntriesOffset = dxRootInfoOffset + sizeof(DiskDxRoot);
+	constexpr size_t dxNodeEntriesOffset = 8;
+
+	// Hash values with bit 0 set mark leaves that continue a hash collision.
+	// The largest hash is reserved as end-of-directory marker.
+	constexpr uint32_t dxHashEof = 0x7FFFFFFF;
+
+	size_t entryLength(size_t name_length) {
+		return (sizeof(DiskDirEntry) + name_length + 3) & ~size_t(3);
+	}
+
+	DirEntry toDirEntry(DiskDirEntry *disk_entry) {
+		DirEntry entry;
+		entry.inode = disk_entry->inode;
+
+		switch(disk_entry->fileType) {
+		case EXT2_FT_REG_FILE:
+			entry.fileType = kTypeRegular; break;
+		case EXT2_FT_DIR:
+			entry.fileType = kTypeDirectory; break;
+		case EXT2_FT_SYMLINK:
+			entry.fileType = kTypeSymlink; break;
+		default:
+			entry.fileType = kTypeNone;
+		}
+		return entry;
+	}
+
+	// Finds a used entry with the given name inside a single directory block.
+	// If previous is not null, it receives the preceding entry of the same block.
+	DiskDirEntry *findInBlock(char *data, size_t block_size, std::string_view name,
+			DiskDirEntry **previous = nullptr) {
+		DiskDirEntry *previous_entry = nullptr;
+		size_t offset = 0;
+		while(offset < block_size) {
+			assert(!(offset & 3));
+			assert(offset + sizeof(DiskDirEntry) <= block_size);
+			auto disk_entry = reinterpret_cast<DiskDirEntry *>(data + offset);
+			assert(disk_entry->recordLength);
+			assert(offset + disk_entry->recordLength <= block_size);
+
+			if(disk_entry->inode
+					&& name.length() == disk_entry->nameLength
+					&& !memcmp(disk_entry->name, name.data(), name.length())) {
+				if(previous)
+					*previous = previous_entry;
+				return disk_entry;
+			}
+
+			offset += disk_entry->recordLength;
+			previous_entry = disk_entry;
+		}
+		assert(offset == block_size);
+		return nullptr;
+	}
+
+	// Inserts an entry into a single directory block. Returns false if the block is full.
+	bool insertIntoBlock(char *data, size_t block_size, std::string_view name,
+			uint32_t ino, uint8_t type) {
+		// Space required for the new directory entry.
+		auto required = entryLength(name.size());
+
+		size_t offset = 0;
+		while(offset < block_size) {
+			assert(!(offset & 3));
+			assert(offset + sizeof(DiskDirEntry) <= block_size);
+			auto previous_entry = reinterpret_cast<DiskDirEntry *>(data + offset);
+			assert(previous_entry->recordLength);
+
+			// Unused entries can be overwritten directly.
+			if(!previous_entry->inode && previous_entry->recordLength >= required) {
+				previous_entry->inode = ino;
+				previous_entry->nameLength = name.length();
+				previous_entry->fileType = type;
+				memcpy(previous_entry->name, name.data(), name.length());
+				return true;
+			}
+
+			// Calculate available space after we contract previous_entry.
+			auto contracted = entryLength(previous_entry->nameLength);
+			assert(previous_entry->recordLength >= contracted);
+			auto available = previous_entry->recordLength - contracted;
+
+			// Check whether we can shrink previous_entry and insert a new entry after it.
+			if(previous_entry->inode && available >= required) {
+				auto disk_entry = reinterpret_cast<DiskDirEntry *>(data + offset + contracted);
+				memset(disk_entry, 0, sizeof(DiskDirEntry));
+				disk_entry->inode = ino;
+				disk_entry->recordLength = available;
+				disk_entry->nameLength = name.length();
+				disk_entry->fileType = type;
+				memcpy(disk_entry->name, name.data(), name.length());
+
+				previous_entry->recordLength = contracted;
+				return true;
+			}
+
+			offset += previous_entry->recordLength;
+		}
+		assert(offset == block_size);
+		return false;
+	}
+
+	// Removes an entry from a single directory block. Returns false if it does not exist.
+	bool removeFromBlock(char *data, size_t block_size, std::string_view name) {
+		DiskDirEntry *previous_entry;
+		auto disk_entry = findInBlock(data, block_size, name, &previous_entry);
+		if(!disk_entry)
+			return false;
+
+		// Entries never cross block boundaries. Merge the entry into its predecessor
+		// if there is one; otherwise, mark it as unused.
+		if(previous_entry) {
+			previous_entry->recordLength += disk_entry->recordLength;
+		}else{
+			disk_entry->inode = 0;
+		}
+		return true;
+	}
+
+	// A used directory entry together with its hash.
+	struct HashedRecord {
+		uint32_t hash;
+		uint32_t inode;
+		uint8_t fileType;
+		std::string name;
+	};
+
+	// Collects the used entries of a directory block.
+	template<typename F>
+	std::vector<HashedRecord> collectRecords(char *data, size_t block_size, F hash) {
+		std::vector<HashedRecord> records;
+		size_t offset = 0;
+		while(offset < block_size) {
+			auto disk_entry = reinterpret_cast<DiskDirEntry *>(data + offset);
+			assert(disk_entry->recordLength);
+			if(disk_entry->inode) {
+				std::string name{disk_entry->name, disk_entry->nameLength};
+				records.push_back({hash(name), disk_entry->inode, disk_entry->fileType,
+						std::move(name)});
+			}
+			offset += disk_entry->recordLength;
+		}
+		return records;
+	}
+
+	// Overwrites a directory block with a packed list of entries.
+	void writeRecords(char *data, size_t block_size,
+			const HashedRecord *begin, const HashedRecord *end) {
+		memset(data, 0, block_size);
+
+		size_t offset = 0;
+		DiskDirEntry *disk_entry = nullptr;
+		for(auto it = begin; it != end; ++it) {
+			disk_entry = reinterpret_cast<DiskDirEntry *>(data + offset);
+			disk_entry->inode = it->inode;
+			disk_entry->recordLength = entryLength(it->name.size());
+			disk_entry->nameLength = it->name.size();
+			disk_entry->fileType = it->fileType;
+			memcpy(disk_entry->name, it->name.data(), it->name.size());
+			offset += disk_entry->recordLength;
+			assert(offset <= block_size);
+		}
+
+		// The last entry covers the remainder of the block.
+		if(disk_entry) {
+			disk_entry->recordLength += block_size - offset;
+		}else{
+			disk_entry = reinterpret_cast<DiskDirEntry *>(data);
+			disk_entry->recordLength = block_size;
+		}
+	}
+
+	// Inserts an index entry after the given position.
+	void insertDxEntry(DiskDxEntry *entries, DiskDxEntry *at, uint32_t hash, uint32_t block) {
+		auto count_limit = reinterpret_cast<DiskDxCountLimit *>(entries);
+		assert(count_limit->count < count_limit->limit);
+		auto end = entries + count_limit->count;
+		memmove(at + 2, at + 1, (end - (at + 1)) * sizeof(DiskDxEntry));
+		at[1].hash = hash;
+		at[1].block = block;
+		count_limit->count++;
+	}
+
+	// Initializes an interior block of a directory index.
+	DiskDxEntry *initDxNode(char *data, size_t block_size) {
+		memset(data, 0, block_size);
+		auto fake_entry = reinterpret_cast<DiskDirEntry *>(data);
+		fake_entry->recordLength = block_size;
+
+		auto entries = reinterpret_cast<DiskDxEntry *>(data + dxNodeEntriesOffset);
+		auto count_limit = reinterpret_cast<DiskDxCountLimit *>(entries);
+		count_limit->limit = (block_size - dxNodeEntriesOffset) / sizeof(DiskDxEntry);
+		count_limit->count = 0;
+		return entries;
+	}
+
+	// --------------------------------------------------------
+	// Directory entry hashes.
+	// These are bit-compatible with the hashes used by Linux's ext3/ext4.
+	// --------------------------------------------------------
+
+	uint32_t rotateLeft(uint32_t x, int s) {
+		return (x << s) | (x >> (32 - s));
+	}
+
+	template<typename C>
+	uint32_t legacyHash(const C *p, size_t length) {
+		uint32_t hash0 = 0x12A3FE2D;
+		uint32_t hash1 = 0x37ABE8F9;
+		for(size_t i = 0; i < length; i++) {
+			uint32_t hash = hash1 + (hash0 ^ static_cast<uint32_t>(int{p[i]} * 7152373));
+			if(hash & 0x80000000)
+				hash -= 0x7FFFFFFF;
+			hash1 = hash0;
+			hash0 = hash;
+		}
+		return hash0 << 1;
+	}
+
+	// Converts (a part of) the name into the input of the hash functions.
+	template<typename C>
+	void nameToHashBuffer(const C *p, size_t length, uint32_t *buffer, int num) {
+		uint32_t pad = static_cast<uint32_t>(length) | (static_cast<uint32_t>(length) << 8);
+		pad |= pad << 16;
+
+		uint32_t value = pad;
+		if(length > size_t(num) * 4)
+			length = num * 4;
+		for(size_t i = 0; i < length; i++) {
+			value = static_cast<uint32_t>(int{p[i]}) + (value << 8);
+			if((i % 4) == 3) {
+				*buffer++ = value;
+				value = pad;
+				num--;
+			}
+		}
+		if(--num >= 0)
+			*buffer++ = value;
+		while(--num >= 0)
+			*buffer++ = pad;
+	}
+
+	void halfMd4Transform(uint32_t state[4], const uint32_t in[8]) {
+		constexpr uint32_t k2 = 013240474631;
+		constexpr uint32_t k3 = 015666365641;
+		auto f = [] (uint32_t x, uint32_t y, uint32_t z) { return z ^ (x & (y ^ z)); };
+		auto g = [] (uint32_t x, uint32_t y, uint32_t z) { return (x & y) + ((x ^ y) & z); };
+		auto h = [] (uint32_t x, uint32_t y, uint32_t z) { return x ^ y ^ z; };
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		auto round = [] (auto fn, uint32_t &a, uint32_t b, uint32_t c, uint32_t d,
+				uint32_t x, int s) {
+			a += fn(b, c, d) + x;
+			a = rotateLeft(a, s);
+		};
+
+		round(f, a, b, c, d, in[0], 3);
+		round(f, d, a, b, c, in[1], 7);
+		round(f, c, d, a, b, in[2], 11);
+		round(f, b, c, d, a, in[3], 19);
+		round(f, a, b, c, d, in[4], 3);
+		round(f, d, a, b, c, in[5], 7);
+		round(f, c, d, a, b, in[6], 11);
+		round(f, b, c, d, a, in[7], 19);
+
+		round(g, a, b, c, d, in[1] + k2, 3);
+		round(g, d, a, b, c, in[3] + k2, 5);
+		round(g, c, d, a, b, in[5] + k2, 9);
+		round(g, b, c, d, a, in[7] + k2, 13);
+		round(g, a, b, c, d, in[0] + k2, 3);
+		round(g, d, a, b, c, in[2] + k2, 5);
+		round(g, c, d, a, b, in[4] + k2, 9);
+		round(g, b, c, d, a, in[6] + k2, 13);
+
+		round(h, a, b, c, d, in[3] + k3, 3);
+		round(h, d, a, b, c, in[7] + k3, 9);
+		round(h, c, d, a, b, in[2] + k3, 11);
+		round(h, b, c, d, a, in[6] + k3, 15);
+		round(h, a, b, c, d, in[1] + k3, 3);
+		round(h, d, a, b, c, in[5] + k3, 9);
+		round(h, c, d, a, b, in[0] + k3, 11);
+		round(h, b, c, d, a, in[4] + k3, 15);
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+	}
+
+	void teaTransform(uint32_t state[4], const uint32_t in[4]) {
+		constexpr uint32_t delta = 0x9E3779B9;
+		uint32_t sum = 0;
+		uint32_t b0 = state[0], b1 = state[1];
+		for(int n = 0; n < 16; n++) {
+			sum += delta;
+			b0 += ((b1 << 4) + in[0]) ^ (b1 + sum) ^ ((b1 >> 5) + in[1]);
+			b1 += ((b0 << 4) + in[2]) ^ (b0 + sum) ^ ((b0 >> 5) + in[3]);
+		}
+		state[0] += b0;
+		state[1] += b1;
+	}
+
+	template<typename C>
+	std::pair<uint32_t, uint32_t> computeHash(const C *p, size_t length,
+			int version, const uint32_t seed[4]) {
+		uint32_t state[4] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476};
+		if(seed[0] || seed[1] || seed[2] || seed[3])
+			memcpy(state, seed, sizeof(state));
+
+		uint32_t hash = 0;
+		uint32_t minor = 0;
+		uint32_t in[8];
+		switch(version) {
+		case DX_HASH_LEGACY:
+			hash = legacyHash(p, length);
+			break;
+		case DX_HASH_HALF_MD4:
+			for(size_t i = 0; i < length; i += 32) {
+				nameToHashBuffer(p + i, length - i, in, 8);
+				halfMd4Transform(state, in);
+			}
+			hash = state[1];
+			minor = state[2];
+			break;
+		case DX_HASH_TEA:
+			for(size_t i = 0; i < length; i += 16) {
+				nameToHashBuffer(p + i, length - i, in, 4);
+				teaTransform(state, in);
+			}
+			hash = state[0];
+			minor = state[1];
+			break;
+		default:
+			throw std::runtime_error("ext2fs: Unexpected directory hash version");
+		}
+
+		hash &= ~uint32_t(1);
+		if(hash == (dxHashEof << 1))
+			hash = (dxHashEof - 1) << 1;
+		return {hash, minor};
+	}
 }
 
 // --------------------------------------------------------
@@ -34,182 +411,489 @@ Inode::findEntry(std::string name) {
 
 	co_await readyJump.async_wait();
 
-	helix::LockMemoryView lock_memory;
-	auto map_size = (fileSize() + 0xFFF) & ~size_t(0xFFF);
-	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(frontalMemory),
-			&lock_memory,
-			0, map_size, helix::Dispatcher::global());
-	co_await submit.async_wait();
-	HEL_CHECK(lock_memory.error());
+	co_await directoryMutex.async_lock();
+	std::unique_lock<async::mutex> lock{directoryMutex, std::adopt_lock};
 
-	// Map the page cache into the address space.
-	helix::Mapping file_map{helix::BorrowedDescriptor{frontalMemory},
-			0, map_size,
-			kHelMapProtRead | kHelMapDontRequireBacking};
+	if(isIndexed()) {
+		uint32_t hash;
+		std::vector<DxFrame> frames;
+		if(co_await probeIndex(name, hash, frames))
+			co_return co_await findIndexedEntry(name, hash, frames);
+	}
 
-	// Read the directory structure.
-	uintptr_t offset = 0;
-	while(offset < fileSize()) {
-		assert(!(offset & 3));
-		assert(offset + sizeof(DiskDirEntry) <= fileSize());
-		auto disk_entry = reinterpret_cast<DiskDirEntry *>(
-				reinterpret_cast<char *>(file_map.get()) + offset);
+	co_return co_await findLinearEntry(name);
+}
 
-		if(disk_entry->inode
-				&& name.length() == disk_entry->nameLength
-				&& !memcmp(disk_entry->name, name.data(), name.length())) {
-			DirEntry entry;
-			entry.inode = disk_entry->inode;
-
-			switch(disk_entry->fileType) {
-			case EXT2_FT_REG_FILE:
-				entry.fileType = kTypeRegular; break;
-			case EXT2_FT_DIR:
-				entry.fileType = kTypeDirectory; break;
-			case EXT2_FT_SYMLINK:
-				entry.fileType = kTypeSymlink; break;
-			default:
-				entry.fileType = kTypeNone;
-			}
+async::result<std::optional<DirEntry>>
+Inode::link(std::string name, int64_t ino, blockfs::FileType type) {
+	assert(!name.empty() && name != "." && name != "..");
+	assert(ino);
 
-			co_return entry;
-		}
+	co_await readyJump.async_wait();
 
-		offset += disk_entry->recordLength;
+	uint8_t disk_type;
+	switch (type) {
+		case kTypeRegular:
+			disk_type = EXT2_FT_REG_FILE;
+			break;
+		case kTypeDirectory:
+			disk_type = EXT2_FT_DIR;
+			break;
+		case kTypeSymlink:
+			disk_type = EXT2_FT_SYMLINK;
+			break;
+		default:
+			throw std::runtime_error("unexpected type");
 	}
-	assert(offset == fileSize());
 
-	co_return std::nullopt;
+	co_await directoryMutex.async_lock();
+	std::unique_lock<async::mutex> lock{directoryMutex, std::adopt_lock};
+
+	uint32_t hash;
+	std::vector<DxFrame> frames;
+	if(isIndexed() && (co_await probeIndex(name, hash, frames))) {
+		co_await insertIndexedEntry(name, hash, ino, disk_type, frames);
+	}else{
+		// Inserting entries without respecting the index would corrupt it.
+		if(diskInode()->flags & EXT2_INDEX_FL)
+			co_await dropIndex();
+
+		if(!(co_await insertLinearEntry(name, ino, disk_type))) {
+			co_await buildIndex();
+			if(!(co_await probeIndex(name, hash, frames)))
+				throw std::runtime_error("ext2fs: Failed to create directory index");
+			co_await insertIndexedEntry(name, hash, ino, disk_type, frames);
+		}
+	}
+
+	// Update the inode.
+	auto target = fs.accessInode(ino);
+	co_await target->readyJump.async_wait();
+	target->diskInode()->linksCount++;
+	auto syncInode = co_await helix_ng::synchronizeSpace(
+			helix::BorrowedDescriptor{kHelNullHandle},
+			target->diskMapping.get(), fs.inodeSize);
+	HEL_CHECK(syncInode.error());
+
+	DirEntry entry;
+	entry.inode = ino;
+	entry.fileType = type;
+	if(entryCache)
+		entryCache->insert_or_assign(name, entry);
+	co_return entry;
 }
 
-async::result<std::optional<DirEntry>>
-Inode::link(std::string name, int64_t ino, blockfs::FileType type) {
+async::result<void> Inode::unlink(std::string name) {
 	assert(!name.empty() && name != "." && name != "..");
-	assert(ino);
 
 	co_await readyJump.async_wait();
 
+	co_await directoryMutex.async_lock();
+	std::unique_lock<async::mutex> lock{directoryMutex, std::adopt_lock};
+
+	// Removing entries does not change the order of hashes. Hence, the index stays valid
+	// even if we need to fall back to a linear scan.
+	bool removed;
+	uint32_t hash;
+	std::vector<DxFrame> frames;
+	if(isIndexed() && (co_await probeIndex(name, hash, frames))) {
+		removed = co_await removeIndexedEntry(name, hash, frames);
+	}else{
+		removed = co_await removeLinearEntry(name);
+	}
+
+	if(!removed)
+		throw std::runtime_error("Given link does not exist");
+	if(entryCache)
+		entryCache->erase(name);
+}
+
+bool Inode::isIndexed() {
+	return fs.dirIndex && (diskInode()->flags & EXT2_INDEX_FL)
+			&& fileSize() > fs.blockSize;
+}
+
+async::result<DirectoryBlock> Inode::accessDirectoryBlock(uint32_t index) {
+	auto offset = uint64_t{index} << fs.blockShift;
+	assert(offset + fs.blockSize <= fileSize());
+	auto map_offset = offset & ~uint64_t(pageSize - 1);
+	auto map_size = (offset - map_offset + fs.blockSize + (pageSize - 1)) & ~(pageSize - 1);
+
 	helix::LockMemoryView lock_memory;
-	auto map_size = (fileSize() + 0xFFF) & ~size_t(0xFFF);
 	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(frontalMemory),
-			&lock_memory,
-			0, map_size, helix::Dispatcher::global());
+			&lock_memory, map_offset, map_size, helix::Dispatcher::global());
 	co_await submit.async_wait();
 	HEL_CHECK(lock_memory.error());
 
 	// Map the page cache into the address space.
-	helix::Mapping file_map{helix::BorrowedDescriptor{frontalMemory},
-			0, map_size,
+	DirectoryBlock block;
+	block.index = index;
+	block.lock = lock_memory.descriptor();
+	block.mapping = helix::Mapping{helix::BorrowedDescriptor{frontalMemory},
+			static_cast<ptrdiff_t>(map_offset), map_size,
 			kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+	block.offset = offset - map_offset;
+	co_return std::move(block);
+}
 
-	// Space required for the new directory entry.
-	auto required = (sizeof(DiskDirEntry) + name.size() + 3) & ~size_t(3);
+async::result<DirectoryBlock> Inode::appendDirectoryBlock() {
+	assert(!(fileSize() & (fs.blockSize - 1)));
+	uint32_t index = fileSize() >> fs.blockShift;
 
-	// Walk the directory structure.
-	uintptr_t offset = 0;
-	while(offset < fileSize()) {
-		assert(!(offset & 3));
-		assert(offset + sizeof(DiskDirEntry) <= fileSize());
-		auto previous_entry = reinterpret_cast<DiskDirEntry *>(
-				reinterpret_cast<char *>(file_map.get()) + offset);
+	// A single unused entry that spans the whole block.
+	std::vector<char> buffer(fs.blockSize);
+	auto disk_entry = reinterpret_cast<DiskDirEntry *>(buffer.data());
+	disk_entry->recordLength = fs.blockSize;
+	co_await fs.write(this, fileSize(), buffer.data(), fs.blockSize);
 
-		// Calculate available space after we contract previous_entry.
-		auto contracted = (sizeof(DiskDirEntry) + previous_entry->nameLength + 3) & ~size_t(3);
-		assert(previous_entry->recordLength >= contracted);
-		auto available = previous_entry->recordLength - contracted;
+	co_return co_await accessDirectoryBlock(index);
+}
 
-		// Check whether we can shrink previous_entry and insert a new entry after it.
-		if(available >= required) {
-			// Create the new dentry.
-			auto disk_entry = reinterpret_cast<DiskDirEntry *>(
-					reinterpret_cast<char *>(file_map.get()) + offset + contracted);
-			memset(disk_entry, 0, sizeof(DiskDirEntry));
-			disk_entry->inode = ino;
-			disk_entry->recordLength = available;
-			disk_entry->nameLength = name.length();
-			switch (type) {
-				case kTypeRegular:
-					disk_entry->fileType = EXT2_FT_REG_FILE;
-					break;
-				case kTypeDirectory:
-					disk_entry->fileType = EXT2_FT_DIR;
-					break;
-				case kTypeSymlink:
-					disk_entry->fileType = EXT2_FT_SYMLINK;
-					break;
-				default:
-					throw std::runtime_error("unexpected type");
+async::result<void> Inode::dropIndex() {
+	diskInode()->flags &= ~EXT2_INDEX_FL;
+	auto syncInode = co_await helix_ng::synchronizeSpace(
+			helix::BorrowedDescriptor{kHelNullHandle},
+			diskMapping.get(), fs.inodeSize);
+	HEL_CHECK(syncInode.error());
+}
+
+async::result<bool> Inode::probeIndex(std::string_view name, uint32_t &hash,
+		std::vector<DxFrame> &frames) {
+	auto num_blocks = fileSize() >> fs.blockShift;
+	frames.clear();
+
+	auto root_block = co_await accessDirectoryBlock(0);
+	auto info = reinterpret_cast<DiskDxRoot *>(root_block.data() + dxRootInfoOffset);
+	if(info->hashVersion > DX_HASH_TEA || info->infoLength != sizeof(DiskDxRoot)
+			|| info->indirectLevels > 1) {
+		std::cout << "ext2fs: Unsupported directory index in inode " << number << std::endl;
+		co_return false;
+	}
+	size_t levels = info->indirectLevels;
+	hash = fs.hashName(name, info->hashVersion).first;
+
+	auto root_entries = reinterpret_cast<DiskDxEntry *>(root_block.data() + dxRootEntriesOffset);
+	frames.push_back({std::move(root_block), root_entries, nullptr});
+
+	size_t limit = (fs.blockSize - dxRootEntriesOffset) / sizeof(DiskDxEntry);
+	while(true) {
+		auto &frame = frames.back();
+		auto count_limit = frame.countLimit();
+		if(count_limit->limit != limit || !count_limit->count || count_limit->count > limit) {
+			std::cout << "ext2fs: Corrupted directory index in inode " << number << std::endl;
+			co_return false;
+		}
+
+		// Find the last entry whose hash is not greater than the target hash.
+		// The first entry does not store a hash; it covers all hashes below the second one.
+		auto p = frame.entries + 1;
+		auto q = frame.entries + count_limit->count;
+		while(p < q) {
+			auto m = p + (q - p) / 2;
+			if(m->hash > hash) {
+				q = m;
+			}else{
+				p = m + 1;
 			}
-			memcpy(disk_entry->name, name.data(), name.length());
-
-			// Update the existing dentry.
-			previous_entry->recordLength = contracted;
-
-			// Update the inode.
-			auto target = fs.accessInode(ino);
-			co_await target->readyJump.async_wait();
-			target->diskInode()->linksCount++;
-			auto syncInode = co_await helix_ng::synchronizeSpace(
-					helix::BorrowedDescriptor{kHelNullHandle},
-					target->diskMapping.get(), fs.inodeSize);
-			HEL_CHECK(syncInode.error());
-
-			DirEntry entry;
-			entry.inode = ino;
-			entry.fileType = type;
-			co_return entry;
 		}
+		frame.at = p - 1;
 
-		offset += previous_entry->recordLength;
+		auto block = frame.at->block & dxBlockMask;
+		if(!block || block >= num_blocks) {
+			std::cout << "ext2fs: Corrupted directory index in inode " << number << std::endl;
+			co_return false;
+		}
+		if(frames.size() > levels)
+			break;
+
+		auto node_block = co_await accessDirectoryBlock(block);
+		auto node_entries = reinterpret_cast<DiskDxEntry *>(node_block.data()
+				+ dxNodeEntriesOffset);
+		frames.push_back({std::move(node_block), node_entries, nullptr});
+		limit = (fs.blockSize - dxNodeEntriesOffset) / sizeof(DiskDxEntry);
 	}
-	assert(offset == fileSize());
 
-	throw std::runtime_error("Not enough space for ext2fs directory entry");
+	co_return true;
 }
 
-async::result<void> Inode::unlink(std::string name) {
-	assert(!name.empty() && name != "." && name != "..");
+async::result<bool> Inode::nextIndexLeaf(uint32_t hash, std::vector<DxFrame> &frames) {
+	// Find the deepest level that has another entry.
+	auto level = frames.size();
+	while(level) {
+		auto &frame = frames[level - 1];
+		if(frame.at + 1 < frame.entries + frame.countLimit()->count)
+			break;
+		level--;
+	}
+	if(!level)
+		co_return false;
+
+	// The next leaf only contains relevant entries if it continues a hash collision.
+	auto &frame = frames[level - 1];
+	frame.at++;
+	if((frame.at->hash & ~uint32_t(1)) != hash)
+		co_return false;
+
+	// Descend to the first leaf of the new subtree.
+	auto num_blocks = fileSize() >> fs.blockShift;
+	for(; level < frames.size(); level++) {
+		auto block = frames[level - 1].at->block & dxBlockMask;
+		if(!block || block >= num_blocks)
+			co_return false;
+
+		auto node_block = co_await accessDirectoryBlock(block);
+		auto node_entries = reinterpret_cast<DiskDxEntry *>(node_block.data()
+				+ dxNodeEntriesOffset);
+		frames[level] = DxFrame{std::move(node_block), node_entries, node_entries};
+	}
 
-	co_await readyJump.async_wait();
+	co_return true;
+}
 
-	helix::LockMemoryView lock_memory;
-	auto map_size = (fileSize() + 0xFFF) & ~size_t(0xFFF);
-	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(frontalMemory),
-			&lock_memory,
-			0, map_size, helix::Dispatcher::global());
-	co_await submit.async_wait();
-	HEL_CHECK(lock_memory.error());
+async::result<std::optional<DirEntry>> Inode::findIndexedEntry(std::string_view name,
+		uint32_t hash, std::vector<DxFrame> &frames) {
+	while(true) {
+		auto leaf = co_await accessDirectoryBlock(frames.back().at->block & dxBlockMask);
+		if(auto disk_entry = findInBlock(leaf.data(), fs.blockSize, name); disk_entry)
+			co_return toDirEntry(disk_entry);
 
-	// Map the page cache into the address space.
-	helix::Mapping file_map{helix::BorrowedDescriptor{frontalMemory},
-			0, map_size,
-			kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+		if(!(co_await nextIndexLeaf(hash, frames)))
+			co_return std::nullopt;
+	}
+}
 
-	// Read the directory structure.
-	DiskDirEntry *previous_entry = nullptr;
-	uintptr_t offset = 0;
-	while(offset < fileSize()) {
-		assert(!(offset & 3));
-		assert(offset + sizeof(DiskDirEntry) <= fileSize());
-		auto disk_entry = reinterpret_cast<DiskDirEntry *>(
-				reinterpret_cast<char *>(file_map.get()) + offset);
+async::result<std::optional<DirEntry>> Inode::findLinearEntry(std::string_view name) {
+	uint32_t num_blocks = fileSize() >> fs.blockShift;
+	if(num_blocks <= 1) {
+		if(!num_blocks)
+			co_return std::nullopt;
 
-		if(disk_entry->inode
-				&& name.length() == disk_entry->nameLength
-				&& !memcmp(disk_entry->name, name.data(), name.length())) {
-			// The directory should start with "." and "..". As those entries are never deleted,
-			// we can assume that a previous entry exists.
-			assert(previous_entry);
-			previous_entry->recordLength += disk_entry->recordLength;
-			co_return;
+		auto block = co_await accessDirectoryBlock(0);
+		if(auto disk_entry = findInBlock(block.data(), fs.blockSize, name); disk_entry)
+			co_return toDirEntry(disk_entry);
+		co_return std::nullopt;
+	}
+
+	// Scan large directories only once; afterwards, lookups are served from the cache.
+	if(!entryCache) {
+		std::unordered_map<std::string, DirEntry> cache;
+		for(uint32_t i = 0; i < num_blocks; i++) {
+			auto block = co_await accessDirectoryBlock(i);
+
+			size_t offset = 0;
+			while(offset < fs.blockSize) {
+				auto disk_entry = reinterpret_cast<DiskDirEntry *>(block.data() + offset);
+				assert(disk_entry->recordLength);
+				if(disk_entry->inode)
+					cache.insert({std::string{disk_entry->name, disk_entry->nameLength},
+							toDirEntry(disk_entry)});
+				offset += disk_entry->recordLength;
+			}
+			assert(offset == fs.blockSize);
 		}
+		entryCache = std::move(cache);
+	}
 
-		offset += disk_entry->recordLength;
-		previous_entry = disk_entry;
+	auto it = entryCache->find(std::string{name});
+	if(it == entryCache->end())
+		co_return std::nullopt;
+	co_return it->second;
+}
+
+async::result<void> Inode::insertIndexedEntry(std::string_view name, uint32_t hash,
+		uint32_t ino, uint8_t type, std::vector<DxFrame> &frames) {
+	auto leaf = co_await accessDirectoryBlock(frames.back().at->block & dxBlockMask);
+	if(insertIntoBlock(leaf.data(), fs.blockSize, name, ino, type))
+		co_return;
+
+	// The leaf needs to be split. Before doing that, make sure that
+	// the index has room for another entry.
+	auto isFull = [] (DxFrame &frame) {
+		auto count_limit = frame.countLimit();
+		return count_limit->count >= count_limit->limit;
+	};
+
+	auto info = reinterpret_cast<DiskDxRoot *>(frames[0].block.data() + dxRootInfoOffset);
+	if(isFull(frames.back())) {
+		if(frames.size() == 1) {
+			// Add another level by moving the entries of the root to a new interior block.
+			auto &root = frames[0];
+			auto node_block = co_await appendDirectoryBlock();
+			auto node_entries = initDxNode(node_block.data(), fs.blockSize);
+
+			auto count = root.countLimit()->count;
+			node_entries[0].block = root.entries[0].block;
+			memcpy(node_entries + 1, root.entries + 1, (count - 1) * sizeof(DiskDxEntry));
+			reinterpret_cast<DiskDxCountLimit *>(node_entries)->count = count;
+
+			root.entries[0].block = node_block.index;
+			root.countLimit()->count = 1;
+			info->indirectLevels = 1;
+
+			auto at = node_entries + (root.at - root.entries);
+			root.at = root.entries;
+			frames.push_back({std::move(node_block), node_entries, at});
+		}else{
+			assert(frames.size() == 2);
+			auto &root = frames[0];
+			auto &node = frames[1];
+			if(isFull(root))
+				throw std::runtime_error("ext2fs: Directory index is full");
+
+			// Move the upper half of the interior block to a new sibling.
+			auto sibling_block = co_await appendDirectoryBlock();
+			auto sibling_entries = initDxNode(sibling_block.data(), fs.blockSize);
+
+			auto count = node.countLimit()->count;
+			auto half = count / 2;
+			auto split_hash = node.entries[half].hash;
+			sibling_entries[0].block = node.entries[half].block;
+			memcpy(sibling_entries + 1, node.entries + half + 1,
+					(count - half - 1) * sizeof(DiskDxEntry));
+			reinterpret_cast<DiskDxCountLimit *>(sibling_entries)->count = count - half;
+			node.countLimit()->count = half;
+
+			insertDxEntry(root.entries, root.at, split_hash, sibling_block.index);
+			if(node.at >= node.entries + half) {
+				auto at = sibling_entries + (node.at - node.entries - half);
+				root.at++;
+				node = DxFrame{std::move(sibling_block), sibling_entries, at};
+			}
+		}
+	}
+
+	// Split the leaf at the median hash.
+	auto version = info->hashVersion;
+	auto records = collectRecords(leaf.data(), fs.blockSize, [&] (const std::string &n) {
+		return fs.hashName(n, version).first;
+	});
+	std::sort(records.begin(), records.end(), [] (const auto &a, const auto &b) {
+		return a.hash < b.hash;
+	});
+	auto split = records.size() / 2;
+	if(!split)
+		throw std::runtime_error("ext2fs: Cannot split directory leaf");
+
+	// If entries with the same hash end up in both leaves, bit 0 of the
+	// index entry signals that the lookup has to continue into the new leaf.
+	auto split_hash = records[split].hash;
+	uint32_t continued = records[split - 1].hash == split_hash;
+
+	auto sibling = co_await appendDirectoryBlock();
+	writeRecords(leaf.data(), fs.blockSize, records.data(), records.data() + split);
+	writeRecords(sibling.data(), fs.blockSize,
+			records.data() + split, records.data() + records.size());
+	auto &frame = frames.back();
+	insertDxEntry(frame.entries, frame.at, split_hash + continued, sibling.index);
+
+	auto &target = (hash >= split_hash) ? sibling : leaf;
+	if(!insertIntoBlock(target.data(), fs.blockSize, name, ino, type))
+		throw std::runtime_error("Not enough space for ext2fs directory entry");
+}
+
+async::result<bool> Inode::insertLinearEntry(std::string_view name,
+		uint32_t ino, uint8_t type) {
+	uint32_t num_blocks = fileSize() >> fs.blockShift;
+	for(uint32_t i = 0; i < num_blocks; i++) {
+		auto block = co_await accessDirectoryBlock(i);
+		if(insertIntoBlock(block.data(), fs.blockSize, name, ino, type))
+			co_return true;
+	}
+
+	// Convert the directory to an indexed one instead of growing it linearly.
+	if(fs.dirIndex && num_blocks == 1)
+		co_return false;
+
+	auto block = co_await appendDirectoryBlock();
+	if(!insertIntoBlock(block.data(), fs.blockSize, name, ino, type))
+		throw std::runtime_error("Not enough space for ext2fs directory entry");
+	co_return true;
+}
+
+async::result<bool> Inode::removeIndexedEntry(std::string_view name,
+		uint32_t hash, std::vector<DxFrame> &frames) {
+	while(true) {
+		auto leaf = co_await accessDirectoryBlock(frames.back().at->block & dxBlockMask);
+		if(removeFromBlock(leaf.data(), fs.blockSize, name))
+			co_return true;
+
+		if(!(co_await nextIndexLeaf(hash, frames)))
+			co_return false;
 	}
-	assert(offset == fileSize());
+}
 
-	throw std::runtime_error("Given link does not exist");
+async::result<bool> Inode::removeLinearEntry(std::string_view name) {
+	uint32_t num_blocks = fileSize() >> fs.blockShift;
+	for(uint32_t i = 0; i < num_blocks; i++) {
+		auto block = co_await accessDirectoryBlock(i);
+		if(removeFromBlock(block.data(), fs.blockSize, name))
+			co_return true;
+	}
+	co_return false;
+}
+
+async::result<void> Inode::buildIndex() {
+	assert(fileSize() == fs.blockSize);
+	auto version = fs.defaultHashVersion;
+
+	auto root_block = co_await accessDirectoryBlock(0);
+
+	// The directory starts with "." and "..", which stay in the first block.
+	auto dot_entry = reinterpret_cast<DiskDirEntry *>(root_block.data());
+	assert(dot_entry->nameLength == 1 && dot_entry->name[0] == '.');
+	auto dot_dot_entry = reinterpret_cast<DiskDirEntry *>(root_block.data()
+			+ dot_entry->recordLength);
+	assert(dot_dot_entry->nameLength == 2 && !memcmp(dot_dot_entry->name, "..", 2));
+	auto dot_inode = dot_entry->inode;
+	auto dot_dot_inode = dot_dot_entry->inode;
+
+	// Move all other entries to a new leaf.
+	auto records = collectRecords(root_block.data(), fs.blockSize, [&] (const std::string &n) {
+		return fs.hashName(n, version).first;
+	});
+	records.erase(std::remove_if(records.begin(), records.end(), [] (const auto &record) {
+		return record.name == "." || record.name == "..";
+	}), records.end());
+	std::sort(records.begin(), records.end(), [] (const auto &a, const auto &b) {
+		return a.hash < b.hash;
+	});
+
+	auto leaf = co_await appendDirectoryBlock();
+	writeRecords(leaf.data(), fs.blockSize, records.data(), records.data() + records.size());
+
+	// Turn the first block into the root of the index.
+	memset(root_block.data(), 0, fs.blockSize);
+
+	dot_entry->inode = dot_inode;
+	dot_entry->recordLength = entryLength(1);
+	dot_entry->nameLength = 1;
+	dot_entry->fileType = EXT2_FT_DIR;
+	memcpy(dot_entry->name, ".", 1);
+
+	dot_dot_entry = reinterpret_cast<DiskDirEntry *>(root_block.data() + entryLength(1));
+	dot_dot_entry->inode = dot_dot_inode;
+	dot_dot_entry->recordLength = fs.blockSize - entryLength(1);
+	dot_dot_entry->nameLength = 2;
+	dot_dot_entry->fileType = EXT2_FT_DIR;
+	memcpy(dot_dot_entry->name, "..", 2);
+
+	auto info = reinterpret_cast<DiskDxRoot *>(root_block.data() + dxRootInfoOffset);
+	info->hashVersion = version;
+	info->infoLength = sizeof(DiskDxRoot);
+
+	auto root_entries = reinterpret_cast<DiskDxEntry *>(root_block.data() + dxRootEntriesOffset);
+	auto count_limit = reinterpret_cast<DiskDxCountLimit *>(root_entries);
+	count_limit->limit = (fs.blockSize - dxRootEntriesOffset) / sizeof(DiskDxEntry);
+	count_limit->count = 1;
+	root_entries[0].block = leaf.index;
+
+	diskInode()->flags |= EXT2_INDEX_FL;
+	auto syncInode = co_await helix_ng::synchronizeSpace(
+			helix::BorrowedDescriptor{kHelNullHandle},
+			diskMapping.get(), fs.inodeSize);
+	HEL_CHECK(syncInode.error());
+
+	entryCache.reset();
 }
 
 async::result<std::optional<DirEntry>> Inode::mkdir(std::string name) {
@@ -309,10 +993,10 @@ FileSystem::FileSystem(BlockDevice *device)
 
 async::result<void> FileSystem::init() {
 	std::vector<uint8_t> buffer(1024);
-	co_await device->readSectors(2, buffer.data(), 2);
+	checkIo(co_await device->readSectors(2, buffer.data(), 2));
 
-	DiskSuperblock sb;
-	memcpy(&sb, buffer.data(), sizeof(DiskSuperblock));
+	memcpy(&superblock, buffer.data(), sizeof(DiskSuperblock));
+	auto &sb = superblock;
 	assert(sb.magic == 0xEF53);
 
 	inodeSize = sb.inodeSize;
@@ -324,8 +1008,14 @@ async::result<void> FileSystem::init() {
 	inodesPerGroup = sb.inodesPerGroup;
 	blocksCount = sb.blocksCount;
 	inodesCount = sb.inodesCount;
+	firstDataBlock = sb.firstDataBlock;
 	numBlockGroups = (sb.blocksCount + (sb.blocksPerGroup - 1)) / sb.blocksPerGroup;
 
+	dirIndex = sb.featureCompat & EXT2_FEATURE_COMPAT_DIR_INDEX;
+	memcpy(hashSeed, sb.hashSeed, sizeof(hashSeed));
+	defaultHashVersion = sb.defHashVersion <= DX_HASH_TEA ? sb.defHashVersion : DX_HASH_HALF_MD4;
+	unsignedHash = sb.flags & EXT2_FLAGS_UNSIGNED_HASH;
+
 	if(logSuperblock) {
 		std::cout << "ext2fs: Revision is: " << sb.revLevel << std::endl;
 		std::cout << "ext2fs: Block size is: " << blockSize << std::endl;
@@ -346,8 +1036,12 @@ async::result<void> FileSystem::init() {
 	blockGroupDescriptorBuffer = malloc(bgdt_size);
 
 	auto bgdt_offset = (2048 + blockSize - 1) & ~size_t(blockSize - 1);
-	co_await device->readSectors((bgdt_offset >> blockShift) * sectorsPerBlock,
-			blockGroupDescriptorBuffer, bgdt_size / 512);
+	blockGroupDescriptorSector = (bgdt_offset >> blockShift) * sectorsPerBlock;
+	checkIo(co_await device->readSectors(blockGroupDescriptorSector,
+			blockGroupDescriptorBuffer, bgdt_size / 512));
+	dirtyDescriptorSectors.resize(bgdt_size / 512);
+
+	blockGroups.resize(numBlockGroups);
 
 	// Create memory bundles to manage the block and inode bitmaps.
 	HelHandle block_bitmap_frontal, inode_bitmap_frontal;
@@ -375,6 +1069,14 @@ async::result<void> FileSystem::init() {
 	co_return;
 }
 
+std::pair<uint32_t, uint32_t> FileSystem::hashName(std::string_view name, int version) {
+	if(unsignedHash)
+		return computeHash(reinterpret_cast<const unsigned char *>(name.data()),
+				name.size(), version, hashSeed);
+	return computeHash(reinterpret_cast<const signed char *>(name.data()),
+			name.size(), version, hashSeed);
+}
+
 async::detached FileSystem::manageBlockBitmap(helix::UniqueDescriptor memory) {
 	while(true) {
 		helix::ManageMemory manage;
@@ -396,8 +1098,8 @@ async::detached FileSystem::manageBlockBitmap(helix::UniqueDescriptor memory) {
 		if(manage.type() == kHelManageInitialize) {
 			helix::Mapping bitmap_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->readSectors(block * sectorsPerBlock,
-					bitmap_map.get(), sectorsPerBlock);
+			checkIo(co_await device->readSectors(block * sectorsPerBlock,
+					bitmap_map.get(), sectorsPerBlock));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageInitialize,
 					manage.offset(), manage.length()));
 		}else{
@@ -405,8 +1107,8 @@ async::detached FileSystem::manageBlockBitmap(helix::UniqueDescriptor memory) {
 
 			helix::Mapping bitmap_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->writeSectors(block * sectorsPerBlock,
-					bitmap_map.get(), sectorsPerBlock);
+			checkIo(co_await device->writeSectors(block * sectorsPerBlock,
+					bitmap_map.get(), sectorsPerBlock));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageWriteback,
 					manage.offset(), manage.length()));
 		}
@@ -434,8 +1136,8 @@ async::detached FileSystem::manageInodeBitmap(helix::UniqueDescriptor memory) {
 		if(manage.type() == kHelManageInitialize) {
 			helix::Mapping bitmap_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->readSectors(block * sectorsPerBlock,
-					bitmap_map.get(), sectorsPerBlock);
+			checkIo(co_await device->readSectors(block * sectorsPerBlock,
+					bitmap_map.get(), sectorsPerBlock));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageInitialize,
 					manage.offset(), manage.length()));
 		}else{
@@ -443,8 +1145,8 @@ async::detached FileSystem::manageInodeBitmap(helix::UniqueDescriptor memory) {
 
 			helix::Mapping bitmap_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->writeSectors(block * sectorsPerBlock,
-					bitmap_map.get(), sectorsPerBlock);
+			checkIo(co_await device->writeSectors(block * sectorsPerBlock,
+					bitmap_map.get(), sectorsPerBlock));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageWriteback,
 					manage.offset(), manage.length()));
 		}
@@ -472,8 +1174,8 @@ async::detached FileSystem::manageInodeTable(helix::UniqueDescriptor memory) {
 		if(manage.type() == kHelManageInitialize) {
 			helix::Mapping table_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->readSectors(block * sectorsPerBlock + bg_offset / 512,
-					table_map.get(), manage.length() / 512);
+			checkIo(co_await device->readSectors(block * sectorsPerBlock + bg_offset / 512,
+					table_map.get(), manage.length() / 512));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageInitialize,
 					manage.offset(), manage.length()));
 		}else{
@@ -481,8 +1183,8 @@ async::detached FileSystem::manageInodeTable(helix::UniqueDescriptor memory) {
 
 			helix::Mapping table_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->writeSectors(block * sectorsPerBlock + bg_offset / 512,
-					table_map.get(), manage.length() / 512);
+			checkIo(co_await device->writeSectors(block * sectorsPerBlock + bg_offset / 512,
+					table_map.get(), manage.length() / 512));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageWriteback,
 					manage.offset(), manage.length()));
 		}
@@ -787,60 +1489,250 @@ async::detached FileSystem::manageIndirect(std::shared_ptr<Inode> inode,
 		if (manage.type() == kHelManageInitialize) {
 			helix::Mapping out_map{memory,
 					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->readSectors(block * sectorsPerBlock,
-					out_map.get(), sectorsPerBlock);
+			checkIo(co_await device->readSectors(block * sectorsPerBlock,
+					out_map.get(), sectorsPerBlock));
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageInitialize,
 					manage.offset(), manage.length()));
 		} else {
 			assert(manage.type() == kHelManageWriteback);
 
-			helix::Mapping out_map{memory,
-					static_cast<ptrdiff_t>(manage.offset()), manage.length()};
-			co_await device->writeSectors(block * sectorsPerBlock,
-					out_map.get(), sectorsPerBlock);
+			// truncate() frees indirect blocks and resets their block numbers to zero;
+			// their contents do not need to be written back anymore.
+			if(block) {
+				helix::Mapping out_map{memory,
+						static_cast<ptrdiff_t>(manage.offset()), manage.length()};
+				checkIo(co_await device->writeSectors(block * sectorsPerBlock,
+						out_map.get(), sectorsPerBlock));
+			}
 			HEL_CHECK(helUpdateMemory(memory.getHandle(), kHelManageWriteback,
 					manage.offset(), manage.length()));
-
 		}
 	}
 }
 
-async::result<uint32_t> FileSystem::allocateBlock() {
-	for(uint32_t bg_idx = 0; bg_idx < numBlockGroups; bg_idx++) {
-		helix::LockMemoryView lock_bitmap;
-		auto &&submit_bitmap = helix::submitLockMemoryView(blockBitmap,
-				&lock_bitmap,
-				bg_idx << blockPagesShift, 1 << blockPagesShift,
-				helix::Dispatcher::global());
-		co_await submit_bitmap.async_wait();
-		HEL_CHECK(lock_bitmap.error());
+async::result<void> FileSystem::loadFreeExtents(uint32_t bg_idx) {
+	auto group = &blockGroups[bg_idx];
+	if(group->extentsLoaded)
+		co_return;
 
-		helix::Mapping bitmap_map{blockBitmap,
-				bg_idx << blockPagesShift, size_t{1} << blockPagesShift,
-				kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+	helix::LockMemoryView lock_bitmap;
+	auto &&submit_bitmap = helix::submitLockMemoryView(blockBitmap,
+			&lock_bitmap,
+			bg_idx << blockPagesShift, 1 << blockPagesShift,
+			helix::Dispatcher::global());
+	co_await submit_bitmap.async_wait();
+	HEL_CHECK(lock_bitmap.error());
 
-		// TODO: Update the block group descriptor table.
+	// Another allocation might have loaded the group while we were waiting.
+	if(group->extentsLoaded)
+		co_return;
 
-		auto words = reinterpret_cast<uint32_t *>(bitmap_map.get());
-		for(int i = 0; i < (blocksPerGroup + 31) / 32; i++) {
-			if(words[i] == 0xFFFFFFFF)
+	group->bitmapLock = lock_bitmap.descriptor();
+	group->bitmapMapping = helix::Mapping{blockBitmap,
+			bg_idx << blockPagesShift, size_t{1} << blockPagesShift,
+			kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+
+	// The last group can be smaller than blocksPerGroup.
+	auto num_blocks = std::min(blocksPerGroup,
+			blocksCount - firstDataBlock - bg_idx * blocksPerGroup);
+
+	// Collect runs of zero bits. Skip full and empty words as a whole.
+	auto words = reinterpret_cast<uint32_t *>(group->bitmapMapping.get());
+	uint32_t num_free = 0;
+	uint32_t run_start = 0;
+	bool in_run = false;
+	uint32_t k = 0;
+	while(k < num_blocks) {
+		auto word = words[k / 32];
+		if(!(k & 31) && k + 32 <= num_blocks) {
+			if(word == 0xFFFFFFFF) {
+				if(in_run) {
+					group->freeExtents.emplace(run_start, k - run_start);
+					num_free += k - run_start;
+					in_run = false;
+				}
+				k += 32;
+				continue;
+			}else if(!word) {
+				if(!in_run) {
+					run_start = k;
+					in_run = true;
+				}
+				k += 32;
 				continue;
-			for(int j = 0; j < 32; j++) {
-				if(words[i] & (static_cast<uint32_t>(1) << j))
-					continue;
-				// TODO: Make sure we never return reserved blocks.
-				// TODO: Make sure we never return blocks higher than the max. block in the SB.
-				auto block = bg_idx * blocksPerGroup + i * 32 + j;
-				assert(block);
-				assert(block < blocksCount);
-				words[i] |= static_cast<uint32_t>(1) << j;
-				co_return block;
 			}
-			assert(!"Failed to find zero-bit");
 		}
+
+		bool used = word & (static_cast<uint32_t>(1) << (k & 31));
+		if(!used && !in_run) {
+			run_start = k;
+			in_run = true;
+		}else if(used && in_run) {
+			group->freeExtents.emplace(run_start, k - run_start);
+			num_free += k - run_start;
+			in_run = false;
+		}
+		k++;
 	}
+	if(in_run) {
+		group->freeExtents.emplace(run_start, num_blocks - run_start);
+		num_free += num_blocks - run_start;
+	}
+	group->extentsLoaded = true;
 
-	co_return 0;
+	// The bitmap is authoritative; fix up the counts if the descriptor disagrees.
+	auto bgdt = (DiskGroupDesc *)blockGroupDescriptorBuffer;
+	if(bgdt[bg_idx].freeBlocksCount != num_free)
+		adjustFreeBlocks(bg_idx, int64_t{num_free} - bgdt[bg_idx].freeBlocksCount);
+}
+
+void FileSystem::adjustFreeBlocks(uint32_t bg_idx, int64_t delta) {
+	auto bgdt = (DiskGroupDesc *)blockGroupDescriptorBuffer;
+	assert(bgdt[bg_idx].freeBlocksCount + delta >= 0);
+	bgdt[bg_idx].freeBlocksCount += delta;
+	dirtyDescriptorSectors[bg_idx * sizeof(DiskGroupDesc) / 512] = true;
+
+	// The superblock count might be stale if the file system was not unmounted cleanly.
+	if(superblock.freeBlocksCount + delta < 0) {
+		superblock.freeBlocksCount = 0;
+	}else{
+		superblock.freeBlocksCount += delta;
+	}
+	superblockDirty = true;
+}
+
+async::result<void> FileSystem::writeAllocationCounts() {
+	// Write runs of dirty descriptor sectors with a single writeSectors() each.
+	size_t sector = 0;
+	while(sector < dirtyDescriptorSectors.size()) {
+		if(!dirtyDescriptorSectors[sector]) {
+			sector++;
+			continue;
+		}
+
+		// Clear the flags before writing: changes made during the write mark them again.
+		size_t n = 0;
+		while(sector + n < dirtyDescriptorSectors.size() && dirtyDescriptorSectors[sector + n]) {
+			dirtyDescriptorSectors[sector + n] = false;
+			n++;
+		}
+		checkIo(co_await device->writeSectors(blockGroupDescriptorSector + sector,
+				reinterpret_cast<char *>(blockGroupDescriptorBuffer) + sector * 512, n));
+		sector += n;
+	}
+
+	if(superblockDirty) {
+		superblockDirty = false;
+		checkIo(co_await device->writeSectors(2, &superblock, 2));
+	}
+}
+
+async::result<std::pair<uint32_t, uint32_t>> FileSystem::allocateBlocks(uint32_t goal,
+		uint32_t num_blocks) {
+	assert(num_blocks);
+	if(goal < firstDataBlock || goal >= blocksCount)
+		goal = firstDataBlock;
+	auto goal_bg = (goal - firstDataBlock) / blocksPerGroup;
+
+	auto bgdt = (DiskGroupDesc *)blockGroupDescriptorBuffer;
+	for(uint32_t i = 0; i < numBlockGroups; i++) {
+		auto bg_idx = (goal_bg + i) % numBlockGroups;
+		if(!bgdt[bg_idx].freeBlocksCount)
+			continue;
+		co_await loadFreeExtents(bg_idx);
+
+		auto group = &blockGroups[bg_idx];
+		if(group->freeExtents.empty())
+			continue;
+
+		// Prefer the extent that contains the goal, then the next extent after it.
+		uint32_t start = 0;
+		auto it = group->freeExtents.end();
+		if(!i) {
+			auto bg_goal = (goal - firstDataBlock) % blocksPerGroup;
+			it = group->freeExtents.upper_bound(bg_goal);
+			if(it != group->freeExtents.begin()) {
+				auto pred = std::prev(it);
+				if(pred->first + pred->second > bg_goal) {
+					it = pred;
+					start = bg_goal;
+				}
+			}
+			if(it != group->freeExtents.end() && it->first > bg_goal)
+				start = it->first;
+		}
+		if(it == group->freeExtents.end()) {
+			it = group->freeExtents.begin();
+			start = it->first;
+		}
+
+		// Carve the allocated blocks out of the extent.
+		auto extent_start = it->first;
+		auto extent_end = it->first + it->second;
+		auto count = std::min(num_blocks, extent_end - start);
+		group->freeExtents.erase(it);
+		if(start > extent_start)
+			group->freeExtents.emplace(extent_start, start - extent_start);
+		if(start + count < extent_end)
+			group->freeExtents.emplace(start + count, extent_end - (start + count));
+
+		auto words = reinterpret_cast<uint32_t *>(group->bitmapMapping.get());
+		for(uint32_t k = start; k < start + count; k++) {
+			assert(!(words[k / 32] & (static_cast<uint32_t>(1) << (k & 31))));
+			words[k / 32] |= static_cast<uint32_t>(1) << (k & 31);
+		}
+
+		adjustFreeBlocks(bg_idx, -int64_t{count});
+
+		auto block = firstDataBlock + bg_idx * blocksPerGroup + start;
+		assert(block);
+		assert(block + count <= blocksCount);
+		co_return std::pair<uint32_t, uint32_t>{block, count};
+	}
+
+	co_return std::pair<uint32_t, uint32_t>{0, 0};
+}
+
+async::result<void> FileSystem::freeBlocks(uint32_t block, uint32_t num_blocks) {
+	assert(block >= firstDataBlock);
+	assert(block + num_blocks <= blocksCount);
+
+	while(num_blocks) {
+		auto bg_idx = (block - firstDataBlock) / blocksPerGroup;
+		auto start = (block - firstDataBlock) % blocksPerGroup;
+		auto count = std::min(num_blocks, blocksPerGroup - start);
+		co_await loadFreeExtents(bg_idx);
+
+		auto group = &blockGroups[bg_idx];
+		auto words = reinterpret_cast<uint32_t *>(group->bitmapMapping.get());
+		for(uint32_t k = start; k < start + count; k++) {
+			assert(words[k / 32] & (static_cast<uint32_t>(1) << (k & 31)));
+			words[k / 32] &= ~(static_cast<uint32_t>(1) << (k & 31));
+		}
+
+		// Insert the extent and merge it with its neighbors.
+		auto extent_start = start;
+		auto extent_end = start + count;
+		auto it = group->freeExtents.lower_bound(start);
+		if(it != group->freeExtents.end() && it->first == extent_end) {
+			extent_end += it->second;
+			it = group->freeExtents.erase(it);
+		}
+		if(it != group->freeExtents.begin()) {
+			auto pred = std::prev(it);
+			assert(pred->first + pred->second <= extent_start);
+			if(pred->first + pred->second == extent_start) {
+				extent_start = pred->first;
+				group->freeExtents.erase(pred);
+			}
+		}
+		group->freeExtents.emplace(extent_start, extent_end - extent_start);
+
+		adjustFreeBlocks(bg_idx, count);
+
+		block += count;
+		num_blocks -= count;
+	}
 }
 
 async::result<uint32_t> FileSystem::allocateInode() {
@@ -895,29 +1787,56 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 
 	auto disk_inode = inode->diskInode();
 
+	// Try to place new blocks right after the preceding block of the file.
+	// For the first block of a file, start at the inode's block group.
+	uint32_t goal = firstDataBlock + ((inode->number - 1) / inodesPerGroup) * blocksPerGroup;
+	auto updateGoal = [&] (uint32_t block) {
+		if(block)
+			goal = block + 1;
+	};
+
+	// Fills the free slots in list[begin, end) with newly allocated blocks.
+	// Allocates runs of contiguous blocks where possible.
+	auto fillSlots = [&] (uint32_t *list, size_t begin, size_t end) -> async::result<void> {
+		size_t idx = begin;
+		while(idx < end) {
+			if(list[idx]) {
+				updateGoal(list[idx]);
+				idx++;
+				continue;
+			}
+
+			size_t n = 1;
+			while(idx + n < end && !list[idx + n])
+				n++;
+
+			auto [block, count] = co_await allocateBlocks(goal, n);
+			assert(block && "Out of disk space"); // TODO: Fix this.
+			for(size_t k = 0; k < count; k++)
+				list[idx + k] = block + k;
+			updateGoal(block + count - 1);
+			idx += count;
+		}
+	};
+
+	if(block_offset && block_offset <= i_range)
+		updateGoal(disk_inode->data.blocks.direct[block_offset - 1]);
+
 	size_t prg = 0;
 	while(prg < num_blocks) {
 		if(block_offset + prg < i_range) {
-			while(prg < num_blocks
-					&& block_offset + prg < i_range) {
-				auto idx = block_offset + prg;
-				if(disk_inode->data.blocks.direct[idx]) {
-					prg++;
-					continue;
-				}
-				auto block = co_await allocateBlock();
-				assert(block && "Out of disk space"); // TODO: Fix this.
-				disk_inode->data.blocks.direct[idx] = block;
-				prg++;
-			}
+			auto end = std::min(block_offset + num_blocks, i_range);
+			co_await fillSlots(disk_inode->data.blocks.direct, block_offset + prg, end);
+			prg = end - block_offset;
 		}else if(block_offset + prg < s_range) {
 			bool needsReset = false;
 
 			// Allocate the single-indirect block itself.
 			if(!disk_inode->data.blocks.singleIndirect) {
-				auto block = co_await allocateBlock();
+				auto [block, count] = co_await allocateBlocks(goal, 1);
 				assert(block && "Out of disk space"); // TODO: Fix this.
 				disk_inode->data.blocks.singleIndirect = block;
+				updateGoal(block);
 				needsReset = true;
 			}
 
@@ -936,18 +1855,12 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 			if(needsReset)
 				memset(window, 0, size_t{1} << blockPagesShift);
 
-			while(prg < num_blocks
-					&& block_offset + prg < s_range) {
-				auto idx = block_offset + prg - i_range;
-				if(window[idx]) {
-					prg++;
-					continue;
-				}
-				auto block = co_await allocateBlock();
-				assert(block && "Out of disk space"); // TODO: Fix this.
-				window[idx] = block;
-				prg++;
-			}
+			auto idx = block_offset + prg - i_range;
+			if(idx)
+				updateGoal(window[idx - 1]);
+			auto end = std::min(block_offset + num_blocks, s_range);
+			co_await fillSlots(window, idx, end - i_range);
+			prg = end - block_offset;
 		}else if(block_offset + prg < d_range) {
 			assert(!"TODO: Implement allocation in double indirect blocks");
 		}else{
@@ -955,6 +1868,8 @@ async::result<void> FileSystem::assignDataBlocks(Inode *inode,
 		}
 	}
 
+	co_await writeAllocationCounts();
+
 	auto syncInode = co_await helix_ng::synchronizeSpace(
 			helix::BorrowedDescriptor{kHelNullHandle},
 			inode->diskMapping.get(), inodeSize);
@@ -1041,9 +1956,9 @@ async::result<void> FileSystem::readDataBlocks(std::shared_ptr<Inode> inode,
 //				<< " blocks, starting at " << issue.first << std::endl;
 
 		assert(issue.first);
-		co_await device->readSectors(issue.first * sectorsPerBlock,
+		checkIo(co_await device->readSectors(issue.first * sectorsPerBlock,
 				(uint8_t *)buffer + progress * blockSize,
-				issue.second * sectorsPerBlock);
+				issue.second * sectorsPerBlock));
 		progress += issue.second;
 	}
 }
@@ -1130,9 +2045,9 @@ async::result<void> FileSystem::writeDataBlocks(std::shared_ptr<Inode> inode,
 //				<< " blocks, starting at " << issue.first << std::endl;
 
 		assert(issue.first);
-		co_await device->writeSectors(issue.first * sectorsPerBlock,
+		checkIo(co_await device->writeSectors(issue.first * sectorsPerBlock,
 				(const uint8_t *)buffer + progress * blockSize,
-				issue.second * sectorsPerBlock);
+				issue.second * sectorsPerBlock));
 		progress += issue.second;
 	}
 }
@@ -1141,6 +2056,67 @@ async::result<void> FileSystem::writeDataBlocks(std::shared_ptr<Inode> inode,
 async::result<void> FileSystem::truncate(Inode *inode, size_t size) {
 	HEL_CHECK(helResizeMemory(inode->backingMemory,
 			(size + 0xFFF) & ~size_t(0xFFF)));
+
+	// Free the data blocks past the new end of the file. Blocks that share a page with
+	// the remaining data are kept, as the page cache may still write them back.
+	size_t per_indirect = blockSize / 4;
+	size_t i_range = 12;
+	size_t s_range = i_range + per_indirect;
+
+	auto disk_inode = inode->diskInode();
+	auto keep_size = (size + (size_t{1} << blockPagesShift) - 1)
+			& ~((size_t{1} << blockPagesShift) - 1);
+	auto keep_blocks = keep_size >> blockShift;
+
+	// Frees all blocks in list[begin, end), fusing runs of consecutive blocks.
+	auto releaseSlots = [&] (uint32_t *list, size_t begin, size_t end) -> async::result<void> {
+		size_t idx = begin;
+		while(idx < end) {
+			if(!list[idx]) {
+				idx++;
+				continue;
+			}
+
+			size_t n = 1;
+			while(idx + n < end && list[idx + n] == list[idx] + n)
+				n++;
+
+			co_await freeBlocks(list[idx], n);
+			for(size_t k = 0; k < n; k++)
+				list[idx + k] = 0;
+			idx += n;
+		}
+	};
+
+	if(keep_blocks < i_range)
+		co_await releaseSlots(disk_inode->data.blocks.direct, keep_blocks, i_range);
+
+	if(keep_blocks < s_range && disk_inode->data.blocks.singleIndirect) {
+		helix::LockMemoryView lock_indirect;
+		auto &&submit = helix::submitLockMemoryView(inode->indirectOrder1,
+				&lock_indirect, 0, 1 << blockPagesShift,
+				helix::Dispatcher::global());
+		co_await submit.async_wait();
+		HEL_CHECK(lock_indirect.error());
+
+		helix::Mapping indirect_map{inode->indirectOrder1,
+				0, size_t{1} << blockPagesShift,
+				kHelMapProtRead | kHelMapProtWrite | kHelMapDontRequireBacking};
+		auto window = reinterpret_cast<uint32_t *>(indirect_map.get());
+
+		co_await releaseSlots(window, std::max(keep_blocks, i_range) - i_range, per_indirect);
+
+		// The indirect block itself is no longer needed if no data block remains in it.
+		if(keep_blocks <= i_range) {
+			co_await freeBlocks(disk_inode->data.blocks.singleIndirect, 1);
+			disk_inode->data.blocks.singleIndirect = 0;
+		}
+	}
+
+	// TODO: Free blocks in double and triple indirect blocks once we allocate them.
+
+	co_await writeAllocationCounts();
+
 	inode->setFileSize(size);
 	auto syncInode = co_await helix_ng::synchronizeSpace(
 			helix::BorrowedDescriptor{kHelNullHandle},
@@ -1156,6 +2132,46 @@ async::result<void> FileSystem::truncate(Inode *inode, size_t size) {
 OpenFile::OpenFile(std::shared_ptr<Inode> inode)
 : inode(inode), offset(0) { }
 
+void OpenFile::readahead(uint64_t read_offset, size_t length) {
+	auto read_end = read_offset + length;
+	if(read_offset != readaheadExpected) {
+		// Non-sequential access: stop readahead until the file is streamed again.
+		readaheadExpected = read_end;
+		readaheadWindow = 0;
+		readaheadEnd = 0;
+		return;
+	}
+	readaheadExpected = read_end;
+
+	auto page_end = (read_end + (pageSize - 1)) & ~uint64_t(pageSize - 1);
+	if(!readaheadWindow) {
+		readaheadWindow = std::clamp((length * 4 + (pageSize - 1)) & ~size_t(pageSize - 1),
+				minReadahead, maxReadahead);
+		readaheadEnd = page_end;
+	}else if(read_end + readaheadWindow / 2 < readaheadEnd) {
+		// The reader has not yet reached the second half of the current window.
+		return;
+	}else{
+		readaheadWindow = std::min(readaheadWindow * 2, maxReadahead);
+	}
+
+	auto file_end = (inode->fileSize() + (pageSize - 1)) & ~uint64_t(pageSize - 1);
+	auto ra_begin = std::max(readaheadEnd, page_end);
+	auto ra_end = std::min(ra_begin + readaheadWindow, file_end);
+	if(ra_begin >= ra_end)
+		return;
+
+	// The kernel fuses the range into large initialization requests; those are
+	// served by manageFileData() while the reader consumes the current window.
+	// truncate() shrinks the memory object before it updates the file size, hence
+	// the range can exceed the object; as readahead is only a hint, ignore that.
+	auto error = helLoadahead(inode->frontalMemory, ra_begin, ra_end - ra_begin);
+	if(error == kHelErrOutOfBounds || error == kHelErrIllegalArgs)
+		return;
+	HEL_CHECK(error);
+	readaheadEnd = ra_end;
+}
+
 async::result<std::optional<std::string>>
 OpenFile::readEntries() {
 	co_await inode->readyJump.async_wait();
@@ -1200,5 +2216,61 @@ OpenFile::readEntries() {
 	co_return std::nullopt;
 }
 
+async::result<protocols::fs::ReadResult>
+OpenFile::readEntryBatch(void *buffer, size_t max_length) {
+	co_await inode->readyJump.async_wait();
+
+	if(inode->fileType != kTypeDirectory)
+		co_return protocols::fs::Error::illegalArguments;
+
+	// Directory records never cross block boundaries. Hence, we only need to
+	// lock and map a block-aligned window of the page cache instead of the whole directory.
+	auto granularity = std::max(size_t{inode->fs.blockSize}, pageSize);
+	auto window_size = std::max(entryWindowSize, granularity);
+
+	size_t length = 0;
+	assert(offset <= inode->fileSize());
+	while(offset < inode->fileSize()) {
+		auto window_offset = offset & ~uint64_t(granularity - 1);
+		auto window_end = std::min(window_offset + window_size, inode->fileSize());
+		auto map_size = (window_end - window_offset + (pageSize - 1)) & ~(pageSize - 1);
+
+		helix::LockMemoryView lock_memory;
+		auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(inode->frontalMemory),
+				&lock_memory, window_offset, map_size, helix::Dispatcher::global());
+		co_await submit.async_wait();
+		HEL_CHECK(lock_memory.error());
+
+		helix::Mapping window_map{helix::BorrowedDescriptor{inode->frontalMemory},
+				static_cast<ptrdiff_t>(window_offset), map_size,
+				kHelMapProtRead | kHelMapDontRequireBacking};
+
+		while(offset < window_end) {
+			assert(!(offset & 3));
+			assert(offset + sizeof(DiskDirEntry) <= window_end);
+			auto disk_entry = reinterpret_cast<DiskDirEntry *>(
+					reinterpret_cast<char *>(window_map.get()) + (offset - window_offset));
+			assert(disk_entry->recordLength);
+			assert(offset + disk_entry->recordLength <= window_end);
+
+			if(disk_entry->inode) {
+				if(!protocols::fs::appendEntryRecord(buffer, max_length, length,
+						disk_entry->inode, entryTypeToDirent(disk_entry->fileType),
+						std::string_view{disk_entry->name, disk_entry->nameLength})) {
+					// Return the entry on the next call.
+					if(!length)
+						co_return protocols::fs::Error::illegalArguments;
+					co_return length;
+				}
+			}
+
+			offset += disk_entry->recordLength;
+		}
+	}
+	assert(offset == inode->fileSize());
+
+	co_return length;
+}
+
 } } // namespace blockfs::ext2fs
 
@@ -2,14 +2,18 @@
 #include <string.h>
 #include <time.h>
 #include <optional>
+#include <map>
 #include <memory>
 #include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <protocols/fs/common.hpp>
 #include <protocols/fs/file-locks.hpp>
 
 #include <async/jump.hpp>
 #include <async/doorbell.hpp>
+#include <async/mutex.hpp>
 #include <hel.h>
 
 #include <blockfs.hpp>
@@ -92,10 +96,28 @@ struct DiskSuperblock {
 	//-- Other options --
 	uint32_t defaultMountOptions;
 	uint32_t firstMetaBg;
-	uint8_t unused[760];
+	uint32_t mkfsTime;
+	uint32_t journalBlocks[17];
+	//-- 64-bit Support --
+	uint32_t blocksCountHi;
+	uint32_t rBlocksCountHi;
+	uint32_t freeBlocksCountHi;
+	uint16_t minExtraIsize;
+	uint16_t wantExtraIsize;
+	uint32_t flags;
+	uint8_t unused[668];
 };
 static_assert(sizeof(DiskSuperblock) == 1024, "Bad DiskSuperblock struct size");
 
+enum {
+	EXT2_FEATURE_COMPAT_DIR_INDEX = 0x20
+};
+
+enum {
+	EXT2_FLAGS_SIGNED_HASH = 1,
+	EXT2_FLAGS_UNSIGNED_HASH = 2
+};
+
 struct DiskGroupDesc {
 	uint32_t blockBitmap;
 	uint32_t inodeBitmap;
@@ -134,6 +156,10 @@ enum {
 	EXT2_ROOT_INO = 2
 };
 
+enum {
+	EXT2_INDEX_FL = 0x1000
+};
+
 enum {
 	EXT2_S_IFMT = 0xF000,
 	EXT2_S_IFLNK = 0xA000,
@@ -155,6 +181,39 @@ enum {
 	EXT2_FT_SYMLINK = 7
 };
 
+// Hashed directory indices (HTree) are stored in directory blocks that look like
+// empty directory blocks to implementations that do not support them.
+// The root block starts with "." and "..", followed by DiskDxRoot.
+// Interior blocks start with an unused DiskDirEntry that spans the whole block.
+// In both cases, the header is followed by an array of DiskDxEntry that is sorted by hash.
+// The hash of the first DiskDxEntry is replaced by a DiskDxCountLimit.
+
+enum {
+	DX_HASH_LEGACY = 0,
+	DX_HASH_HALF_MD4 = 1,
+	DX_HASH_TEA = 2
+};
+
+struct DiskDxRoot {
+	uint32_t reservedZero;
+	uint8_t hashVersion;
+	uint8_t infoLength;
+	uint8_t indirectLevels;
+	uint8_t unusedFlags;
+};
+static_assert(sizeof(DiskDxRoot) == 8, "Bad DiskDxRoot struct size");
+
+struct DiskDxCountLimit {
+	uint16_t limit;
+	uint16_t count;
+};
+
+struct DiskDxEntry {
+	uint32_t hash;
+	uint32_t block;
+};
+static_assert(sizeof(DiskDxEntry) == 8, "Bad DiskDxEntry struct size");
+
 // --------------------------------------------------------
 // DirEntry
 // --------------------------------------------------------
@@ -170,6 +229,19 @@ struct DirEntry {
 
 struct FileSystem;
 
+// A block of a directory that is locked in the page cache and mapped.
+struct DirectoryBlock {
+	char *data() {
+		return reinterpret_cast<char *>(mapping.get()) + offset;
+	}
+
+	uint32_t index;
+	helix::UniqueDescriptor lock;
+	helix::Mapping mapping;
+	// Offset of the block inside the (page-aligned) mapping.
+	size_t offset;
+};
+
 struct Inode : std::enable_shared_from_this<Inode> {
 	Inode(FileSystem &fs, uint32_t number);
 
@@ -194,6 +266,45 @@ struct Inode : std::enable_shared_from_this<Inode> {
 	async::result<std::optional<DirEntry>> symlink(std::string name, std::string target);
 	async::result<protocols::fs::Error> chmod(int mode);
 
+private:
+	// One step of the path from the root of a directory index to a leaf.
+	struct DxFrame {
+		DiskDxCountLimit *countLimit() {
+			return reinterpret_cast<DiskDxCountLimit *>(entries);
+		}
+
+		DirectoryBlock block;
+		DiskDxEntry *entries;
+		DiskDxEntry *at;
+	};
+
+	bool isIndexed();
+	async::result<DirectoryBlock> accessDirectoryBlock(uint32_t index);
+	// Appends an empty block to the directory.
+	async::result<DirectoryBlock> appendDirectoryBlock();
+	async::result<void> dropIndex();
+
+	// Hashes the name and walks the directory index down to the leaf that can contain it.
+	// Returns false if the index is not valid; callers fall back to a linear scan.
+	async::result<bool> probeIndex(std::string_view name, uint32_t &hash,
+			std::vector<DxFrame> &frames);
+	// Advances the frames to the next leaf if it may contain entries with the given hash.
+	async::result<bool> nextIndexLeaf(uint32_t hash, std::vector<DxFrame> &frames);
+
+	async::result<std::optional<DirEntry>> findIndexedEntry(std::string_view name,
+			uint32_t hash, std::vector<DxFrame> &frames);
+	async::result<std::optional<DirEntry>> findLinearEntry(std::string_view name);
+	async::result<void> insertIndexedEntry(std::string_view name, uint32_t hash,
+			uint32_t ino, uint8_t type, std::vector<DxFrame> &frames);
+	// Returns false if the directory should be converted to an indexed directory instead.
+	async::result<bool> insertLinearEntry(std::string_view name, uint32_t ino, uint8_t type);
+	async::result<bool> removeIndexedEntry(std::string_view name,
+			uint32_t hash, std::vector<DxFrame> &frames);
+	async::result<bool> removeLinearEntry(std::string_view name);
+	// Converts a directory that consists of a single block to an indexed directory.
+	async::result<void> buildIndex();
+
+public:
 	FileSystem &fs;
 
 	// ext2fs on-disk inode number
@@ -229,6 +340,13 @@ struct Inode : std::enable_shared_from_this<Inode> {
 
 	FileType fileType;
 
+	// Serializes modifications and lookups of directories.
+	async::mutex directoryMutex;
+
+	// Maps names to entries for large directories without index.
+	// This is only populated once a lookup needs to scan such a directory.
+	std::optional<std::unordered_map<std::string, DirEntry>> entryCache;
+
 	int numLinks; // number of links to this file
 	int uid, gid;
 	struct timespec accessTime;
@@ -242,6 +360,19 @@ struct Inode : std::enable_shared_from_this<Inode> {
 // --------------------------------------------------------
 
 struct FileSystem {
+	// In-memory allocation state of a single block group.
+	struct BlockGroup {
+		// Whether the fields below have been initialized from the block bitmap.
+		bool extentsLoaded = false;
+
+		// Keeps the block bitmap of this group locked and mapped.
+		helix::UniqueDescriptor bitmapLock;
+		helix::Mapping bitmapMapping;
+
+		// Maps the first block of each free extent (relative to the group) to its length.
+		std::map<uint32_t, uint32_t> freeExtents;
+	};
+
 	FileSystem(BlockDevice *device);
 
 	async::result<void> init();
@@ -264,9 +395,19 @@ struct FileSystem {
 	async::detached manageIndirect(std::shared_ptr<Inode> inode, int order,
 			helix::UniqueDescriptor memory);
 
-	async::result<uint32_t> allocateBlock();
+	// Allocates up to num_blocks contiguous blocks. Tries to start at the goal block,
+	// or otherwise close to it. Returns the first block and the number of allocated blocks.
+	async::result<std::pair<uint32_t, uint32_t>> allocateBlocks(uint32_t goal,
+			uint32_t num_blocks);
+	async::result<void> freeBlocks(uint32_t block, uint32_t num_blocks);
 	async::result<uint32_t> allocateInode();
 
+	async::result<void> loadFreeExtents(uint32_t bg_idx);
+	// Adjusts the free block counts of the group descriptor and the superblock.
+	// The change is written to disk by the next writeAllocationCounts().
+	void adjustFreeBlocks(uint32_t bg_idx, int64_t delta);
+	async::result<void> writeAllocationCounts();
+
 	async::result<void> assignDataBlocks(Inode *inode,
 			uint64_t block_offset, size_t num_blocks);
 
@@ -277,6 +418,10 @@ struct FileSystem {
 
 	async::result<void> truncate(Inode *inode, size_t size);
 
+	// Computes the major and minor hash of a directory entry name.
+	// Whether characters are signed is determined by the superblock.
+	std::pair<uint32_t, uint32_t> hashName(std::string_view name, int version);
+
 	BlockDevice *device;
 	uint16_t inodeSize;
 	uint32_t blockShift;
@@ -288,7 +433,22 @@ struct FileSystem {
 	uint32_t inodesPerGroup;
 	uint32_t blocksCount;
 	uint32_t inodesCount;
+	uint32_t firstDataBlock;
+	// Whether new directory indices may be created.
+	bool dirIndex;
+	uint32_t hashSeed[4];
+	int defaultHashVersion;
+	bool unsignedHash;
 	void *blockGroupDescriptorBuffer;
+	uint64_t blockGroupDescriptorSector;
+	// Sectors of the block group descriptor table that were changed in memory.
+	std::vector<bool> dirtyDescriptorSectors;
+
+	// In-memory copy of the superblock. Only the free block count is updated.
+	DiskSuperblock superblock;
+	bool superblockDirty = false;
+
+	std::vector<BlockGroup> blockGroups;
 
 	helix::UniqueDescriptor blockBitmap;
 	helix::UniqueDescriptor inodeBitmap;
@@ -306,9 +466,22 @@ struct OpenFile {
 
 	async::result<std::optional<std::string>> readEntries();
 
+	// Fills the buffer with as many entries as possible (see protocols::fs::EntryRecord).
+	async::result<protocols::fs::ReadResult> readEntryBatch(void *buffer, size_t max_length);
+
+	// Called on each read. Detects sequential reads and issues readahead for them.
+	void readahead(uint64_t offset, size_t length);
+
 	std::shared_ptr<Inode> inode;
 	uint64_t offset;
 	Flock flock;
+
+	// Offset at which the next sequential read is expected to start.
+	uint64_t readaheadExpected = 0;
+	// Size of the next readahead window. Zero if no readahead is in progress.
+	size_t readaheadWindow = 0;
+	// End of the range that readahead was already issued for.
+	uint64_t readaheadEnd = 0;
 };
 
 } } // namespace blockfs::ext2fs
@@ -1,6 +1,7 @@
 
 #include <stdlib.h>
 #include <iostream>
+#include <stdexcept>
 
 #include "gpt.hpp"
 
@@ -19,7 +20,8 @@ async::result<void> Table::parse() {
 
 	auto header_buffer = malloc(512);
 	assert(header_buffer);
-	co_await getDevice()->readSectors(1, header_buffer, 1);
+	if(!(co_await getDevice()->readSectors(1, header_buffer, 1)))
+		throw std::runtime_error("gpt: I/O error while reading the GPT header");
 	
 	DiskHeader *header = (DiskHeader *)header_buffer;
 	assert(header->signature == 0x5452415020494645); // TODO: handle this error
@@ -31,7 +33,8 @@ async::result<void> Table::parse() {
 
 	auto table_buffer = malloc(table_sectors * 512);
 	assert(table_buffer);
-	co_await getDevice()->readSectors(2, table_buffer, table_sectors);
+	if(!(co_await getDevice()->readSectors(2, table_buffer, table_sectors)))
+		throw std::runtime_error("gpt: I/O error while reading the partition table");
 	
 	for(uint32_t i = 0; i < header->numEntries; i++) {
 		DiskEntry *entry = (DiskEntry *)((char *)table_buffer + i * header->entrySize);
@@ -72,13 +75,13 @@ Guid Partition::type() {
 	return _type;
 }
 
-async::result<void> Partition::readSectors(uint64_t sector, void *buffer, size_t count) {
+async::result<bool> Partition::readSectors(uint64_t sector, void *buffer, size_t count) {
 	assert(sector + count <= _numSectors);
 	return _table.getDevice()->readSectors(_startLba + sector,
 			buffer, count);
 }
 
-async::result<void> Partition::writeSectors(uint64_t sector, const void *buffer, size_t count) {
+async::result<bool> Partition::writeSectors(uint64_t sector, const void *buffer, size_t count) {
 	assert(sector + count <= _numSectors);
 	return _table.getDevice()->writeSectors(_startLba + sector,
 			buffer, count);
@@ -96,16 +96,20 @@ struct Partition : public BlockDevice {
 	Partition(Table &table, Guid id, Guid type,
 			uint64_t start_lba, uint64_t num_sectors);
 
-	async::result<void> readSectors(uint64_t sector, void *buffer,
+	async::result<bool> readSectors(uint64_t sector, void *buffer,
 			size_t num_sectors) override;
 
-	async::result<void> writeSectors(uint64_t sector, const void *buffer,
+	async::result<bool> writeSectors(uint64_t sector, const void *buffer,
 			size_t num_sectors) override;
 
 	Guid id();
 
 	Guid type();
 
+	uint64_t numSectors() {
+		return _numSectors;
+	}
+
 private:
 	Table &_table;
 	Guid _id;
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <iostream>
 #include <algorithm>
+#include <vector>
 #include <sys/epoll.h>
 
 #include <helix/ipc.hpp>
@@ -75,6 +76,8 @@ async::result<protocols::fs::ReadResult> read(void *object, const char *,
 	helix::LockMemoryView lock_memory;
 	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(self->inode->frontalMemory),
 			&lock_memory, map_offset, map_size, helix::Dispatcher::global());
+	// Issue readahead after the lock such that the current range is loaded first.
+	self->readahead(chunk_offset, chunk_size);
 	co_await submit.async_wait();
 	HEL_CHECK(lock_memory.error());
 
@@ -110,6 +113,8 @@ async::result<protocols::fs::ReadResult> pread(void *object, int64_t offset, con
 	helix::LockMemoryView lock_memory;
 	auto &&submit = helix::submitLockMemoryView(helix::BorrowedDescriptor(self->inode->frontalMemory),
 			&lock_memory, map_offset, map_size, helix::Dispatcher::global());
+	// Issue readahead after the lock such that the current range is loaded first.
+	self->readahead(chunk_offset, chunk_size);
 	co_await submit.async_wait();
 	HEL_CHECK(lock_memory.error());
 
@@ -123,13 +128,14 @@ async::result<protocols::fs::ReadResult> pread(void *object, int64_t offset, con
 	co_return chunk_size;
 }
 
-async::result<void> write(void *object, const char *,
+async::result<protocols::fs::WriteResult> write(void *object, const char *,
 		const void *buffer, size_t length) {
 	assert(length);
 
 	auto self = static_cast<ext2fs::OpenFile *>(object);
 	co_await self->inode->fs.write(self->inode.get(), self->offset, buffer, length);
 	self->offset += length;
+	co_return length;
 }
 
 async::result<helix::BorrowedDescriptor>
@@ -145,6 +151,12 @@ readEntries(void *object) {
 	co_return co_await self->readEntries();
 }
 
+async::result<protocols::fs::ReadResult>
+readEntryBatch(void *object, void *buffer, size_t max_length) {
+	auto self = static_cast<ext2fs::OpenFile *>(object);
+	co_return co_await self->readEntryBatch(buffer, max_length);
+}
+
 async::result<void>
 truncate(void *object, size_t size) {
 	auto self = static_cast<ext2fs::OpenFile *>(object);
@@ -185,6 +197,7 @@ constexpr protocols::fs::FileOperations fileOperations {
 	.pread        = &pread,
 	.write        = &write,
 	.readEntries  = &readEntries,
+	.readEntryBatch = &readEntryBatch,
 	.accessMemory = &accessMemory,
 	.truncate     = &truncate,
 	.flock        = &flock,
@@ -350,12 +363,92 @@ constexpr protocols::fs::NodeOperations nodeOperations{
 	.chmod = &chmod
 };
 
+// --------------------------------------------------------
+// Raw partition access.
+// --------------------------------------------------------
+
+// File that is opened through the partition's device node. Reads go directly to
+// the disk, bypassing the file system and its page cache. Writes are rejected
+// since the partition is mounted.
+struct RawFile {
+	RawFile(gpt::Partition *partition)
+	: partition{partition}, offset{0} { }
+
+	uint64_t size() {
+		return partition->numSectors() * partition->sectorSize;
+	}
+
+	gpt::Partition *partition;
+	uint64_t offset;
+};
+
+async::result<protocols::fs::SeekResult> rawSeekAbs(void *object, int64_t offset) {
+	auto self = static_cast<RawFile *>(object);
+	self->offset = offset;
+	co_return self->offset;
+}
+
+async::result<protocols::fs::SeekResult> rawSeekRel(void *object, int64_t offset) {
+	auto self = static_cast<RawFile *>(object);
+	self->offset += offset;
+	co_return self->offset;
+}
+
+async::result<protocols::fs::SeekResult> rawSeekEof(void *object, int64_t offset) {
+	auto self = static_cast<RawFile *>(object);
+	self->offset = self->size() + offset;
+	co_return self->offset;
+}
+
+async::result<protocols::fs::ReadResult> rawPread(void *object, int64_t offset,
+		const char *, void *buffer, size_t length) {
+	auto self = static_cast<RawFile *>(object);
+	auto sector_size = self->partition->sectorSize;
+	if(offset < 0)
+		co_return protocols::fs::Error::illegalArguments;
+	if(static_cast<uint64_t>(offset) >= self->size())
+		co_return 0;
+	length = std::min(length, self->size() - offset);
+
+	// Read whole sectors and copy out the requested range.
+	auto first = offset / sector_size;
+	auto last = (offset + length + sector_size - 1) / sector_size;
+	std::vector<char> sectors((last - first) * sector_size);
+	if(!(co_await self->partition->readSectors(first, sectors.data(), last - first)))
+		co_return protocols::fs::Error::ioError;
+	memcpy(buffer, sectors.data() + (offset - first * sector_size), length);
+	co_return length;
+}
+
+async::result<protocols::fs::ReadResult> rawRead(void *object, const char *credentials,
+		void *buffer, size_t length) {
+	auto self = static_cast<RawFile *>(object);
+	auto result = co_await rawPread(object, self->offset, credentials, buffer, length);
+	if(auto size = std::get_if<size_t>(&result); size)
+		self->offset += *size;
+	co_return result;
+}
+
+async::result<protocols::fs::WriteResult> rawWrite(void *, const char *,
+		const void *, size_t) {
+	co_return protocols::fs::Error::illegalArguments;
+}
+
+constexpr protocols::fs::FileOperations rawFileOperations {
+	.seekAbs      = &rawSeekAbs,
+	.seekRel      = &rawSeekRel,
+	.seekEof      = &rawSeekEof,
+	.read         = &rawRead,
+	.pread        = &rawPread,
+	.write        = &rawWrite,
+};
+
 } // anonymous namespace
 
 BlockDevice::BlockDevice(size_t sector_size)
 : sectorSize(sector_size) { }
 
-async::detached servePartition(helix::UniqueLane lane) {
+async::detached servePartition(helix::UniqueLane lane, gpt::Partition *partition) {
 	std::cout << "unix device: Connection" << std::endl;
 
 	while(true) {
@@ -371,7 +464,26 @@ async::detached servePartition(helix::UniqueLane lane) {
 
 		managarm::fs::CntRequest req;
 		req.ParseFromArray(recv_req.data(), recv_req.length());
-		if(req.req_type() == managarm::fs::CntReqType::DEV_MOUNT) {
+		if(req.req_type() == managarm::fs::CntReqType::DEV_OPEN) {
+			auto file = smarter::make_shared<RawFile>(partition);
+
+			helix::UniqueLane local_lane, remote_lane;
+			std::tie(local_lane, remote_lane) = helix::createStream();
+			async::detach(protocols::fs::servePassthrough(std::move(local_lane),
+					file, &rawFileOperations));
+
+			managarm::fs::SvrResponse resp;
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp, push_pt] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::pushDescriptor(remote_lane)
+			);
+			HEL_CHECK(send_resp.error());
+			HEL_CHECK(push_pt.error());
+		}else if(req.req_type() == managarm::fs::CntReqType::DEV_MOUNT) {
 			helix::UniqueLane local_lane, remote_lane;
 			std::tie(local_lane, remote_lane) = helix::createStream();
 			protocols::fs::serveNode(std::move(local_lane), fs->accessRoot(),
@@ -471,10 +583,11 @@ async::detached runDevice(BlockDevice *device) {
 		};
 
 		auto handler = mbus::ObjectHandler{}
-		.withBind([] () -> async::result<helix::UniqueDescriptor> {
+		.withBind([partition = &table->getPartition(i)] ()
+				-> async::result<helix::UniqueDescriptor> {
 			helix::UniqueLane local_lane, remote_lane;
 			std::tie(local_lane, remote_lane) = helix::createStream();
-			servePartition(std::move(local_lane));
+			servePartition(std::move(local_lane), partition);
 
 			async::promise<helix::UniqueDescriptor> promise;
 			promise.set_value(std::move(remote_lane));
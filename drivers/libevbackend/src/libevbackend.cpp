@@ -132,7 +132,8 @@ File::read(void *object, const char *, void *buffer, size_t max_size) {
 	}
 }
 
-async::result<void> File::write(void *, const char *, const void *, size_t) {
+async::result<protocols::fs::WriteResult>
+File::write(void *, const char *, const void *, size_t) {
 	throw std::runtime_error("write not yet implemented");
 }
 
@@ -1,18 +1,29 @@
 #include <nic/virtio/virtio.hpp>
 
 #include <arch/dma_pool.hpp>
+#include <async/doorbell.hpp>
 #include <core/virtio/core.hpp>
+#include <deque>
+#include <thread>
+#include <vector>
 
 namespace {
 // Device feature bits.
-constexpr size_t legacyHeaderSize = 10;
 enum {
-	VIRTIO_NET_F_MAC = 5
+	VIRTIO_NET_F_CSUM = 0,
+	VIRTIO_NET_F_GUEST_CSUM = 1,
+	VIRTIO_NET_F_MAC = 5,
+	VIRTIO_NET_F_GUEST_TSO4 = 7,
+	VIRTIO_NET_F_HOST_TSO4 = 11,
+	VIRTIO_NET_F_MRG_RXBUF = 15,
+	VIRTIO_NET_F_CTRL_VQ = 17,
+	VIRTIO_NET_F_MQ = 22
 };
 
 // Bits for VirtHeader::flags.
 enum {
-	VIRTIO_NET_HDR_F_NEEDS_CSUM = 1
+	VIRTIO_NET_HDR_F_NEEDS_CSUM = 1,
+	VIRTIO_NET_HDR_F_DATA_VALID = 2
 };
 
 // Values for VirtHeader::gsoType.
@@ -24,6 +35,28 @@ enum {
 	VIRTIO_NET_HDR_GSO_ECN = 0x80
 };
 
+// Classes and commands of the control virtq.
+enum {
+	VIRTIO_NET_CTRL_MQ = 4,
+	VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET = 0
+};
+
+// Values of the ack byte of control commands.
+enum {
+	VIRTIO_NET_OK = 0
+};
+
+// Size of VirtHeader without numBuffers; only used by legacy devices
+// if VIRTIO_NET_F_MRG_RXBUF is not negotiated.
+constexpr size_t legacyHeaderSize = 10;
+
+// Size of receive buffers if VIRTIO_NET_F_MRG_RXBUF is negotiated.
+constexpr size_t mergeableBufferSize = 2048;
+
+namespace regs {
+	inline constexpr arch::scalar_register<uint16_t> maxQueuePairs{8};
+}
+
 struct VirtHeader {
 	uint8_t flags;
 	uint8_t gsoType;
@@ -34,18 +67,60 @@ struct VirtHeader {
 	uint16_t numBuffers;
 };
 
+struct CtrlHeader {
+	uint8_t cls;
+	uint8_t command;
+};
+
+struct ReceiveBuffer;
+
+struct ReceiveQueue {
+	virtio_core::Queue *vq;
+
+	// Buffers that the device returned, in the order in which the device used them.
+	std::deque<ReceiveBuffer *> used;
+	async::doorbell usedDoorbell;
+};
+
+struct ReceiveBuffer : virtio_core::Request {
+	ReceiveQueue *queue;
+	arch::dma_buffer buffer;
+};
+
 struct VirtioNic : nic::Link {
 	VirtioNic(std::unique_ptr<virtio_core::Transport> transport);
 
-	virtual async::result<void> receive(arch::dma_buffer_view) override;
-	virtual async::result<void> send(const arch::dma_buffer_view) override;
+	virtual async::result<nic::ReceivedFrame> receive() override;
+	virtual async::result<void> send(const arch::dma_buffer_view,
+			const nic::TxOffload &offload) override;
 
 	virtual ~VirtioNic() override = default;
 private:
+	// Posts a new buffer to a receive virtq. Does not notify the device.
+	async::result<void> postReceiveBuffer_(ReceiveQueue *queue);
+	// Keeps a receive virtq filled and turns used buffers into frames.
+	async::detached processReceiveQueue_(ReceiveQueue *queue);
+	// Asks the device to distribute traffic over numPairs virtq pairs.
+	async::detached enableQueuePairs_(unsigned int numPairs);
+
+	// Picks the transmit virtq for a frame. Frames of the same flow always use the same
+	// virtq, such that they are not reordered.
+	virtio_core::Queue *steerTransmit_(const arch::dma_buffer_view frame);
+
 	std::unique_ptr<virtio_core::Transport> transport_;
 	arch::contiguous_pool dmaPool_;
-	virtio_core::Queue *receiveVq_;
-	virtio_core::Queue *transmitVq_;
+	std::vector<std::unique_ptr<ReceiveQueue>> receiveQueues_;
+	std::vector<virtio_core::Queue *> transmitVqs_;
+	virtio_core::Queue *controlVq_ = nullptr;
+	// Number of virtq pairs that the device currently uses.
+	unsigned int activePairs_ = 1;
+	size_t headerSize_;
+	size_t receiveBufferSize_;
+	bool mergeable_ = false;
+
+	// Frames that were received but not yet returned by receive().
+	std::deque<nic::ReceivedFrame> received_;
+	async::doorbell receivedDoorbell_;
 };
 
 VirtioNic::VirtioNic(std::unique_ptr<virtio_core::Transport> transport)
@@ -64,47 +139,239 @@ VirtioNic::VirtioNic(std::unique_ptr<virtio_core::Transport> transport)
 		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_MAC);
 	}
 
+	if(transport_->checkDeviceFeature(VIRTIO_NET_F_MRG_RXBUF)) {
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_MRG_RXBUF);
+		mergeable_ = true;
+	}
+
+	// Checksum offloads. TSO requires both checksum offloading and (for the receive
+	// direction) mergeable buffers, otherwise we would have to post 64 KiB buffers.
+	if(transport_->checkDeviceFeature(VIRTIO_NET_F_CSUM)) {
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_CSUM);
+		caps_.transmitChecksum = true;
+		if(transport_->checkDeviceFeature(VIRTIO_NET_F_HOST_TSO4)) {
+			transport_->acknowledgeDriverFeature(VIRTIO_NET_F_HOST_TSO4);
+			caps_.tcpSegmentation = true;
+			caps_.maxSegmentationSize = 14 + 0xFFFF;
+		}
+	}
+	if(transport_->checkDeviceFeature(VIRTIO_NET_F_GUEST_CSUM)) {
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_GUEST_CSUM);
+		caps_.receiveChecksum = true;
+		if(mergeable_ && transport_->checkDeviceFeature(VIRTIO_NET_F_GUEST_TSO4))
+			transport_->acknowledgeDriverFeature(VIRTIO_NET_F_GUEST_TSO4);
+	}
+
+	// Use one virtq pair per CPU. Multiple pairs require the control virtq.
+	unsigned int max_pairs = 1;
+	unsigned int num_pairs = 1;
+	if(transport_->checkDeviceFeature(VIRTIO_NET_F_MQ)
+			&& transport_->checkDeviceFeature(VIRTIO_NET_F_CTRL_VQ)) {
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_MQ);
+		transport_->acknowledgeDriverFeature(VIRTIO_NET_F_CTRL_VQ);
+		max_pairs = std::max<unsigned int>(1, transport_->space().load(regs::maxQueuePairs));
+		num_pairs = max_pairs;
+		if(auto num_cpus = std::thread::hardware_concurrency(); num_cpus)
+			num_pairs = std::min(num_pairs, num_cpus);
+	}
+
+	if(mergeable_ || transport_->checkDeviceFeature(virtio_core::VIRTIO_F_VERSION_1)) {
+		headerSize_ = sizeof(VirtHeader);
+	}else{
+		headerSize_ = legacyHeaderSize;
+	}
+	receiveBufferSize_ = mergeable_ ? mergeableBufferSize : headerSize_ + 1514;
+
 	transport_->finalizeFeatures();
-	transport_->claimQueues(2);
-	receiveVq_ = transport_->setupQueue(0);
-	transmitVq_ = transport_->setupQueue(1);
+	if(max_pairs > 1) {
+		// The control virtq follows all receive and transmit virtqs.
+		transport_->claimQueues(2 * max_pairs + 1);
+	}else{
+		transport_->claimQueues(2);
+	}
+	for(unsigned int i = 0; i < num_pairs; i++) {
+		auto queue = std::make_unique<ReceiveQueue>();
+		queue->vq = transport_->setupQueue(2 * i);
+		receiveQueues_.push_back(std::move(queue));
+		transmitVqs_.push_back(transport_->setupQueue(2 * i + 1));
+	}
+	if(max_pairs > 1)
+		controlVq_ = transport_->setupQueue(2 * max_pairs);
 
 	transport_->runDevice();
+
+	for(auto &queue : receiveQueues_)
+		processReceiveQueue_(queue.get());
+	if(num_pairs > 1)
+		enableQueuePairs_(num_pairs);
 }
 
-async::result<void> VirtioNic::receive(arch::dma_buffer_view frame) {
-	arch::dma_object<VirtHeader> header { &dmaPool_ };
+async::result<void> VirtioNic::postReceiveBuffer_(ReceiveQueue *queue) {
+	auto request = new ReceiveBuffer;
+	request->queue = queue;
+	request->buffer = arch::dma_buffer{&dmaPool_, receiveBufferSize_};
 
 	virtio_core::Chain chain;
-	chain.append(co_await receiveVq_->obtainDescriptor());
-	chain.setupBuffer(virtio_core::deviceToHost,
-			header.view_buffer().subview(0, legacyHeaderSize));
-	chain.append(co_await receiveVq_->obtainDescriptor());
-	chain.setupBuffer(virtio_core::deviceToHost, frame);
+	chain.append(co_await queue->vq->obtainDescriptor());
+	chain.setupBuffer(virtio_core::deviceToHost, request->buffer);
+
+	queue->vq->postDescriptor(chain.front(), request,
+			[] (virtio_core::Request *base_request) {
+		auto request = static_cast<ReceiveBuffer *>(base_request);
+		request->queue->used.push_back(request);
+		request->queue->usedDoorbell.ring();
+	});
+}
 
-	co_await receiveVq_->submitDescriptor(chain.front());
+async::detached VirtioNic::processReceiveQueue_(ReceiveQueue *queue) {
+	auto popUsed = [queue] () -> async::result<ReceiveBuffer *> {
+		while(queue->used.empty())
+			co_await queue->usedDoorbell.async_wait();
+		auto request = queue->used.front();
+		queue->used.pop_front();
+		co_return request;
+	};
 
-	co_return;
+	for(size_t i = 0; i < queue->vq->numDescriptors(); i++)
+		co_await postReceiveBuffer_(queue);
+	queue->vq->notify();
+
+	while(true) {
+		auto first = co_await popUsed();
+		VirtHeader header{};
+		memcpy(&header, first->buffer.data(), headerSize_);
+
+		size_t num_buffers = 1;
+		if(mergeable_)
+			num_buffers = std::max<size_t>(1, header.numBuffers);
+
+		nic::ReceivedFrame frame;
+		frame.checksumValid = caps_.receiveChecksum
+				&& (header.flags & (VIRTIO_NET_HDR_F_DATA_VALID | VIRTIO_NET_HDR_F_NEEDS_CSUM));
+		if(num_buffers == 1) {
+			// Common case: hand the buffer to the caller without copying.
+			frame.frame = first->buffer.subview(headerSize_, first->written - headerSize_);
+			frame.buffer = std::move(first->buffer);
+			delete first;
+		}else{
+			// The frame was split into multiple buffers (e.g., because of GUEST_TSO4).
+			std::vector<ReceiveBuffer *> parts{first};
+			size_t size = first->written - headerSize_;
+			for(size_t i = 1; i < num_buffers; i++) {
+				parts.push_back(co_await popUsed());
+				size += parts.back()->written;
+			}
+
+			frame.buffer = arch::dma_buffer{&dmaPool_, size};
+			size_t progress = 0;
+			for(auto part : parts) {
+				size_t offset = (part == first) ? headerSize_ : 0;
+				memcpy(static_cast<char *>(frame.buffer.data()) + progress,
+						static_cast<char *>(part->buffer.data()) + offset,
+						part->written - offset);
+				progress += part->written - offset;
+				delete part;
+			}
+			frame.frame = frame.buffer.subview(0, size);
+		}
+		received_.push_back(std::move(frame));
+		receivedDoorbell_.ring();
+
+		for(size_t i = 0; i < num_buffers; i++)
+			co_await postReceiveBuffer_(queue);
+		queue->vq->notify();
+	}
 }
 
-async::result<void> VirtioNic::send(const arch::dma_buffer_view payload) {
-	if (payload.size() > 1514) {
+async::detached VirtioNic::enableQueuePairs_(unsigned int numPairs) {
+	arch::dma_object<CtrlHeader> header { &dmaPool_ };
+	arch::dma_object<uint16_t> pairs { &dmaPool_ };
+	arch::dma_object<uint8_t> ack { &dmaPool_ };
+	header.data()->cls = VIRTIO_NET_CTRL_MQ;
+	header.data()->command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+	*pairs.data() = numPairs;
+	*ack.data() = 0xFF;
+
+	virtio_core::Chain chain;
+	chain.append(co_await controlVq_->obtainDescriptor());
+	chain.setupBuffer(virtio_core::hostToDevice, header.view_buffer());
+	chain.append(co_await controlVq_->obtainDescriptor());
+	chain.setupBuffer(virtio_core::hostToDevice, pairs.view_buffer());
+	chain.append(co_await controlVq_->obtainDescriptor());
+	chain.setupBuffer(virtio_core::deviceToHost, ack.view_buffer());
+	co_await controlVq_->submitDescriptor(chain.front());
+
+	if(*ack.data() != VIRTIO_NET_OK) {
+		std::cout << "virtio-driver: Failed to enable " << numPairs
+				<< " queue pairs" << std::endl;
+		co_return;
+	}
+	std::cout << "virtio-driver: Using " << numPairs << " queue pairs" << std::endl;
+	activePairs_ = numPairs;
+}
+
+async::result<nic::ReceivedFrame> VirtioNic::receive() {
+	while(received_.empty())
+		co_await receivedDoorbell_.async_wait();
+	auto frame = std::move(received_.front());
+	received_.pop_front();
+	co_return frame;
+}
+
+virtio_core::Queue *VirtioNic::steerTransmit_(const arch::dma_buffer_view frame) {
+	if(activePairs_ == 1)
+		return transmitVqs_[0];
+
+	// Hash the IPv4 addresses and (for TCP and UDP) the ports.
+	auto data = reinterpret_cast<const uint8_t *>(frame.data());
+	uint32_t hash = 0;
+	if(frame.size() >= 14 + 20 && data[12] == 0x08 && data[13] == 0x00) {
+		auto ip = data + 14;
+		size_t ihl = (ip[0] & 0xF) * 4;
+		for(size_t i = 12; i < 20; i++)
+			hash = hash * 31 + ip[i];
+		if((ip[9] == 6 || ip[9] == 17) && frame.size() >= 14 + ihl + 4) {
+			for(size_t i = 0; i < 4; i++)
+				hash = hash * 31 + ip[ihl + i];
+		}
+	}
+	return transmitVqs_[hash % activePairs_];
+}
+
+async::result<void> VirtioNic::send(const arch::dma_buffer_view payload,
+		const nic::TxOffload &offload) {
+	if (offload.segmentSize) {
+		assert(caps_.tcpSegmentation);
+		if (payload.size() > caps_.maxSegmentationSize) {
+			throw std::runtime_error("data exceeds maximal segmentation size");
+		}
+	} else if (payload.size() > 1514) {
 		throw std::runtime_error("data exceeds mtu");
 	}
 
 	arch::dma_object<VirtHeader> header { &dmaPool_ };
 	memset(header.data(), 0, sizeof(VirtHeader));
+	if (offload.needsChecksum) {
+		assert(caps_.transmitChecksum);
+		header.data()->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		header.data()->csumStart = offload.checksumStart;
+		header.data()->csumOffset = offload.checksumOffset;
+	}
+	if (offload.segmentSize) {
+		header.data()->gsoType = VIRTIO_NET_HDR_GSO_TCPV4;
+		header.data()->hdrLen = offload.headerLength;
+		header.data()->gsoSize = offload.segmentSize;
+	}
 
+	auto vq = steerTransmit_(payload);
 	virtio_core::Chain chain;
-	chain.append(co_await transmitVq_->obtainDescriptor());
+	chain.append(co_await vq->obtainDescriptor());
 	chain.setupBuffer(virtio_core::hostToDevice,
-			header.view_buffer().subview(0, legacyHeaderSize));
-	chain.append(co_await transmitVq_->obtainDescriptor());
-	chain.setupBuffer(virtio_core::hostToDevice, payload);
+			header.view_buffer().subview(0, headerSize_));
+	// Segmentation offload frames can span multiple pages.
+	co_await virtio_core::scatterGather(virtio_core::hostToDevice, chain, vq, payload);
 
-	std::cout << "virtio-driver: sending frame" << std::endl;
-	co_await transmitVq_->submitDescriptor(chain.front());
-	std::cout << "virtio-driver: sent frame" << std::endl;
+	co_await vq->submitDescriptor(chain.front());
 }
 } // namespace
 
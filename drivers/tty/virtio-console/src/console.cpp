@@ -11,6 +11,26 @@
 namespace {
 	helix::UniqueLane kerncfgByteRingLane;
 	async::jump foundKerncfgByteRing;
+
+	// The heap trace consists of records that carry the bytes logged by a single CPU.
+	// This matches thor's LogRecordHeader.
+	struct LogRecordHeader {
+		uint64_t timestamp;
+		uint32_t cpu;
+		uint32_t size;
+	};
+	static_assert(sizeof(LogRecordHeader) == 16);
+
+	// Checks that the chunk consists of whole records.
+	bool validateRecords(const char *data, size_t size) {
+		size_t offset = 0;
+		while(offset + sizeof(LogRecordHeader) <= size) {
+			LogRecordHeader header;
+			memcpy(&header, data + offset, sizeof(LogRecordHeader));
+			offset += sizeof(LogRecordHeader) + header.size;
+		}
+		return offset == size;
+	}
 }
 
 async::result<void> enumerateKerncfgByteRing(const char *purpose) {
@@ -33,6 +53,8 @@ async::result<void> enumerateKerncfgByteRing(const char *purpose) {
 	co_await foundKerncfgByteRing.async_wait();
 }
 
+// Returns the size of the data, the new dequeue index and the number of bytes that were lost.
+// If the dequeue index is stale, no data is returned but the dequeue index is updated.
 async::result<std::tuple<size_t, uint64_t, uint64_t>>
 getKerncfgByteRingPart(arch::dma_buffer_view chunk, uint64_t dequeue) {
 	managarm::kerncfg::CntRequest req;
@@ -52,13 +74,18 @@ getKerncfgByteRingPart(arch::dma_buffer_view chunk, uint64_t dequeue) {
 	HEL_CHECK(offer.error());
 	HEL_CHECK(send_req.error());
 	HEL_CHECK(recv_resp.error());
-	HEL_CHECK(recv_buffer.error());
 
 	managarm::kerncfg::SvrResponse resp;
 	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+	if(resp.error() == managarm::kerncfg::Error::ILLEGAL_ARGUMENTS) {
+		std::cerr << "virtio-console: warning, dequeue index " << dequeue
+				<< " is stale, continuing at " << resp.new_dequeue() << std::endl;
+		co_return std::make_tuple(size_t{0}, resp.new_dequeue(), uint64_t{0});
+	}
 	assert(resp.error() == managarm::kerncfg::Error::SUCCESS);
+	HEL_CHECK(recv_buffer.error());
 
-	co_return std::make_tuple(resp.size(), resp.new_dequeue(), resp.enqueue());
+	co_return std::make_tuple(resp.size(), resp.new_dequeue(), resp.lost());
 }
 
 namespace tty {
@@ -85,20 +112,29 @@ async::detached Device::runDevice() {
 	co_await enumerateKerncfgByteRing("heap-trace");
 
 	uint64_t dequeue = 0;
+	uint64_t reported_lost = 0;
 
 	constexpr size_t chunk_size = 64 * 1024;
 	arch::dma_buffer chunk_buffer{&dmaPool_, chunk_size};
 
 	while (true) {
-		auto [size, new_dequeue, enqueue] = co_await getKerncfgByteRingPart(chunk_buffer, dequeue);
+		auto [size, new_dequeue, lost] = co_await getKerncfgByteRingPart(chunk_buffer, dequeue);
+		dequeue = new_dequeue;
 		if (!size)
 			continue;
 
-		if (dequeue + (256 * 1024 * 1024) < enqueue)
-			std::cerr << "virtio-console: warning, we possibly missed "
-				<< (enqueue - dequeue + (256 * 1024 * 1024)) << " bytes" << std::endl;
+		if (lost > reported_lost) {
+			std::cerr << "virtio-console: warning, we missed "
+				<< (lost - reported_lost) << " bytes" << std::endl;
+			reported_lost = lost;
+		}
 
-		dequeue = new_dequeue;
+		// The host demultiplexes the records by CPU; hence we only forward whole records.
+		if (!validateRecords(reinterpret_cast<const char *>(chunk_buffer.data()), size)) {
+			std::cerr << "virtio-console: warning, dropping chunk with malformed records"
+				<< std::endl;
+			continue;
+		}
 
 		virtio_core::Chain chain;
 		chain.append(co_await txQueue_->obtainDescriptor());
@@ -166,10 +166,13 @@ async::detached StorageDevice::run(int config_num, int intf_num) {
 				std::cout << "block-usb: Error status 0x"
 						<< std::hex << (unsigned int)csw.status << std::dec
 						<<  " in CSW" << std::endl;
-				throw std::runtime_error("block-usb: Giving up");
+				// Status 1 only means that the command failed. Phase errors (status 2)
+				// require a reset recovery, which is not implemented.
+				if(csw.status != 1)
+					throw std::runtime_error("block-usb: Giving up");
 			}
 
-			req->promise.set_value();
+			req->promise.set_value(!csw.status);
 			_queue.pop_front();
 			delete req;
 		}else{
@@ -178,22 +181,22 @@ async::detached StorageDevice::run(int config_num, int intf_num) {
 	}
 }
 
-async::result<void> StorageDevice::readSectors(uint64_t sector,
+async::result<bool> StorageDevice::readSectors(uint64_t sector,
 		void *buffer, size_t numSectors) {
 	auto req = new Request{false, sector, buffer, numSectors};
 	_queue.push_back(*req);
 	auto result = req->promise.async_get();
 	_doorbell.ring();
-	return result;
+	co_return co_await std::move(result);
 }
 
-async::result<void> StorageDevice::writeSectors(uint64_t sector,
+async::result<bool> StorageDevice::writeSectors(uint64_t sector,
 		const void *buffer, size_t numSectors) {
 	auto req = new Request{true, sector, const_cast<void *>(buffer), numSectors};
 	_queue.push_back(*req);
 	auto result = req->promise.async_get();
 	_doorbell.ring();
-	return result;
+	co_return co_await std::move(result);
 }
 
 async::detached bindDevice(mbus::Entity entity) {
@@ -100,10 +100,10 @@ struct StorageDevice : blockfs::BlockDevice {
 
 	async::detached run(int config_num, int intf_num);
 
-	async::result<void> readSectors(uint64_t sector,
+	async::result<bool> readSectors(uint64_t sector,
 			void *buffer, size_t numSectors) override;
 
-	async::result<void> writeSectors(uint64_t sector,
+	async::result<bool> writeSectors(uint64_t sector,
 			const void *buffer, size_t numSectors) override;
 
 private:
@@ -115,7 +115,8 @@ private:
 		uint64_t sector;
 		void *buffer;
 		size_t numSectors;
-		async::promise<void> promise;
+		// The value is false if the device reports an error.
+		async::promise<bool> promise;
 		boost::intrusive::list_member_hook<> requestHook;
 	};
 
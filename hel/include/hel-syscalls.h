@@ -152,6 +152,14 @@ extern inline __attribute__ (( always_inline )) HelError helCreateSpace(HelHandl
 	return error;
 };
 
+extern inline __attribute__ (( always_inline )) HelError helForkSpace(HelHandle handle,
+		HelHandle *out_handle) {
+	HelWord handle_word;
+	HelError error = helSyscall1_1(kHelCallForkSpace, (HelWord)handle, &handle_word);
+	*out_handle = (HelHandle)handle_word;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helCreateVirtualizedSpace(HelHandle *handle) {
 	HelWord handle_word;
 	HelError error = helSyscall0_1(kHelCallCreateVirtualizedSpace, &handle_word);
@@ -341,10 +349,40 @@ extern inline __attribute__ (( always_inline )) HelError helSubmitAsync(HelHandl
 			(HelWord)queue, (HelWord)context, (HelWord)flags);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helSubmitAsyncBatch(
+		const HelSubmission *submissions, size_t count, HelHandle queue,
+		uint32_t flags, size_t *numSubmitted) {
+	HelWord submitted;
+	HelError error = helSyscall4_1(kHelCallSubmitAsyncBatch, (HelWord)submissions,
+			(HelWord)count, (HelWord)queue, (HelWord)flags, &submitted);
+	*numSubmitted = submitted;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helShutdownLane(HelHandle handle) {
 	return helSyscall1(kHelCallShutdownLane, (HelWord)handle);
 };
 
+extern inline __attribute__ (( always_inline )) HelError helCall(HelHandle handle,
+		const void *request, size_t requestLength, void *response, size_t maxResponse,
+		size_t *responseLength) {
+	HelWord length;
+	HelError error = helSyscall5_1(kHelCallCall, (HelWord)handle, (HelWord)request,
+			(HelWord)requestLength, (HelWord)response, (HelWord)maxResponse, &length);
+	*responseLength = length;
+	return error;
+};
+
+extern inline __attribute__ (( always_inline )) HelError helReplyAndWait(HelHandle handle,
+		const void *reply, size_t replyLength, void *request, size_t maxRequest,
+		size_t *requestLength) {
+	HelWord length;
+	HelError error = helSyscall5_1(kHelCallReplyAndWait, (HelWord)handle, (HelWord)reply,
+			(HelWord)replyLength, (HelWord)request, (HelWord)maxRequest, &length);
+	*requestLength = length;
+	return error;
+};
+
 extern inline __attribute__ (( always_inline )) HelError helFutexWait(int *pointer,
 		int expected, int64_t deadline) {
 	return helSyscall3(kHelCallFutexWait, (HelWord)pointer, (HelWord)expected,
@@ -39,6 +39,7 @@ enum {
 	kHelCallCreateSliceView = 88,
 	kHelCallForkMemory = 40,
 	kHelCallCreateSpace = 27,
+	kHelCallForkSpace = 28,
 	kHelCallCreateIndirectMemory = 45,
 	kHelCallAlterMemoryIndirection = 52,
 	kHelCallMapMemory = 44,
@@ -74,6 +75,9 @@ enum {
 	kHelCallCreateStream = 68,
 	kHelCallSubmitAsync = 79,
 	kHelCallShutdownLane = 91,
+	kHelCallCall = 54,
+	kHelCallReplyAndWait = 55,
+	kHelCallSubmitAsyncBatch = 56,
 
 	kHelCallFutexWait = 73,
 	kHelCallFutexWake = 71,
@@ -203,6 +207,11 @@ enum {
 	kHelItemAncillary = 2,
 };
 
+enum {
+	//! Maximal size of requests and responses of helCall() and helReplyAndWait().
+	kHelMaxInlineCall = 128
+};
+
 struct HelSgItem {
 	void *buffer;
 	size_t length;
@@ -217,6 +226,18 @@ struct HelAction {
 	HelHandle handle;
 };
 
+//! One conversation of helSubmitAsyncBatch().
+struct HelSubmission {
+	//! Handle to the lane that messages will be passed to.
+	HelHandle handle;
+	//! Pointer to array of message items.
+	const HelAction *actions;
+	//! Number of elements in @p actions.
+	size_t count;
+	//! Context that is reported in the completion.
+	uintptr_t context;
+};
+
 enum {
 	kHelDescMemory = 1,
 	kHelDescAddressSpace = 2,
@@ -605,6 +626,17 @@ HEL_C_LINKAGE HelError helForkMemory(HelHandle handle, HelHandle *forkedHandle);
 //!     Handle to the new address space.
 HEL_C_LINKAGE HelError helCreateSpace(HelHandle *handle);
 
+//! Forks a virtual address space.
+//!
+//! The new address space contains the same mappings at the same addresses.
+//! Mappings of copy-on-write memory (see ::helCopyOnWrite) are forked
+//! as if by ::helForkMemory; all other memory is shared.
+//! @param[in] handle
+//!     Handle to the address space that is forked.
+//! @param[out] forkedHandle
+//!     Handle to the new address space.
+HEL_C_LINKAGE HelError helForkSpace(HelHandle handle, HelHandle *forkedHandle);
+
 //! Maps memory objects into an address space.
 //! @param[in] memoryHandle
 //!     Handle to the memory object.
@@ -712,6 +744,7 @@ HEL_C_LINKAGE HelError helSubmitLockMemoryView(HelHandle handle, uintptr_t offse
 //!
 //! This acts as a hint to the kernel and is meant purely as a performance optimization.
 //! The kernel is free to ignore it.
+//! @p offset and @p length must be page-aligned.
 //! @param[in] handle
 //!     Handle to the memory object.
 //! @param[in] offset
@@ -854,8 +887,69 @@ HEL_C_LINKAGE HelError helCreateStream(HelHandle *lane1, HelHandle *lane2);
 HEL_C_LINKAGE HelError helSubmitAsync(HelHandle handle, const HelAction *actions,
 		size_t count, HelHandle queue, uintptr_t context, uint32_t flags);
 
+//! Pass messages on multiple streams.
+//!
+//! Equivalent to one helSubmitAsync() call per element of @p submissions
+//! but only enters the kernel once. If a submission fails, all previous
+//! submissions are still performed.
+//! @param[in] submissions
+//!     Pointer to array of conversations.
+//! @param[in] count
+//!     Number of elements in @p submissions.
+//! @param[in] queue
+//!     Queue that receives the completions of all conversations.
+//! @param[out] numSubmitted
+//!     Number of conversations that were submitted successfully.
+HEL_C_LINKAGE HelError helSubmitAsyncBatch(const HelSubmission *submissions,
+		size_t count, HelHandle queue, uint32_t flags, size_t *numSubmitted);
+
 HEL_C_LINKAGE HelError helShutdownLane(HelHandle handle);
 
+//! Perform a synchronous call on a stream.
+//!
+//! This is a fast path for small request/response pairs that avoids the overhead
+//! of helSubmitAsync() and IPC queues. The request is passed to a thread that
+//! waits in helReplyAndWait() on the peer lane; that thread is run on the
+//! caller's CPU. The calling thread blocks until the call is answered.
+//! Synchronous calls do not interact with messages passed by helSubmitAsync().
+//! @param[in] handle
+//!     Handle to the lane that the call is issued on.
+//! @param[in] request
+//!     Pointer to the request. At most ::kHelMaxInlineCall bytes.
+//! @param[in] requestLength
+//!     Length of the request in bytes.
+//! @param[out] response
+//!     Pointer to a buffer that receives the response.
+//! @param[in] maxResponse
+//!     Size of the @p response buffer.
+//! @param[out] responseLength
+//!     Length of the response in bytes.
+HEL_C_LINKAGE HelError helCall(HelHandle handle, const void *request, size_t requestLength,
+		void *response, size_t maxResponse, size_t *responseLength);
+
+//! Answer a synchronous call and wait for the next one.
+//!
+//! Sends @p reply to the caller of the call that this thread received last
+//! on the lane (if any; otherwise the reply is ignored). Afterwards, the thread
+//! blocks until the next call arrives.
+//! If the next request does not fit into @p request (::kHelErrBufferTooSmall)
+//! or cannot be written to it (::kHelErrFault), the call fails with the same
+//! error on the caller's side and no reply is owed for it.
+//! @param[in] handle
+//!     Handle to the lane that calls are received on.
+//! @param[in] reply
+//!     Pointer to the reply. At most ::kHelMaxInlineCall bytes.
+//! @param[in] replyLength
+//!     Length of the reply in bytes.
+//! @param[out] request
+//!     Pointer to a buffer that receives the next request.
+//! @param[in] maxRequest
+//!     Size of the @p request buffer.
+//! @param[out] requestLength
+//!     Length of the next request in bytes.
+HEL_C_LINKAGE HelError helReplyAndWait(HelHandle handle, const void *reply, size_t replyLength,
+		void *request, size_t maxRequest, size_t *requestLength);
+
 //! @}
 //! @name Inter-Thread Synchronization
 //! @{
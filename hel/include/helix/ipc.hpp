@@ -9,6 +9,7 @@
 #include <tuple>
 #include <array>
 #include <stdexcept>
+#include <vector>
 
 #include <async/result.hpp>
 
@@ -927,6 +928,89 @@ auto exchangeMsgs(BorrowedDescriptor descriptor, Args &&...args) {
 	};
 }
 
+// --------------------------------------------------------------------
+// Batched transmissions
+// --------------------------------------------------------------------
+
+// Collects multiple exchangeMsgs() conversations (on arbitrary lanes)
+// and submits them to the kernel using a single helSubmitAsyncBatch() call.
+struct SubmitBatch {
+	SubmitBatch() = default;
+
+	SubmitBatch(const SubmitBatch &) = delete;
+
+	~SubmitBatch() {
+		assert(_submissions.empty() && "SubmitBatch destructed without submit()");
+	}
+
+	SubmitBatch &operator= (const SubmitBatch &) = delete;
+
+	void add(HelSubmission submission) {
+		_submissions.push_back(submission);
+	}
+
+	void submit() {
+		if(_submissions.empty())
+			return;
+
+		size_t submitted;
+		HEL_CHECK(helSubmitAsyncBatch(_submissions.data(), _submissions.size(),
+				Dispatcher::global().acquire(), 0, &submitted));
+		assert(submitted == _submissions.size());
+		_submissions.clear();
+	}
+
+private:
+	std::vector<HelSubmission> _submissions;
+};
+
+// Like Transmission but the actions are only passed to the kernel by SubmitBatch::submit().
+template <typename Results, typename Actions>
+struct BatchedTransmission : private Context {
+	BatchedTransmission(SubmitBatch &batch, BorrowedDescriptor descriptor,
+			Results, Actions actions)
+	: _actions{actions} {
+		auto context = static_cast<Context *>(this);
+		batch.add(HelSubmission{descriptor.getHandle(), _actions.data(), _actions.size(),
+				reinterpret_cast<uintptr_t>(context)});
+	}
+
+	BatchedTransmission(const BatchedTransmission &) = delete;
+
+	BatchedTransmission &operator= (const BatchedTransmission &) = delete;
+
+	auto operator co_await() {
+		using async::operator co_await;
+		return operator co_await(_resultsPromise.async_get());
+	}
+
+private:
+	void complete(ElementHandle element) override {
+		Results results;
+		void *ptr = element.data();
+
+		[&]<size_t ...p>(std::index_sequence<p...>) {
+			(results.template get<p>().parse(ptr, element), ...);
+		} (std::make_index_sequence<std::tuple_size<Results>::value>{});
+
+		_resultsPromise.set_value(std::move(results));
+	}
+
+	// The kernel reads the actions during submit(); hence, we need to keep them alive.
+	Actions _actions;
+	async::promise<decltype(Results{})> _resultsPromise;
+};
+
+template <typename ...Args>
+auto exchangeMsgs(SubmitBatch &batch, BorrowedDescriptor descriptor, Args &&...args) {
+	return BatchedTransmission{
+		batch,
+		std::move(descriptor),
+		createResultsTuple(args...),
+		chainActionArrays(args...)
+	};
+}
+
 // --------------------------------------------------------------------
 // Operations other than exchangeMsgs().
 // --------------------------------------------------------------------
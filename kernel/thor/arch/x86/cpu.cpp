@@ -654,6 +654,9 @@ CpuData *getCpuData(size_t k) {
 }
 
 int getCpuCount() {
+	// The physical allocator asks for the CPUs before the first one is registered.
+	if(!allCpuContexts)
+		return 0;
 	return allCpuContexts->size();
 }
 
@@ -699,6 +702,7 @@ void initializeThisProcessor() {
 	auto cpu_data = getCpuData();
 	
 	// TODO: If we want to make bootSecondary() parallel, we have to lock here.
+	cpu_data->cpuIndex = allCpuContexts->size();
 	allCpuContexts->push(cpu_data);
 
 	// Allocate per-CPU areas.
@@ -758,10 +758,9 @@ void ClientPageSpace::mapSingle4k(VirtualAddr pointer, PhysicalAddr physical,
 	if(tbl4[index4].load() & kPagePresent) {
 		accessor3 = PageAccessor{tbl4[index4].load() & 0x000FFFFFFFFFF000};
 	}else{
-		auto tbl_address = physicalAllocator->allocate(kPageSize);
+		auto tbl_address = physicalAllocator->allocateZeroed(kPageSize);
 		assert(tbl_address != PhysicalAddr(-1) && "OOM");
 		accessor3 = PageAccessor{tbl_address};
-		memset(accessor3.get(), 0, kPageSize);
 
 		uint64_t new_entry = tbl_address | kPagePresent | kPageWrite;
 		if(user_page)
@@ -776,10 +775,9 @@ void ClientPageSpace::mapSingle4k(VirtualAddr pointer, PhysicalAddr physical,
 	if(tbl3[index3].load() & kPagePresent) {
 		accessor2 = PageAccessor{tbl3[index3].load() & 0x000FFFFFFFFFF000};
 	}else{
-		auto tbl_address = physicalAllocator->allocate(kPageSize);
+		auto tbl_address = physicalAllocator->allocateZeroed(kPageSize);
 		assert(tbl_address != PhysicalAddr(-1) && "OOM");
 		accessor2 = PageAccessor{tbl_address};
-		memset(accessor2.get(), 0, kPageSize);
 
 		uint64_t new_entry = tbl_address | kPagePresent | kPageWrite;
 		if(user_page)
@@ -794,10 +792,9 @@ void ClientPageSpace::mapSingle4k(VirtualAddr pointer, PhysicalAddr physical,
 	if(tbl2[index2].load() & kPagePresent) {
 		accessor1 = PageAccessor{tbl2[index2].load() & 0x000FFFFFFFFFF000};
 	}else{
-		auto tbl_address = physicalAllocator->allocate(kPageSize);
+		auto tbl_address = physicalAllocator->allocateZeroed(kPageSize);
 		assert(tbl_address != PhysicalAddr(-1) && "OOM");
 		accessor1 = PageAccessor{tbl_address};
-		memset(accessor1.get(), 0, kPageSize);
 
 		uint64_t new_entry = tbl_address | kPagePresent | kPageWrite;
 		if(user_page)
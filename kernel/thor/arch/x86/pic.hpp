@@ -59,6 +59,8 @@ uint32_t getLocalApicId();
 
 uint64_t localTicks();
 
+uint64_t rdtsc();
+
 void calibrateApicTimer();
 
 void armPreemption(uint64_t nanos);
@@ -466,6 +466,20 @@ smarter::shared_ptr<Mapping> VirtualSpace::getMapping(VirtualAddr address) {
 	return _findMapping(address);
 }
 
+frg::vector<smarter::shared_ptr<Mapping>, KernelAlloc> VirtualSpace::getMappings() {
+	frg::vector<smarter::shared_ptr<Mapping>, KernelAlloc> mappings{*kernelAlloc};
+
+	auto irq_lock = frigg::guard(&irqMutex());
+	auto space_guard = frigg::guard(&_mutex);
+
+	auto mapping = _mappings.first();
+	while(mapping) {
+		mappings.push(mapping->selfPtr.lock());
+		mapping = MappingTree::successor(mapping);
+	}
+	return mappings;
+}
+
 Error VirtualSpace::map(frigg::UnsafePtr<MemorySlice> slice, VirtualAddr address,
 		size_t offset, size_t length, uint32_t flags, VirtualAddr *actual_address) {
 	assert(length);
@@ -219,6 +219,14 @@ struct Mapping : MemoryObserver {
 		return _flags;
 	}
 
+	frigg::SharedPtr<MemorySlice> slice() {
+		return _slice;
+	}
+
+	uintptr_t viewOffset() const {
+		return _viewOffset;
+	}
+
 	void tie(smarter::shared_ptr<VirtualSpace> owner, VirtualAddr address);
 
 	void protect(MappingFlags flags);
@@ -559,6 +567,9 @@ public:
 
 	smarter::shared_ptr<Mapping> getMapping(VirtualAddr address);
 
+	// Returns references to all mappings of this space, ordered by address.
+	frg::vector<smarter::shared_ptr<Mapping>, KernelAlloc> getMappings();
+
 	void setupInitialHole(VirtualAddr address, size_t size);
 
 	Error map(frigg::UnsafePtr<MemorySlice> view,
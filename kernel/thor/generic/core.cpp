@@ -178,28 +178,312 @@ void KernelVirtualAlloc::unmap(uintptr_t address, size_t length) {
 		WorkQueue::post(&p->worklet);
 }
 
-frigg::LazyInitializer<LogRingBuffer> allocLog;
+frigg::LazyInitializer<PerCpuLogRing> allocLog;
 
 void KernelVirtualAlloc::output_trace(uint8_t val) {
 	if (!allocLog)
 		allocLog.initialize(0xFFFF'F000'0000'0000, 268435456);
 
-	allocLog->enqueue(val);
+	// Collect the trace into records to avoid writing a header for each byte.
+	auto irqLock = frigg::guard(&irqMutex());
+	auto cpuData = getCpuData();
+	auto &staging = cpuData->allocLogStaging;
+	staging.buffer[staging.size++] = val;
+	if(staging.size == LogCpuStaging::maxPayload || allocLog->needsFlush(staging)) {
+		allocLog->enqueue(cpuData->cpuIndex, rdtsc(), staging.buffer, staging.size);
+		staging.size = 0;
+	}
 }
 
 frigg::LazyInitializer<PhysicalChunkAllocator> physicalAllocator;
 
 frigg::LazyInitializer<KernelVirtualAlloc> kernelVirtualAlloc;
 
-frigg::LazyInitializer<
-	frg::slab_pool<
-		KernelVirtualAlloc,
-		IrqSpinlock
-	>
-> kernelHeap;
+frigg::LazyInitializer<KernelSlabPool> kernelHeap;
 
 frigg::LazyInitializer<KernelAlloc> kernelAlloc;
 
+// --------------------------------------------------------
+// CachingSlabAllocator
+// --------------------------------------------------------
+
+namespace {
+	// Objects in magazines would show up as leaks in the allocation trace.
+#ifdef KERNEL_LOG_ALLOCATIONS
+	constexpr bool enableHeapCaches = false;
+#else
+	constexpr bool enableHeapCaches = true;
+#endif
+
+	// Checking sized deallocations requires a lookup in the slab pool (which takes
+	// the slab pool's lock), hence it is only done if the kernel is built for it.
+#ifdef KERNEL_CHECK_HEAP
+	constexpr bool checkHeapObjects = true;
+#else
+	constexpr bool checkHeapObjects = false;
+#endif
+
+	// Maximal number of full magazines that the depot keeps per size class.
+	// Beyond that, magazines are drained back into the slab pool.
+	constexpr size_t maxDepotMagazines = 16;
+
+	// Returns the size class index for a given object size (or -1 if the size is not cached).
+	int heapClassOf(size_t size) {
+		if(size > (size_t{1} << heapMaxClassShift))
+			return -1;
+		int shift = heapMinClassShift;
+		while(size > (size_t{1} << shift))
+			shift++;
+		return shift - heapMinClassShift;
+	}
+
+	size_t heapClassSize(int index) {
+		return size_t{1} << (heapMinClassShift + index);
+	}
+
+	void bumpCounter(std::atomic<uint64_t> &counter) {
+		// Counters are only written by the owning CPU; hence we can avoid a locked RMW operation.
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	struct HeapDepot {
+		HeapMagazine *takeFull() {
+			auto lock = frigg::guard(&mutex);
+			if(!fullList)
+				return nullptr;
+			auto magazine = fullList;
+			fullList = magazine->next;
+			numFull--;
+			return magazine;
+		}
+
+		HeapMagazine *takeEmpty() {
+			auto lock = frigg::guard(&mutex);
+			if(!emptyList)
+				return nullptr;
+			auto magazine = emptyList;
+			emptyList = magazine->next;
+			numEmpty--;
+			return magazine;
+		}
+
+		// Returns false if the depot already holds enough full magazines.
+		bool putFull(HeapMagazine *magazine) {
+			assert(magazine->count == heapMagazineRounds);
+			auto lock = frigg::guard(&mutex);
+			if(numFull >= maxDepotMagazines)
+				return false;
+			magazine->next = fullList;
+			fullList = magazine;
+			numFull++;
+			return true;
+		}
+
+		void putEmpty(HeapMagazine *magazine) {
+			assert(!magazine->count);
+			auto lock = frigg::guard(&mutex);
+			magazine->next = emptyList;
+			emptyList = magazine;
+			numEmpty++;
+		}
+
+		frigg::TicketLock mutex;
+		HeapMagazine *fullList = nullptr;
+		HeapMagazine *emptyList = nullptr;
+		size_t numFull = 0;
+		size_t numEmpty = 0;
+	};
+
+	HeapDepot heapDepots[heapNumClasses];
+
+	// Incremented by drainCaches(). CPUs drain their magazines once they see a new value.
+	std::atomic<uint64_t> heapDrainSequence{0};
+}
+
+HeapClassCounters::HeapClassCounters()
+: allocations{0}, deallocations{0}, cacheHits{0}, depotExchanges{0}, slabFallbacks{0} { }
+
+HeapCpuClass::HeapCpuClass()
+: loaded{nullptr}, previous{nullptr} { }
+
+CachingSlabAllocator::CachingSlabAllocator(KernelSlabPool *pool)
+: _pool{pool}, _slab{pool} { }
+
+void *CachingSlabAllocator::allocate(size_t size) {
+	auto index = heapClassOf(size);
+	if(!enableHeapCaches || index < 0)
+		return _slab.allocate(size);
+
+	auto irqLock = frigg::guard(&irqMutex());
+	auto cpuCache = &getCpuData()->heapCache;
+	if(cpuCache->drainSequence != heapDrainSequence.load(std::memory_order_relaxed))
+		_drainCpuCache(cpuCache);
+	auto cache = &cpuCache->classes[index];
+	bumpCounter(cache->counters.allocations);
+
+	if(!cache->loaded || !cache->loaded->count) {
+		if(cache->previous && cache->previous->count) {
+			std::swap(cache->loaded, cache->previous);
+		}else{
+			// Both magazines are empty; exchange the previous one for a full one.
+			auto full = heapDepots[index].takeFull();
+			if(!full) {
+				bumpCounter(cache->counters.slabFallbacks);
+				// Allocate the full class size such that the object can be cached on deallocation.
+				return _slab.allocate(heapClassSize(index));
+			}
+			bumpCounter(cache->counters.depotExchanges);
+			if(cache->previous)
+				heapDepots[index].putEmpty(cache->previous);
+			cache->previous = cache->loaded;
+			cache->loaded = full;
+		}
+	}else{
+		bumpCounter(cache->counters.cacheHits);
+	}
+
+	assert(cache->loaded->count);
+	return cache->loaded->rounds[--cache->loaded->count];
+}
+
+void CachingSlabAllocator::deallocate(void *pointer, size_t size) {
+	if(!pointer)
+		return;
+
+	auto index = heapClassOf(size);
+	if(!enableHeapCaches || index < 0) {
+		_slab.deallocate(pointer, size);
+		return;
+	}
+
+	// The object will be handed out again for any size of its class.
+	if(checkHeapObjects)
+		_checkObject(pointer, heapClassSize(index));
+
+	auto irqLock = frigg::guard(&irqMutex());
+	auto cpuCache = &getCpuData()->heapCache;
+	if(cpuCache->drainSequence != heapDrainSequence.load(std::memory_order_relaxed))
+		_drainCpuCache(cpuCache);
+	auto cache = &cpuCache->classes[index];
+	bumpCounter(cache->counters.deallocations);
+
+	if(!cache->loaded || cache->loaded->count == heapMagazineRounds) {
+		if(cache->previous && cache->previous->count < heapMagazineRounds) {
+			std::swap(cache->loaded, cache->previous);
+		}else{
+			// Both magazines are full; exchange the previous one for an empty one.
+			bumpCounter(cache->counters.depotExchanges);
+			HeapMagazine *empty = nullptr;
+			if(cache->previous && !heapDepots[index].putFull(cache->previous)) {
+				// The depot is saturated. Recycle the previous magazine.
+				bumpCounter(cache->counters.slabFallbacks);
+				_drainMagazine(cache->previous);
+				empty = cache->previous;
+			}
+			if(!empty)
+				empty = heapDepots[index].takeEmpty();
+			if(!empty)
+				empty = _allocateMagazine();
+			cache->previous = cache->loaded;
+			cache->loaded = empty;
+		}
+	}else{
+		bumpCounter(cache->counters.cacheHits);
+	}
+
+	assert(cache->loaded->count < heapMagazineRounds);
+	cache->loaded->rounds[cache->loaded->count++] = pointer;
+}
+
+void CachingSlabAllocator::free(void *pointer) {
+	// Without the size, we cannot determine the size class; bypass the caches.
+	_slab.free(pointer);
+}
+
+void *CachingSlabAllocator::reallocate(void *pointer, size_t size) {
+	// Make sure that the new object can later be cached in the size class of its size.
+	auto index = heapClassOf(size);
+	if(enableHeapCaches && index >= 0)
+		size = heapClassSize(index);
+	return _slab.reallocate(pointer, size);
+}
+
+HeapClassStats CachingSlabAllocator::queryStats(int index) {
+	assert(index >= 0 && index < heapNumClasses);
+
+	HeapClassStats stats;
+	memset(&stats, 0, sizeof(HeapClassStats));
+	stats.objectSize = heapClassSize(index);
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto counters = &getCpuData(i)->heapCache.classes[index].counters;
+		stats.allocations += counters->allocations.load(std::memory_order_relaxed);
+		stats.deallocations += counters->deallocations.load(std::memory_order_relaxed);
+		stats.cacheHits += counters->cacheHits.load(std::memory_order_relaxed);
+		stats.depotExchanges += counters->depotExchanges.load(std::memory_order_relaxed);
+		stats.slabFallbacks += counters->slabFallbacks.load(std::memory_order_relaxed);
+	}
+
+	auto irqLock = frigg::guard(&irqMutex());
+	auto lock = frigg::guard(&heapDepots[index].mutex);
+	stats.depotFull = heapDepots[index].numFull;
+	stats.depotEmpty = heapDepots[index].numEmpty;
+	return stats;
+}
+
+void CachingSlabAllocator::drainCaches() {
+	if(!enableHeapCaches)
+		return;
+
+	heapDrainSequence.fetch_add(1, std::memory_order_relaxed);
+
+	auto irqLock = frigg::guard(&irqMutex());
+	for(int index = 0; index < heapNumClasses; index++) {
+		while(auto magazine = heapDepots[index].takeFull()) {
+			_drainMagazine(magazine);
+			_slab.free(magazine);
+		}
+		while(auto magazine = heapDepots[index].takeEmpty())
+			_slab.free(magazine);
+	}
+}
+
+HeapMagazine *CachingSlabAllocator::_allocateMagazine() {
+	static_assert(sizeof(HeapMagazine) == 256);
+	auto magazine = new (_slab.allocate(sizeof(HeapMagazine))) HeapMagazine;
+	magazine->next = nullptr;
+	magazine->count = 0;
+	return magazine;
+}
+
+void CachingSlabAllocator::_drainMagazine(HeapMagazine *magazine) {
+	for(size_t i = 0; i < magazine->count; i++)
+		_slab.free(magazine->rounds[i]);
+	magazine->count = 0;
+}
+
+// The magazines themselves are freed, too. The next heap operation allocates new ones.
+void CachingSlabAllocator::_drainCpuCache(HeapCpuCache *cache) {
+	cache->drainSequence = heapDrainSequence.load(std::memory_order_relaxed);
+	for(int index = 0; index < heapNumClasses; index++) {
+		auto cpuClass = &cache->classes[index];
+		if(auto magazine = std::exchange(cpuClass->loaded, nullptr); magazine) {
+			_drainMagazine(magazine);
+			_slab.free(magazine);
+		}
+		if(auto magazine = std::exchange(cpuClass->previous, nullptr); magazine) {
+			_drainMagazine(magazine);
+			_slab.free(magazine);
+		}
+	}
+}
+
+void CachingSlabAllocator::_checkObject(void *pointer, size_t size) {
+	auto actualSize = _pool->get_size(pointer);
+	if(actualSize < size)
+		frigg::panicLogger() << "thor: Object " << pointer << " of " << actualSize
+				<< " bytes is deallocated with size " << size << frigg::endLog;
+}
+
 // --------------------------------------------------------
 // CpuData
 // --------------------------------------------------------
@@ -211,7 +495,7 @@ IrqMutex &irqMutex() {
 ExecutorContext::ExecutorContext() { }
 
 CpuData::CpuData()
-: scheduler{this}, activeFiber{nullptr}, heartbeat{0} { }
+: cpuIndex{0}, scheduler{this}, activeFiber{nullptr}, heartbeat{0} { }
 
 // --------------------------------------------------------
 // Threading related functions
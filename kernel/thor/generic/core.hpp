@@ -7,6 +7,7 @@
 #include <frigg/variant.hpp>
 #include "error.hpp"
 #include "../arch/x86/cpu.hpp"
+#include "ring-buffer.hpp"
 #include "schedule.hpp"
 
 namespace thor {
@@ -70,6 +71,8 @@ struct CpuData : public PlatformCpuData {
 
 	CpuData &operator= (const CpuData &) = delete;
 
+	// Position of this CPU in the list of all CPUs.
+	int cpuIndex;
 	IrqMutex irqMutex;
 	Scheduler scheduler;
 	bool haveVirtualization;
@@ -77,6 +80,9 @@ struct CpuData : public PlatformCpuData {
 	ExecutorContext *executorContext;
 	KernelFiber *activeFiber;
 	std::atomic<uint64_t> heartbeat;
+	HeapCpuCache heapCache;
+	PhysicalCpuCache pageCache;
+	LogCpuStaging allocLogStaging;
 };
 
 inline CpuData *getCpuData() {
@@ -669,6 +669,85 @@ HelError helCreateSpace(HelHandle *handle) {
 	return kHelErrNone;
 }
 
+HelError helForkSpace(HelHandle handle, HelHandle *forkedHandle) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	smarter::shared_ptr<AddressSpace, BindableHandle> space;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		Universe::Guard universe_guard(&this_universe->lock);
+
+		auto space_wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!space_wrapper)
+			return kHelErrNoDescriptor;
+		if(!space_wrapper->is<AddressSpaceDescriptor>())
+			return kHelErrBadDescriptor;
+		space = space_wrapper->get<AddressSpaceDescriptor>().space;
+	}
+
+	auto forked = AddressSpace::create();
+
+	for(auto &mapping : space->getMappings()) {
+		auto slice = mapping->slice();
+
+		// Copy-on-write memory is forked, all other memory is shared.
+		struct Closure {
+			ThreadBlocker blocker;
+			Error error;
+			frigg::SharedPtr<MemoryView> forkedView;
+		} closure;
+
+		struct Receiver {
+			void set_value(frg::tuple<Error, frigg::SharedPtr<MemoryView>> result) {
+				closure->error = result.get<0>();
+				closure->forkedView = std::move(result.get<1>());
+				Thread::unblockOther(&closure->blocker);
+			}
+
+			Closure *closure;
+		};
+
+		closure.blocker.setup();
+		slice->getView()->fork(Receiver{&closure});
+		Thread::blockCurrent(&closure.blocker);
+
+		if(!closure.error) {
+			slice = frigg::makeShared<MemorySlice>(*kernelAlloc,
+					std::move(closure.forkedView), slice->offset(), slice->length());
+		}else{
+			assert(closure.error == kErrIllegalObject);
+		}
+
+		uint32_t map_flags = AddressSpace::kMapFixed;
+		if(mapping->flags() & MappingFlags::protRead)
+			map_flags |= AddressSpace::kMapProtRead;
+		if(mapping->flags() & MappingFlags::protWrite)
+			map_flags |= AddressSpace::kMapProtWrite;
+		if(mapping->flags() & MappingFlags::protExecute)
+			map_flags |= AddressSpace::kMapProtExecute;
+		if(mapping->flags() & MappingFlags::dontRequireBacking)
+			map_flags |= AddressSpace::kMapDontRequireBacking;
+
+		VirtualAddr actual_address;
+		auto error = forked->map(slice, mapping->address(),
+				mapping->viewOffset() - slice->offset(), mapping->length(),
+				map_flags, &actual_address);
+		assert(!error);
+		assert(actual_address == mapping->address());
+	}
+
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		Universe::Guard universe_guard(&this_universe->lock);
+
+		*forkedHandle = this_universe->attachDescriptor(universe_guard,
+				AddressSpaceDescriptor(std::move(forked)));
+	}
+
+	return kHelErrNone;
+}
+
 HelError helCreateVirtualizedSpace(HelHandle *handle) {
 	if(!getCpuData()->haveVirtualization) {
 		return kHelErrNoHardwareSupport;
@@ -1393,7 +1472,10 @@ HelError helSubmitLockMemoryView(HelHandle handle, uintptr_t offset, size_t size
 }
 
 HelError helLoadahead(HelHandle handle, uintptr_t offset, size_t length) {
-	assert(offset % kPageSize == 0 && length % kPageSize == 0);
+	if(offset % kPageSize || length % kPageSize)
+		return kHelErrIllegalArgs;
+	if(offset + length < offset)
+		return kHelErrIllegalArgs;
 
 	auto this_thread = getCurrentThread();
 	auto this_universe = this_thread->getUniverse();
@@ -1411,12 +1493,32 @@ HelError helLoadahead(HelHandle handle, uintptr_t offset, size_t length) {
 		memory = memory_wrapper->get<MemoryViewDescriptor>().memory;
 	}
 
-/*	auto handle_load = frigg::makeShared<AsyncInitiateLoad>(*kernelAlloc,
-			NullCompleter(), offset, length);
-	{
-		// TODO: protect memory object with a guard
-		memory->submitInitiateLoad(std::move(handle_load));
-	}*/
+	if(offset + length > memory->getLength())
+		return kHelErrOutOfBounds;
+	if(!length)
+		return kHelErrNone;
+
+	// As this is only a hint, drop it instead of competing for scarce physical memory.
+	if(length / kPageSize > physicalAllocator->numFreePages() / 8)
+		return kHelErrNone;
+
+	struct Closure {
+		frigg::SharedPtr<MemoryView> memory;
+		Worklet worklet;
+		MonitorNode initiate;
+	} *closure = frigg::construct<Closure>(*kernelAlloc);
+
+	struct Ops {
+		static void initiated(Worklet *base) {
+			auto closure = frg::container_of(base, &Closure::worklet);
+			frigg::destruct(*kernelAlloc, closure);
+		}
+	};
+
+	closure->memory = std::move(memory);
+	closure->worklet.setup(&Ops::initiated);
+	closure->initiate.setup(ManageRequest::initialize, offset, length, &closure->worklet);
+	closure->memory->submitInitiateLoad(&closure->initiate);
 
 	return kHelErrNone;
 }
@@ -1918,43 +2020,11 @@ HelError helCreateStream(HelHandle *lane1_handle, HelHandle *lane2_handle) {
 	return kHelErrNone;
 }
 
-HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count,
-		HelHandle queue_handle, uintptr_t context, uint32_t flags) {
-	(void)flags;
-	auto this_thread = getCurrentThread();
-	auto this_universe = this_thread->getUniverse();
-
-	// TODO: check userspace page access rights
-
-	LaneHandle lane;
-	frigg::SharedPtr<IpcQueue> queue;
-	{
-		auto irq_lock = frigg::guard(&irqMutex());
-		Universe::Guard universe_guard(&this_universe->lock);
-
-		if(handle == kHelThisThread) {
-			lane = this_thread->inferiorLane();
-		}else{
-			auto wrapper = this_universe->getDescriptor(universe_guard, handle);
-			if(!wrapper)
-				return kHelErrNoDescriptor;
-			if(wrapper->is<LaneDescriptor>()) {
-				lane = wrapper->get<LaneDescriptor>().handle;
-			}else if(wrapper->is<ThreadDescriptor>()) {
-				lane = wrapper->get<ThreadDescriptor>().thread->superiorLane();
-			}else{
-				return kHelErrBadDescriptor;
-			}
-		}
-
-		auto queue_wrapper = this_universe->getDescriptor(universe_guard, queue_handle);
-		if(!queue_wrapper)
-			return kHelErrNoDescriptor;
-		if(!queue_wrapper->is<QueueDescriptor>())
-			return kHelErrBadDescriptor;
-		queue = queue_wrapper->get<QueueDescriptor>().queue;
-	}
-
+// Translates the HelActions of one helSubmitAsync() conversation into a chain of StreamNodes.
+// Completion of the chain is reported to the given IpcQueue.
+HelError prepareTransmission(frigg::UnsafePtr<Thread> this_thread,
+		frigg::UnsafePtr<Universe> this_universe, const HelAction *actions, size_t count,
+		frigg::SharedPtr<IpcQueue> queue, uintptr_t context, StreamList &root_chain) {
 	size_t node_size = 0;
 	for(size_t i = 0; i < count; i++) {
 		HelAction action;
@@ -2135,7 +2205,6 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 	closure->setupContext(context);
 	closure->items = frigg::constructN<Item>(*kernelAlloc, count);
 
-	StreamList root_chain;
 	frg::vector<StreamNode *, KernelAlloc> ancillary_stack(*kernelAlloc);
 
 	// We use this as a marker that the root chain has not ended.
@@ -2265,11 +2334,126 @@ HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count
 	if(!ancillary_stack.empty())
 		return kHelErrIllegalArgs;
 
+	return kHelErrNone;
+}
+
+HelError helSubmitAsync(HelHandle handle, const HelAction *actions, size_t count,
+		HelHandle queue_handle, uintptr_t context, uint32_t flags) {
+	(void)flags;
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	// TODO: check userspace page access rights
+
+	LaneHandle lane;
+	frigg::SharedPtr<IpcQueue> queue;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		Universe::Guard universe_guard(&this_universe->lock);
+
+		if(handle == kHelThisThread) {
+			lane = this_thread->inferiorLane();
+		}else{
+			auto wrapper = this_universe->getDescriptor(universe_guard, handle);
+			if(!wrapper)
+				return kHelErrNoDescriptor;
+			if(wrapper->is<LaneDescriptor>()) {
+				lane = wrapper->get<LaneDescriptor>().handle;
+			}else if(wrapper->is<ThreadDescriptor>()) {
+				lane = wrapper->get<ThreadDescriptor>().thread->superiorLane();
+			}else{
+				return kHelErrBadDescriptor;
+			}
+		}
+
+		auto queue_wrapper = this_universe->getDescriptor(universe_guard, queue_handle);
+		if(!queue_wrapper)
+			return kHelErrNoDescriptor;
+		if(!queue_wrapper->is<QueueDescriptor>())
+			return kHelErrBadDescriptor;
+		queue = queue_wrapper->get<QueueDescriptor>().queue;
+	}
+
+	StreamList root_chain;
+	if(auto error = prepareTransmission(this_thread, this_universe, actions, count,
+			std::move(queue), context, root_chain); error)
+		return error;
+
 	Stream::transmit(lane, root_chain);
 
 	return kHelErrNone;
 }
 
+HelError helSubmitAsyncBatch(const HelSubmission *submissions, size_t count,
+		HelHandle queue_handle, uint32_t flags, size_t *num_submitted) {
+	(void)flags;
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	frigg::SharedPtr<IpcQueue> queue;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		Universe::Guard universe_guard(&this_universe->lock);
+
+		auto queue_wrapper = this_universe->getDescriptor(universe_guard, queue_handle);
+		if(!queue_wrapper)
+			return kHelErrNoDescriptor;
+		if(!queue_wrapper->is<QueueDescriptor>())
+			return kHelErrBadDescriptor;
+		queue = queue_wrapper->get<QueueDescriptor>().queue;
+	}
+
+	// All conversations go through a single Submitter, i.e., matching of StreamNodes
+	// is done in one pass after all submissions have been translated.
+	Stream::Submitter submitter;
+	HelError error = kHelErrNone;
+	size_t n;
+	for(n = 0; n < count; n++) {
+		HelSubmission submission;
+		if(!readUserObject(submissions + n, submission)) {
+			error = kHelErrFault;
+			break;
+		}
+
+		LaneHandle lane;
+		{
+			auto irq_lock = frigg::guard(&irqMutex());
+			Universe::Guard universe_guard(&this_universe->lock);
+
+			if(submission.handle == kHelThisThread) {
+				lane = this_thread->inferiorLane();
+			}else{
+				auto wrapper = this_universe->getDescriptor(universe_guard, submission.handle);
+				if(!wrapper) {
+					error = kHelErrNoDescriptor;
+					break;
+				}
+				if(wrapper->is<LaneDescriptor>()) {
+					lane = wrapper->get<LaneDescriptor>().handle;
+				}else if(wrapper->is<ThreadDescriptor>()) {
+					lane = wrapper->get<ThreadDescriptor>().thread->superiorLane();
+				}else{
+					error = kHelErrBadDescriptor;
+					break;
+				}
+			}
+		}
+
+		StreamList root_chain;
+		error = prepareTransmission(this_thread, this_universe, submission.actions,
+				submission.count, queue, submission.context, root_chain);
+		if(error)
+			break;
+		submitter.enqueue(lane, root_chain);
+	}
+
+	// Even on error, the conversations that were translated successfully are submitted.
+	submitter.run();
+
+	*num_submitted = n;
+	return error;
+}
+
 HelError helShutdownLane(HelHandle handle) {
 	auto this_thread = getCurrentThread();
 	auto this_universe = this_thread->getUniverse();
@@ -2292,6 +2476,92 @@ HelError helShutdownLane(HelHandle handle) {
 	return kHelErrNone;
 }
 
+static_assert(kHelMaxInlineCall == inlineCallSize, "Size of synchronous calls does not match");
+
+HelError helCall(HelHandle handle, const void *request, size_t request_length,
+		void *response, size_t max_response, size_t *response_length) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	if(request_length > kHelMaxInlineCall)
+		return kHelErrIllegalArgs;
+
+	LaneHandle lane;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		Universe::Guard universe_guard(&this_universe->lock);
+
+		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!wrapper)
+			return kHelErrNoDescriptor;
+		if(!wrapper->is<LaneDescriptor>())
+			return kHelErrBadDescriptor;
+		lane = wrapper->get<LaneDescriptor>().handle;
+	}
+
+	char temp[kHelMaxInlineCall];
+	if(!readUserMemory(temp, request, request_length))
+		return kHelErrFault;
+
+	CallNode node;
+	node.setup(temp, request_length);
+	if(auto error = lane.getStream()->call(lane.getLane(), &node); error)
+		return translateError(error);
+
+	*response_length = node.length();
+	if(node.length() > max_response)
+		return kHelErrBufferTooSmall;
+	if(!writeUserMemory(response, node.data(), node.length()))
+		return kHelErrFault;
+
+	return kHelErrNone;
+}
+
+HelError helReplyAndWait(HelHandle handle, const void *reply, size_t reply_length,
+		void *request, size_t max_request, size_t *request_length) {
+	auto this_thread = getCurrentThread();
+	auto this_universe = this_thread->getUniverse();
+
+	if(reply_length > kHelMaxInlineCall)
+		return kHelErrIllegalArgs;
+
+	LaneHandle lane;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		Universe::Guard universe_guard(&this_universe->lock);
+
+		auto wrapper = this_universe->getDescriptor(universe_guard, handle);
+		if(!wrapper)
+			return kHelErrNoDescriptor;
+		if(!wrapper->is<LaneDescriptor>())
+			return kHelErrBadDescriptor;
+		lane = wrapper->get<LaneDescriptor>().handle;
+	}
+
+	char temp[kHelMaxInlineCall];
+	if(!readUserMemory(temp, reply, reply_length))
+		return kHelErrFault;
+
+	ReceiveNode node;
+	if(auto error = lane.getStream()->replyAndReceive(lane.getLane(),
+			temp, reply_length, &node); error)
+		return translateError(error);
+
+	// If the request cannot be delivered, the call is failed. Otherwise, the next
+	// reply would be sent to the caller of a call that the server never saw.
+	*request_length = node.length();
+	if(node.length() > max_request) {
+		lane.getStream()->failCall(lane.getLane(), kErrBufferTooSmall);
+		return kHelErrBufferTooSmall;
+	}
+	if(!writeUserMemory(request, node.data(), node.length())) {
+		lane.getStream()->failCall(lane.getLane(), kErrFault);
+		return kHelErrFault;
+	}
+
+	return kHelErrNone;
+}
+
 HelError helFutexWait(int *pointer, int expected, int64_t deadline) {
 	auto thisThread = getCurrentThread();
 	auto space = thisThread->getAddressSpace();
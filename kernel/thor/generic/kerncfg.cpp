@@ -15,10 +15,30 @@ namespace thor {
 
 extern frigg::LazyInitializer<LaneHandle> mbusClient;
 extern frigg::LazyInitializer<frg::string<KernelAlloc>> kernelCommandLine;
-extern frigg::LazyInitializer<LogRingBuffer> allocLog;
+extern frigg::LazyInitializer<PerCpuLogRing> allocLog;
 
 namespace {
 
+// Formats the per-size-class counters of the kernel heap as a human-readable table.
+frigg::String<KernelAlloc> formatHeapStats() {
+	frigg::String<KernelAlloc> text{*kernelAlloc,
+			"size allocations deallocations cache-hits depot-exchanges"
+			" slab-fallbacks depot-full depot-empty\n"};
+	for(int i = 0; i < heapNumClasses; i++) {
+		auto stats = kernelAlloc->queryStats(i);
+		uint64_t fields[] = {stats.objectSize, stats.allocations, stats.deallocations,
+				stats.cacheHits, stats.depotExchanges, stats.slabFallbacks,
+				stats.depotFull, stats.depotEmpty};
+		for(size_t j = 0; j < sizeof(fields) / sizeof(uint64_t); j++) {
+			if(j)
+				text += frigg::StringView{" "};
+			text += frigg::to_string(*kernelAlloc, fields[j]);
+		}
+		text += frigg::StringView{"\n"};
+	}
+	return text;
+}
+
 coroutine<Error> handleReq(LaneHandle boundLane) {
 	auto [acceptError, lane] = co_await AcceptSender{boundLane};
 	if(acceptError)
@@ -44,6 +64,23 @@ coroutine<Error> handleReq(LaneHandle boundLane) {
 		memcpy(cmdlineBuffer.data(), kernelCommandLine->data(), kernelCommandLine->size());
 		auto cmdlineError = co_await SendBufferSender{lane, std::move(cmdlineBuffer)};
 		assert(!cmdlineError && "Unexpected mbus transaction");
+	}else if(req.req_type() == managarm::kerncfg::CntReqType::GET_HEAP_STATS) {
+		auto text = formatHeapStats();
+
+		managarm::kerncfg::SvrResponse<KernelAlloc> resp(*kernelAlloc);
+		resp.set_error(managarm::kerncfg::Error::SUCCESS);
+		resp.set_size(text.size());
+
+		frg::string<KernelAlloc> ser(*kernelAlloc);
+		resp.SerializeToString(&ser);
+		frigg::UniqueMemory<KernelAlloc> respBuffer{*kernelAlloc, ser.size()};
+		memcpy(respBuffer.data(), ser.data(), ser.size());
+		auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+		assert(!respError && "Unexpected mbus transaction");
+		frigg::UniqueMemory<KernelAlloc> statsBuffer{*kernelAlloc, text.size()};
+		memcpy(statsBuffer.data(), text.data(), text.size());
+		auto statsError = co_await SendBufferSender{lane, std::move(statsBuffer)};
+		assert(!statsError && "Unexpected mbus transaction");
 	}else{
 		managarm::kerncfg::SvrResponse<KernelAlloc> resp(*kernelAlloc);
 		resp.set_error(managarm::kerncfg::Error::ILLEGAL_REQUEST);
@@ -59,6 +96,20 @@ coroutine<Error> handleReq(LaneHandle boundLane) {
 	co_return kErrSuccess;
 }
 
+// Tells a reader that its dequeue index is stale and where the stream continues.
+coroutine<void> rejectDequeue(LaneHandle lane) {
+	managarm::kerncfg::SvrResponse<KernelAlloc> resp(*kernelAlloc);
+	resp.set_error(managarm::kerncfg::Error::ILLEGAL_ARGUMENTS);
+	resp.set_new_dequeue(allocLog->dequeueIndex());
+
+	frg::string<KernelAlloc> ser(*kernelAlloc);
+	resp.SerializeToString(&ser);
+	frigg::UniqueMemory<KernelAlloc> respBuffer{*kernelAlloc, ser.size()};
+	memcpy(respBuffer.data(), ser.data(), ser.size());
+	auto respError = co_await SendBufferSender{lane, std::move(respBuffer)};
+	assert(!respError && "Unexpected mbus transaction");
+}
+
 coroutine<Error> handleByteRingReq(LaneHandle boundLane) {
 	auto [acceptError, lane] = co_await AcceptSender{boundLane};
 	if(acceptError)
@@ -71,22 +122,38 @@ coroutine<Error> handleByteRingReq(LaneHandle boundLane) {
 
 	if(req.req_type() == managarm::kerncfg::CntReqType::GET_BUFFER_CONTENTS) {
 		size_t oldDequeue = req.dequeue();
-		size_t wantedSize = allocLog->wantedSize(oldDequeue, req.size());;
 
+		// The merged stream can only be read sequentially.
+		if(oldDequeue != allocLog->dequeueIndex()) {
+			co_await rejectDequeue(lane);
+			co_return kErrSuccess;
+		}
+
+		// Make partially filled staging buffers visible while we wait.
 		constexpr uint64_t nanos = 100000000;
 		constexpr size_t minSize = 1024 * 1024; // 1M
-		while (!allocLog->hasEnoughBytes(oldDequeue, minSize))
+		allocLog->requestFlush();
+		while (!allocLog->hasEnoughBytes(oldDequeue, minSize)) {
 			co_await generalTimerEngine()->sleep(systemClockSource()->currentNanos() + nanos);
+			allocLog->requestFlush();
+		}
 
+		size_t wantedSize = allocLog->wantedSize(oldDequeue, req.size());
 		frigg::UniqueMemory<KernelAlloc> dataBuffer{*kernelAlloc, wantedSize};
-		auto [newDequeue, actualSize] =
-			allocLog->dequeueInto(dataBuffer.data(), oldDequeue, wantedSize);
+		auto result = allocLog->dequeueInto(dataBuffer.data(), oldDequeue, wantedSize);
+		// Another reader could have consumed the data in the meantime.
+		if(!result) {
+			co_await rejectDequeue(lane);
+			co_return kErrSuccess;
+		}
+		auto [newDequeue, actualSize] = *result;
 
 		managarm::kerncfg::SvrResponse<KernelAlloc> resp(*kernelAlloc);
 		resp.set_error(managarm::kerncfg::Error::SUCCESS);
 		resp.set_size(actualSize);
 		resp.set_new_dequeue(newDequeue);
 		resp.set_enqueue(allocLog->enqueueIndex());
+		resp.set_lost(allocLog->lostBytes());
 
 		frg::string<KernelAlloc> ser(*kernelAlloc);
 		resp.SerializeToString(&ser);
@@ -1,6 +1,7 @@
 #ifndef THOR_GENERIC_KERNEL_HEAP_HPP
 #define THOR_GENERIC_KERNEL_HEAP_HPP
 
+#include <atomic>
 #include <frigg/atomic.hpp>
 #include <frigg/initializer.hpp>
 #include <frg/slab.hpp>
@@ -61,16 +62,109 @@ public:
 	void output_trace(uint8_t val);
 };
 
-using KernelAlloc = frg::slab_allocator<KernelVirtualAlloc, IrqSpinlock>;
+using KernelSlabPool = frg::slab_pool<KernelVirtualAlloc, IrqSpinlock>;
+using KernelSlabAlloc = frg::slab_allocator<KernelVirtualAlloc, IrqSpinlock>;
+
+// --------------------------------------------------------
+// Per-CPU magazine caches in front of the slab pool.
+// This follows Bonwick and Adams, "Magazines and Vmem" (USENIX 2001):
+// Each CPU keeps two magazines (= arrays of free objects) per size class
+// and only talks to the global depot (and thus takes a lock)
+// once both magazines are empty (on allocation) or full (on deallocation).
+// --------------------------------------------------------
+
+// Size classes are powers of two from 2^heapMinClassShift to 2^heapMaxClassShift.
+// Larger objects are allocated from the slab pool directly.
+inline constexpr int heapMinClassShift = 4;
+inline constexpr int heapMaxClassShift = 11;
+inline constexpr int heapNumClasses = heapMaxClassShift - heapMinClassShift + 1;
+
+// Chosen such that sizeof(HeapMagazine) is 256 bytes.
+inline constexpr size_t heapMagazineRounds = 30;
+
+struct HeapMagazine {
+	HeapMagazine *next;
+	size_t count;
+	void *rounds[heapMagazineRounds];
+};
+
+// Counters of a single size class.
+// These are only written by the owning CPU and read (without synchronization) by readers.
+struct HeapClassCounters {
+	HeapClassCounters();
+
+	// Calls to allocate() / deallocate().
+	std::atomic<uint64_t> allocations;
+	std::atomic<uint64_t> deallocations;
+	// Operations that were served by the per-CPU magazines.
+	std::atomic<uint64_t> cacheHits;
+	// Magazine exchanges with the depot.
+	std::atomic<uint64_t> depotExchanges;
+	// Operations that had to fall back to the slab pool.
+	std::atomic<uint64_t> slabFallbacks;
+};
+
+struct HeapCpuClass {
+	HeapCpuClass();
+
+	HeapMagazine *loaded;
+	HeapMagazine *previous;
+	HeapClassCounters counters;
+};
+
+// This is part of CpuData. It may only be accessed with IRQs disabled.
+struct HeapCpuCache {
+	HeapCpuClass classes[heapNumClasses];
+	// Last drain sequence of the CachingSlabAllocator that this cache has seen.
+	uint64_t drainSequence = 0;
+};
+
+// Sum of the counters of all CPUs for a given size class.
+struct HeapClassStats {
+	size_t objectSize;
+	uint64_t allocations;
+	uint64_t deallocations;
+	uint64_t cacheHits;
+	uint64_t depotExchanges;
+	uint64_t slabFallbacks;
+	size_t depotFull;
+	size_t depotEmpty;
+};
+
+// Drop-in replacement for frg::slab_allocator that caches objects per CPU.
+struct CachingSlabAllocator {
+	CachingSlabAllocator(KernelSlabPool *pool);
+
+	void *allocate(size_t size);
+	void deallocate(void *pointer, size_t size);
+	void free(void *pointer);
+	void *reallocate(void *pointer, size_t size);
+
+	// Returns the statistics of size class index (0 <= index < heapNumClasses).
+	HeapClassStats queryStats(int index);
+
+	// Returns all objects in the depot to the slab pool. The magazines of all CPUs
+	// are drained as soon as the CPUs perform their next heap operation.
+	// Called under memory pressure.
+	void drainCaches();
+
+private:
+	HeapMagazine *_allocateMagazine();
+	void _drainMagazine(HeapMagazine *magazine);
+	void _drainCpuCache(HeapCpuCache *cache);
+
+	// Checks that the object was allocated from the slab pool with (at least) the given size.
+	void _checkObject(void *pointer, size_t size);
+
+	KernelSlabPool *_pool;
+	KernelSlabAlloc _slab;
+};
+
+using KernelAlloc = CachingSlabAllocator;
 
 extern frigg::LazyInitializer<KernelVirtualAlloc> kernelVirtualAlloc;
 
-extern frigg::LazyInitializer<
-	frg::slab_pool<
-		KernelVirtualAlloc,
-		IrqSpinlock
-	>
-> kernelHeap;
+extern frigg::LazyInitializer<KernelSlabPool> kernelHeap;
 
 extern frigg::LazyInitializer<KernelAlloc> kernelAlloc;
 
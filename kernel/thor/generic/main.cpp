@@ -249,6 +249,9 @@ extern "C" void thorMain(PhysicalAddr info_paddr) {
 					<< frigg::endLog;
 	
 
+		// All CPUs are online now; allow threads to migrate between them.
+		Scheduler::enableLoadBalancing();
+
 		// Launch initial user space programs.
 		initializeKerncfg();
 		initializeSvrctl();
@@ -642,6 +645,11 @@ void handleSyscall(SyscallImageAccessor image) {
 		*image.error() = helCreateSpace(&handle);
 		*image.out0() = handle;
 	} break;
+	case kHelCallForkSpace: {
+		HelHandle forkedHandle;
+		*image.error() = helForkSpace((HelHandle)arg0, &forkedHandle);
+		*image.out0() = forkedHandle;
+	} break;
 	case kHelCallMapMemory: {
 		void *actual_pointer;
 		*image.error() = helMapMemory((HelHandle)arg0, (HelHandle)arg1,
@@ -770,9 +778,27 @@ void handleSyscall(SyscallImageAccessor image) {
 		*image.error() = helSubmitAsync((HelHandle)arg0, (HelAction *)arg1,
 				(size_t)arg2, (HelHandle)arg3, (uintptr_t)arg4, (uint32_t)arg5);
 	} break;
+	case kHelCallSubmitAsyncBatch: {
+		size_t submitted;
+		*image.error() = helSubmitAsyncBatch((const HelSubmission *)arg0, (size_t)arg1,
+				(HelHandle)arg2, (uint32_t)arg3, &submitted);
+		*image.out0() = submitted;
+	} break;
 	case kHelCallShutdownLane: {
 		*image.error() = helShutdownLane((HelHandle)arg0);
 	} break;
+	case kHelCallCall: {
+		size_t length;
+		*image.error() = helCall((HelHandle)arg0, (const void *)arg1, (size_t)arg2,
+				(void *)arg3, (size_t)arg4, &length);
+		*image.out0() = length;
+	} break;
+	case kHelCallReplyAndWait: {
+		size_t length;
+		*image.error() = helReplyAndWait((HelHandle)arg0, (const void *)arg1, (size_t)arg2,
+				(void *)arg3, (size_t)arg4, &length);
+		*image.out0() = length;
+	} break;
 
 	case kHelCallFutexWait: {
 		*image.error() = helFutexWait((int *)arg0, (int)arg1, (int64_t)arg2);
@@ -10,6 +10,10 @@ namespace {
 	constexpr bool logUsage = false;
 	constexpr bool logUncaching = false;
 
+	// The caches of the kernel heap are drained if less than 1/heapPressureRatio
+	// of all physical pages is free.
+	constexpr size_t heapPressureRatio = 16;
+
 	// The following flags are debugging options to debug the correctness of various components.
 	constexpr bool disableUncaching = false;
 }
@@ -134,6 +138,12 @@ struct MemoryReclaimer {
 
 				while(checkReclaim())
 					;
+
+				auto freePages = physicalAllocator->numFreePages();
+				auto usedPages = physicalAllocator->numUsedPages();
+				if(freePages < (freePages + usedPages) / heapPressureRatio)
+					kernelAlloc->drainCaches();
+
 				fiberSleep(1'000'000'000);
 			}
 		});
@@ -538,14 +548,9 @@ void AllocatedMemory::copyKernelToThisSync(ptrdiff_t offset, void *pointer, size
 	size_t index = offset / _chunkSize;
 	assert(index < _physicalChunks.size());
 	if(_physicalChunks[index] == PhysicalAddr(-1)) {
-		auto physical = physicalAllocator->allocate(_chunkSize, _addressBits);
+		auto physical = physicalAllocator->allocateZeroed(_chunkSize, _addressBits);
 		assert(physical != PhysicalAddr(-1) && "OOM");
 		assert(!(physical % _chunkAlign));
-
-		for(size_t pg_progress = 0; pg_progress < _chunkSize; pg_progress += kPageSize) {
-			PageAccessor accessor{physical + pg_progress};
-			memset(accessor.get(), 0, kPageSize);
-		}
 		_physicalChunks[index] = physical;
 	}
 
@@ -596,14 +601,9 @@ bool AllocatedMemory::fetchRange(uintptr_t offset, FetchNode *node) {
 	assert(index < _physicalChunks.size());
 
 	if(_physicalChunks[index] == PhysicalAddr(-1)) {
-		auto physical = physicalAllocator->allocate(_chunkSize, _addressBits);
+		auto physical = physicalAllocator->allocateZeroed(_chunkSize, _addressBits);
 		assert(physical != PhysicalAddr(-1) && "OOM");
 		assert(!(physical & (_chunkAlign - 1)));
-
-		for(size_t pg_progress = 0; pg_progress < _chunkSize; pg_progress += kPageSize) {
-			PageAccessor accessor{physical + pg_progress};
-			memset(accessor.get(), 0, kPageSize);
-		}
 		_physicalChunks[index] = physical;
 	}
 
@@ -903,11 +903,8 @@ bool BackingMemory::fetchRange(uintptr_t offset, FetchNode *node) {
 	assert(pit);
 
 	if(pit->physical == PhysicalAddr(-1)) {
-		PhysicalAddr physical = physicalAllocator->allocate(kPageSize);
+		PhysicalAddr physical = physicalAllocator->allocateZeroed(kPageSize);
 		assert(physical != PhysicalAddr(-1) && "OOM");
-
-		PageAccessor accessor{physical};
-		memset(accessor.get(), 0, kPageSize);
 		pit->physical = physical;
 	}
 
@@ -1155,17 +1152,24 @@ void FrontalMemory::submitInitiateLoad(MonitorNode *node) {
 	// TODO: This assumes that we want to load the range (which might not be true).
 	assert(node->offset % kPageSize == 0);
 	assert(node->length % kPageSize == 0);
-	for(size_t pg = 0; pg < node->length; pg += kPageSize) {
-		auto index = (node->offset + pg) >> kPageShift;
-		auto [pit, wasInserted] = _managed->pages.find_or_insert(index, _managed.get(), index);
-		assert(pit);
-		if(pit->loadState == ManagedSpace::kStateMissing) {
-			pit->loadState = ManagedSpace::kStateWantInitialization;
-			_managed->_initializationList.push_back(&pit->cachePage);
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		auto lock = frigg::guard(&_managed->mutex);
+
+		for(size_t pg = 0; pg < node->length; pg += kPageSize) {
+			auto index = (node->offset + pg) >> kPageShift;
+			auto [pit, wasInserted] = _managed->pages.find_or_insert(index,
+					_managed.get(), index);
+			assert(pit);
+			if(pit->loadState == ManagedSpace::kStateMissing) {
+				pit->loadState = ManagedSpace::kStateWantInitialization;
+				_managed->_initializationList.push_back(&pit->cachePage);
+			}
 		}
+		_managed->_progressManagement();
 	}
-	_managed->_progressManagement();
 
+	// submitMonitor() takes the locks itself.
 	_managed->submitMonitor(node);
 }
 
@@ -4,6 +4,17 @@ namespace thor {
 
 static bool logPhysicalAllocs = false;
 
+namespace {
+	// Number of pages that are moved between the per-CPU caches and the buddy at once.
+	constexpr size_t cacheBatch = 16;
+
+	// Number of pages that zeroIdlePages() zeroes per call.
+	constexpr size_t idleZeroBatch = 8;
+
+	// zeroIdlePages() stops once the cache contains this many zeroed pages.
+	constexpr size_t idleZeroTarget = 32;
+}
+
 // --------------------------------------------------------
 // SkeletalRegion
 // --------------------------------------------------------
@@ -27,6 +38,9 @@ void *SkeletalRegion::access(PhysicalAddr physical) {
 // PhysicalChunkAllocator
 // --------------------------------------------------------
 
+PhysicalCpuCache::PhysicalCpuCache()
+: numDirty{0}, numZeroed{0} { }
+
 PhysicalChunkAllocator::PhysicalChunkAllocator() {
 }
 
@@ -49,11 +63,19 @@ void PhysicalChunkAllocator::bootstrapRegion(PhysicalAddr address,
 
 PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
 	auto irq_lock = frigg::guard(&irqMutex());
-	auto lock = frigg::guard(&_mutex);
 
-	assert(_freePages > size / kPageSize);
-	_freePages -= size / kPageSize;
-	_usedPages += size / kPageSize;
+	// Order-0 pages are served from the per-CPU cache (without taking _mutex).
+	// The cache can contain pages from all regions; hence only use it if there is no restriction.
+	if(size == kPageSize && addressBits >= 64) {
+		auto cache = &getCpuData()->pageCache;
+		auto cache_lock = frigg::guard(&cache->mutex);
+		if(!cache->numDirty && !cache->numZeroed)
+			_refillCache(cache);
+		if(cache->numDirty)
+			return cache->dirtyPages[--cache->numDirty];
+		if(cache->numZeroed)
+			return cache->zeroedPages[--cache->numZeroed];
+	}
 
 	// TODO: This could be solved better.
 	int target = 0;
@@ -61,6 +83,91 @@ PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
 		target++;
 	assert(size == (size_t(kPageSize) << target));
 
+	{
+		auto lock = frigg::guard(&_mutex);
+		if(_freePages > size / kPageSize) {
+			auto physical = _allocateFromBuddy(target, addressBits);
+			if(physical != PhysicalAddr(-1))
+				return physical;
+		}
+	}
+
+	// Before giving up, return the pages that are held by the per-CPU caches.
+	// This also makes contiguous ranges available again.
+	_reclaimCaches();
+
+	auto lock = frigg::guard(&_mutex);
+
+	assert(_freePages > size / kPageSize);
+
+	return _allocateFromBuddy(target, addressBits);
+}
+
+void PhysicalChunkAllocator::free(PhysicalAddr address, size_t size) {
+	auto irq_lock = frigg::guard(&irqMutex());
+
+	if(size == kPageSize) {
+		auto cache = &getCpuData()->pageCache;
+		auto cache_lock = frigg::guard(&cache->mutex);
+		if(cache->numDirty == PhysicalCpuCache::capacity)
+			_drainCache(cache);
+		assert(cache->numDirty < PhysicalCpuCache::capacity);
+		cache->dirtyPages[cache->numDirty++] = address;
+		return;
+	}
+
+	auto lock = frigg::guard(&_mutex);
+	
+	int target = 0;
+	while(size > (size_t(kPageSize) << target))
+		target++;
+
+	_freeToBuddy(address, target);
+}
+
+PhysicalAddr PhysicalChunkAllocator::allocateZeroed(size_t size, int addressBits) {
+	if(size == kPageSize && addressBits >= 64) {
+		auto irq_lock = frigg::guard(&irqMutex());
+
+		auto cache = &getCpuData()->pageCache;
+		auto cache_lock = frigg::guard(&cache->mutex);
+		if(cache->numZeroed)
+			return cache->zeroedPages[--cache->numZeroed];
+	}
+
+	auto physical = allocate(size, addressBits);
+	if(physical == PhysicalAddr(-1))
+		return physical;
+
+	for(size_t pg_progress = 0; pg_progress < size; pg_progress += kPageSize) {
+		PageAccessor accessor{physical + pg_progress};
+		memset(accessor.get(), 0, kPageSize);
+	}
+	return physical;
+}
+
+void PhysicalChunkAllocator::zeroIdlePages() {
+	assert(!intsAreEnabled());
+
+	// Zeroing is done with IRQs disabled; hence we only zero a few pages at a time.
+	auto cache = &getCpuData()->pageCache;
+	auto cache_lock = frigg::guard(&cache->mutex);
+	for(size_t i = 0; i < idleZeroBatch; i++) {
+		if(cache->numZeroed >= idleZeroTarget)
+			return;
+		if(!cache->numDirty)
+			_refillCache(cache);
+		if(!cache->numDirty)
+			return;
+
+		auto physical = cache->dirtyPages[--cache->numDirty];
+		PageAccessor accessor{physical};
+		memset(accessor.get(), 0, kPageSize);
+		cache->zeroedPages[cache->numZeroed++] = physical;
+	}
+}
+
+PhysicalAddr PhysicalChunkAllocator::_allocateFromBuddy(int target, int addressBits) {
 	if(logPhysicalAllocs)
 		frigg::infoLogger() << "thor: Allocating physical memory of order "
 					<< (target + kPageShift) << frigg::endLog;
@@ -73,20 +180,16 @@ PhysicalAddr PhysicalChunkAllocator::allocate(size_t size, int addressBits) {
 			continue;
 	//	frigg::infoLogger() << "Allocate " << (void *)physical << frigg::endLog;
 		assert(!(physical % (size_t(kPageSize) << target)));
+		_freePages -= size_t{1} << target;
+		_usedPages += size_t{1} << target;
 		return physical;
 	}
 
 	return static_cast<PhysicalAddr>(-1);
 }
 
-void PhysicalChunkAllocator::free(PhysicalAddr address, size_t size) {
-	auto irq_lock = frigg::guard(&irqMutex());
-	auto lock = frigg::guard(&_mutex);
-	
-	int target = 0;
-	while(size > (size_t(kPageSize) << target))
-		target++;
-
+void PhysicalChunkAllocator::_freeToBuddy(PhysicalAddr address, int target) {
+	auto size = size_t(kPageSize) << target;
 	for(int i = 0; i < _numRegions; i++) {
 		if(address < _allRegions[i].physicalBase)
 			continue;
@@ -103,17 +206,69 @@ void PhysicalChunkAllocator::free(PhysicalAddr address, size_t size) {
 	assert(!"Physical page is not part of any region");
 }
 
+// Pages in the per-CPU caches are accounted as used pages in _usedPages/_freePages.
+// The callers hold cache->mutex.
+void PhysicalChunkAllocator::_refillCache(PhysicalCpuCache *cache) {
+	auto lock = frigg::guard(&_mutex);
+
+	while(cache->numDirty < cacheBatch) {
+		// Keep the last page in reserve, similar to the assertion in allocate().
+		if(_freePages <= 1)
+			break;
+		auto physical = _allocateFromBuddy(0, 64);
+		if(physical == PhysicalAddr(-1))
+			break;
+		cache->dirtyPages[cache->numDirty++] = physical;
+	}
+}
+
+void PhysicalChunkAllocator::_drainCache(PhysicalCpuCache *cache) {
+	auto lock = frigg::guard(&_mutex);
+
+	for(size_t i = 0; i < cacheBatch && cache->numDirty; i++)
+		_freeToBuddy(cache->dirtyPages[--cache->numDirty], 0);
+}
+
+void PhysicalChunkAllocator::_reclaimCaches() {
+	assert(!intsAreEnabled());
+
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto cache = &getCpuData(i)->pageCache;
+		auto cache_lock = frigg::guard(&cache->mutex);
+		auto lock = frigg::guard(&_mutex);
+
+		while(cache->numDirty)
+			_freeToBuddy(cache->dirtyPages[--cache->numDirty], 0);
+		while(cache->numZeroed)
+			_freeToBuddy(cache->zeroedPages[--cache->numZeroed], 0);
+	}
+}
+
+size_t PhysicalChunkAllocator::_numCachedPages() {
+	size_t n = 0;
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto cache = &getCpuData(i)->pageCache;
+		auto cache_lock = frigg::guard(&cache->mutex);
+		n += cache->numDirty + cache->numZeroed;
+	}
+	return n;
+}
+
 size_t PhysicalChunkAllocator::numUsedPages() {
 	auto irq_lock = frigg::guard(&irqMutex());
+	auto cached = _numCachedPages();
 	auto lock = frigg::guard(&_mutex);
 
-	return _usedPages;
+	// The caches can shrink after they were counted.
+	return _usedPages > cached ? _usedPages - cached : 0;
 }
+
 size_t PhysicalChunkAllocator::numFreePages() {
 	auto irq_lock = frigg::guard(&irqMutex());
+	auto cached = _numCachedPages();
 	auto lock = frigg::guard(&_mutex);
 
-	return _freePages;
+	return _freePages + cached;
 }
 
 } // namespace thor
@@ -21,6 +21,26 @@ public:
 	void *access(PhysicalAddr physical);
 };
 
+// Per-CPU stacks of free order-0 pages in front of the buddy allocator.
+// This is part of CpuData. It may only be accessed with IRQs disabled.
+struct PhysicalCpuCache {
+	static constexpr size_t capacity = 64;
+
+	PhysicalCpuCache();
+
+	// Only contended if another CPU reclaims the pages of this cache.
+	// Must be taken before PhysicalChunkAllocator::_mutex.
+	frigg::TicketLock mutex;
+
+	// Pages with unspecified contents.
+	PhysicalAddr dirtyPages[capacity];
+	size_t numDirty;
+
+	// Pages that are known to be filled with zeros.
+	PhysicalAddr zeroedPages[capacity];
+	size_t numZeroed;
+};
+
 class PhysicalChunkAllocator {
 	typedef frigg::TicketLock Mutex;
 public:
@@ -32,10 +52,31 @@ public:
 	PhysicalAddr allocate(size_t size, int addressBits = 64);
 	void free(PhysicalAddr address, size_t size);
 
+	// Like allocate() but guarantees that the memory is filled with zeros.
+	// Prefers pages that were zeroed ahead of time by zeroIdlePages().
+	PhysicalAddr allocateZeroed(size_t size, int addressBits = 64);
+
+	// Zeroes a bounded number of pages into the current CPU's cache.
+	// Called by the scheduler before the CPU goes idle.
+	void zeroIdlePages();
+
+	// Pages in the per-CPU caches are counted as free.
 	size_t numUsedPages();
 	size_t numFreePages();
 
 private:
+	PhysicalAddr _allocateFromBuddy(int target, int addressBits);
+	void _freeToBuddy(PhysicalAddr address, int target);
+
+	void _refillCache(PhysicalCpuCache *cache);
+	void _drainCache(PhysicalCpuCache *cache);
+
+	// Returns the pages of all per-CPU caches to the buddy allocator.
+	void _reclaimCaches();
+
+	// Number of pages in all per-CPU caches.
+	size_t _numCachedPages();
+
 	Mutex _mutex;
 
 	struct Region {
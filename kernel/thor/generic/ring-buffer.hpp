@@ -2,81 +2,278 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <frg/optional.hpp>
 #include <frg/tuple.hpp>
 #include <frg/utility.hpp>
+#include <frigg/initializer.hpp>
 #include "../arch/x86/ints.hpp"
 
 namespace thor {
 
+// Header that precedes the payload of each record in a LogRingBuffer.
+struct LogRecordHeader {
+	// Value of the TSC when the record was written.
+	uint64_t timestamp;
+	uint32_t cpu;
+	// Size of the payload in bytes.
+	uint32_t size;
+};
+static_assert(sizeof(LogRecordHeader) == 16);
+
+// Ring buffer that stores the log records of a single CPU.
+// Only the owning CPU writes to the ring, hence writers do not take any locks.
+// Old records are overwritten when the ring is full; readers detect this
+// by comparing the reserve index to their position after copying a record.
 struct LogRingBuffer {
 	LogRingBuffer(uintptr_t storage, size_t size)
-	: size_{size}, enqueue_{0}, stor_{reinterpret_cast<char *>(storage)},
-	mutex_{} {
+	: size_{size}, stor_{reinterpret_cast<char *>(storage)},
+	reserve_{0}, commit_{0} {
 		assert(size_ && (size_ & (size_ - 1)) == 0);
 	}
 
-	void enqueue(char c) {
+	// Appends a record. May only be called on the owning CPU with IRQs disabled.
+	void enqueue(const LogRecordHeader &header, const void *payload) {
+		auto index = commit_.load(std::memory_order_relaxed);
+		auto end = index + sizeof(LogRecordHeader) + header.size;
+		assert(end - index <= size_);
+
+		// Publish the reservation before overwriting old records.
+		reserve_.store(end, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		copyIn_(index, &header, sizeof(LogRecordHeader));
+		copyIn_(index + sizeof(LogRecordHeader), payload, header.size);
+		commit_.store(end, std::memory_order_release);
+	}
+
+	// Index after the last complete record.
+	uint64_t enqueueIndex() {
+		return commit_.load(std::memory_order_acquire);
+	}
+
+	// Reads the header of the record at the given index.
+	// Returns false if the record was already overwritten.
+	bool peekHeader(uint64_t dequeue, LogRecordHeader &header) {
+		assert(dequeue < enqueueIndex());
+		copyOut_(&header, dequeue, sizeof(LogRecordHeader));
+		return isIntact_(dequeue);
+	}
+
+	// Copies the record (including its header) at the given index.
+	// Returns false if the record was already overwritten.
+	bool copyRecord(void *buffer, uint64_t dequeue, size_t size) {
+		assert(dequeue + size <= enqueueIndex());
+		copyOut_(buffer, dequeue, size);
+		return isIntact_(dequeue);
+	}
+
+	// Number of bytes between the given index and the last complete record.
+	size_t newDataSize(uint64_t dequeue) {
+		return frg::min(enqueueIndex() - dequeue, size_);
+	}
+
+private:
+	bool isIntact_(uint64_t dequeue) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return reserve_.load(std::memory_order_relaxed) - dequeue <= size_;
+	}
+
+	void copyIn_(uint64_t index, const void *data, size_t size) {
+		size_t i = 0;
+		while(i < size) {
+			auto offset = (index + i) & (size_ - 1);
+			auto chunk = frg::min(size_ - offset, size - i);
+			memcpy(stor_ + offset, reinterpret_cast<const char *>(data) + i, chunk);
+			i += chunk;
+		}
+	}
+
+	void copyOut_(void *buffer, uint64_t index, size_t size) {
+		size_t i = 0;
+		while(i < size) {
+			auto offset = (index + i) & (size_ - 1);
+			auto chunk = frg::min(size_ - offset, size - i);
+			memcpy(reinterpret_cast<char *>(buffer) + i, stor_ + offset, chunk);
+			i += chunk;
+		}
+	}
+
+	size_t size_;
+	char *stor_;
+	std::atomic<uint64_t> reserve_;
+	std::atomic<uint64_t> commit_;
+};
+
+// This is part of CpuData. It collects bytes that are logged on this CPU
+// until they are written to the CPU's LogRingBuffer as a single record.
+// It may only be accessed with IRQs disabled.
+struct LogCpuStaging {
+	static constexpr size_t maxPayload = 256 - sizeof(LogRecordHeader);
+
+	size_t size = 0;
+	// Last flush sequence of the PerCpuLogRing that this buffer has seen.
+	uint64_t flushSequence = 0;
+	char buffer[maxPayload];
+};
+
+// Set of per-CPU LogRingBuffers. Readers see a single stream that contains
+// the records of all CPUs in timestamp order. As the stream is assembled
+// while it is read, all reads have to continue at the position of the previous read;
+// dequeueInto() rejects other dequeue indices.
+struct PerCpuLogRing {
+	static constexpr size_t maxCpus = 64;
+
+	PerCpuLogRing(uintptr_t storage, size_t size)
+	: dequeue_{0}, lost_{0}, flushSequence_{0}, mutex_{} {
+		auto ringSize = size / maxCpus;
+		for(size_t i = 0; i < maxCpus; i++) {
+			rings_[i].initialize(storage + i * ringSize, ringSize);
+			cursors_[i] = 0;
+		}
+	}
+
+	// Writes a record to the ring of the given CPU.
+	// May only be called on that CPU with IRQs disabled.
+	void enqueue(uint32_t cpu, uint64_t timestamp, const void *payload, size_t size) {
+		assert(cpu < maxCpus);
+		LogRecordHeader header{timestamp, cpu, static_cast<uint32_t>(size)};
+		rings_[cpu]->enqueue(header, payload);
+	}
+
+	// Asks all CPUs to enqueue their partially filled LogCpuStaging buffers.
+	// CPUs do this when they log the next byte (see needsFlush()).
+	void requestFlush() {
+		flushSequence_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Returns true if the staging buffer needs to be enqueued even though it is not full.
+	// Updates the buffer's flush sequence. May only be called on the owning CPU.
+	bool needsFlush(LogCpuStaging &staging) {
+		auto sequence = flushSequence_.load(std::memory_order_relaxed);
+		if(staging.flushSequence == sequence)
+			return false;
+		staging.flushSequence = sequence;
+		return true;
+	}
+
+	// Copies whole records in timestamp order until the buffer is full.
+	// Returns the new dequeue index and the number of bytes copied, or a null optional
+	// if the given dequeue index is not the one returned by the previous read.
+	frg::optional<frg::tuple<uint64_t, size_t>>
+	dequeueInto(void *buffer, uint64_t dequeue, size_t size) {
 		auto irqLock = frigg::guard(&thor::irqMutex());
 		auto lock = frigg::guard(&mutex_);
-		stor_[enqueue_ & (size_ - 1)] = c;
-		enqueue_++;
+
+		if(dequeue != dequeue_)
+			return frg::null_opt;
+
+		size_t actualSize = 0;
+		while(true) {
+			LogRecordHeader header;
+			auto cpu = findOldest_(header);
+			if(cpu < 0)
+				break;
+			auto recordSize = sizeof(LogRecordHeader) + header.size;
+			if(actualSize + recordSize > size)
+				break;
+
+			auto ring = rings_[cpu].get();
+			if(ring->copyRecord(reinterpret_cast<char *>(buffer) + actualSize,
+					cursors_[cpu], recordSize)) {
+				cursors_[cpu] += recordSize;
+				actualSize += recordSize;
+			}else{
+				skipLost_(cpu);
+			}
+		}
+
+		dequeue_ += actualSize;
+		return frg::make_tuple(dequeue_, actualSize);
 	}
 
-	frg::tuple<uint64_t, size_t>
-	dequeueInto(void *buffer, size_t dequeue, size_t size) {
+	// Dequeue index that the next read has to pass to dequeueInto().
+	uint64_t dequeueIndex() {
+		auto irqLock = frigg::guard(&thor::irqMutex());
+		auto lock = frigg::guard(&mutex_);
+
+		return dequeue_;
+	}
+
+	// Total number of bytes that were overwritten before they could be read.
+	uint64_t lostBytes() {
 		auto irqLock = frigg::guard(&thor::irqMutex());
 		auto lock = frigg::guard(&mutex_);
-		size_t actualSize = frg::min(size, newDataSize(dequeue));
-		size_t i = 0;
-		while (i < actualSize) {
-			size_t readSize = frg::min(
-				size_ - ((dequeue + i) & (size_ - 1)),
-				actualSize - i
-			);
-
-			memcpy(
-				reinterpret_cast<char *>(buffer) + i,
-				stor_ + ((dequeue + i) & (size_ - 1)),
-				readSize
-			);
-
-			i += readSize;
-		}
 
-		return frg::make_tuple(dequeue + i, actualSize);
+		return lost_;
 	}
 
-	size_t enqueueIndex() {
+	uint64_t enqueueIndex() {
 		auto irqLock = frigg::guard(&thor::irqMutex());
 		auto lock = frigg::guard(&mutex_);
 
-		return enqueue_;
+		return dequeue_ + newDataSize_();
 	}
 
-	bool hasEnoughBytes(uint64_t dequeue, size_t wantedSize) {
+	bool hasEnoughBytes(uint64_t, size_t wantedSize) {
 		auto irqLock = frigg::guard(&thor::irqMutex());
 		auto lock = frigg::guard(&mutex_);
 
-		return newDataSize(dequeue) >= wantedSize;
+		return newDataSize_() >= wantedSize;
 	}
 
-	size_t wantedSize(uint64_t dequeue, size_t size) {
+	size_t wantedSize(uint64_t, size_t size) {
 		auto irqLock = frigg::guard(&thor::irqMutex());
 		auto lock = frigg::guard(&mutex_);
 
-		return frg::min(newDataSize(dequeue), size);
+		return frg::min(newDataSize_(), size);
 	}
 
 private:
-	size_t size_;
-	size_t enqueue_;
-	char *stor_;
+	// Returns the CPU whose next record has the smallest timestamp or -1 if there is none.
+	// Skips records that were overwritten.
+	int findOldest_(LogRecordHeader &oldest) {
+		int result = -1;
+		for(size_t i = 0; i < maxCpus; i++) {
+			auto ring = rings_[i].get();
+			if(cursors_[i] == ring->enqueueIndex())
+				continue;
+			LogRecordHeader header;
+			if(!ring->peekHeader(cursors_[i], header)) {
+				skipLost_(i);
+				continue;
+			}
 
-	frigg::TicketLock mutex_;
+			if(result < 0 || header.timestamp < oldest.timestamp) {
+				oldest = header;
+				result = i;
+			}
+		}
+		return result;
+	}
+
+	// Skips all records of the given CPU that have been written so far.
+	void skipLost_(size_t cpu) {
+		auto index = rings_[cpu]->enqueueIndex();
+		lost_ += index - cursors_[cpu];
+		cursors_[cpu] = index;
+	}
 
-	size_t newDataSize(size_t dequeue) const {
-		return frg::min(enqueue_ - dequeue, size_);
+	size_t newDataSize_() {
+		size_t size = 0;
+		for(size_t i = 0; i < maxCpus; i++)
+			size += rings_[i]->newDataSize(cursors_[i]);
+		return size;
 	}
+
+	frigg::LazyInitializer<LogRingBuffer> rings_[maxCpus];
+	uint64_t cursors_[maxCpus];
+	uint64_t dequeue_;
+	uint64_t lost_;
+	std::atomic<uint64_t> flushSequence_;
+
+	frigg::TicketLock mutex_;
 };
 
 } // namespace thor
@@ -8,11 +8,17 @@ namespace {
 	constexpr bool logNextBest = false;
 	constexpr bool logUpdates = false;
 	constexpr bool logTimeSlice = false;
+	constexpr bool logMigration = false;
 
 	constexpr bool disablePreemption = false;
 
 	// Minimum length of a preemption time slice in ns.
 	constexpr int64_t sliceGranularity = 10'000'000;
+
+	// Minimum time between two runs of the periodic load balancer in ns.
+	constexpr uint64_t balanceInterval = 4'000'000;
+
+	std::atomic<bool> loadBalancingEnabled{false};
 }
 
 int ScheduleEntity::orderPriority(const ScheduleEntity *a, const ScheduleEntity *b) {
@@ -24,8 +30,8 @@ bool ScheduleEntity::scheduleBefore(const ScheduleEntity *a, const ScheduleEntit
 			> b->baseUnfairness - b->refProgress; // Prefer greater unfairness.
 }
 
-ScheduleEntity::ScheduleEntity()
-: state{ScheduleState::null}, priority{0}, _refClock{0}, _runTime{0},
+ScheduleEntity::ScheduleEntity(ScheduleAffinity affinity)
+: state{ScheduleState::null}, affinity{affinity}, priority{0}, _refClock{0}, _runTime{0},
 		refProgress{0}, baseUnfairness{0} { }
 
 ScheduleEntity::~ScheduleEntity() {
@@ -90,6 +96,7 @@ void Scheduler::resume(ScheduleEntity *entity) {
 	
 	self->_waitQueue.push(entity);
 	self->_numWaiting++;
+	self->_updateLoad();
 
 	if(self == &getCpuData()->scheduler) {
 		if(self->_updatePreemption())
@@ -97,6 +104,24 @@ void Scheduler::resume(ScheduleEntity *entity) {
 	}else{
 		sendPingIpi(self->_cpuContext->localApicId);
 	}
+
+	if(entity->affinity == ScheduleAffinity::migratable)
+		self->_kickIdle();
+}
+
+void Scheduler::resumeOn(ScheduleEntity *entity, Scheduler *scheduler) {
+	// Attached entities are not part of any wait queue and their state is saved completely.
+	// The caller synchronizes with all other users of the entity (e.g., by taking the
+	// thread's lock), so we can simply switch the scheduler here.
+	assert(entity->state == ScheduleState::attached);
+	if(entity->affinity == ScheduleAffinity::migratable && entity->_scheduler != scheduler) {
+		if(logMigration)
+			frigg::infoLogger() << "thor: Moving entity " << (void *)entity
+					<< " to CPU " << scheduler->_cpuContext->localApicId
+					<< " on resume" << frigg::endLog;
+		entity->_scheduler = scheduler;
+	}
+	resume(entity);
 }
 
 void Scheduler::suspendCurrent() {
@@ -116,6 +141,7 @@ void Scheduler::suspendCurrent() {
 	entity->state = ScheduleState::attached;
 
 	self->_current = nullptr;
+	self->_updateLoad();
 }
 
 void Scheduler::suspendWaiting(ScheduleEntity *entity) {
@@ -140,6 +166,7 @@ void Scheduler::suspendWaiting(ScheduleEntity *entity) {
 
 	self->_waitQueue.remove(entity); // TODO: Pairing heap remove() is untested.
 	self->_numWaiting--;
+	self->_updateLoad();
 
 	if(self == &getCpuData()->scheduler) {
 		if(self->_updatePreemption())
@@ -149,9 +176,14 @@ void Scheduler::suspendWaiting(ScheduleEntity *entity) {
 	}
 }
 
+void Scheduler::enableLoadBalancing() {
+	loadBalancingEnabled.store(true, std::memory_order_release);
+}
+
 Scheduler::Scheduler(CpuData *cpu_context)
 : _cpuContext{cpu_context}, _current{nullptr},
-		_numWaiting{0}, _refClock{0}, _systemProgress{0} { }
+		_numWaiting{0}, _refClock{0}, _systemProgress{0},
+		_load{0}, _idle{false}, _balanceClock{0} { }
 
 Progress Scheduler::_liveUnfairness(const ScheduleEntity *entity) {
 	assert(entity->state == ScheduleState::active);
@@ -175,6 +207,14 @@ int64_t Scheduler::_liveRuntime(const ScheduleEntity *entity) {
 
 bool Scheduler::wantSchedule() {
 	assert(!intsAreEnabled());
+
+	// If we are idle, reschedule() will try to steal work from busy CPUs.
+	if(_idle.load(std::memory_order_relaxed) && _findBusiest(2))
+		return true;
+
+	// This needs to lock other schedulers; hence it runs before we take our own lock.
+	_balance(false);
+
 	auto lock = frigg::guard(&_mutex);
 
 	_updateSystemProgress();
@@ -189,16 +229,30 @@ void Scheduler::reschedule() {
 
 	if(_current)
 		_unschedule();
-	
+
+	if(_waitQueue.empty()) {
+		// Try to steal work from other CPUs before going idle.
+		// Other CPUs lock their own scheduler first; hence we cannot keep our lock here.
+		lock.unlock();
+		if(!_balance(true)) {
+			// Use the idle time to prepare zeroed pages for page faults.
+			physicalAllocator->zeroIdlePages();
+		}
+		lock.lock();
+		_updateSystemProgress();
+	}
+
 	_sliceClock = _refClock;
 	
 	if(_waitQueue.empty()) {
 		if(logScheduling)
 			frigg::infoLogger() << "System is idle" << frigg::endLog;
+		_idle.store(true, std::memory_order_relaxed);
 		lock.unlock();
 		suspendSelf();
 		frigg::panicLogger() << "Return from suspendSelf()" << frigg::endLog;
 	}
+	_idle.store(false, std::memory_order_relaxed);
 
 	_schedule();
 	assert(_current);
@@ -224,6 +278,7 @@ void Scheduler::_unschedule() {
 	}
 
 	_current = nullptr;
+	_updateLoad();
 }
 
 void Scheduler::_schedule() {
@@ -254,6 +309,7 @@ void Scheduler::_schedule() {
 				<< " ms" << frigg::endLog;
 
 	_current = entity;
+	_updateLoad();
 }
 
 void Scheduler::_updateSystemProgress() {
@@ -346,6 +402,128 @@ void Scheduler::_updateEntityStats(ScheduleEntity *entity) {
 	entity->_refClock = _refClock;
 }
 
+size_t Scheduler::_liveLoad() {
+	return _numWaiting + (_current ? 1 : 0);
+}
+
+void Scheduler::_updateLoad() {
+	_load.store(_liveLoad(), std::memory_order_relaxed);
+}
+
+// Pulls a single entity from the busiest CPU.
+// If idle is false, this is rate-limited to one attempt per balanceInterval.
+bool Scheduler::_balance(bool idle) {
+	assert(!intsAreEnabled());
+	if(!loadBalancingEnabled.load(std::memory_order_acquire))
+		return false;
+
+	if(!idle) {
+		assert(haveTimer());
+		auto now = systemClockSource()->currentNanos();
+		if(now - _balanceClock < balanceInterval)
+			return false;
+		_balanceClock = now;
+	}
+
+	// Only migrate if the victim has at least two more entities than we have.
+	// Otherwise, the migration would only move the imbalance to this CPU.
+	auto threshold = _load.load(std::memory_order_relaxed) + 2;
+	auto victim = _findBusiest(threshold);
+	if(!victim)
+		return false;
+	return _pullFrom(victim, threshold);
+}
+
+// Returns the CPU with the highest load that is at least threshold.
+// This function does not take any locks; the result is only a hint.
+Scheduler *Scheduler::_findBusiest(size_t threshold) {
+	if(!loadBalancingEnabled.load(std::memory_order_acquire))
+		return nullptr;
+
+	Scheduler *busiest = nullptr;
+	size_t busiestLoad = 0;
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto other = &getCpuData(i)->scheduler;
+		if(other == this)
+			continue;
+		auto load = other->_load.load(std::memory_order_relaxed);
+		if(load >= threshold && load > busiestLoad) {
+			busiest = other;
+			busiestLoad = load;
+		}
+	}
+	return busiest;
+}
+
+bool Scheduler::_pullFrom(Scheduler *victim, size_t threshold) {
+	assert(victim != this);
+
+	// Always lock the scheduler with the lower address first to avoid deadlocks.
+	auto first = frigg::min(this, victim);
+	auto second = frigg::max(this, victim);
+	auto first_lock = frigg::guard(&first->_mutex);
+	auto second_lock = frigg::guard(&second->_mutex);
+
+	// Re-check the condition now that we hold the locks.
+	if(victim->_waitQueue.empty() || victim->_liveLoad() < threshold)
+		return false;
+
+	// Entities in the wait queue have their state saved completely
+	// (the entity's own lock is only dropped after leaving its stack), so we can move them.
+	// We only look at the top of the heap; that is the entity that suffers most from the imbalance.
+	auto entity = victim->_waitQueue.top();
+	assert(entity->state == ScheduleState::active);
+	if(entity->affinity != ScheduleAffinity::migratable)
+		return false;
+
+	victim->_updateSystemProgress();
+	_updateSystemProgress();
+
+	// Fold the unfairness that the entity accumulated on the victim into its base unfairness.
+	// The current entity's unfairness depends on the number of waiting entities;
+	// hence it has to be updated before the wait queue changes (like in resume()).
+	if(victim->_current)
+		victim->_updateCurrentEntity();
+	victim->_updateWaitingEntity(entity);
+	victim->_updateEntityStats(entity);
+	victim->_waitQueue.pop();
+	victim->_numWaiting--;
+	victim->_updateLoad();
+
+	// From now on, the unfairness is tracked relative to our own system progress.
+	if(_current)
+		_updateCurrentEntity();
+	entity->_scheduler = this;
+	entity->refProgress = _systemProgress;
+	entity->_refClock = _refClock;
+	_waitQueue.push(entity);
+	_numWaiting++;
+	_updateLoad();
+
+	if(logMigration)
+		frigg::infoLogger() << "thor: Migrating entity " << (void *)entity
+				<< " from CPU " << victim->_cpuContext->localApicId
+				<< " to CPU " << _cpuContext->localApicId << frigg::endLog;
+	return true;
+}
+
+// Wakes up an idle CPU if this CPU has more work than it can run.
+// The idle CPU will then steal an entity in reschedule().
+void Scheduler::_kickIdle() {
+	if(!loadBalancingEnabled.load(std::memory_order_acquire))
+		return;
+	if(_load.load(std::memory_order_relaxed) < 2)
+		return;
+
+	for(int i = 0; i < getCpuCount(); i++) {
+		auto other = &getCpuData(i)->scheduler;
+		if(other == this || !other->_idle.load(std::memory_order_relaxed))
+			continue;
+		sendPingIpi(other->_cpuContext->localApicId);
+		return;
+	}
+}
+
 Scheduler *localScheduler() {
 	return &getCpuData()->scheduler;
 }
@@ -1,6 +1,7 @@
 #ifndef THOR_GENERIC_SCHEDULE_HPP
 #define THOR_GENERIC_SCHEDULE_HPP
 
+#include <atomic>
 #include <frg/list.hpp>
 #include <frg/pairing_heap.hpp>
 
@@ -14,6 +15,13 @@ enum class ScheduleState {
 	active
 };
 
+enum class ScheduleAffinity {
+	// The entity always runs on the CPU that it was associated with.
+	pinned,
+	// The entity may be moved to other CPUs by the load balancer.
+	migratable
+};
+
 // This needs to store a large timeframe.
 // For now, store it as 55.8 0 signed integer nanoseconds.
 using Progress = int64_t;
@@ -24,7 +32,7 @@ struct ScheduleEntity {
 	static int orderPriority(const ScheduleEntity *a, const ScheduleEntity *b);
 	static bool scheduleBefore(const ScheduleEntity *a, const ScheduleEntity *b);
 
-	ScheduleEntity();
+	ScheduleEntity(ScheduleAffinity affinity = ScheduleAffinity::pinned);
 
 	ScheduleEntity(const ScheduleEntity &) = delete;
 
@@ -43,6 +51,7 @@ private:
 	Scheduler *_scheduler;
 
 	ScheduleState state;
+	ScheduleAffinity affinity;
 	int priority;
 	
 	frg::pairing_heap_hook<ScheduleEntity> hook;
@@ -73,9 +82,15 @@ struct Scheduler {
 	static void setPriority(ScheduleEntity *entity, int priority);
 
 	static void resume(ScheduleEntity *entity);
+	// Like resume() but moves migratable entities to the given scheduler first.
+	static void resumeOn(ScheduleEntity *entity, Scheduler *scheduler);
 	static void suspendCurrent();
 	static void suspendWaiting(ScheduleEntity *entity);
 
+	// Allows idle and overloaded CPUs to exchange entities.
+	// Must only be called once all CPUs are online.
+	static void enableLoadBalancing();
+
 	Scheduler(CpuData *cpu_context);
 
 	Scheduler(const Scheduler &) = delete;
@@ -104,6 +119,15 @@ private:
 
 	void _updateEntityStats(ScheduleEntity *entity);
 
+private:
+	size_t _liveLoad();
+	void _updateLoad();
+
+	bool _balance(bool idle);
+	Scheduler *_findBusiest(size_t threshold);
+	bool _pullFrom(Scheduler *victim, size_t threshold);
+	void _kickIdle();
+
 	CpuData *_cpuContext;
 
 	frigg::TicketLock _mutex;
@@ -132,6 +156,16 @@ private:
 	// This variables stores sum{t = 0, ... T} w(t)/n(t).
 	// This allows us to easily track u_p(T) for all waiting processes.
 	Progress _systemProgress;
+
+	// Number of runnable (i.e. waiting or running) entities.
+	// This is read without taking _mutex by other CPUs.
+	std::atomic<size_t> _load;
+
+	// True while this CPU is halted in reschedule().
+	std::atomic<bool> _idle;
+
+	// Last time at which the periodic balancer ran on this CPU.
+	uint64_t _balanceClock;
 };
 
 Scheduler *localScheduler();
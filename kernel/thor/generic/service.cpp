@@ -101,6 +101,7 @@ namespace stdio {
 
 			fs::SvrResponse<KernelAlloc> resp(*kernelAlloc);
 			resp.set_error(managarm::fs::Errors::SUCCESS);
+			resp.set_size(data.size());
 
 			resp.SerializeToString(&_buffer);
 			serviceSend(_lane, _buffer.data(), _buffer.size(),
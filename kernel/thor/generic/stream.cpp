@@ -212,6 +212,8 @@ bool Stream::decrementPeers(Stream *stream, int lane) {
 			auto item = stream->_processQueue[!lane].pop_front();
 			_cancelItem(item, kErrEndOfLane);
 		}
+
+		stream->_cancelCalls(!lane, kErrEndOfLane);
 	}
 	return true;
 }
@@ -244,6 +246,140 @@ void Stream::shutdownLane(int lane) {
 		auto item = _processQueue[!lane].pop_front();
 		_cancelItem(item, kErrEndOfLane);
 	}
+
+	_cancelCalls(lane, kErrLaneShutdown);
+	_cancelCalls(!lane, kErrEndOfLane);
+}
+
+Error Stream::call(int lane, CallNode *node) {
+	node->_blocker.setup();
+
+	ReceiveNode *receiver = nullptr;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		auto lock = frigg::guard(&_mutex);
+		assert(!_laneBroken[lane]);
+
+		if(_laneShutDown[lane])
+			return kErrLaneShutdown;
+		if(_laneBroken[!lane] || _laneShutDown[!lane])
+			return kErrEndOfLane;
+
+		if(_receiveQueue[!lane].empty()) {
+			_callQueue[!lane].push_back(node);
+		}else{
+			receiver = _receiveQueue[!lane].pop_front();
+			_dispatchCall(!lane, node, receiver);
+		}
+	}
+
+	// We block immediately afterwards; hence, run the server on this CPU.
+	if(receiver)
+		Thread::unblockOtherLocally(&receiver->_blocker);
+
+	Thread::blockCurrent(&node->_blocker);
+	return node->_error;
+}
+
+Error Stream::replyAndReceive(int lane, const void *reply, size_t length, ReceiveNode *node) {
+	assert(length <= inlineCallSize);
+	node->_thread = getCurrentThread().get();
+	node->_blocker.setup();
+
+	CallNode *answered = nullptr;
+	bool wait = false;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		auto lock = frigg::guard(&_mutex);
+		assert(!_laneBroken[lane]);
+
+		// If the call was cancelled in the meantime, there is nothing to answer.
+		for(auto it = _serviceQueue[lane].begin(); it != _serviceQueue[lane].end(); ++it) {
+			if((*it)->_server != node->_thread)
+				continue;
+			answered = *it;
+			_serviceQueue[lane].erase(it);
+			memcpy(answered->_buffer, reply, length);
+			answered->_length = length;
+			break;
+		}
+
+		if(_laneShutDown[lane]) {
+			node->_error = kErrLaneShutdown;
+		}else if(_laneBroken[!lane] || _laneShutDown[!lane]) {
+			node->_error = kErrEndOfLane;
+		}else if(!_callQueue[lane].empty()) {
+			_dispatchCall(lane, _callQueue[lane].pop_front(), node);
+		}else{
+			_receiveQueue[lane].push_back(node);
+			wait = true;
+		}
+	}
+
+	if(answered) {
+		// If we are going to block, switch back to the caller directly.
+		if(wait) {
+			Thread::unblockOtherLocally(&answered->_blocker);
+		}else{
+			Thread::unblockOther(&answered->_blocker);
+		}
+	}
+
+	if(wait)
+		Thread::blockCurrent(&node->_blocker);
+	return node->_error;
+}
+
+void Stream::failCall(int lane, Error error) {
+	auto thread = getCurrentThread().get();
+
+	CallNode *failed = nullptr;
+	{
+		auto irq_lock = frigg::guard(&irqMutex());
+		auto lock = frigg::guard(&_mutex);
+
+		for(auto it = _serviceQueue[lane].begin(); it != _serviceQueue[lane].end(); ++it) {
+			if((*it)->_server != thread)
+				continue;
+			failed = *it;
+			_serviceQueue[lane].erase(it);
+			failed->_error = error;
+			failed->_length = 0;
+			break;
+		}
+	}
+
+	if(failed)
+		Thread::unblockOther(&failed->_blocker);
+}
+
+void Stream::_dispatchCall(int lane, CallNode *call, ReceiveNode *receiver) {
+	memcpy(receiver->_buffer, call->_buffer, call->_length);
+	receiver->_length = call->_length;
+	receiver->_error = kErrSuccess;
+
+	call->_server = receiver->_thread;
+	_serviceQueue[lane].push_back(call);
+}
+
+void Stream::_cancelCalls(int lane, Error error) {
+	auto cancelCall = [&] (CallNode *call) {
+		call->_error = error;
+		call->_length = 0;
+		Thread::unblockOther(&call->_blocker);
+	};
+
+	while(!_callQueue[!lane].empty())
+		cancelCall(_callQueue[!lane].pop_front());
+	while(!_serviceQueue[!lane].empty())
+		cancelCall(_serviceQueue[!lane].pop_front());
+
+	while(!_receiveQueue[lane].empty()) {
+		auto receiver = _receiveQueue[lane].pop_front();
+		receiver->_error = error;
+		receiver->_length = 0;
+		Thread::unblockOther(&receiver->_blocker);
+	}
 }
 
 void Stream::_cancelItem(StreamNode *item, Error error) {
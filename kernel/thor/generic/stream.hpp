@@ -169,6 +169,75 @@ using StreamList = frg::intrusive_list<
 	>
 >;
 
+// Maximal payload size of synchronous calls.
+constexpr size_t inlineCallSize = 128;
+
+// Synchronous calls (see Stream::call()) do not go through StreamNodes.
+// Instead, the caller blocks on a CallNode that lives on its kernel stack;
+// hence, no allocations are required on this path.
+struct CallNode {
+	friend struct Stream;
+
+	void setup(const void *request, size_t length) {
+		assert(length <= inlineCallSize);
+		memcpy(_buffer, request, length);
+		_length = length;
+		_error = kErrSuccess;
+	}
+
+	Error error() {
+		return _error;
+	}
+
+	// After the call completes, the buffer contains the response.
+	const void *data() {
+		return _buffer;
+	}
+
+	size_t length() {
+		return _length;
+	}
+
+	frg::default_list_hook<CallNode> hook;
+
+private:
+	ThreadBlocker _blocker;
+
+	// Thread that serves this call (null while the call is still pending).
+	Thread *_server = nullptr;
+
+	Error _error;
+	size_t _length;
+	char _buffer[inlineCallSize];
+};
+
+// Server-side counterpart of CallNode (see Stream::replyAndReceive()).
+struct ReceiveNode {
+	friend struct Stream;
+
+	Error error() {
+		return _error;
+	}
+
+	const void *data() {
+		return _buffer;
+	}
+
+	size_t length() {
+		return _length;
+	}
+
+	frg::default_list_hook<ReceiveNode> hook;
+
+private:
+	ThreadBlocker _blocker;
+	Thread *_thread;
+
+	Error _error;
+	size_t _length;
+	char _buffer[inlineCallSize];
+};
+
 struct Stream {
 	struct Submitter {
 		void enqueue(const LaneHandle &lane, StreamList &chain);
@@ -197,9 +266,28 @@ struct Stream {
 
 	void shutdownLane(int lane);
 
+	// Synchronous small-message calls. Those bypass the process queues:
+	// If a thread is blocked in replyAndReceive() on the peer lane, the request is copied
+	// directly to that thread and it is resumed on the current CPU (direct process switch).
+	// Blocks the current thread until the call is answered.
+	Error call(int lane, CallNode *node);
+
+	// Answers the call that the current thread received last on this lane (if any)
+	// and blocks the current thread until the next call arrives.
+	Error replyAndReceive(int lane, const void *reply, size_t length, ReceiveNode *node);
+
+	// Completes the call that the current thread received last on this lane (if any)
+	// with an error instead of a reply. Used if the request cannot be delivered.
+	void failCall(int lane, Error error);
+
 private:
 	static void _cancelItem(StreamNode *item, Error error);
 
+	// Cancels all synchronous calls and receives that were issued on the given lane.
+	void _cancelCalls(int lane, Error error);
+
+	void _dispatchCall(int lane, CallNode *call, ReceiveNode *receiver);
+
 	std::atomic<int> _peerCount[2];
 
 	frigg::TicketLock _mutex;
@@ -214,6 +302,38 @@ private:
 		>
 	> _processQueue[2];
 
+	// Protected by _mutex.
+	// All of these queues are indexed by the lane that serves the calls.
+	// Calls that were not yet picked up by a server.
+	frg::intrusive_list<
+		CallNode,
+		frg::locate_member<
+			CallNode,
+			frg::default_list_hook<CallNode>,
+			&CallNode::hook
+		>
+	> _callQueue[2];
+
+	// Calls that are currently being served (and still need a reply).
+	frg::intrusive_list<
+		CallNode,
+		frg::locate_member<
+			CallNode,
+			frg::default_list_hook<CallNode>,
+			&CallNode::hook
+		>
+	> _serviceQueue[2];
+
+	// Servers that wait for calls.
+	frg::intrusive_list<
+		ReceiveNode,
+		frg::locate_member<
+			ReceiveNode,
+			frg::default_list_hook<ReceiveNode>,
+			&ReceiveNode::hook
+		>
+	> _receiveQueue[2];
+
 	// Protected by _mutex.
 	// Further submissions cannot happen (lane went out-of-scope).
 	// Submissions to the paired lane return end-of-lane errors.
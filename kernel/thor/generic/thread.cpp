@@ -276,6 +276,25 @@ void Thread::unblockOther(ThreadBlocker *blocker) {
 	Scheduler::resume(thread);
 }
 
+void Thread::unblockOtherLocally(ThreadBlocker *blocker) {
+	auto thread = blocker->_thread;
+	auto irq_lock = frigg::guard(&irqMutex());
+	auto lock = frigg::guard(&thread->_mutex);
+
+	assert(!blocker->_done);
+	blocker->_done = true;
+
+	if(thread->_runState != kRunBlocked)
+		return;
+	
+	if(logRunStates)
+		frigg::infoLogger() << "thor: " << (void *)thread
+				<< " is deferred (via local unblock)" << frigg::endLog;
+
+	thread->_runState = kRunDeferred;
+	Scheduler::resumeOn(thread, localScheduler());
+}
+
 void Thread::killOther(frigg::UnsafePtr<Thread> thread) {
 	thread->_kill();
 }
@@ -310,7 +329,8 @@ Error Thread::resumeOther(frigg::UnsafePtr<Thread> thread) {
 
 Thread::Thread(frigg::SharedPtr<Universe> universe,
 		smarter::shared_ptr<AddressSpace, BindableHandle> address_space, AbiParameters abi)
-: flags{0}, _mainWorkQueue{this}, _pagingWorkQueue{this},
+: ScheduleEntity{ScheduleAffinity::migratable},
+		flags{0}, _mainWorkQueue{this}, _pagingWorkQueue{this},
 		_runState{kRunInterrupted}, _lastInterrupt{kIntrNull}, _stateSeq{1},
 		_numTicks{0}, _activationTick{0},
 		_pendingKill{false}, _pendingSignal{kSigNone}, _runCount{1},
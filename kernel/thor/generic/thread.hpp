@@ -121,6 +121,9 @@ public:
 	// State transitions that apply to arbitrary threads.
 	// TODO: interruptOther() needs an Interrupt argument.
 	static void unblockOther(ThreadBlocker *blocker);
+	// Like unblockOther() but runs the thread on the current CPU.
+	// This should be used if the current thread is about to block.
+	static void unblockOtherLocally(ThreadBlocker *blocker);
 	static void killOther(frigg::UnsafePtr<Thread> thread);
 	static void interruptOther(frigg::UnsafePtr<Thread> thread);
 	static Error resumeOther(frigg::UnsafePtr<Thread> thread);
@@ -154,7 +154,11 @@ struct Observer {
 
 	async::detached traverse(std::shared_ptr<Entity> root);
 
-	async::detached onAttach(std::shared_ptr<Entity> entity);
+	bool matches(const Entity *entity);
+
+	helix::BorrowedLane getLane() {
+		return _lane;
+	}
 
 private:
 	AnyFilter _filter;
@@ -178,9 +182,47 @@ static bool matchesFilter(const Entity *entity, const AnyFilter &filter) {
 	}
 }
 	
+// Sends an ATTACH message to each of the observers. As all observers receive the same
+// message, the messages are submitted to the kernel in a single batch.
+static async::detached notifyAttach(std::vector<std::shared_ptr<Observer>> observers,
+		std::shared_ptr<Entity> entity) {
+	managarm::mbus::SvrRequest req;
+	req.set_req_type(managarm::mbus::SvrReqType::ATTACH);
+	req.set_id(entity->getId());
+	for(auto kv : entity->getProperties()) {
+		auto entry = req.add_properties();
+		entry->set_name(kv.first);
+		entry->mutable_item()->mutable_string_item()->set_value(kv.second);
+	}
+
+	auto ser = req.SerializeAsString();
+
+	// Transmissions cannot be moved; hence we allocate them individually.
+	using Transmission = decltype(helix_ng::exchangeMsgs(
+			std::declval<helix_ng::SubmitBatch &>(), helix::BorrowedLane{},
+			helix_ng::sendBuffer(nullptr, 0)));
+	std::vector<std::unique_ptr<Transmission>> transmissions;
+
+	helix_ng::SubmitBatch batch;
+	for(auto &observer : observers)
+		transmissions.emplace_back(new auto(helix_ng::exchangeMsgs(batch, observer->getLane(),
+				helix_ng::sendBuffer(ser.data(), ser.size()))));
+	batch.submit();
+
+	for(auto &transmission : transmissions) {
+		auto [send_req] = co_await *transmission;
+		HEL_CHECK(send_req.error());
+	}
+}
+
 void Group::processAttach(std::shared_ptr<Entity> entity) {
+	std::vector<std::shared_ptr<Observer>> observers;
 	for(auto &observer_ptr : _observers)
-		observer_ptr->onAttach(entity);
+		if(observer_ptr->matches(entity.get()))
+			observers.push_back(observer_ptr);
+
+	if(!observers.empty())
+		notifyAttach(std::move(observers), std::move(entity));
 }
 
 async::detached Observer::traverse(std::shared_ptr<Entity> root) {
@@ -217,26 +259,8 @@ async::detached Observer::traverse(std::shared_ptr<Entity> root) {
 	}
 }
 
-async::detached Observer::onAttach(std::shared_ptr<Entity> entity) {
-	if(!matchesFilter(entity.get(), _filter)) 
-		co_return;
-	
-	helix::SendBuffer send_req;
-
-	managarm::mbus::SvrRequest req;
-	req.set_req_type(managarm::mbus::SvrReqType::ATTACH);
-	req.set_id(entity->getId());
-	for(auto kv : entity->getProperties()) {
-		auto entry = req.add_properties();
-		entry->set_name(kv.first);
-		entry->mutable_item()->mutable_string_item()->set_value(kv.second);
-	}
-
-	auto ser = req.SerializeAsString();
-	auto &&transmit = helix::submitAsync(_lane, helix::Dispatcher::global(),
-			helix::action(&send_req, ser.data(), ser.size()));
-	co_await transmit.async_wait();
-	HEL_CHECK(send_req.error());
+bool Observer::matches(const Entity *entity) {
+	return matchesFilter(entity, _filter);
 }
 
 std::unordered_map<int64_t, std::shared_ptr<Entity>> allEntities;
@@ -102,6 +102,8 @@ constexpr bool logStatusSeqlock = false;
 struct DeviceFile : File {
 private:
 	expected<off_t> seek(off_t offset, VfsSeek whence) override {
+		if(whence == VfsSeek::eof)
+			co_return co_await _file.seekEof(offset);
 		assert(whence == VfsSeek::absolute);
 		co_await _file.seekAbsolute(offset);
 		co_return offset;
@@ -109,8 +111,12 @@ private:
 
 	// TODO: Ensure that the process is null? Pass credentials of the thread in the request?
 	expected<size_t> readSome(Process *, void *data, size_t max_length) override {
-		size_t length = co_await _file.readSome(data, max_length);
-		co_return length;
+		auto result = co_await _file.readSome(data, max_length);
+		if(auto error = std::get_if<protocols::fs::Error>(&result); error) {
+			assert(*error == protocols::fs::Error::ioError);
+			co_return Error::ioError;
+		}
+		co_return std::get<size_t>(result);
 	}
 	
 	expected<PollResult> poll(Process *, uint64_t sequence,
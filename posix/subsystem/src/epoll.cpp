@@ -1,6 +1,7 @@
 
 #include <string.h>
 #include <iostream>
+#include <optional>
 
 #include <async/doorbell.hpp>
 #include <boost/intrusive/list.hpp>
@@ -27,6 +28,9 @@ private:
 	static constexpr State statePending = 4;
 	static constexpr State stateInitial = 8;
 
+	// Flags that control the behavior of an item; they are never reported as events.
+	static constexpr int privateFlags = EPOLLET | EPOLLONESHOT;
+
 	struct Item : boost::intrusive::list_base_hook<> {
 		Item(smarter::shared_ptr<OpenFile> epoll, Process *process,
 				smarter::shared_ptr<File> file, int mask, uint64_t cookie)
@@ -44,8 +48,31 @@ private:
 
 		async::cancellation_event cancelPoll;
 		expected<PollResult> pollFuture;
+
+		// Result of the poll() that made this item pending. If this is empty,
+		// waitForEvents() has to obtain the status of the file via checkStatus().
+		std::optional<PollResult> readyResult;
 	};
 
+	// Events that the item is interested in. This is zero for EPOLLONESHOT items
+	// that already reported an event and were not re-armed by modifyItem().
+	static int _interest(Item *item) {
+		return item->eventMask & ~privateFlags;
+	}
+
+	static void _startPoll(Item *item, uint64_t sequence) {
+		assert(!(item->state & statePolling));
+		item->state |= statePolling;
+
+		// Here, we assume that the lambda does not execute on the current stack.
+		// TODO: Use some callback queueing mechanism to ensure this.
+		item->cancelPoll.reset();
+		item->pollFuture = item->file->poll(item->process, sequence, item->cancelPoll);
+		item->pollFuture.then([item] {
+			_awaitPoll(item);
+		});
+	}
+
 	static void _awaitPoll(Item *item) {
 		assert(item->state & statePolling);
 		auto self = item->epoll.get();
@@ -54,66 +81,66 @@ private:
 		assert(item->pollFuture.ready());
 		auto result_or_error = std::move(item->pollFuture.value());
 		item->pollFuture = expected<PollResult>{};
+		item->state &= ~statePolling;
 
 		// Discard non-active and closed items.
 		if(!(item->state & stateActive)) {
-			item->state &= ~statePolling;
-			// TODO: We might have polling + pending items in the future.
-			assert(!item->state);
-			delete item;
+			if(!item->state)
+				delete item;
 			return;
 		}
 
 		auto error = std::get_if<Error>(&result_or_error);
 		if(error) {
 			assert(*error == Error::fileClosed);
-			item->state &= ~statePolling;
 			if(!item->state)
 				delete item;
 			return;
 		}
 
-		// TODO: Ignore items that are already pending.
-		// This will happen once we implement modifyItem().
-		assert(!(item->state & (stateInitial | statePending)));
+		// Items that are already pending are checked by waitForEvents() anyway.
+		// This happens if modifyItem() is called while we are polling.
+		if(item->state & (stateInitial | statePending))
+			return;
+
+		// Disarmed EPOLLONESHOT items are not watched until they are re-armed.
+		if(!_interest(item))
+			return;
 
 		// Note that items only become pending if there is an edge.
 		// This is the correct behavior for edge-triggered items.
 		// Level-triggered items stay pending until the event disappears.
 		auto result = std::get<PollResult>(result_or_error);
-		if((std::get<1>(result) & (item->eventMask | EPOLLERR | EPOLLHUP))
-				&& (std::get<2>(result) & (item->eventMask | EPOLLERR | EPOLLHUP))) {
+		if((std::get<1>(result) & _interest(item))
+				&& (std::get<2>(result) & _interest(item))) {
 			if(logEpoll)
 				std::cout << "posix.epoll \e[1;34m" << item->epoll->structName() << "\e[0m"
 						<< ": Item \e[1;34m" << item->file->structName()
 						<< "\e[0m becomes pending" << std::endl;
 
 			// Note that we stop watching once an item becomes pending.
-			// We do this as we have to poll() again anyway before we report the item.
-			item->state &= ~statePolling;
+			// The result of poll() is fresh, hence waitForEvents() can report it
+			// without asking the file for its status again.
 			item->state |= statePending;
-
-			self->_pendingQueue.push_back(*item);
-			self->_currentSeq++;
-			self->_statusBell.ring();
+			item->readyResult = result;
+			self->_pushPending(item);
 		}else{
-			// Here, we assume that the lambda does not execute on the current stack.
-			// TODO: Use some callback queueing mechanism to ensure this.
 			if(logEpoll)
 				std::cout << "posix.epoll \e[1;34m" << item->epoll->structName() << "\e[0m"
 						<< ": Item \e[1;34m" << item->file->structName()
 						<< "\e[0m still not pending after poll()."
 						<< " Mask is " << item->eventMask << ", while "
 						<< std::get<2>(result) << " is active" << std::endl;
-			item->cancelPoll.reset();
-			item->pollFuture = item->file->poll(item->process, std::get<0>(result),
-					item->cancelPoll);
-			item->pollFuture.then([item] {
-				_awaitPoll(item);
-			});
+			_startPoll(item, std::get<0>(result));
 		}
 	}
 
+	void _pushPending(Item *item) {
+		_pendingQueue.push_back(*item);
+		_currentSeq++;
+		_statusBell.ring();
+	}
+
 public:
 	~OpenFile() {
 		// Nothing to do here.
@@ -125,20 +152,34 @@ public:
 					<< file->structName() << "\e[0m. Mask is " << mask << std::endl;
 		// TODO: Fix the memory-leak.
 		assert(_fileMap.find(file.get()) == _fileMap.end());
+		// Like on Linux, EPOLLERR and EPOLLHUP are always reported.
 		auto item = new Item{smarter::static_pointer_cast<OpenFile>(weakFile().lock()),
-				process, std::move(file), mask, cookie};
+				process, std::move(file), mask | EPOLLERR | EPOLLHUP, cookie};
 		item->state |= stateInitial;
 
 		_fileMap.insert({item->file.get(), item});
-
-		_pendingQueue.push_back(*item);
-		_currentSeq++;
-		_statusBell.ring();
+		_pushPending(item);
 	}
 
 	void modifyItem(File *file, int mask, uint64_t cookie) {
-		std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Modifying item \e[1;34m"
-				<< file->structName() << "\e[0m. New mask is " << mask << std::endl;
+		if(logEpoll)
+			std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Modifying item \e[1;34m"
+					<< file->structName() << "\e[0m. New mask is " << mask << std::endl;
+		auto it = _fileMap.find(file);
+		assert(it != _fileMap.end());
+		auto item = it->second;
+		assert(item->state & stateActive);
+
+		// This also re-arms EPOLLONESHOT items.
+		item->eventMask = mask | EPOLLERR | EPOLLHUP;
+		item->cookie = cookie;
+
+		// The new mask might include events that are already active.
+		// Items that are still polling continue to do so until they become pending.
+		if(!(item->state & (stateInitial | statePending))) {
+			item->state |= stateInitial;
+			_pushPending(item);
+		}
 	}
 
 	void deleteItem(File *file) {
@@ -152,6 +193,10 @@ public:
 
 		_fileMap.erase(it);
 		item->state &= ~stateActive;
+
+		if(item->state & statePolling)
+			item->cancelPoll.cancel();
+
 		if(!item->state)
 			delete item;
 	}
@@ -190,26 +235,43 @@ public:
 					continue;
 				}
 
-				if(logEpoll)
-					std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Checking item "
-							<< "\e[1;34m" << item->file->structName() << "\e[0m" << std::endl;
-				auto result_or_error = co_await item->file->checkStatus(item->process);
-
-				// Discard closed items.
-				auto error = std::get_if<Error>(&result_or_error);
-				if(error) {
-					assert(*error == Error::fileClosed);
-					if(logEpoll)
-						std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Discarding"
-								" closed item \e[1;34m" << item->file->structName() << "\e[0m"
-								<< std::endl;
+				// Disarmed EPOLLONESHOT items are not reported until they are re-armed.
+				if(!_interest(item)) {
 					item->state &= ~(stateInitial | statePending);
-					if(!item->state)
-						delete item;
+					item->readyResult.reset();
 					continue;
 				}
 
-				auto result = std::get<PollResult>(result_or_error);
+				// Items that became pending in _awaitPoll() carry a fresh poll() result.
+				// Only items that were not woken up by their file need to be checked;
+				// this avoids a round trip to the file for each pending item.
+				PollResult result;
+				if(item->readyResult) {
+					result = *item->readyResult;
+					item->readyResult.reset();
+				}else{
+					if(logEpoll)
+						std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Checking item "
+								<< "\e[1;34m" << item->file->structName() << "\e[0m" << std::endl;
+					auto result_or_error = co_await item->file->checkStatus(item->process);
+
+					// Discard closed items.
+					auto error = std::get_if<Error>(&result_or_error);
+					if(error) {
+						assert(*error == Error::fileClosed);
+						if(logEpoll)
+							std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m: Discarding"
+									" closed item \e[1;34m" << item->file->structName() << "\e[0m"
+									<< std::endl;
+						item->state &= ~(stateInitial | statePending);
+						if(!item->state)
+							delete item;
+						continue;
+					}
+
+					result = std::get<PollResult>(result_or_error);
+				}
+
 				if(logEpoll)
 					std::cout << "posix.epoll \e[1;34m" << structName() << "\e[0m:"
 							" Item \e[1;34m" << item->file->structName() << "\e[0m"
@@ -217,30 +279,32 @@ public:
 							<< " is active" << std::endl;
 
 				// Abort early (i.e before requeuing) if the item is not pending.
-				auto status = std::get<2>(result) & (item->eventMask | EPOLLERR | EPOLLHUP);
+				auto status = std::get<2>(result) & _interest(item);
 				if(!status) {
-					// TODO: Once we implement modifyItem(), items can be both
-					// polling and pending at the same time. In this case, only poll
-					// if we are not already polling.
-					assert(!(item->state & statePolling));
 					item->state &= ~(stateInitial | statePending);
-					item->state |= statePolling;
 
 					// Once an item is not pending anymore, we continue watching it.
-					item->cancelPoll.reset();
-					item->pollFuture = item->file->poll(item->process, std::get<0>(result),
-							item->cancelPoll);
-					item->pollFuture.then([item] {
-						_awaitPoll(item);
-					});
-
+					// Items can still be polling if modifyItem() requeued them.
+					if(!(item->state & statePolling))
+						_startPoll(item, std::get<0>(result));
 					continue;
 				}
 
-				// We have to increment the sequence again as concurrent waiters
-				// might have seen an empty _pendingQueue.
-				// TODO: Edge-triggered watches should not be requeued here.
-				repoll_queue.push_back(*item);
+				if(item->eventMask & EPOLLONESHOT) {
+					// Disarm the item; modifyItem() re-arms it.
+					item->state &= ~(stateInitial | statePending);
+					item->eventMask &= privateFlags;
+				}else if(item->eventMask & EPOLLET) {
+					// Edge-triggered items are not requeued; they only become
+					// pending again once poll() reports a new edge.
+					item->state &= ~(stateInitial | statePending);
+					if(!(item->state & statePolling))
+						_startPoll(item, std::get<0>(result));
+				}else{
+					// We have to increment the sequence again as concurrent waiters
+					// might have seen an empty _pendingQueue.
+					repoll_queue.push_back(*item);
+				}
 
 				assert(k < max_events);
 				memset(events + k, 0, sizeof(struct epoll_event));
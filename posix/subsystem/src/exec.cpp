@@ -81,29 +81,44 @@ expected<ImageInfo> load(SharedFilePtr file,
 					throw std::runtime_error("Illegal combination of segment permissions");
 				}
 			}else{
-				// map the segment with write permission into this address space.
-				HelHandle segmentHandle;
-				HEL_CHECK(helAllocateMemory(mapLength, 0, nullptr, &segmentHandle));
+				if((phdr->p_flags & (PF_R | PF_W | PF_X)) != (PF_R | PF_W))
+					throw std::runtime_error("Illegal combination of segment permissions");
+				assert((phdr->p_offset & (kPageSize - 1)) == misalign);
 
-				void *window;
-				HEL_CHECK(helMapMemory(segmentHandle, kHelNullHandle, nullptr,
-						0, mapLength, kHelMapProtRead | kHelMapProtWrite, &window));
+				// Map the file-backed part of the segment as a copy-on-write view
+				// of the file's memory. Only pages that the process writes to are copied.
+				size_t fileLength = 0;
+				if(phdr->p_filesz) {
+					fileLength = (phdr->p_filesz + misalign + kPageSize - 1) & ~(kPageSize - 1);
+					HEL_CHECK(helLoadahead(fileMemory.getHandle(),
+							phdr->p_offset - misalign, fileLength));
 
-				// map the segment with correct permissions into the process.
-				if((phdr->p_flags & (PF_R | PF_W | PF_X)) == (PF_R | PF_W)) {
 					co_await vmContext->mapFile(mapAddress,
-							helix::UniqueDescriptor{segmentHandle}, file,
-							0, mapLength, true,
+							fileMemory.dup(), file,
+							phdr->p_offset - misalign, fileLength, true,
 							kHelMapProtRead | kHelMapProtWrite);
-				}else{
-					throw std::runtime_error("Illegal combination of segment permissions");
+
+					// The last page contains whatever follows the segment in the file.
+					// Zero it up to the page boundary; this copies (only) that page.
+					size_t tail = fileLength - misalign - phdr->p_filesz;
+					if(tail) {
+						static const char zeros[kPageSize] = {};
+						HEL_CHECK(helStoreForeign(vmContext->getSpace().getHandle(),
+								mapAddress + fileLength - tail, tail, zeros));
+					}
 				}
 
-				// read the segment contents from the file.
-				memset(window, 0, mapLength);
-				co_await file->seek(phdr->p_offset, VfsSeek::absolute);
-				co_await file->readExactly(nullptr, (char *)window + misalign, phdr->p_filesz);
-				HEL_CHECK(helUnmapMemory(kHelNullHandle, window, mapLength));
+				// The rest of the bss is backed by anonymous zero-filled memory.
+				if(mapLength > fileLength) {
+					HelHandle bssHandle;
+					HEL_CHECK(helAllocateMemory(mapLength - fileLength,
+							kHelAllocOnDemand, nullptr, &bssHandle));
+
+					co_await vmContext->mapFile(mapAddress + fileLength,
+							helix::UniqueDescriptor{bssHandle}, nullptr,
+							0, mapLength - fileLength, true,
+							kHelMapProtRead | kHelMapProtWrite);
+				}
 			}
 		}else if(phdr->p_type == PT_PHDR) {
 			info.phdrPtr = (char *)base + phdr->p_vaddr;
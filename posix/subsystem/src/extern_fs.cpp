@@ -32,6 +32,9 @@ private:
 	std::map<uint64_t, std::weak_ptr<DirectoryNode>> _activeStructural;
 	std::map<uint64_t, std::weak_ptr<Node>> _activePeripheralNodes;
 	std::map<std::pair<Node *, std::string>, std::weak_ptr<FsLink>> _activePeripheralLinks;
+
+	// Cookies that associate the two inotify events of a rename.
+	uint32_t _renameCookie = 0;
 };
 
 struct Node : FsNode {
@@ -99,8 +102,9 @@ struct Node : FsNode {
 	}
 
 public:
-	Node(uint64_t inode, helix::UniqueLane lane, Superblock *sb = nullptr)
-	: FsNode{sb}, _inode{inode}, _lane{std::move(lane)} { }
+	Node(uint64_t inode, helix::UniqueLane lane, Superblock *sb = nullptr,
+			FsNode::DefaultOps default_ops = 0)
+	: FsNode{sb, default_ops}, _inode{inode}, _lane{std::move(lane)} { }
 
 protected:
 	~Node() = default;
@@ -139,8 +143,19 @@ private:
 	// TODO: Ensure that the process is null? Pass credentials of the thread in the request?
 	expected<size_t>
 	readSome(Process *, void *data, size_t max_length) override {
-		size_t length = co_await _file.readSome(data, max_length);
-		co_return length;
+		auto result = co_await _file.readSome(data, max_length);
+		if(auto error = std::get_if<protocols::fs::Error>(&result); error) {
+			assert(*error == protocols::fs::Error::ioError);
+			co_return Error::ioError;
+		}
+		co_return std::get<size_t>(result);
+	}
+
+	expected<size_t> readEntryBatch(void *buffer, size_t max_length) override {
+		auto result = co_await _file.readEntryBatch(buffer, max_length);
+		if(std::get_if<protocols::fs::Error>(&result))
+			co_return Error::illegalArguments;
+		co_return std::get<size_t>(result);
 	}
 
 	// TODO: For extern_fs, we can simply return POLLIN | POLLOUT here.
@@ -375,6 +390,7 @@ private:
 
 			auto child = _sb->internalizeStructural(this, name,
 					resp.id(), pullNode.descriptor());
+			notifyObservers(FsObserver::createEvent, name, 0);
 			co_return child->treeLink();
 		} else {
 			co_return Error::illegalOperationTarget; // TODO
@@ -412,6 +428,7 @@ private:
 
 			auto child = _sb->internalizeStructural(this, name,
 					resp.id(), pullNode.descriptor());
+			notifyObservers(FsObserver::createEvent, name, 0);
 			co_return child->treeLink();
 		} else {
 			co_return Error::illegalOperationTarget; // TODO
@@ -495,6 +512,7 @@ private:
 		if(resp.error() == managarm::fs::Errors::SUCCESS) {
 			HEL_CHECK(pull_node.error());
 
+			notifyObservers(FsObserver::createEvent, name, 0);
 			if(resp.file_type() == managarm::fs::FileType::DIRECTORY) {
 				auto child = _sb->internalizeStructural(this, name,
 						resp.id(), pull_node.descriptor());
@@ -531,6 +549,7 @@ private:
 		managarm::fs::SvrResponse resp;
 		resp.ParseFromArray(recv_resp.data(), recv_resp.length());
 		assert(resp.error() == managarm::fs::Errors::SUCCESS);
+		notifyObservers(FsObserver::deleteEvent, name, 0);
 	}
 
 	FutureMaybe<SharedFilePtr>
@@ -575,12 +594,12 @@ private:
 
 public:
 	DirectoryNode(Superblock *sb, uint64_t inode, helix::UniqueLane lane)
-	: Node{inode, std::move(lane), sb}, _sb{sb},
+	: Node{inode, std::move(lane), sb, FsNode::defaultSupportsObservers}, _sb{sb},
 			_treeLink{this} { }
 
 	DirectoryNode(Superblock *sb, std::shared_ptr<Node> owner, std::string name,
 			uint64_t inode, helix::UniqueLane lane)
-	: Node{inode, std::move(lane), sb}, _sb{sb},
+	: Node{inode, std::move(lane), sb, FsNode::defaultSupportsObservers}, _sb{sb},
 			_treeLink{std::move(owner), this, std::move(name)} { }
 
 private:
@@ -661,6 +680,9 @@ async::result<std::shared_ptr<FsLink>> Superblock::rename(FsLink *source,
 	managarm::fs::SvrResponse resp;
 	resp.ParseFromArray(recv_resp.data(), recv_resp.length());
 	if(resp.error() == managarm::fs::Errors::SUCCESS) {
+		auto cookie = ++_renameCookie;
+		source_node->notifyObservers(FsObserver::moveFromEvent, source->getName(), cookie);
+		target_node->notifyObservers(FsObserver::moveToEvent, name, cookie);
 		co_return internalizePeripheralLink(target_node, name, shared_node);
 	}else{
 		co_return nullptr;
@@ -10,6 +10,35 @@ struct Socket : File {
 		_lane { std::move(sock_lane) } {
 	}
 
+	expected<AcceptResult> accept(Process *) override {
+		managarm::fs::CntRequest req;
+		req.set_req_type(managarm::fs::CntReqType::PT_ACCEPT);
+
+		auto ser = req.SerializeAsString();
+		auto [offer, send_req, recv_resp, pull_lane] = co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::recvInline(),
+				helix_ng::pullDescriptor()
+			)
+		);
+		HEL_CHECK(offer.error());
+		HEL_CHECK(send_req.error());
+		HEL_CHECK(recv_resp.error());
+
+		managarm::fs::SvrResponse resp;
+		resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+		// On error, the server does not send a descriptor and the pull fails.
+		if(resp.error() == managarm::fs::Errors::ILLEGAL_ARGUMENT)
+			co_return Error::illegalArguments;
+		assert(resp.error() == managarm::fs::Errors::SUCCESS);
+		HEL_CHECK(pull_lane.error());
+
+		co_return File::constructHandle(
+			smarter::make_shared<Socket>(pull_lane.descriptor()));
+	}
+
 	helix::BorrowedDescriptor getPassthroughLane() override {
 		return _lane;
 	}
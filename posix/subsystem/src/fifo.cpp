@@ -1,9 +1,10 @@
 
 #include <string.h>
 #include <sys/epoll.h>
+#include <algorithm>
 #include <iostream>
-#include <deque>
 #include <map>
+#include <memory>
 
 #include <async/doorbell.hpp>
 #include <helix/ipc.hpp>
@@ -17,16 +18,16 @@ namespace {
 
 constexpr bool logFifos = false;
 
-struct Packet {
-	// The actual octet data that the packet consists of.
-	std::vector<char> buffer;
-
-	size_t offset = 0;
-};
+// Writes of at most this many bytes are atomic, i.e., they are not interleaved
+// with data from other writes.
+constexpr size_t atomicWriteSize = 4096;
 
 struct Channel {
+	// Same default capacity as on Linux. Must be a power of two.
+	static constexpr size_t capacity = 64 * 1024;
+
 	Channel()
-	: writerCount{0}, readerCount{0} { }
+	: writerCount{0}, readerCount{0}, _ring{new char[capacity]} { }
 
 	// Status management for poll().
 	async::doorbell statusBell;
@@ -35,14 +36,49 @@ struct Channel {
 	uint64_t noWriterSeq = 0;
 	uint64_t noReaderSeq = 0;
 	uint64_t inSeq = 0;
+	// The pipe became writable when it was created.
+	uint64_t outSeq = 1;
 	int writerCount;
 	int readerCount;
 
 	async::doorbell readerPresent;
 	async::doorbell writerPresent;
 
-	// The actual queue of this pipe.
-	std::deque<Packet> packetQueue;
+	size_t bytesAvailable() {
+		return _tail - _head;
+	}
+
+	size_t spaceAvailable() {
+		return capacity - bytesAvailable();
+	}
+
+	// Copies data into the ring. The caller ensures that there is enough space.
+	void produce(const void *data, size_t length) {
+		assert(length <= spaceAvailable());
+		auto offset = _tail & (capacity - 1);
+		auto chunk = std::min(length, capacity - offset);
+		memcpy(_ring.get() + offset, data, chunk);
+		memcpy(_ring.get(), static_cast<const char *>(data) + chunk, length - chunk);
+		_tail += length;
+	}
+
+	// Copies data out of the ring. The caller ensures that enough data is available.
+	void consume(void *data, size_t length) {
+		assert(length <= bytesAvailable());
+		auto offset = _head & (capacity - 1);
+		auto chunk = std::min(length, capacity - offset);
+		memcpy(data, _ring.get() + offset, chunk);
+		memcpy(static_cast<char *>(data) + chunk, _ring.get(), length - chunk);
+		_head += length;
+	}
+
+private:
+	// The actual data of this pipe. _head and _tail count the bytes that
+	// were consumed and produced so far; they are reduced modulo capacity
+	// to obtain offsets into the ring.
+	std::unique_ptr<char[]> _ring;
+	size_t _head = 0;
+	size_t _tail = 0;
 };
 
 struct ReaderFile : File {
@@ -56,8 +92,9 @@ public:
 				smarter::shared_ptr<File>{file}, &File::fileOperations));
 	}
 
-	ReaderFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link)
-	: File{StructName::get("fifo.read"), mount, link, File::defaultPipeLikeSeek} { }
+	ReaderFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link, bool nonBlock)
+	: File{StructName::get("fifo.read"), mount, link, File::defaultPipeLikeSeek},
+			_nonBlock{nonBlock} { }
 
 	void connectChannel(std::shared_ptr<Channel> channel) {
 		assert(!_channel);
@@ -77,21 +114,21 @@ public:
 		if(logFifos)
 			std::cout << "posix: Read from pipe " << this << std::endl;
 
-		while(_channel->packetQueue.empty() && _channel->writerCount)
+		while(!_channel->bytesAvailable() && _channel->writerCount) {
+			if(_nonBlock)
+				co_return Error::wouldBlock;
 			co_await _channel->statusBell.async_wait();
+		}
 
-		if(_channel->packetQueue.empty()) {
+		if(!_channel->bytesAvailable()) {
 			assert(!_channel->writerCount);
 			co_return 0;
 		}
 
-		// TODO: Truncate packets (for SOCK_DGRAM) here.
-		auto packet = &_channel->packetQueue.front();
-		assert(!packet->offset);
-		auto size = packet->buffer.size();
-		assert(max_length >= size);
-		memcpy(data, packet->buffer.data(), size);
-		_channel->packetQueue.pop_front();
+		auto size = std::min(max_length, _channel->bytesAvailable());
+		_channel->consume(data, size);
+		_channel->outSeq = ++_channel->currentSeq;
+		_channel->statusBell.ring();
 		co_return size;
 	}
 
@@ -115,7 +152,7 @@ public:
 		int events = 0;
 		if(!_channel->writerCount)
 			events |= EPOLLHUP;
-		if(!_channel->packetQueue.empty())
+		if(_channel->bytesAvailable())
 			events |= EPOLLIN;
 
 		co_return PollResult(_channel->currentSeq, edges, events);
@@ -129,6 +166,7 @@ private:
 	helix::UniqueLane _passthrough;
 
 	std::shared_ptr<Channel> _channel;
+	bool _nonBlock;
 };
 
 struct WriterFile : File {
@@ -142,8 +180,9 @@ public:
 				smarter::shared_ptr<File>{file}, &File::fileOperations));
 	}
 
-	WriterFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link)
-	: File{StructName::get("fifo.write"), mount, link, File::defaultPipeLikeSeek} { }
+	WriterFile(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link, bool nonBlock)
+	: File{StructName::get("fifo.write"), mount, link, File::defaultPipeLikeSeek},
+			_nonBlock{nonBlock} { }
 
 	void connectChannel(std::shared_ptr<Channel> channel) {
 		assert(!_channel);
@@ -161,18 +200,35 @@ public:
 		_channel = nullptr;
 	}
 
-	FutureMaybe<void> writeAll(Process *process, const void *data, size_t max_length) override {
-
-		Packet packet;
-		packet.buffer.resize(max_length);
-		memcpy(packet.buffer.data(), data, max_length);
-		packet.offset = 0;
-
-		_channel->packetQueue.push_back(std::move(packet));
-		_channel->inSeq = ++_channel->currentSeq;
-		_channel->statusBell.ring();
-
-		co_return;
+	expected<size_t> writeSome(Process *, const void *data, size_t length) override {
+		// Small writes must be performed in one piece; larger writes
+		// are split into chunks that fit into the ring.
+		size_t needed = (length <= atomicWriteSize) ? length : 1;
+
+		size_t progress = 0;
+		while(progress < length) {
+			if(_nonBlock && progress)
+				break;
+			if(_nonBlock && _channel->readerCount && _channel->spaceAvailable() < needed)
+				co_return Error::wouldBlock;
+			while(_channel->spaceAvailable() < needed && _channel->readerCount)
+				co_await _channel->statusBell.async_wait();
+
+			// TODO: Raise SIGPIPE in addition to returning EPIPE.
+			if(!_channel->readerCount) {
+				if(progress)
+					break;
+				co_return Error::brokenPipe;
+			}
+
+			auto chunk = std::min(length - progress, _channel->spaceAvailable());
+			_channel->produce(static_cast<const char *>(data) + progress, chunk);
+			progress += chunk;
+
+			_channel->inSeq = ++_channel->currentSeq;
+			_channel->statusBell.ring();
+		}
+		co_return progress;
 	}
 
 	expected<PollResult> poll(Process *, uint64_t pastSeq,
@@ -186,11 +242,15 @@ public:
 		if(cancellation.is_cancellation_requested())
 			std::cout << "\e[33mposix: fifo::poll() cancellation is untested\e[39m" << std::endl;
 
-		int edges = EPOLLOUT;
+		int edges = 0;
+		if(_channel->outSeq > pastSeq)
+			edges |= EPOLLOUT;
 		if(_channel->noReaderSeq > pastSeq)
 			edges |= EPOLLERR;
 
-		int events = EPOLLOUT;
+		int events = 0;
+		if(_channel->spaceAvailable())
+			events |= EPOLLOUT;
 		if(!_channel->readerCount)
 			events |= EPOLLERR;
 
@@ -205,6 +265,7 @@ private:
 	helix::UniqueLane _passthrough;
 
 	std::shared_ptr<Channel> _channel;
+	bool _nonBlock;
 };
 
 } // anonymous namespace
@@ -232,7 +293,7 @@ openNamedChannel(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 	if (flags & semanticRead) {
 		assert(!(flags & semanticWrite));
 
-		auto r_file = smarter::make_shared<ReaderFile>(mount, link);
+		auto r_file = smarter::make_shared<ReaderFile>(mount, link, flags & semanticNonBlock);
 		r_file->setupWeakFile(r_file);
 		r_file->connectChannel(channel);
 
@@ -247,7 +308,7 @@ openNamedChannel(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 		assert(flags & semanticWrite);
 		assert(!(flags & semanticRead));
 
-		auto w_file = smarter::make_shared<WriterFile>(mount, link);
+		auto w_file = smarter::make_shared<WriterFile>(mount, link, flags & semanticNonBlock);
 		w_file->setupWeakFile(w_file);
 		w_file->connectChannel(channel);
 
@@ -261,11 +322,11 @@ openNamedChannel(std::shared_ptr<MountView> mount, std::shared_ptr<FsLink> link,
 	}
 }
 
-std::array<smarter::shared_ptr<File, FileHandle>, 2> createPair() {
+std::array<smarter::shared_ptr<File, FileHandle>, 2> createPair(bool nonBlock) {
 	auto link = SpecialLink::makeSpecialLink(VfsType::fifo, 0777);
 	auto channel = std::make_shared<Channel>();
-	auto r_file = smarter::make_shared<ReaderFile>(nullptr, link);
-	auto w_file = smarter::make_shared<WriterFile>(nullptr, link);
+	auto r_file = smarter::make_shared<ReaderFile>(nullptr, link, nonBlock);
+	auto w_file = smarter::make_shared<WriterFile>(nullptr, link, nonBlock);
 	r_file->setupWeakFile(r_file);
 	w_file->setupWeakFile(w_file);
 	r_file->connectChannel(channel);
@@ -68,17 +68,28 @@ File::ptRead(void *object, const char *credentials,
 		co_return protocols::fs::Error::illegalArguments;
 	}else if(error && *error == Error::wouldBlock) {
 		co_return protocols::fs::Error::wouldBlock;
+	}else if(error && *error == Error::ioError) {
+		co_return protocols::fs::Error::ioError;
 	}else{
 		assert(!error);
 		co_return std::get<size_t>(result);
 	}
 }
 
-async::result<void> File::ptWrite(void *object, const char *credentials,
+async::result<protocols::fs::WriteResult> File::ptWrite(void *object, const char *credentials,
 		const void *buffer, size_t length) {
 	auto self = static_cast<File *>(object);
 	auto process = findProcessWithCredentials(credentials);
-	return self->writeAll(process.get(), buffer, length);
+	auto result = co_await self->writeSome(process.get(), buffer, length);
+	auto error = std::get_if<Error>(&result);
+	if(error && *error == Error::wouldBlock) {
+		co_return protocols::fs::Error::wouldBlock;
+	}else if(error && *error == Error::brokenPipe) {
+		co_return protocols::fs::Error::brokenPipe;
+	}else{
+		assert(!error);
+		co_return std::get<size_t>(result);
+	}
 }
 
 async::result<ReadEntriesResult> File::ptReadEntries(void *object) {
@@ -86,6 +97,18 @@ async::result<ReadEntriesResult> File::ptReadEntries(void *object) {
 	return self->readEntries();
 }
 
+async::result<protocols::fs::ReadResult>
+File::ptReadEntryBatch(void *object, void *buffer, size_t max_length) {
+	auto self = static_cast<File *>(object);
+	auto result = co_await self->readEntryBatch(buffer, max_length);
+	auto error = std::get_if<Error>(&result);
+	if(error) {
+		assert(*error == Error::illegalArguments || *error == Error::illegalOperationTarget);
+		co_return protocols::fs::Error::illegalArguments;
+	}
+	co_return std::get<size_t>(result);
+}
+
 async::result<void> File::ptTruncate(void *object, size_t size) {
 	auto self = static_cast<File *>(object);
 	return self->truncate(size);
@@ -229,10 +252,19 @@ FutureMaybe<void> File::writeAll(Process *, const void *, size_t) {
 	throw std::runtime_error("posix: Object has no File::writeAll()");
 }
 
+expected<size_t> File::writeSome(Process *process, const void *data, size_t length) {
+	co_await writeAll(process, data, length);
+	co_return length;
+}
+
 async::result<ReadEntriesResult> File::readEntries() {
 	throw std::runtime_error("posix: Object has no File::readEntries()");
 }
 
+expected<size_t> File::readEntryBatch(void *, size_t) {
+	co_return Error::illegalOperationTarget;
+}
+
 async::result<protocols::fs::RecvResult>
 File::recvMsg(Process *, uint32_t, void *, size_t,
 		void *, size_t, size_t) {
@@ -291,7 +323,7 @@ async::result<void> File::setOption(int, int) {
 	throw std::runtime_error("posix: Object has no File::setOption()");
 }
 
-async::result<AcceptResult> File::accept(Process *) {
+expected<AcceptResult> File::accept(Process *) {
 	std::cout << "posix \e[1;34m" << structName()
 			<< "\e[0m: Object does not implement accept()" << std::endl;
 	throw std::runtime_error("posix: Object has no File::accept()");
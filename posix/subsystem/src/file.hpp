@@ -44,7 +44,10 @@ enum class Error {
 
 	insufficientPermissions,
 
-	accessDenied
+	accessDenied,
+
+	// The underlying device failed to transfer the data.
+	ioError
 };
 
 // TODO: Rename this enum as is not part of the VFS.
@@ -96,12 +99,15 @@ public:
 	static async::result<protocols::fs::ReadResult>
 	ptRead(void *object, const char *credentials, void *buffer, size_t length);
 
-	static async::result<void>
+	static async::result<protocols::fs::WriteResult>
 	ptWrite(void *object, const char *credentials, const void *buffer, size_t length);
 
 	static async::result<protocols::fs::ReadEntriesResult>
 	ptReadEntries(void *object);
 
+	static async::result<protocols::fs::ReadResult>
+	ptReadEntryBatch(void *object, void *buffer, size_t max_length);
+
 	static async::result<void>
 	ptTruncate(void *object, size_t size);
 
@@ -155,6 +161,7 @@ public:
 		.read = &ptRead,
 		.write = &ptWrite,
 		.readEntries = &ptReadEntries,
+		.readEntryBatch = &ptReadEntryBatch,
 		.truncate = &ptTruncate,
 		.fallocate = &ptAllocate,
 		.ioctl = &ptIoctl,
@@ -242,8 +249,16 @@ public:
 
 	virtual FutureMaybe<void> writeAll(Process *process, const void *data, size_t length);
 
+	// Like writeAll() but may write less than length bytes.
+	// The default implementation calls writeAll().
+	virtual expected<size_t> writeSome(Process *process, const void *data, size_t length);
+
 	virtual FutureMaybe<ReadEntriesResult> readEntries();
 
+	// Fills the buffer with protocols::fs::EntryRecords. Returns zero at the end of
+	// the directory and Error::illegalArguments if not even one entry fits.
+	virtual expected<size_t> readEntryBatch(void *buffer, size_t max_length);
+
 	virtual async::result<protocols::fs::RecvResult>
 		recvMsg(Process *process, uint32_t flags,
 			void *data, size_t max_length,
@@ -273,7 +288,7 @@ public:
 	virtual async::result<int> getOption(int option);
 	virtual async::result<void> setOption(int option, int value);
 
-	virtual async::result<AcceptResult> accept(Process *process);
+	virtual expected<AcceptResult> accept(Process *process);
 
 	virtual async::result<protocols::fs::Error> bind(Process *process,
 			const void *addr_ptr, size_t addr_length);
@@ -1,4 +1,5 @@
 
+#include <dirent.h>
 #include <string.h>
 #include <future>
 
@@ -6,6 +7,19 @@
 #include "common.hpp"
 #include "fs.hpp"
 
+uint8_t direntType(VfsType type) {
+	switch(type) {
+	case VfsType::directory: return DT_DIR;
+	case VfsType::regular: return DT_REG;
+	case VfsType::symlink: return DT_LNK;
+	case VfsType::charDevice: return DT_CHR;
+	case VfsType::blockDevice: return DT_BLK;
+	case VfsType::socket: return DT_SOCK;
+	case VfsType::fifo: return DT_FIFO;
+	default: return DT_UNKNOWN;
+	}
+}
+
 // --------------------------------------------------------
 // FsNode implementation.
 // --------------------------------------------------------
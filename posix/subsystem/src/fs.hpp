@@ -22,6 +22,9 @@ enum class VfsType {
 	null, directory, regular, symlink, charDevice, blockDevice, socket, fifo
 };
 
+// Converts a VfsType to the DT_* constant that is used in directory entries.
+uint8_t direntType(VfsType type);
+
 struct FileStats {
 	uint64_t inodeNumber;
 	int numLinks;
@@ -75,6 +78,9 @@ protected:
 
 public:
 	static constexpr uint32_t deleteEvent = 1;
+	static constexpr uint32_t createEvent = 2;
+	static constexpr uint32_t moveFromEvent = 4;
+	static constexpr uint32_t moveToEvent = 8;
 
 	virtual void observeNotification(uint32_t events,
 			const std::string &name, uint32_t cookie) = 0;
@@ -118,6 +124,11 @@ public:
 	// that links this directory from its parent.
 	virtual std::shared_ptr<FsLink> treeLink();
 
+	// File systems that support observers notify them about all changes of directory entries.
+	bool supportsObservers() {
+		return _defaultOps & defaultSupportsObservers;
+	}
+
 	virtual void addObserver(std::shared_ptr<FsObserver> observer);
 
 	virtual void removeObserver(FsObserver *observer);
@@ -161,7 +172,7 @@ public:
 	// Changes permissions on a node
 	virtual async::result<Error> chmod(int mode);
 
-protected:
+	// Called by file systems (directories only).
 	void notifyObservers(uint32_t inotifyEvents, const std::string &name, uint32_t cookie);
 
 private:
@@ -32,6 +32,12 @@ public:
 			uint32_t inotifyEvents = 0;
 			if(events & FsObserver::deleteEvent)
 				inotifyEvents |= IN_DELETE;
+			if(events & FsObserver::createEvent)
+				inotifyEvents |= IN_CREATE;
+			if(events & FsObserver::moveFromEvent)
+				inotifyEvents |= IN_MOVED_FROM;
+			if(events & FsObserver::moveToEvent)
+				inotifyEvents |= IN_MOVED_TO;
 			if(!(inotifyEvents & mask))
 				return;
 			file->_queue.push_back(Packet{descriptor, inotifyEvents & mask, name, cookie});
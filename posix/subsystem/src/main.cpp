@@ -10,8 +10,10 @@
 #include <sys/sysmacros.h>
 #include <sys/timerfd.h>
 #include <sys/wait.h>
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include <async/jump.hpp>
 #include <protocols/mbus/client.hpp>
@@ -526,2213 +528,2624 @@ async::detached serveSignals(std::shared_ptr<Process> self,
 		std::cout << "\e[33mposix: Exiting serveSignals()\e[39m" << std::endl;
 }
 
-async::result<void> serveRequests(std::shared_ptr<Process> self,
-		std::shared_ptr<Generation> generation) {
-	async::cancellation_token cancellation = generation->cancelServe;
+// --------------------------------------------------------
+// Request handlers
+// --------------------------------------------------------
 
-	async::cancellation_callback cancel_callback{cancellation, [&] {
-		HEL_CHECK(helShutdownLane(generation->posixLane.getHandle()));
-	}};
+async::result<void> sendErrorResponse(helix::BorrowedDescriptor conversation,
+		managarm::posix::Errors err) {
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(err);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-	while(true) {
-		helix::Accept accept;
-		helix::RecvInline recv_req;
+async::result<void> handleGetPid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_PID" << std::endl;
 
-		auto &&header = helix::submitAsync(generation->posixLane, helix::Dispatcher::global(),
-				helix::action(&accept));
-		co_await header.async_wait();
+	helix::SendBuffer send_resp;
 
-		if(accept.error() == kHelErrLaneShutdown)
-			break;
-		HEL_CHECK(accept.error());
-		auto conversation = accept.descriptor();
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(self->pid());
 
-		auto sendErrorResponse = [&conversation] (managarm::posix::Errors err) -> async::result<void> {
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(err);
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		};
+async::result<void> handleGetUid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_UID" << std::endl;
 
-		auto &&initiate = helix::submitAsync(conversation, helix::Dispatcher::global(),
-				helix::action(&recv_req));
-		co_await initiate.async_wait();
-		if(recv_req.error() == kHelErrBufferTooSmall) {
-			std::cout << "posix: Rejecting request due to RecvInline overflow" << std::endl;
-			continue;
-		}
-		HEL_CHECK(recv_req.error());
+	helix::SendBuffer send_resp;
 
-		managarm::posix::CntRequest req;
-		req.ParseFromArray(recv_req.data(), recv_req.length());
-		if(req.request_type() == managarm::posix::CntReqType::GET_PID) {
-			if(logRequests)
-				std::cout << "posix: GET_PID" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(self->uid());
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(self->pid());
+async::result<void> handleSetUid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SET_UID" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	Error err = self->setUid(req.uid());
+	if(err == Error::accessDenied) {
+		resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_UID) {
-			if(logRequests)
-				std::cout << "posix: GET_UID" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			helix::SendBuffer send_resp;
+async::result<void> handleGetEuid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_EUID" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->uid());
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SET_UID) {
-			if(logRequests)
-				std::cout << "posix: SET_UID" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			managarm::posix::SvrResponse resp;
-			Error err = self->setUid(req.uid());
-			if(err == Error::accessDenied) {
-				resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(self->euid());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_EUID) {
-			if(logRequests)
-				std::cout << "posix: GET_EUID" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			helix::SendBuffer send_resp;
+async::result<void> handleSetEuid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SET_EUID" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	Error err = self->setEuid(req.uid());
+	if(err == Error::accessDenied) {
+		resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->euid());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SET_EUID) {
-			if(logRequests)
-				std::cout << "posix: SET_EUID" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			managarm::posix::SvrResponse resp;
-			Error err = self->setEuid(req.uid());
-			if(err == Error::accessDenied) {
-				resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-			}
+async::result<void> handleGetGid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_GID" << std::endl;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_GID) {
-			if(logRequests)
-				std::cout << "posix: GET_GID" << std::endl;
+	helix::SendBuffer send_resp;
 
-			helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(self->gid());
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->gid());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_EGID) {
-			if(logRequests)
-				std::cout << "posix: GET_EGID" << std::endl;
+async::result<void> handleGetEgid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_EGID" << std::endl;
 
-			helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_uid(self->egid());
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_uid(self->egid());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SET_GID) {
-			if(logRequests)
-				std::cout << "posix: SET_GID" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			managarm::posix::SvrResponse resp;
-			Error err = self->setGid(req.uid());
-			if(err == Error::accessDenied) {
-				resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SET_EGID) {
-			if(logRequests)
-				std::cout << "posix: SET_EGID" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			managarm::posix::SvrResponse resp;
-			Error err = self->setEgid(req.uid());
-			if(err == Error::accessDenied) {
-				resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
-			} else if(err == Error::illegalArguments) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-			}
+async::result<void> handleSetGid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SET_GID" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	Error err = self->setGid(req.uid());
+	if(err == Error::accessDenied) {
+		resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::WAIT) {
-			if(logRequests)
-				std::cout << "posix: WAIT" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			assert(!(req.flags() & ~WNOHANG));
+async::result<void> handleSetEgid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SET_EGID" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	Error err = self->setEgid(req.uid());
+	if(err == Error::accessDenied) {
+		resp.set_error(managarm::posix::Errors::ACCESS_DENIED);
+	} else if(err == Error::illegalArguments) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+	}
 
-			TerminationState state;
-			auto pid = co_await self->wait(req.pid(), req.flags() & WNOHANG, &state);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			helix::SendBuffer send_resp;
+async::result<void> handleWait(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: WAIT" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_pid(pid);
+	assert(!(req.flags() & ~WNOHANG));
 
-			uint32_t mode = 0;
-			if(auto byExit = std::get_if<TerminationByExit>(&state); byExit) {
-				mode |= 0x200 | byExit->code; // 0x200 = normal exit().
-			}else if(auto bySignal = std::get_if<TerminationBySignal>(&state); bySignal) {
-				mode |= 0x400 | (bySignal->signo << 24); // 0x400 = killed by signal.
-			}else{
-				assert(std::holds_alternative<std::monostate>(state));
-			}
-			resp.set_mode(mode);
+	TerminationState state;
+	auto pid = co_await self->wait(req.pid(), req.flags() & WNOHANG, &state);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GET_RESOURCE_USAGE) {
-			if(logRequests)
-				std::cout << "posix: GET_RESOURCE_USAGE" << std::endl;
+	helix::SendBuffer send_resp;
 
-			HelThreadStats stats;
-			HEL_CHECK(helQueryThreadStats(generation->threadDescriptor.getHandle(), &stats));
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_pid(pid);
 
-			uint64_t user_time;
-			if(req.mode() == RUSAGE_SELF) {
-				user_time = stats.userTime;
-			}else if(req.mode() == RUSAGE_CHILDREN) {
-				user_time = self->accumulatedUsage().userTime;
-			}else{
-				std::cout << "\e[31mposix: GET_RESOURCE_USAGE mode is not supported\e[39m"
-						<< std::endl;
-				// TODO: Return an error response.
-			}
+	uint32_t mode = 0;
+	if(auto byExit = std::get_if<TerminationByExit>(&state); byExit) {
+		mode |= 0x200 | byExit->code; // 0x200 = normal exit().
+	}else if(auto bySignal = std::get_if<TerminationBySignal>(&state); bySignal) {
+		mode |= 0x400 | (bySignal->signo << 24); // 0x400 = killed by signal.
+	}else{
+		assert(std::holds_alternative<std::monostate>(state));
+	}
+	resp.set_mode(mode);
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_ru_user_time(stats.userTime);
+async::result<void> handleGetResourceUsage(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GET_RESOURCE_USAGE" << std::endl;
+
+	HelThreadStats stats;
+	HEL_CHECK(helQueryThreadStats(generation->threadDescriptor.getHandle(), &stats));
+
+	uint64_t user_time;
+	if(req.mode() == RUSAGE_SELF) {
+		user_time = stats.userTime;
+	}else if(req.mode() == RUSAGE_CHILDREN) {
+		user_time = self->accumulatedUsage().userTime;
+	}else{
+		std::cout << "\e[31mposix: GET_RESOURCE_USAGE mode is not supported\e[39m"
+				<< std::endl;
+		// TODO: Return an error response.
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_MAP) {
-			if(logRequests)
-				std::cout << "posix: VM_MAP size: " << (void *)(size_t)req.size() << std::endl;
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+	helix::SendBuffer send_resp;
 
-			// TODO: Validate req.flags().
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_ru_user_time(stats.userTime);
 
-			if(req.mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			uint32_t nativeFlags = 0;
+async::result<void> handleVmMap(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_MAP size: " << (void *)(size_t)req.size() << std::endl;
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+
+	// TODO: Validate req.flags().
+
+	if(req.mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			if(req.mode() & PROT_READ)
-				nativeFlags |= kHelMapProtRead;
-			if(req.mode() & PROT_WRITE)
-				nativeFlags |= kHelMapProtWrite;
-			if(req.mode() & PROT_EXEC)
-				nativeFlags |= kHelMapProtExecute;
+	uint32_t nativeFlags = 0;
+
+	if(req.mode() & PROT_READ)
+		nativeFlags |= kHelMapProtRead;
+	if(req.mode() & PROT_WRITE)
+		nativeFlags |= kHelMapProtWrite;
+	if(req.mode() & PROT_EXEC)
+		nativeFlags |= kHelMapProtExecute;
+
+	bool copyOnWrite;
+	if((req.flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_PRIVATE) {
+		copyOnWrite = true;
+	}else if((req.flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_SHARED) {
+		copyOnWrite = false;
+	}else{
+		throw std::runtime_error("posix: Handle illegal flags in VM_MAP");
+	}
 
-			bool copyOnWrite;
-			if((req.flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_PRIVATE) {
-				copyOnWrite = true;
-			}else if((req.flags() & (MAP_PRIVATE | MAP_SHARED)) == MAP_SHARED) {
-				copyOnWrite = false;
-			}else{
-				throw std::runtime_error("posix: Handle illegal flags in VM_MAP");
-			}
+	uintptr_t hint = 0;
+	if(req.flags() & MAP_FIXED)
+		hint = req.address_hint();
+
+	void *address;
+	if(req.flags() & MAP_ANONYMOUS) {
+		assert(req.fd() == -1);
+		assert(!req.rel_offset());
+
+		// TODO: this is a waste of memory. Use some always-zero memory instead.
+		HelHandle handle;
+		HEL_CHECK(helAllocateMemory(req.size(), 0, nullptr, &handle));
+
+		address = co_await self->vmContext()->mapFile(hint,
+				helix::UniqueDescriptor{handle}, nullptr,
+				0, req.size(), copyOnWrite, nativeFlags);
+	}else{
+		auto file = self->fileContext()->getFile(req.fd());
+		assert(file && "Illegal FD for VM_MAP");
+		auto memory = co_await file->accessMemory();
+		address = co_await self->vmContext()->mapFile(hint,
+				std::move(memory), std::move(file),
+				req.rel_offset(), req.size(), copyOnWrite, nativeFlags);
+	}
 
-			uintptr_t hint = 0;
-			if(req.flags() & MAP_FIXED)
-				hint = req.address_hint();
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_offset(reinterpret_cast<uintptr_t>(address));
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			void *address;
-			if(req.flags() & MAP_ANONYMOUS) {
-				assert(req.fd() == -1);
-				assert(!req.rel_offset());
+async::result<void> handleVmRemap(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_REMAP" << std::endl;
 
-				// TODO: this is a waste of memory. Use some always-zero memory instead.
-				HelHandle handle;
-				HEL_CHECK(helAllocateMemory(req.size(), 0, nullptr, &handle));
+	helix::SendBuffer send_resp;
 
-				address = co_await self->vmContext()->mapFile(hint,
-						helix::UniqueDescriptor{handle}, nullptr,
-						0, req.size(), copyOnWrite, nativeFlags);
-			}else{
-				auto file = self->fileContext()->getFile(req.fd());
-				assert(file && "Illegal FD for VM_MAP");
-				auto memory = co_await file->accessMemory();
-				address = co_await self->vmContext()->mapFile(hint,
-						std::move(memory), std::move(file),
-						req.rel_offset(), req.size(), copyOnWrite, nativeFlags);
-			}
+	auto address = co_await self->vmContext()->remapFile(
+			reinterpret_cast<void *>(req.address()), req.size(), req.new_size());
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_offset(reinterpret_cast<uintptr_t>(address));
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_REMAP) {
-			if(logRequests)
-				std::cout << "posix: VM_REMAP" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_offset(reinterpret_cast<uintptr_t>(address));
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto address = co_await self->vmContext()->remapFile(
-					reinterpret_cast<void *>(req.address()), req.size(), req.new_size());
+async::result<void> handleVmProtect(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_PROTECT" << std::endl;
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+
+	if(req.mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_offset(reinterpret_cast<uintptr_t>(address));
+	uint32_t native_flags = 0;
+	if(req.mode() & PROT_READ)
+		native_flags |= kHelMapProtRead;
+	if(req.mode() & PROT_WRITE)
+		native_flags |= kHelMapProtWrite;
+	if(req.mode() & PROT_EXEC)
+		native_flags |= kHelMapProtExecute;
+
+	co_await self->vmContext()->protectFile(
+			reinterpret_cast<void *>(req.address()), req.size(), native_flags);
+
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_PROTECT) {
-			if(logRequests)
-				std::cout << "posix: VM_PROTECT" << std::endl;
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+async::result<void> handleVmUnmap(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: VM_UNMAP address: " << (void *)req.address()
+				<< ", size: " << (void *)(size_t)req.size() << std::endl;
 
-			if(req.mode() & ~(PROT_READ | PROT_WRITE | PROT_EXEC)) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	helix::SendBuffer send_resp;
 
-			uint32_t native_flags = 0;
-			if(req.mode() & PROT_READ)
-				native_flags |= kHelMapProtRead;
-			if(req.mode() & PROT_WRITE)
-				native_flags |= kHelMapProtWrite;
-			if(req.mode() & PROT_EXEC)
-				native_flags |= kHelMapProtExecute;
+	self->vmContext()->unmapFile(reinterpret_cast<void *>(req.address()), req.size());
 
-			co_await self->vmContext()->protectFile(
-					reinterpret_cast<void *>(req.address()), req.size(), native_flags);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::VM_UNMAP) {
-			if(logRequests)
-				std::cout << "posix: VM_UNMAP address: " << (void *)req.address()
-						<< ", size: " << (void *)(size_t)req.size() << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			helix::SendBuffer send_resp;
+async::result<void> handleMount(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: MOUNT " << req.fs_type() << " on " << req.path()
+				<< " to " << req.target_path() << std::endl;
 
-			self->vmContext()->unmapFile(reinterpret_cast<void *>(req.address()), req.size());
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto target = co_await resolve(self->fsContext()->getRoot(),
+			self->fsContext()->getWorkingDirectory(), req.target_path());
+	if(!target.second) {
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::MOUNT) {
-			if(logRequests)
-				std::cout << "posix: MOUNT " << req.fs_type() << " on " << req.path()
-						<< " to " << req.target_path() << std::endl;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			helix::SendBuffer send_resp;
+	if(req.fs_type() == "procfs") {
+		target.first->mount(target.second, getProcfs());
+	}else if(req.fs_type() == "sysfs") {
+		target.first->mount(target.second, getSysfs());
+	}else if(req.fs_type() == "devtmpfs") {
+		target.first->mount(target.second, getDevtmpfs());
+	}else if(req.fs_type() == "tmpfs") {
+		target.first->mount(target.second, tmp_fs::createRoot());
+	}else if(req.fs_type() == "devpts") {
+		target.first->mount(target.second, pts::getFsRoot());
+	}else{
+		assert(req.fs_type() == "ext2");
+		auto source = co_await resolve(self->fsContext()->getRoot(),
+				self->fsContext()->getWorkingDirectory(), req.path());
+		assert(source.second);
+		assert(source.second->getTarget()->getType() == VfsType::blockDevice);
+		auto device = blockRegistry.get(source.second->getTarget()->readDevice());
+		auto link = co_await device->mount();
+		target.first->mount(target.second, std::move(link));
+	}
 
-			auto target = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.target_path());
-			if(!target.second) {
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	if(logRequests)
+		std::cout << "posix:     MOUNT succeeds" << std::endl;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			if(req.fs_type() == "procfs") {
-				target.first->mount(target.second, getProcfs());
-			}else if(req.fs_type() == "sysfs") {
-				target.first->mount(target.second, getSysfs());
-			}else if(req.fs_type() == "devtmpfs") {
-				target.first->mount(target.second, getDevtmpfs());
-			}else if(req.fs_type() == "tmpfs") {
-				target.first->mount(target.second, tmp_fs::createRoot());
-			}else if(req.fs_type() == "devpts") {
-				target.first->mount(target.second, pts::getFsRoot());
-			}else{
-				assert(req.fs_type() == "ext2");
-				auto source = co_await resolve(self->fsContext()->getRoot(),
-						self->fsContext()->getWorkingDirectory(), req.path());
-				assert(source.second);
-				assert(source.second->getTarget()->getType() == VfsType::blockDevice);
-				auto device = blockRegistry.get(source.second->getTarget()->readDevice());
-				auto link = co_await device->mount();
-				target.first->mount(target.second, std::move(link));
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			if(logRequests)
-				std::cout << "posix:     MOUNT succeeds" << std::endl;
+async::result<void> handleChroot(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CHROOT" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::CHROOT) {
-			if(logRequests)
-				std::cout << "posix: CHROOT" << std::endl;
+	auto path = co_await resolve(self->fsContext()->getRoot(),
+			self->fsContext()->getWorkingDirectory(), req.path());
+	if(path.second) {
+		self->fsContext()->changeRoot(path);
 
-			helix::SendBuffer send_resp;
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto path = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path());
-			if(path.second) {
-				self->fsContext()->changeRoot(path);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<void> handleChdir(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CHDIR" << std::endl;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::CHDIR) {
-			if(logRequests)
-				std::cout << "posix: CHDIR" << std::endl;
+	auto path = co_await resolve(self->fsContext()->getRoot(),
+			self->fsContext()->getWorkingDirectory(), req.path());
+	if(path.second) {
+		self->fsContext()->changeWorkingDirectory(path);
 
-			helix::SendBuffer send_resp;
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto path = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path());
-			if(path.second) {
-				self->fsContext()->changeWorkingDirectory(path);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<void> handleFchdir(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CHDIR" << std::endl;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	managarm::posix::SvrResponse resp;
+	helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::FCHDIR) {
-			if(logRequests)
-				std::cout << "posix: CHDIR" << std::endl;
+	auto file = self->fileContext()->getFile(req.fd());
 
-			managarm::posix::SvrResponse resp;
-			helix::SendBuffer send_resp;
+	if(!file) {
+		resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
 
-			auto file = self->fileContext()->getFile(req.fd());
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			if(!file) {
-				resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
+	self->fsContext()->changeWorkingDirectory({file->associatedMount(),
+			file->associatedLink()});
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			self->fsContext()->changeWorkingDirectory({file->associatedMount(),
-					file->associatedLink()});
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<void> handleAccessat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: ACCESSAT " << req.path() << std::endl;
+
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+
+	if(req.flags()) {
+		if(req.flags() & AT_SYMLINK_NOFOLLOW) {
+			std::cout << "posix: ACCESSAT flag handling AT_SYMLINK_NOFOLLOW is unimplemented" << std::endl;
+		} else if(req.flags() & AT_EACCESS) {
+			std::cout << "posix: ACCESSAT flag handling AT_EACCESS is unimplemented" << std::endl;
+		} else {
+			std::cout << "posix: ACCESSAT unknown flag is unimplemented: " << req.flags() << std::endl;
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return;
+		}
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::ACCESSAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: ACCESSAT " << req.path() << std::endl;
-
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-
-			if(req.flags()) {
-				if(req.flags() & AT_SYMLINK_NOFOLLOW) {
-					std::cout << "posix: ACCESSAT flag handling AT_SYMLINK_NOFOLLOW is unimplemented" << std::endl;
-				} else if(req.flags() & AT_EACCESS) {
-					std::cout << "posix: ACCESSAT flag handling AT_EACCESS is unimplemented" << std::endl;
-				} else {
-					std::cout << "posix: ACCESSAT unknown flag is unimplemented: " << req.flags() << std::endl;
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
-			}
+	if(req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
 
-			if(req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+		if(!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	auto path = co_await resolve(self->fsContext()->getRoot(),
+			relative_to, req.path());
 
-			auto path = co_await resolve(self->fsContext()->getRoot(),
-					relative_to, req.path());
+	if(path.second) {
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			if(path.second) {
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+		auto ser = resp.SerializeAsString();
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()));
+		HEL_CHECK(send_resp.error());
+	}else{
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return;
+	}
+}
 
-				auto ser = resp.SerializeAsString();
-				auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size()));
-				HEL_CHECK(send_resp.error());
-			}else{
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::MKDIRAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: MKDIRAT " << req.path() << std::endl;
+async::result<void> handleMkdirat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: MKDIRAT " << req.path() << std::endl;
 
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
 
-			if (!req.path().size()) {
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	if (!req.path().size()) {
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			if(req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+	if(req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
-			co_await resolver.resolve(resolvePrefix);
-			assert(resolver.currentLink());
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
+	co_await resolver.resolve(resolvePrefix);
+	assert(resolver.currentLink());
 
-			auto parent = resolver.currentLink()->getTarget();
-			if(co_await parent->getLink(resolver.nextComponent())) {
-				resp.set_error(managarm::posix::Errors::ALREADY_EXISTS);
+	auto parent = resolver.currentLink()->getTarget();
+	if(co_await parent->getLink(resolver.nextComponent())) {
+		resp.set_error(managarm::posix::Errors::ALREADY_EXISTS);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			auto result = co_await parent->mkdir(resolver.nextComponent());
-			if(auto error = std::get_if<Error>(&result); error) {
-				assert(*error == Error::illegalOperationTarget);
+	auto result = co_await parent->mkdir(resolver.nextComponent());
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalOperationTarget);
 
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		resp.set_error(managarm::posix::Errors::SUCCESS);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::MKFIFOAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: MKFIFOAT " << req.fd() << " " << req.path() << std::endl;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
 
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+async::result<void> handleMkfifoat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: MKFIFOAT " << req.fd() << " " << req.path() << std::endl;
 
-			if (!req.path().size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+	if (!req.path().size()) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return;
+	}
 
-			if (req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	if (req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
-			co_await resolver.resolve(resolvePrefix);
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			if (!resolver.currentLink()) {
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
+	co_await resolver.resolve(resolvePrefix);
 
-			auto parent = resolver.currentLink()->getTarget();
-			if(co_await parent->getLink(resolver.nextComponent())) {
-				co_await sendErrorResponse(managarm::posix::Errors::ALREADY_EXISTS);
-				continue;
-			}
+	if (!resolver.currentLink()) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return;
+	}
 
-			co_await parent->mkfifo(resolver.nextComponent(), req.mode());
+	auto parent = resolver.currentLink()->getTarget();
+	if(co_await parent->getLink(resolver.nextComponent())) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ALREADY_EXISTS);
+		co_return;
+	}
 
-			co_await sendErrorResponse(managarm::posix::Errors::SUCCESS);
-		}else if(req.request_type() == managarm::posix::CntReqType::LINKAT) {
-			if(logRequests)
-				std::cout << "posix: LINKAT" << std::endl;
+	co_await parent->mkfifo(resolver.nextComponent(), req.mode());
 
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+	co_await sendErrorResponse(conversation, managarm::posix::Errors::SUCCESS);
+}
 
-			if(!(req.flags() & ~(AT_EMPTY_PATH | AT_SYMLINK_FOLLOW))) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+async::result<void> handleLinkat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: LINKAT" << std::endl;
 
-			if(req.flags() & AT_EMPTY_PATH) {
-				std::cout << "posix: AT_EMPTY_PATH is unimplemented for linkat" << std::endl;
-			}
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
 
-			if(req.flags() & AT_SYMLINK_FOLLOW) {
-				std::cout << "posix: AT_SYMLINK_FOLLOW is unimplemented for linkat" << std::endl;
-			}
+	if(!(req.flags() & ~(AT_EMPTY_PATH | AT_SYMLINK_FOLLOW))) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return;
+	}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+	if(req.flags() & AT_EMPTY_PATH) {
+		std::cout << "posix: AT_EMPTY_PATH is unimplemented for linkat" << std::endl;
+	}
 
-			if(req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+	if(req.flags() & AT_SYMLINK_FOLLOW) {
+		std::cout << "posix: AT_SYMLINK_FOLLOW is unimplemented for linkat" << std::endl;
+	}
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
-			co_await resolver.resolve();
-			if(!resolver.currentLink()) {
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+		if(!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			if (req.newfd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.newfd());
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
+	co_await resolver.resolve();
+	if(!resolver.currentLink()) {
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
-				if(!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if (req.newfd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.newfd());
 
-			PathResolver new_resolver;
-			new_resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.target_path());
-			co_await new_resolver.resolve(resolvePrefix);
-			assert(new_resolver.currentLink());
+		if(!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-			auto target = resolver.currentLink()->getTarget();
-			auto directory = new_resolver.currentLink()->getTarget();
-			assert(target->superblock() == directory->superblock()); // Hard links across mount points are not allowed, return EXDEV
-			co_await directory->link(new_resolver.nextComponent(), target);
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	PathResolver new_resolver;
+	new_resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.target_path());
+	co_await new_resolver.resolve(resolvePrefix);
+	assert(new_resolver.currentLink());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
+	auto target = resolver.currentLink()->getTarget();
+	auto directory = new_resolver.currentLink()->getTarget();
+	assert(target->superblock() == directory->superblock()); // Hard links across mount points are not allowed, return EXDEV
+	co_await directory->link(new_resolver.nextComponent(), target);
 
-		}else if(req.request_type() == managarm::posix::CntReqType::SYMLINKAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: SYMLINK " << req.path() << std::endl;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			ViewPath relativeTo;
-			smarter::shared_ptr<File, FileHandle> file;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			if (!req.path().size()) {
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+async::result<void> handleSymlinkat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: SYMLINK " << req.path() << std::endl;
 
-			if(req.fd() == AT_FDCWD) {
-				relativeTo = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	ViewPath relativeTo;
+	smarter::shared_ptr<File, FileHandle> file;
 
-				relativeTo = {file->associatedMount(), file->associatedLink()};
-			}
+	if (!req.path().size()) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return;
+	}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relativeTo, req.path());
-			co_await resolver.resolve(resolvePrefix);
-			assert(resolver.currentLink());
-
-			auto parent = resolver.currentLink()->getTarget();
-			auto result = co_await parent->symlink(resolver.nextComponent(), req.target_path());
-			if(auto error = std::get_if<Error>(&result); error) {
-				assert(*error == Error::illegalOperationTarget);
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	if(req.fd() == AT_FDCWD) {
+		relativeTo = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+		relativeTo = {file->associatedMount(), file->associatedLink()};
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto [sendResp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size())
-			);
-			HEL_CHECK(sendResp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::RENAMEAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: RENAMEAT " << req.path()
-						<< " to " << req.target_path() << std::endl;
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relativeTo, req.path());
+	co_await resolver.resolve(resolvePrefix);
+	assert(resolver.currentLink());
+
+	auto parent = resolver.currentLink()->getTarget();
+	auto result = co_await parent->symlink(resolver.nextComponent(), req.target_path());
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalOperationTarget);
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return;
+	}
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+	auto ser = resp.SerializeAsString();
+	auto [sendResp] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::sendBuffer(ser.data(), ser.size())
+	);
+	HEL_CHECK(sendResp.error());
+}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
+async::result<void> handleRenameat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: RENAMEAT " << req.path()
+				<< " to " << req.target_path() << std::endl;
 
-			if (req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if (req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
+
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
+
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
+
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
+	co_await resolver.resolve();
+	if(!resolver.currentLink()) {
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
+
+	if (req.newfd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.newfd());
+
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
+
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
+	PathResolver new_resolver;
+	new_resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.target_path());
+	co_await new_resolver.resolve(resolvePrefix);
+	assert(new_resolver.currentLink());
+
+	auto superblock = resolver.currentLink()->getTarget()->superblock();
+	auto directory = new_resolver.currentLink()->getTarget();
+	assert(superblock == directory->superblock());
+	co_await superblock->rename(resolver.currentLink().get(),
+			directory.get(), new_resolver.nextComponent());
+
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
+
+async::result<void> handleFstatat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: FSTATAT request" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
+
+	if (req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
+
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
+
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
+
+	if (req.flags() & AT_EMPTY_PATH) {
+		target_link = file->associatedLink();
+	} else {
+		PathResolver resolver;
+		resolver.setup(self->fsContext()->getRoot(),
+				relative_to, req.path());
+
+		if (req.flags() & AT_SYMLINK_NOFOLLOW)
+			co_await resolver.resolve(resolveDontFollow);
+		else
 			co_await resolver.resolve();
-			if(!resolver.currentLink()) {
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		target_link = resolver.currentLink();
+	}
 
-			if (req.newfd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.newfd());
+	if (!target_link) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return;
+	}
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+	auto stats = co_await target_link->getTarget()->getStats();
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	DeviceId devnum;
+	switch(target_link->getTarget()->getType()) {
+	case VfsType::regular:
+		resp.set_file_type(managarm::posix::FT_REGULAR);
+		break;
+	case VfsType::directory:
+		resp.set_file_type(managarm::posix::FT_DIRECTORY);
+		break;
+	case VfsType::symlink:
+		resp.set_file_type(managarm::posix::FT_SYMLINK);
+		break;
+	case VfsType::charDevice:
+		resp.set_file_type(managarm::posix::FT_CHAR_DEVICE);
+		devnum = target_link->getTarget()->readDevice();
+		resp.set_ref_devnum(makedev(devnum.first, devnum.second));
+		break;
+	case VfsType::blockDevice:
+		resp.set_file_type(managarm::posix::FT_BLOCK_DEVICE);
+		devnum = target_link->getTarget()->readDevice();
+		resp.set_ref_devnum(makedev(devnum.first, devnum.second));
+		break;
+	case VfsType::socket:
+		resp.set_file_type(managarm::posix::FT_SOCKET);
+		break;
+	case VfsType::fifo:
+		resp.set_file_type(managarm::posix::FT_FIFO);
+		break;
+	default:
+		assert(target_link->getTarget()->getType() == VfsType::null);
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(stats.mode & ~0xFFFu)
+		std::cout << "\e[31m" "posix: FsNode::getStats() returned illegal mode of "
+				<< stats.mode << "\e[39m" << std::endl;
+
+	resp.set_fs_inode(stats.inodeNumber);
+	resp.set_mode(stats.mode);
+	resp.set_num_links(stats.numLinks);
+	resp.set_uid(stats.uid);
+	resp.set_gid(stats.gid);
+	resp.set_file_size(stats.fileSize);
+	resp.set_atime_secs(stats.atimeSecs);
+	resp.set_atime_nanos(stats.atimeNanos);
+	resp.set_mtime_secs(stats.mtimeSecs);
+	resp.set_mtime_nanos(stats.mtimeNanos);
+	resp.set_ctime_secs(stats.ctimeSecs);
+	resp.set_ctime_nanos(stats.ctimeNanos);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			PathResolver new_resolver;
-			new_resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.target_path());
-			co_await new_resolver.resolve(resolvePrefix);
-			assert(new_resolver.currentLink());
+async::result<void> handleFchmodat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: FCHMODAT request" << std::endl;
 
-			auto superblock = resolver.currentLink()->getTarget()->superblock();
-			auto directory = new_resolver.currentLink()->getTarget();
-			assert(superblock == directory->superblock());
-			co_await superblock->rename(resolver.currentLink().get(),
-					directory.get(), new_resolver.nextComponent());
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	if(req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
+
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
+
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
+
+	if(req.flags()) {
+		if(req.flags() & AT_SYMLINK_NOFOLLOW) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::NOT_SUPPORTED);
+			co_return;
+		} else if(req.flags() & AT_EMPTY_PATH) {
+			// Allowed, managarm extension
+		} else {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+			co_return;
+		}
+	}
+
+	if(req.flags() & AT_EMPTY_PATH) {
+		target_link = file->associatedLink();
+	} else {
+		PathResolver resolver;
+		resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
+
+		co_await resolver.resolve();
+
+		target_link = resolver.currentLink();
+	}
+
+	if (!target_link) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::FILE_NOT_FOUND);
+		co_return;
+	}
+
+	co_await target_link->getTarget()->chmod(req.mode());
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(
+		conversation,
+		helix_ng::sendBuffer(ser.data(), ser.size())
+	);
+	HEL_CHECK(send_resp.error());
+}
+
+async::result<void> handleReadlink(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: READLINK path: " << req.path() << std::endl;
+
+	helix::SendBuffer send_resp;
+	helix::SendBuffer send_data;
+
+	auto path = co_await resolve(self->fsContext()->getRoot(),
+			self->fsContext()->getWorkingDirectory(), req.path(), resolveDontFollow);
+	if(!path.second) {
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+				helix::action(&send_data, nullptr, 0));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
+
+	auto result = co_await path.second->getTarget()->readSymlink(path.second.get());
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalOperationTarget);
+
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+				helix::action(&send_data, nullptr, 0));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		auto &target = std::get<std::string>(result);
+
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+				helix::action(&send_data, target.data(), target.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
+
+async::result<void> handleOpen(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: OPEN path: " << req.path()	<< std::endl;
+
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+
+	assert(!(req.flags() & ~(managarm::posix::OF_CREATE
+			| managarm::posix::OF_EXCLUSIVE
+			| managarm::posix::OF_NONBLOCK
+			| managarm::posix::OF_CLOEXEC
+			| managarm::posix::OF_RDONLY
+			| managarm::posix::OF_WRONLY
+			| managarm::posix::OF_RDWR)));
+
+	SemanticFlags semantic_flags = 0;
+	if(req.flags() & managarm::posix::OF_NONBLOCK)
+		semantic_flags |= semanticNonBlock;
+
+	if (req.flags() & managarm::posix::OF_RDONLY)
+		semantic_flags |= semanticRead;
+	else if (req.flags() & managarm::posix::OF_WRONLY)
+		semantic_flags |= semanticWrite;
+	else if (req.flags() & managarm::posix::OF_RDWR)
+		semantic_flags |= semanticRead | semanticWrite;
+
+	smarter::shared_ptr<File, FileHandle> file;
+
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			self->fsContext()->getWorkingDirectory(), req.path());
+	if(req.flags() & managarm::posix::OF_CREATE) {
+		co_await resolver.resolve(resolvePrefix);
+		if(!resolver.currentLink()) {
+			resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FSTATAT) {
-			if(logRequests)
-				std::cout << "posix: FSTATAT request" << std::endl;
+			co_return;
+		}
 
-			helix::SendBuffer send_resp;
+		if(logRequests)
+			std::cout << "posix: Creating file " << req.path() << std::endl;
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+		auto directory = resolver.currentLink()->getTarget();
+		auto tail = co_await directory->getLink(resolver.nextComponent());
+		if(tail) {
+			if(req.flags() & managarm::posix::OF_EXCLUSIVE) {
+				resp.set_error(managarm::posix::Errors::ALREADY_EXISTS);
 
-			if (req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+				auto ser = resp.SerializeAsString();
+				auto &&transmit = helix::submitAsync(conversation,
+						helix::Dispatcher::global(),
+						helix::action(&send_resp, ser.data(), ser.size()));
+				co_await transmit.async_wait();
+				HEL_CHECK(send_resp.error());
+				co_return;
+			}else{
+				file = co_await tail->getTarget()->open(
+						resolver.currentView(), std::move(tail),
+						semantic_flags);
+				assert(file);
+			}
+		}else{
+			assert(directory->superblock());
+			auto node = co_await directory->superblock()->createRegular();
+			// Due to races, link() can fail here.
+			// TODO: Implement a version of link() that eithers links the new node
+			// or returns the current node without failing.
+			auto link = co_await directory->link(resolver.nextComponent(), node);
+			file = co_await node->open(resolver.currentView(), std::move(link),
+					semantic_flags);
+			assert(file);
+		}
+	}else{
+		co_await resolver.resolve();
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		if(resolver.currentLink()) {
+			auto target = resolver.currentLink()->getTarget();
+			file = co_await target->open(resolver.currentView(), resolver.currentLink(),
+					semantic_flags);
+		}
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(file) {
+		auto fd = self->fileContext()->attachFile(file,
+				req.flags() & managarm::posix::OF_CLOEXEC);
+		if(!fd) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+			co_return;
+		}
 
-			if (req.flags() & AT_EMPTY_PATH) {
-				target_link = file->associatedLink();
-			} else {
-				PathResolver resolver;
-				resolver.setup(self->fsContext()->getRoot(),
-						relative_to, req.path());
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+		resp.set_fd(*fd);
 
-				if (req.flags() & AT_SYMLINK_NOFOLLOW)
-					co_await resolver.resolve(resolveDontFollow);
-				else
-					co_await resolver.resolve();
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		if(logRequests)
+			std::cout << "posix:     OPEN failed: file not found" << std::endl;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
 
-				target_link = resolver.currentLink();
-			}
+async::result<void> handleOpenat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: OPENAT path: " << req.path()	<< std::endl;
+
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+
+	if((req.flags() & ~(managarm::posix::OF_CREATE
+			| managarm::posix::OF_EXCLUSIVE
+			| managarm::posix::OF_NONBLOCK
+			| managarm::posix::OF_CLOEXEC
+			| managarm::posix::OF_RDONLY
+			| managarm::posix::OF_WRONLY
+			| managarm::posix::OF_RDWR))) {
+		std::cout << "posix: OPENAT flags not recognized: " << req.flags() << std::endl;
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return;
+	}
 
-			if (!target_link) {
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
+	SemanticFlags semantic_flags = 0;
+	if(req.flags() & managarm::posix::OF_NONBLOCK)
+		semantic_flags |= semanticNonBlock;
 
-			auto stats = co_await target_link->getTarget()->getStats();
+	if (req.flags() & managarm::posix::OF_RDONLY)
+		semantic_flags |= semanticRead;
+	else if (req.flags() & managarm::posix::OF_WRONLY)
+		semantic_flags |= semanticWrite;
+	else if (req.flags() & managarm::posix::OF_RDWR)
+		semantic_flags |= semanticRead | semanticWrite;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
+
+	if(req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
+
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-			DeviceId devnum;
-			switch(target_link->getTarget()->getType()) {
-			case VfsType::regular:
-				resp.set_file_type(managarm::posix::FT_REGULAR);
-				break;
-			case VfsType::directory:
-				resp.set_file_type(managarm::posix::FT_DIRECTORY);
-				break;
-			case VfsType::symlink:
-				resp.set_file_type(managarm::posix::FT_SYMLINK);
-				break;
-			case VfsType::charDevice:
-				resp.set_file_type(managarm::posix::FT_CHAR_DEVICE);
-				devnum = target_link->getTarget()->readDevice();
-				resp.set_ref_devnum(makedev(devnum.first, devnum.second));
-				break;
-			case VfsType::blockDevice:
-				resp.set_file_type(managarm::posix::FT_BLOCK_DEVICE);
-				devnum = target_link->getTarget()->readDevice();
-				resp.set_ref_devnum(makedev(devnum.first, devnum.second));
-				break;
-			case VfsType::socket:
-				resp.set_file_type(managarm::posix::FT_SOCKET);
-				break;
-			case VfsType::fifo:
-				resp.set_file_type(managarm::posix::FT_FIFO);
-				break;
-			default:
-				assert(target_link->getTarget()->getType() == VfsType::null);
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			if(stats.mode & ~0xFFFu)
-				std::cout << "\e[31m" "posix: FsNode::getStats() returned illegal mode of "
-						<< stats.mode << "\e[39m" << std::endl;
-
-			resp.set_fs_inode(stats.inodeNumber);
-			resp.set_mode(stats.mode);
-			resp.set_num_links(stats.numLinks);
-			resp.set_uid(stats.uid);
-			resp.set_gid(stats.gid);
-			resp.set_file_size(stats.fileSize);
-			resp.set_atime_secs(stats.atimeSecs);
-			resp.set_atime_nanos(stats.atimeNanos);
-			resp.set_mtime_secs(stats.mtimeSecs);
-			resp.set_mtime_nanos(stats.mtimeNanos);
-			resp.set_ctime_secs(stats.ctimeSecs);
-			resp.set_ctime_nanos(stats.ctimeNanos);
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
+	if(req.flags() & managarm::posix::OF_CREATE) {
+		co_await resolver.resolve(resolvePrefix);
+		if(!resolver.currentLink()) {
+			resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
 			auto ser = resp.SerializeAsString();
 			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
 					helix::action(&send_resp, ser.data(), ser.size()));
 			co_await transmit.async_wait();
 			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FCHMODAT) {
-			if(logRequests)
-				std::cout << "posix: FCHMODAT request" << std::endl;
-
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
-
-			if(req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+			co_return;
+		}
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		if(logRequests)
+			std::cout << "posix: Creating file " << req.path() << std::endl;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+		auto directory = resolver.currentLink()->getTarget();
+		auto tail = co_await directory->getLink(resolver.nextComponent());
+		if(tail) {
+			if(req.flags() & managarm::posix::OF_EXCLUSIVE) {
+				resp.set_error(managarm::posix::Errors::ALREADY_EXISTS);
 
-			if(req.flags()) {
-				if(req.flags() & AT_SYMLINK_NOFOLLOW) {
-					co_await sendErrorResponse(managarm::posix::Errors::NOT_SUPPORTED);
-					continue;
-				} else if(req.flags() & AT_EMPTY_PATH) {
-					// Allowed, managarm extension
-				} else {
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-					continue;
-				}
+				auto ser = resp.SerializeAsString();
+				auto &&transmit = helix::submitAsync(conversation,
+						helix::Dispatcher::global(),
+						helix::action(&send_resp, ser.data(), ser.size()));
+				co_await transmit.async_wait();
+				HEL_CHECK(send_resp.error());
+				co_return;
+			}else{
+				file = co_await tail->getTarget()->open(
+						resolver.currentView(), std::move(tail),
+						semantic_flags);
+				assert(file);
 			}
+		}else{
+			assert(directory->superblock());
+			auto node = co_await directory->superblock()->createRegular();
+			// Due to races, link() can fail here.
+			// TODO: Implement a version of link() that eithers links the new node
+			// or returns the current node without failing.
+			auto link = co_await directory->link(resolver.nextComponent(), node);
+			file = co_await node->open(resolver.currentView(), std::move(link),
+					semantic_flags);
+			assert(file);
+		}
+	}else{
+		co_await resolver.resolve();
 
-			if(req.flags() & AT_EMPTY_PATH) {
-				target_link = file->associatedLink();
-			} else {
-				PathResolver resolver;
-				resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
+		if(resolver.currentLink()) {
+			auto target = resolver.currentLink()->getTarget();
+			file = co_await target->open(resolver.currentView(), resolver.currentLink(),
+					semantic_flags);
+		}
+	}
 
-				co_await resolver.resolve();
+	if(file) {
+		auto fd = self->fileContext()->attachFile(file,
+				req.flags() & managarm::posix::OF_CLOEXEC);
+		if(!fd) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+			co_return;
+		}
 
-				target_link = resolver.currentLink();
-			}
+		resp.set_error(managarm::posix::Errors::SUCCESS);
+		resp.set_fd(*fd);
 
-			if (!target_link) {
-				co_await sendErrorResponse(managarm::posix::Errors::FILE_NOT_FOUND);
-				continue;
-			}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}else{
+		if(logRequests)
+			std::cout << "posix:     OPEN failed: file not found" << std::endl;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
 
-			co_await target_link->getTarget()->chmod(req.mode());
+async::result<void> handleClose(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: CLOSE file descriptor " << req.fd() << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(
-				conversation,
-				helix_ng::sendBuffer(ser.data(), ser.size())
-			);
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::READLINK) {
-			if(logRequests || logPaths)
-				std::cout << "posix: READLINK path: " << req.path() << std::endl;
+	self->fileContext()->closeFile(req.fd());
 
-			helix::SendBuffer send_resp;
-			helix::SendBuffer send_data;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto path = co_await resolve(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path(), resolveDontFollow);
-			if(!path.second) {
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-						helix::action(&send_data, nullptr, 0));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+async::result<void> handleDup(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: DUP" << std::endl;
 
-			auto result = co_await path.second->getTarget()->readSymlink(path.second.get());
-			if(auto error = std::get_if<Error>(&result); error) {
-				assert(*error == Error::illegalOperationTarget);
+	auto file = self->fileContext()->getFile(req.fd());
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	if (!file) {
+		helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-						helix::action(&send_data, nullptr, 0));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				auto &target = std::get<std::string>(result);
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::BAD_FD);
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-						helix::action(&send_data, target.data(), target.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::OPEN) {
-			if(logRequests || logPaths)
-				std::cout << "posix: OPEN path: " << req.path()	<< std::endl;
-
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
-
-			assert(!(req.flags() & ~(managarm::posix::OF_CREATE
-					| managarm::posix::OF_EXCLUSIVE
-					| managarm::posix::OF_NONBLOCK
-					| managarm::posix::OF_CLOEXEC
-					| managarm::posix::OF_RDONLY
-					| managarm::posix::OF_WRONLY
-					| managarm::posix::OF_RDWR)));
-
-			SemanticFlags semantic_flags = 0;
-			if(req.flags() & managarm::posix::OF_NONBLOCK)
-				semantic_flags |= semanticNonBlock;
-
-			if (req.flags() & managarm::posix::OF_RDONLY)
-				semantic_flags |= semanticRead;
-			else if (req.flags() & managarm::posix::OF_WRONLY)
-				semantic_flags |= semanticWrite;
-			else if (req.flags() & managarm::posix::OF_RDWR)
-				semantic_flags |= semanticRead | semanticWrite;
-
-			smarter::shared_ptr<File, FileHandle> file;
-
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path());
-			if(req.flags() & managarm::posix::OF_CREATE) {
-				co_await resolver.resolve(resolvePrefix);
-				if(!resolver.currentLink()) {
-					resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
-
-					auto ser = resp.SerializeAsString();
-					auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-							helix::action(&send_resp, ser.data(), ser.size()));
-					co_await transmit.async_wait();
-					HEL_CHECK(send_resp.error());
-					continue;
-				}
+	if(req.flags() & ~(managarm::posix::OF_CLOEXEC)) {
+		helix::SendBuffer send_resp;
 
-				if(logRequests)
-					std::cout << "posix: Creating file " << req.path() << std::endl;
-
-				auto directory = resolver.currentLink()->getTarget();
-				auto tail = co_await directory->getLink(resolver.nextComponent());
-				if(tail) {
-					if(req.flags() & managarm::posix::OF_EXCLUSIVE) {
-						resp.set_error(managarm::posix::Errors::ALREADY_EXISTS);
-
-						auto ser = resp.SerializeAsString();
-						auto &&transmit = helix::submitAsync(conversation,
-								helix::Dispatcher::global(),
-								helix::action(&send_resp, ser.data(), ser.size()));
-						co_await transmit.async_wait();
-						HEL_CHECK(send_resp.error());
-						continue;
-					}else{
-						file = co_await tail->getTarget()->open(
-								resolver.currentView(), std::move(tail),
-								semantic_flags);
-						assert(file);
-					}
-				}else{
-					assert(directory->superblock());
-					auto node = co_await directory->superblock()->createRegular();
-					// Due to races, link() can fail here.
-					// TODO: Implement a version of link() that eithers links the new node
-					// or returns the current node without failing.
-					auto link = co_await directory->link(resolver.nextComponent(), node);
-					file = co_await node->open(resolver.currentView(), std::move(link),
-							semantic_flags);
-					assert(file);
-				}
-			}else{
-				co_await resolver.resolve();
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
-				if(resolver.currentLink()) {
-					auto target = resolver.currentLink()->getTarget();
-					file = co_await target->open(resolver.currentView(), resolver.currentLink(),
-							semantic_flags);
-				}
-			}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			if(file) {
-				int fd = self->fileContext()->attachFile(file,
-						req.flags() & managarm::posix::OF_CLOEXEC);
+	auto newfd = self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OF_CLOEXEC);
+	if(!newfd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-				resp.set_fd(fd);
+	helix::SendBuffer send_resp;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				if(logRequests)
-					std::cout << "posix:     OPEN failed: file not found" << std::endl;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(*newfd);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::OPENAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: OPENAT path: " << req.path()	<< std::endl;
-
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
-
-			if((req.flags() & ~(managarm::posix::OF_CREATE
-					| managarm::posix::OF_EXCLUSIVE
-					| managarm::posix::OF_NONBLOCK
-					| managarm::posix::OF_CLOEXEC
-					| managarm::posix::OF_RDONLY
-					| managarm::posix::OF_WRONLY
-					| managarm::posix::OF_RDWR))) {
-				std::cout << "posix: OPENAT flags not recognized: " << req.flags() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			SemanticFlags semantic_flags = 0;
-			if(req.flags() & managarm::posix::OF_NONBLOCK)
-				semantic_flags |= semanticNonBlock;
+async::result<void> handleDup2(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: DUP2" << std::endl;
 
-			if (req.flags() & managarm::posix::OF_RDONLY)
-				semantic_flags |= semanticRead;
-			else if (req.flags() & managarm::posix::OF_WRONLY)
-				semantic_flags |= semanticWrite;
-			else if (req.flags() & managarm::posix::OF_RDWR)
-				semantic_flags |= semanticRead | semanticWrite;
+	auto file = self->fileContext()->getFile(req.fd());
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+	if (!file || req.newfd() < 0 || req.newfd() >= FileContext::maxFileDescriptors) {
+		helix::SendBuffer send_resp;
 
-			if(req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::BAD_FD);
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	if(req.flags()) {
+		helix::SendBuffer send_resp;
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
-			if(req.flags() & managarm::posix::OF_CREATE) {
-				co_await resolver.resolve(resolvePrefix);
-				if(!resolver.currentLink()) {
-					resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
-
-					auto ser = resp.SerializeAsString();
-					auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-							helix::action(&send_resp, ser.data(), ser.size()));
-					co_await transmit.async_wait();
-					HEL_CHECK(send_resp.error());
-					continue;
-				}
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
 
-				if(logRequests)
-					std::cout << "posix: Creating file " << req.path() << std::endl;
-
-				auto directory = resolver.currentLink()->getTarget();
-				auto tail = co_await directory->getLink(resolver.nextComponent());
-				if(tail) {
-					if(req.flags() & managarm::posix::OF_EXCLUSIVE) {
-						resp.set_error(managarm::posix::Errors::ALREADY_EXISTS);
-
-						auto ser = resp.SerializeAsString();
-						auto &&transmit = helix::submitAsync(conversation,
-								helix::Dispatcher::global(),
-								helix::action(&send_resp, ser.data(), ser.size()));
-						co_await transmit.async_wait();
-						HEL_CHECK(send_resp.error());
-						continue;
-					}else{
-						file = co_await tail->getTarget()->open(
-								resolver.currentView(), std::move(tail),
-								semantic_flags);
-						assert(file);
-					}
-				}else{
-					assert(directory->superblock());
-					auto node = co_await directory->superblock()->createRegular();
-					// Due to races, link() can fail here.
-					// TODO: Implement a version of link() that eithers links the new node
-					// or returns the current node without failing.
-					auto link = co_await directory->link(resolver.nextComponent(), node);
-					file = co_await node->open(resolver.currentView(), std::move(link),
-							semantic_flags);
-					assert(file);
-				}
-			}else{
-				co_await resolver.resolve();
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-				if(resolver.currentLink()) {
-					auto target = resolver.currentLink()->getTarget();
-					file = co_await target->open(resolver.currentView(), resolver.currentLink(),
-							semantic_flags);
-				}
-			}
+	self->fileContext()->attachFile(req.newfd(), file);
 
-			if(file) {
-				int fd = self->fileContext()->attachFile(file,
-						req.flags() & managarm::posix::OF_CLOEXEC);
+	helix::SendBuffer send_resp;
 
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-				resp.set_fd(fd);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}else{
-				if(logRequests)
-					std::cout << "posix:     OPEN failed: file not found" << std::endl;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::CLOSE) {
-			if(logRequests)
-				std::cout << "posix: CLOSE file descriptor " << req.fd() << std::endl;
+async::result<void> handleIsTty(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: IS_TTY" << std::endl;
 
-			helix::SendBuffer send_resp;
+	auto file = self->fileContext()->getFile(req.fd());
+	assert(file && "Illegal FD for IS_TTY");
 
-			self->fileContext()->closeFile(req.fd());
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_mode(file->isTerminal());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::DUP) {
-			if(logRequests)
-				std::cout << "posix: DUP" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto file = self->fileContext()->getFile(req.fd());
+async::result<void> handleTtyName(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: TTY_NAME" << std::endl;
 
-			if (!file) {
-				helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::BAD_FD);
+	std::cout << "\e[31mposix: Fix TTY_NAME\e[39m" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_path("/dev/ttyS0");
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			if(req.flags() & ~(managarm::posix::OF_CLOEXEC)) {
-				helix::SendBuffer send_resp;
+async::result<void> handleGetcwd(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: GETCWD" << std::endl;
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	auto dir = self->fsContext()->getWorkingDirectory();
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	std::string path = "/";
+	while(true) {
+		if(dir == self->fsContext()->getRoot())
+			break;
 
-			int newfd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OF_CLOEXEC);
+		// If we are at the origin of a mount point, traverse that mount point.
+		ViewPath traversed;
+		if(dir.second == dir.first->getOrigin()) {
+			if(!dir.first->getParent())
+				break;
+			auto anchor = dir.first->getAnchor();
+			assert(anchor); // Non-root mounts must have anchors in their parents.
+			traversed = ViewPath{dir.first->getParent(), dir.second};
+		}else{
+			traversed = dir;
+		}
 
-			helix::SendBuffer send_resp;
+		auto owner = traversed.second->getOwner();
+		assert(owner); // Otherwise, we would have been at the root.
+		path = "/" + traversed.second->getName() + path;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(newfd);
+		dir = ViewPath{traversed.first, owner->treeLink()};
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::DUP2) {
-			if(logRequests)
-				std::cout << "posix: DUP2" << std::endl;
+	helix::SendBuffer send_resp;
+	helix::SendBuffer send_path;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_size(path.size());
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+			helix::action(&send_path, path.data(),
+					std::min(static_cast<size_t>(req.size()), path.size() + 1)));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+	HEL_CHECK(send_path.error());
+}
 
-			auto file = self->fileContext()->getFile(req.fd());
+async::result<void> handleUnlinkat(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests || logPaths)
+		std::cout << "posix: UNLINKAT path: " << req.path() << std::endl;
 
-			if (!file || req.newfd() < 0) {
-				helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::BAD_FD);
+	ViewPath relative_to;
+	smarter::shared_ptr<File, FileHandle> file;
+	std::shared_ptr<FsLink> target_link;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	if(req.flags()) {
+		if(req.flags() & AT_REMOVEDIR) {
+			std::cout << "posix: UNLINKAT flag AT_REMOVEDIR handling unimplemented" << std::endl;
+		} else {
+			std::cout << "posix: UNLINKAT flag handling unimplemented with unknown flag: " << req.flags() << std::endl;
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		}
+	} 
 
-			if(req.flags()) {
-				helix::SendBuffer send_resp;
+	if(req.fd() == AT_FDCWD) {
+		relative_to = self->fsContext()->getWorkingDirectory();
+	} else {
+		file = self->fileContext()->getFile(req.fd());
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		if (!file) {
+			co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+			co_return;
+		}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+		relative_to = {file->associatedMount(), file->associatedLink()};
+	}
 
-			self->fileContext()->attachFile(req.newfd(), file);
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			relative_to, req.path());
 
-			helix::SendBuffer send_resp;
+	co_await resolver.resolve();
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	target_link = resolver.currentLink();
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::IS_TTY) {
-			if(logRequests)
-				std::cout << "posix: IS_TTY" << std::endl;
+	if (!target_link) {
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
-			auto file = self->fileContext()->getFile(req.fd());
-			assert(file && "Illegal FD for IS_TTY");
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	} else {
+		auto owner = target_link->getOwner();
+		co_await owner->unlink(target_link->getName());
 
-			helix::SendBuffer send_resp;
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_mode(file->isTerminal());
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+	}
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TTY_NAME) {
-			if(logRequests)
-				std::cout << "posix: TTY_NAME" << std::endl;
+async::result<void> handleFdGetFlags(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: FD_GET_FLAGS" << std::endl;
 
-			helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
 
-			std::cout << "\e[31mposix: Fix TTY_NAME\e[39m" << std::endl;
-			managarm::posix::SvrResponse resp;
-			resp.set_path("/dev/ttyS0");
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto descriptor = self->fileContext()->getDescriptor(req.fd());
+	if(!descriptor) {
+		managarm::posix::SvrResponse resp;
+		resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::GETCWD) {
-			if(logRequests)
-				std::cout << "posix: GETCWD" << std::endl;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			auto dir = self->fsContext()->getWorkingDirectory();
+	int flags = 0;
+	if(descriptor->closeOnExec)
+		flags |= FD_CLOEXEC;
 
-			std::string path = "/";
-			while(true) {
-				if(dir == self->fsContext()->getRoot())
-					break;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_flags(flags);
 
-				// If we are at the origin of a mount point, traverse that mount point.
-				ViewPath traversed;
-				if(dir.second == dir.first->getOrigin()) {
-					if(!dir.first->getParent())
-						break;
-					auto anchor = dir.first->getAnchor();
-					assert(anchor); // Non-root mounts must have anchors in their parents.
-					traversed = ViewPath{dir.first->getParent(), dir.second};
-				}else{
-					traversed = dir;
-				}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-				auto owner = traversed.second->getOwner();
-				assert(owner); // Otherwise, we would have been at the root.
-				path = "/" + traversed.second->getName() + path;
+async::result<void> handleFdSetFlags(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: FD_SET_FLAGS" << std::endl;
 
-				dir = ViewPath{traversed.first, owner->treeLink()};
-			}
+	if(req.flags() & ~FD_CLOEXEC) {
+		std::cout << "posix: FD_SET_FLAGS unknown flags: " << req.flags() << std::endl;
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+		co_return;
+	}
+	int closeOnExec = req.flags() & FD_CLOEXEC;
+	if(self->fileContext()->setDescriptor(req.fd(), closeOnExec) != Error::success) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::NO_SUCH_FD);
+		co_return;
+	}
 
-			helix::SendBuffer send_resp;
-			helix::SendBuffer send_path;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_size(path.size());
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()));
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-					helix::action(&send_path, path.data(),
-							std::min(static_cast<size_t>(req.size()), path.size() + 1)));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-			HEL_CHECK(send_path.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::UNLINKAT) {
-			if(logRequests || logPaths)
-				std::cout << "posix: UNLINKAT path: " << req.path() << std::endl;
+async::result<void> handleSigAction(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SIG_ACTION" << std::endl;
+
+	if(req.flags() & ~(SA_SIGINFO | SA_RESETHAND | SA_NODEFER | SA_RESTART | SA_NOCLDSTOP)) {
+		std::cout << "\e[31mposix: Unknown SIG_ACTION flags: 0x"
+				<< std::hex << req.flags()
+				<< std::dec << "\e[39m" << std::endl;
+		assert(!"Flags not implemented");
+	}
 
-			helix::SendBuffer send_resp;
+	SignalHandler saved_handler;
+	if(req.mode()) {
+		SignalHandler handler;
+		if(req.sig_handler() == uintptr_t(-2)) {
+			handler.disposition = SignalDisposition::none;
+		}else if(req.sig_handler() == uintptr_t(-3)) {
+			handler.disposition = SignalDisposition::ignore;
+		}else{
+			handler.disposition = SignalDisposition::handle;
+			handler.handlerIp = req.sig_handler();
+		}
 
-			ViewPath relative_to;
-			smarter::shared_ptr<File, FileHandle> file;
-			std::shared_ptr<FsLink> target_link;
+		handler.flags = 0;
+		handler.mask = req.sig_mask();
+		handler.restorerIp = req.sig_restorer();
+
+		if(req.flags() & SA_SIGINFO)
+			handler.flags |= signalInfo;
+		if(req.flags() & SA_RESETHAND)
+			handler.flags |= signalOnce;
+		if(req.flags() & SA_NODEFER)
+			handler.flags |= signalReentrant;
+		if(req.flags() & SA_RESTART)
+			std::cout << "\e[31mposix: Ignoring SA_RESTART\e[39m" << std::endl;
+		if(req.flags() & SA_NOCLDSTOP)
+			std::cout << "\e[31mposix: Ignoring SA_NOCLDSTOP\e[39m" << std::endl;
+
+		saved_handler = self->signalContext()->changeHandler(req.sig_number(), handler);
+	}else{
+		saved_handler = self->signalContext()->getHandler(req.sig_number());
+	}
 
-			if(req.flags()) {
-				if(req.flags() & AT_REMOVEDIR) {
-					std::cout << "posix: UNLINKAT flag AT_REMOVEDIR handling unimplemented" << std::endl;
-				} else {
-					std::cout << "posix: UNLINKAT flag handling unimplemented with unknown flag: " << req.flags() << std::endl;
-					co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				}
-			} 
+	int saved_flags = 0;
+	if(saved_handler.flags & signalInfo)
+		saved_flags |= SA_SIGINFO;
+	if(saved_handler.flags & signalOnce)
+		saved_flags |= SA_RESETHAND;
+	if(saved_handler.flags & signalReentrant)
+		saved_flags |= SA_NODEFER;
+
+	helix::SendBuffer send_resp;
+
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_flags(saved_flags);
+	resp.set_sig_mask(saved_handler.mask);
+	if(saved_handler.disposition == SignalDisposition::handle) {
+		resp.set_sig_handler(saved_handler.handlerIp);
+		resp.set_sig_restorer(saved_handler.restorerIp);
+	}else if(saved_handler.disposition == SignalDisposition::none) {
+		resp.set_sig_handler(-2);
+	}else{
+		assert(saved_handler.disposition == SignalDisposition::ignore);
+		resp.set_sig_handler(-3);
+	}
 
-			if(req.fd() == AT_FDCWD) {
-				relative_to = self->fsContext()->getWorkingDirectory();
-			} else {
-				file = self->fileContext()->getFile(req.fd());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-				if (!file) {
-					co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-					continue;
-				}
+async::result<void> handlePipeCreate(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: PIPE_CREATE" << std::endl;
 
-				relative_to = {file->associatedMount(), file->associatedLink()};
-			}
+	assert(!(req.flags() & ~(O_CLOEXEC | O_NONBLOCK)));
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					relative_to, req.path());
+	helix::SendBuffer send_resp;
 
-			co_await resolver.resolve();
+	auto pair = fifo::createPair(req.flags() & O_NONBLOCK);
+	auto r_fd = self->fileContext()->attachFile(std::get<0>(pair),
+			req.flags() & O_CLOEXEC);
+	if(!r_fd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
+	auto w_fd = self->fileContext()->attachFile(std::get<1>(pair),
+			req.flags() & O_CLOEXEC);
+	if(!w_fd) {
+		self->fileContext()->closeFile(*r_fd);
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-			target_link = resolver.currentLink();
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.mutable_fds()->Add(*r_fd);
+	resp.mutable_fds()->Add(*w_fd);
 
-			if (!target_link) {
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			} else {
-				auto owner = target_link->getOwner();
-				co_await owner->unlink(target_link->getName());
+async::result<void> handleSetsid(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SETSID" << std::endl;
 
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto session = TerminalSession::initializeNewSession(self.get());
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-			}
-		}else if(req.request_type() == managarm::posix::CntReqType::FD_GET_FLAGS) {
-			if(logRequests)
-				std::cout << "posix: FD_GET_FLAGS" << std::endl;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_sid(session->getSessionId());
 
-			helix::SendBuffer send_resp;
+	auto ser = resp.SerializeAsString();
+	auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()));
+	HEL_CHECK(send_resp.error());
+}
 
-			auto descriptor = self->fileContext()->getDescriptor(req.fd());
-			if(!descriptor) {
-				managarm::posix::SvrResponse resp;
-				resp.set_error(managarm::posix::Errors::NO_SUCH_FD);
+async::result<void> handleSocket(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SOCKET" << std::endl;
+
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+
+	assert(!(req.flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
+
+	if(req.flags() & SOCK_NONBLOCK)
+		std::cout << "\e[31mposix: socket(SOCK_NONBLOCK)"
+				" is not implemented correctly\e[39m" << std::endl;
+
+	smarter::shared_ptr<File, FileHandle> file;
+	if(req.domain() == AF_UNIX) {
+		assert(req.socktype() == SOCK_DGRAM || req.socktype() == SOCK_STREAM
+				|| req.socktype() == SOCK_SEQPACKET);
+		assert(!req.protocol());
+
+		file = un_socket::createSocketFile();
+	}else if(req.domain() == AF_NETLINK) {
+		assert(req.socktype() == SOCK_RAW || req.socktype() == SOCK_DGRAM);
+		file = nl_socket::createSocketFile(req.protocol());
+	} else if (req.domain() == AF_INET) {
+		file = co_await extern_socket::createSocket(
+			co_await net::getNetLane(),
+			req.domain(),
+			req.socktype(), req.protocol());
+	}else{
+		throw std::runtime_error("posix: Handle unknown protocol families");
+	}
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	auto fd = self->fileContext()->attachFile(file,
+			req.flags() & SOCK_CLOEXEC);
+	if(!fd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-			int flags = 0;
-			if(descriptor->closeOnExec)
-				flags |= FD_CLOEXEC;
+	resp.set_fd(*fd);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_flags(flags);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::FD_SET_FLAGS) {
-			if(logRequests)
-				std::cout << "posix: FD_SET_FLAGS" << std::endl;
+async::result<void> handleSockpair(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SOCKPAIR" << std::endl;
 
-			if(req.flags() & ~FD_CLOEXEC) {
-				std::cout << "posix: FD_SET_FLAGS unknown flags: " << req.flags() << std::endl;
-				co_await sendErrorResponse(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-				continue;
-			}
-			int closeOnExec = req.flags() & FD_CLOEXEC;
-			if(self->fileContext()->setDescriptor(req.fd(), closeOnExec) != Error::success) {
-				co_await sendErrorResponse(managarm::posix::Errors::NO_SUCH_FD);
-				continue;
-			}
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	assert(!(req.flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
 
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size()));
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SIG_ACTION) {
-			if(logRequests)
-				std::cout << "posix: SIG_ACTION" << std::endl;
+	if(req.flags() & SOCK_NONBLOCK)
+		std::cout << "\e[31mposix: socketpair(SOCK_NONBLOCK)"
+				" is not implemented correctly\e[39m" << std::endl;
 
-			if(req.flags() & ~(SA_SIGINFO | SA_RESETHAND | SA_NODEFER | SA_RESTART | SA_NOCLDSTOP)) {
-				std::cout << "\e[31mposix: Unknown SIG_ACTION flags: 0x"
-						<< std::hex << req.flags()
-						<< std::dec << "\e[39m" << std::endl;
-				assert(!"Flags not implemented");
-			}
+	assert(req.domain() == AF_UNIX);
+	assert(req.socktype() == SOCK_DGRAM || req.socktype() == SOCK_STREAM
+			|| req.socktype() == SOCK_SEQPACKET);
+	assert(!req.protocol());
 
-			SignalHandler saved_handler;
-			if(req.mode()) {
-				SignalHandler handler;
-				if(req.sig_handler() == uintptr_t(-2)) {
-					handler.disposition = SignalDisposition::none;
-				}else if(req.sig_handler() == uintptr_t(-3)) {
-					handler.disposition = SignalDisposition::ignore;
-				}else{
-					handler.disposition = SignalDisposition::handle;
-					handler.handlerIp = req.sig_handler();
-				}
+	auto pair = un_socket::createSocketPair(self.get());
+	auto fd0 = self->fileContext()->attachFile(std::get<0>(pair),
+			req.flags() & SOCK_CLOEXEC);
+	if(!fd0) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
+	auto fd1 = self->fileContext()->attachFile(std::get<1>(pair),
+			req.flags() & SOCK_CLOEXEC);
+	if(!fd1) {
+		self->fileContext()->closeFile(*fd0);
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-				handler.flags = 0;
-				handler.mask = req.sig_mask();
-				handler.restorerIp = req.sig_restorer();
-
-				if(req.flags() & SA_SIGINFO)
-					handler.flags |= signalInfo;
-				if(req.flags() & SA_RESETHAND)
-					handler.flags |= signalOnce;
-				if(req.flags() & SA_NODEFER)
-					handler.flags |= signalReentrant;
-				if(req.flags() & SA_RESTART)
-					std::cout << "\e[31mposix: Ignoring SA_RESTART\e[39m" << std::endl;
-				if(req.flags() & SA_NOCLDSTOP)
-					std::cout << "\e[31mposix: Ignoring SA_NOCLDSTOP\e[39m" << std::endl;
-
-				saved_handler = self->signalContext()->changeHandler(req.sig_number(), handler);
-			}else{
-				saved_handler = self->signalContext()->getHandler(req.sig_number());
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.mutable_fds()->Add(*fd0);
+	resp.mutable_fds()->Add(*fd1);
+
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
+
+async::result<void> handleAccept(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: ACCEPT" << std::endl;
 
-			int saved_flags = 0;
-			if(saved_handler.flags & signalInfo)
-				saved_flags |= SA_SIGINFO;
-			if(saved_handler.flags & signalOnce)
-				saved_flags |= SA_RESETHAND;
-			if(saved_handler.flags & signalReentrant)
-				saved_flags |= SA_NODEFER;
+	helix::SendBuffer send_resp;
 
-			helix::SendBuffer send_resp;
+	auto sockfile = self->fileContext()->getFile(req.fd());
+	assert(sockfile && "Illegal FD for ACCEPT");
 
-			managarm::posix::SvrResponse resp;
+	managarm::posix::SvrResponse resp;
+
+	auto result = co_await sockfile->accept(self.get());
+	if(auto error = std::get_if<Error>(&result); error) {
+		assert(*error == Error::illegalArguments);
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	}else{
+		auto fd = self->fileContext()->attachFile(std::move(std::get<AcceptResult>(result)));
+		if(fd) {
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_flags(saved_flags);
-			resp.set_sig_mask(saved_handler.mask);
-			if(saved_handler.disposition == SignalDisposition::handle) {
-				resp.set_sig_handler(saved_handler.handlerIp);
-				resp.set_sig_restorer(saved_handler.restorerIp);
-			}else if(saved_handler.disposition == SignalDisposition::none) {
-				resp.set_sig_handler(-2);
-			}else{
-				assert(saved_handler.disposition == SignalDisposition::ignore);
-				resp.set_sig_handler(-3);
-			}
+			resp.set_fd(*fd);
+		}else{
+			resp.set_error(managarm::posix::Errors::TOO_MANY_FILES);
+		}
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::PIPE_CREATE) {
-			if(logRequests)
-				std::cout << "posix: PIPE_CREATE" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			assert(!(req.flags() & ~(O_CLOEXEC | O_NONBLOCK)));
+async::result<void> handleEpollCall(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_CALL" << std::endl;
+
+	helix::SendBuffer send_resp;
+
+	auto epfile = epoll::createFile();
+	assert(req.fds_size() == req.events_size());
+	for(int i = 0; i < req.fds_size(); i++) {
+		auto file = self->fileContext()->getFile(req.fds(i));
+		assert(file && "Illegal FD for EPOLL_ADD item");
+		auto locked = file->weakFile().lock();
+		assert(locked);
+		epoll::addItem(epfile.get(), self.get(), std::move(locked),
+				req.events(i), i);
+	}
 
-			if(req.flags() & O_NONBLOCK)
-				std::cout << "\e[31mposix: pipe2(O_NONBLOCK)"
-						" is not implemented correctly\e[39m" << std::endl;
+	struct epoll_event events[16];
+	size_t k;
+	if(req.timeout() == -1) {
+		k = co_await epoll::wait(epfile.get(), events, 16);
+	}else if(!req.timeout()) {
+		// Do not bother to set up a timer for zero timeouts.
+		async::cancellation_event cancel_wait;
+		cancel_wait.cancel();
+		k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
+	}else if(req.timeout() > 0) {
+		async::cancellation_event cancel_wait;
+		helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
+		k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
+		co_await timer.retire();
+	}else{
+		assert(!"posix: Illegal timeout for EPOLL_CALL");
+		__builtin_unreachable();
+	}
 
-			helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto pair = fifo::createPair();
-			auto r_fd = self->fileContext()->attachFile(std::get<0>(pair),
-					req.flags() & O_CLOEXEC);
-			auto w_fd = self->fileContext()->attachFile(std::get<1>(pair),
-					req.flags() & O_CLOEXEC);
+	for(int i = 0; i < req.fds_size(); i++)
+		resp.add_events(0);
+	for(size_t m = 0; m < k; m++)
+		resp.set_events(events[m].data.u32, events[m].events);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.mutable_fds()->Add(r_fd);
-			resp.mutable_fds()->Add(w_fd);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SETSID) {
-			if(logRequests)
-				std::cout << "posix: SETSID" << std::endl;
+async::result<void> handleEpollCreate(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_CREATE" << std::endl;
 
-			auto session = TerminalSession::initializeNewSession(self.get());
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_sid(session->getSessionId());
+	assert(!(req.flags() & ~(managarm::posix::OF_CLOEXEC)));
 
-			auto ser = resp.SerializeAsString();
-			auto [send_resp] = co_await helix_ng::exchangeMsgs(conversation,
-					helix_ng::sendBuffer(ser.data(), ser.size()));
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SOCKET) {
-			if(logRequests)
-				std::cout << "posix: SOCKET" << std::endl;
+	auto file = epoll::createFile();
+	auto fd = self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OF_CLOEXEC);
+	if(!fd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(*fd);
 
-			assert(!(req.flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
-
-			if(req.flags() & SOCK_NONBLOCK)
-				std::cout << "\e[31mposix: socket(SOCK_NONBLOCK)"
-						" is not implemented correctly\e[39m" << std::endl;
-
-			smarter::shared_ptr<File, FileHandle> file;
-			if(req.domain() == AF_UNIX) {
-				assert(req.socktype() == SOCK_DGRAM || req.socktype() == SOCK_STREAM
-						|| req.socktype() == SOCK_SEQPACKET);
-				assert(!req.protocol());
-
-				file = un_socket::createSocketFile();
-			}else if(req.domain() == AF_NETLINK) {
-				assert(req.socktype() == SOCK_RAW || req.socktype() == SOCK_DGRAM);
-				file = nl_socket::createSocketFile(req.protocol());
-			} else if (req.domain() == AF_INET) {
-				file = co_await extern_socket::createSocket(
-					co_await net::getNetLane(),
-					req.domain(),
-					req.socktype(), req.protocol());
-			}else{
-				throw std::runtime_error("posix: Handle unknown protocol families");
-			}
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto fd = self->fileContext()->attachFile(file,
-					req.flags() & SOCK_CLOEXEC);
+async::result<void> handleEpollAdd(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_ADD" << std::endl;
 
-			resp.set_fd(fd);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SOCKPAIR) {
-			if(logRequests)
-				std::cout << "posix: SOCKPAIR" << std::endl;
+	auto epfile = self->fileContext()->getFile(req.fd());
+	auto file = self->fileContext()->getFile(req.newfd());
+	if(!file || !epfile) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::BAD_FD);
+		co_return;
+	}
 
-			helix::SendBuffer send_resp;
+	auto locked = file->weakFile().lock();
+	assert(locked);
+	epoll::addItem(epfile.get(), self.get(), std::move(locked),
+			req.flags(), req.cookie());
 
-			assert(!(req.flags() & ~(SOCK_NONBLOCK | SOCK_CLOEXEC)));
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			if(req.flags() & SOCK_NONBLOCK)
-				std::cout << "\e[31mposix: socketpair(SOCK_NONBLOCK)"
-						" is not implemented correctly\e[39m" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			assert(req.domain() == AF_UNIX);
-			assert(req.socktype() == SOCK_DGRAM || req.socktype() == SOCK_STREAM
-					|| req.socktype() == SOCK_SEQPACKET);
-			assert(!req.protocol());
+async::result<void> handleEpollModify(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_MODIFY" << std::endl;
 
-			auto pair = un_socket::createSocketPair(self.get());
-			auto fd0 = self->fileContext()->attachFile(std::get<0>(pair),
-					req.flags() & SOCK_CLOEXEC);
-			auto fd1 = self->fileContext()->attachFile(std::get<1>(pair),
-					req.flags() & SOCK_CLOEXEC);
+	helix::SendBuffer send_resp;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.mutable_fds()->Add(fd0);
-			resp.mutable_fds()->Add(fd1);
+	auto epfile = self->fileContext()->getFile(req.fd());
+	auto file = self->fileContext()->getFile(req.newfd());
+	assert(epfile && "Illegal FD for EPOLL_MODIFY");
+	assert(file && "Illegal FD for EPOLL_MODIFY item");
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::ACCEPT) {
-			if(logRequests)
-				std::cout << "posix: ACCEPT" << std::endl;
+	epoll::modifyItem(epfile.get(), file.get(), req.flags(), req.cookie());
 
-			helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			auto sockfile = self->fileContext()->getFile(req.fd());
-			assert(sockfile && "Illegal FD for ACCEPT");
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto newfile = co_await sockfile->accept(self.get());
-			auto fd = self->fileContext()->attachFile(std::move(newfile));
+async::result<void> handleEpollDelete(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_DELETE" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_CALL) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_CALL" << std::endl;
-
-			helix::SendBuffer send_resp;
-
-			auto epfile = epoll::createFile();
-			assert(req.fds_size() == req.events_size());
-			for(int i = 0; i < req.fds_size(); i++) {
-				auto file = self->fileContext()->getFile(req.fds(i));
-				assert(file && "Illegal FD for EPOLL_ADD item");
-				auto locked = file->weakFile().lock();
-				assert(locked);
-				epoll::addItem(epfile.get(), self.get(), std::move(locked),
-						req.events(i), i);
-			}
+	auto epfile = self->fileContext()->getFile(req.fd());
+	auto file = self->fileContext()->getFile(req.newfd());
+	assert(epfile && "Illegal FD for EPOLL_DELETE");
+	assert(file && "Illegal FD for EPOLL_DELETE item");
 
-			struct epoll_event events[16];
-			size_t k;
-			if(req.timeout() == -1) {
-				k = co_await epoll::wait(epfile.get(), events, 16);
-			}else if(!req.timeout()) {
-				// Do not bother to set up a timer for zero timeouts.
-				async::cancellation_event cancel_wait;
-				cancel_wait.cancel();
-				k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
-			}else if(req.timeout() > 0) {
-				async::cancellation_event cancel_wait;
-				helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
-				k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
-				co_await timer.retire();
-			}else{
-				assert(!"posix: Illegal timeout for EPOLL_CALL");
-				__builtin_unreachable();
-			}
+	epoll::deleteItem(epfile.get(), file.get(), req.flags());
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			for(int i = 0; i < req.fds_size(); i++)
-				resp.add_events(0);
-			for(size_t m = 0; m < k; m++)
-				resp.set_events(events[m].data.u32, events[m].events);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_CREATE) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_CREATE" << std::endl;
+async::result<void> handleEpollWait(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EPOLL_WAIT request" << std::endl;
+
+	helix::SendBuffer send_resp;
+	helix::SendBuffer send_data;
+
+	auto epfile = self->fileContext()->getFile(req.fd());
+	assert(epfile && "Illegal FD for EPOLL_WAIT");
+
+	struct epoll_event events[16];
+	size_t k;
+	if(req.timeout() == -1) {
+		k = co_await epoll::wait(epfile.get(), events,
+				std::min(req.size(), uint32_t(16)));
+	}else if(!req.timeout()) {
+		// Do not bother to set up a timer for zero timeouts.
+		async::cancellation_event cancel_wait;
+		cancel_wait.cancel();
+		k = co_await epoll::wait(epfile.get(), events,
+				std::min(req.size(), uint32_t(16)), cancel_wait);
+	}else if(req.timeout() > 0) {
+		async::cancellation_event cancel_wait;
+		helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
+		k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
+		co_await timer.retire();
+	}else{
+		assert(!"posix: Illegal timeout for EPOLL_WAIT");
+		__builtin_unreachable();
+	}
 
-			helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			assert(!(req.flags() & ~(managarm::posix::OF_CLOEXEC)));
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
+			helix::action(&send_data, events, k * sizeof(struct epoll_event)));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto file = epoll::createFile();
-			auto fd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OF_CLOEXEC);
+async::result<void> handleTimerfdCreate(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: TIMERFD_CREATE" << std::endl;
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	helix::SendBuffer send_resp;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_ADD) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_ADD" << std::endl;
+	assert(!(req.flags() & ~(TFD_CLOEXEC | TFD_NONBLOCK)));
 
-			helix::SendBuffer send_resp;
+	auto file = timerfd::createFile(req.flags() & TFD_NONBLOCK);
+	auto fd = self->fileContext()->attachFile(file, req.flags() & TFD_CLOEXEC);
+	if(!fd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-			auto epfile = self->fileContext()->getFile(req.fd());
-			auto file = self->fileContext()->getFile(req.newfd());
-			if(!file || !epfile) {
-				co_await sendErrorResponse(managarm::posix::Errors::BAD_FD);
-				continue;
-			}
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(*fd);
 
-			auto locked = file->weakFile().lock();
-			assert(locked);
-			epoll::addItem(epfile.get(), self.get(), std::move(locked),
-					req.flags(), req.cookie());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<void> handleTimerfdSettime(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: TIMERFD_SETTIME" << std::endl;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_MODIFY) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_MODIFY" << std::endl;
+	helix::SendBuffer send_resp;
 
-			helix::SendBuffer send_resp;
+	auto file = self->fileContext()->getFile(req.fd());
+	assert(file && "Illegal FD for TIMERFD_SETTIME");
+	timerfd::setTime(file.get(),
+			{static_cast<time_t>(req.time_secs()), static_cast<long>(req.time_nanos())},
+			{static_cast<time_t>(req.interval_secs()), static_cast<long>(req.interval_nanos())});
 
-			auto epfile = self->fileContext()->getFile(req.fd());
-			auto file = self->fileContext()->getFile(req.newfd());
-			assert(epfile && "Illegal FD for EPOLL_MODIFY");
-			assert(file && "Illegal FD for EPOLL_MODIFY item");
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
 
-			epoll::modifyItem(epfile.get(), file.get(), req.flags(), req.cookie());
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+async::result<void> handleSignalfdCreate(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: SIGNALFD_CREATE" << std::endl;
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_DELETE) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_DELETE" << std::endl;
+	helix::SendBuffer send_resp;
 
-			helix::SendBuffer send_resp;
+	assert(!(req.flags() & ~(managarm::posix::OF_CLOEXEC)));
 
-			auto epfile = self->fileContext()->getFile(req.fd());
-			auto file = self->fileContext()->getFile(req.newfd());
-			assert(epfile && "Illegal FD for EPOLL_DELETE");
-			assert(file && "Illegal FD for EPOLL_DELETE item");
+	auto file = createSignalFile(req.sigset());
+	auto fd = self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OF_CLOEXEC);
+	if(!fd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-			epoll::deleteItem(epfile.get(), file.get(), req.flags());
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(*fd);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EPOLL_WAIT) {
-			if(logRequests)
-				std::cout << "posix: EPOLL_WAIT request" << std::endl;
+async::result<void> handleInotifyCreate(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: INOTIFY_CREATE" << std::endl;
 
-			helix::SendBuffer send_resp;
-			helix::SendBuffer send_data;
+	helix::SendBuffer send_resp;
 
-			auto epfile = self->fileContext()->getFile(req.fd());
-			assert(epfile && "Illegal FD for EPOLL_WAIT");
+	assert(!(req.flags() & ~(managarm::posix::OF_CLOEXEC)));
 
-			struct epoll_event events[16];
-			size_t k;
-			if(req.timeout() == -1) {
-				k = co_await epoll::wait(epfile.get(), events,
-						std::min(req.size(), uint32_t(16)));
-			}else if(!req.timeout()) {
-				// Do not bother to set up a timer for zero timeouts.
-				async::cancellation_event cancel_wait;
-				cancel_wait.cancel();
-				k = co_await epoll::wait(epfile.get(), events,
-						std::min(req.size(), uint32_t(16)), cancel_wait);
-			}else if(req.timeout() > 0) {
-				async::cancellation_event cancel_wait;
-				helix::TimeoutCancellation timer{static_cast<uint64_t>(req.timeout()), cancel_wait};
-				k = co_await epoll::wait(epfile.get(), events, 16, cancel_wait);
-				co_await timer.retire();
-			}else{
-				assert(!"posix: Illegal timeout for EPOLL_WAIT");
-				__builtin_unreachable();
-			}
+	auto file = inotify::createFile();
+	auto fd = self->fileContext()->attachFile(file,
+			req.flags() & managarm::posix::OF_CLOEXEC);
+	if(!fd) {
+		co_await sendErrorResponse(conversation, managarm::posix::Errors::TOO_MANY_FILES);
+		co_return;
+	}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_fd(*fd);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size(), kHelItemChain),
-					helix::action(&send_data, events, k * sizeof(struct epoll_event)));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TIMERFD_CREATE) {
-			if(logRequests)
-				std::cout << "posix: TIMERFD_CREATE" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			helix::SendBuffer send_resp;
+async::result<void> handleInotifyAdd(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
 
-			assert(!(req.flags() & ~(TFD_CLOEXEC | TFD_NONBLOCK)));
+	if(logRequests || logPaths)
+		std::cout << "posix: INOTIFY_ADD" << req.path() << std::endl;
 
-			auto file = timerfd::createFile(req.flags() & TFD_NONBLOCK);
-			auto fd = self->fileContext()->attachFile(file, req.flags() & TFD_CLOEXEC);
+	auto ifile = self->fileContext()->getFile(req.fd());
+	assert(ifile);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+	PathResolver resolver;
+	resolver.setup(self->fsContext()->getRoot(),
+			self->fsContext()->getWorkingDirectory(), req.path());
+	co_await resolver.resolve();
+	if(!resolver.currentLink()) {
+		resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::TIMERFD_SETTIME) {
-			if(logRequests)
-				std::cout << "posix: TIMERFD_SETTIME" << std::endl;
+		auto ser = resp.SerializeAsString();
+		auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&send_resp, ser.data(), ser.size()));
+		co_await transmit.async_wait();
+		HEL_CHECK(send_resp.error());
+		co_return;
+	}
 
-			helix::SendBuffer send_resp;
+	auto wd = inotify::addWatch(ifile.get(), resolver.currentLink()->getTarget(),
+			req.flags());
 
-			auto file = self->fileContext()->getFile(req.fd());
-			assert(file && "Illegal FD for TIMERFD_SETTIME");
-			timerfd::setTime(file.get(),
-					{static_cast<time_t>(req.time_secs()), static_cast<long>(req.time_nanos())},
-					{static_cast<time_t>(req.interval_secs()), static_cast<long>(req.interval_nanos())});
+	resp.set_error(managarm::posix::Errors::SUCCESS);
+	resp.set_wd(wd);
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::SIGNALFD_CREATE) {
-			if(logRequests)
-				std::cout << "posix: SIGNALFD_CREATE" << std::endl;
+async::result<void> handleEventfdCreate(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	if(logRequests)
+		std::cout << "posix: EVENTFD_CREATE" << std::endl;
 
-			helix::SendBuffer send_resp;
+	helix::SendBuffer send_resp;
+	managarm::posix::SvrResponse resp;
 
-			assert(!(req.flags() & ~(managarm::posix::OF_CLOEXEC)));
+	if (req.flags() & ~(managarm::posix::OF_CLOEXEC | managarm::posix::OF_NONBLOCK)) {
+		std::cout << "posix: invalid flag specified (EFD_SEMAPHORE?)" << std::endl;
+		std::cout << "posix: flags specified: " << req.flags() << std::endl;
+		resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
+	} else {
 
-			auto file = createSignalFile(req.sigset());
-			auto fd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OF_CLOEXEC);
+		auto file = eventfd::createFile(req.initval(), req.flags() & managarm::posix::OF_NONBLOCK);
+		auto fd = self->fileContext()->attachFile(file,
+				req.flags() & managarm::posix::OF_CLOEXEC);
 
-			managarm::posix::SvrResponse resp;
+		if(fd) {
 			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+			resp.set_fd(*fd);
+		}else{
+			resp.set_error(managarm::posix::Errors::TOO_MANY_FILES);
+		}
+	}
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::INOTIFY_CREATE) {
-			if(logRequests)
-				std::cout << "posix: INOTIFY_CREATE" << std::endl;
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			helix::SendBuffer send_resp;
+async::result<void> handleIllegalRequest(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req) {
+	std::cout << "posix: Illegal request" << std::endl;
+	helix::SendBuffer send_resp;
 
-			assert(!(req.flags() & ~(managarm::posix::OF_CLOEXEC)));
+	managarm::posix::SvrResponse resp;
+	resp.set_error(managarm::posix::Errors::ILLEGAL_REQUEST);
 
-			auto file = inotify::createFile();
-			auto fd = self->fileContext()->attachFile(file,
-					req.flags() & managarm::posix::OF_CLOEXEC);
+	auto ser = resp.SerializeAsString();
+	auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
+			helix::action(&send_resp, ser.data(), ser.size()));
+	co_await transmit.async_wait();
+	HEL_CHECK(send_resp.error());
+}
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_fd(fd);
+using RequestHandler = async::result<void> (*)(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation, helix::BorrowedDescriptor conversation,
+		managarm::posix::CntRequest &req);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::INOTIFY_ADD) {
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+// Latencies are counted in power-of-two buckets: bucket i counts latencies in [2^i, 2^(i+1)) us.
+// The last bucket also counts all latencies above that range.
+constexpr int numLatencyBuckets = 16;
 
-			if(logRequests || logPaths)
-				std::cout << "posix: INOTIFY_ADD" << req.path() << std::endl;
+struct RequestType {
+	void recordLatency(uint64_t nanos) {
+		count++;
+		totalNanos += nanos;
+		maxNanos = std::max(maxNanos, nanos);
 
-			auto ifile = self->fileContext()->getFile(req.fd());
-			assert(ifile);
+		int bucket = 0;
+		for(uint64_t us = nanos / 1000; us > 1 && bucket < numLatencyBuckets - 1; us >>= 1)
+			bucket++;
+		latencyHistogram[bucket]++;
+	}
 
-			PathResolver resolver;
-			resolver.setup(self->fsContext()->getRoot(),
-					self->fsContext()->getWorkingDirectory(), req.path());
-			co_await resolver.resolve();
-			if(!resolver.currentLink()) {
-				resp.set_error(managarm::posix::Errors::FILE_NOT_FOUND);
+	const char *name = nullptr;
+	RequestHandler handler = nullptr;
 
-				auto ser = resp.SerializeAsString();
-				auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-						helix::action(&send_resp, ser.data(), ser.size()));
-				co_await transmit.async_wait();
-				HEL_CHECK(send_resp.error());
-				continue;
-			}
+	// Statistics that are exposed through /proc/posix-requests.
+	uint64_t count = 0;
+	uint64_t totalNanos = 0;
+	uint64_t maxNanos = 0;
+	std::array<uint64_t, numLatencyBuckets> latencyHistogram{};
+};
 
-			auto wd = inotify::addWatch(ifile.get(), resolver.currentLink()->getTarget(),
-					req.flags());
+// Maps request types to handlers. Indexed by managarm::posix::CntReqType.
+std::array<RequestType, managarm::posix::CntReqType_ARRAYSIZE> requestTable = [] {
+	std::array<RequestType, managarm::posix::CntReqType_ARRAYSIZE> table;
+	auto add = [&] (managarm::posix::CntReqType type, const char *name,
+			RequestHandler handler) {
+		assert(!table[type].handler);
+		table[type].name = name;
+		table[type].handler = handler;
+	};
+
+	add(managarm::posix::CntReqType::GET_PID, "GET_PID", &handleGetPid);
+	add(managarm::posix::CntReqType::GET_UID, "GET_UID", &handleGetUid);
+	add(managarm::posix::CntReqType::SET_UID, "SET_UID", &handleSetUid);
+	add(managarm::posix::CntReqType::GET_EUID, "GET_EUID", &handleGetEuid);
+	add(managarm::posix::CntReqType::SET_EUID, "SET_EUID", &handleSetEuid);
+	add(managarm::posix::CntReqType::GET_GID, "GET_GID", &handleGetGid);
+	add(managarm::posix::CntReqType::GET_EGID, "GET_EGID", &handleGetEgid);
+	add(managarm::posix::CntReqType::SET_GID, "SET_GID", &handleSetGid);
+	add(managarm::posix::CntReqType::SET_EGID, "SET_EGID", &handleSetEgid);
+	add(managarm::posix::CntReqType::WAIT, "WAIT", &handleWait);
+	add(managarm::posix::CntReqType::GET_RESOURCE_USAGE, "GET_RESOURCE_USAGE", &handleGetResourceUsage);
+	add(managarm::posix::CntReqType::VM_MAP, "VM_MAP", &handleVmMap);
+	add(managarm::posix::CntReqType::VM_REMAP, "VM_REMAP", &handleVmRemap);
+	add(managarm::posix::CntReqType::VM_PROTECT, "VM_PROTECT", &handleVmProtect);
+	add(managarm::posix::CntReqType::VM_UNMAP, "VM_UNMAP", &handleVmUnmap);
+	add(managarm::posix::CntReqType::MOUNT, "MOUNT", &handleMount);
+	add(managarm::posix::CntReqType::CHROOT, "CHROOT", &handleChroot);
+	add(managarm::posix::CntReqType::CHDIR, "CHDIR", &handleChdir);
+	add(managarm::posix::CntReqType::FCHDIR, "FCHDIR", &handleFchdir);
+	add(managarm::posix::CntReqType::ACCESSAT, "ACCESSAT", &handleAccessat);
+	add(managarm::posix::CntReqType::MKDIRAT, "MKDIRAT", &handleMkdirat);
+	add(managarm::posix::CntReqType::MKFIFOAT, "MKFIFOAT", &handleMkfifoat);
+	add(managarm::posix::CntReqType::LINKAT, "LINKAT", &handleLinkat);
+	add(managarm::posix::CntReqType::SYMLINKAT, "SYMLINKAT", &handleSymlinkat);
+	add(managarm::posix::CntReqType::RENAMEAT, "RENAMEAT", &handleRenameat);
+	add(managarm::posix::CntReqType::FSTATAT, "FSTATAT", &handleFstatat);
+	add(managarm::posix::CntReqType::FCHMODAT, "FCHMODAT", &handleFchmodat);
+	add(managarm::posix::CntReqType::READLINK, "READLINK", &handleReadlink);
+	add(managarm::posix::CntReqType::OPEN, "OPEN", &handleOpen);
+	add(managarm::posix::CntReqType::OPENAT, "OPENAT", &handleOpenat);
+	add(managarm::posix::CntReqType::CLOSE, "CLOSE", &handleClose);
+	add(managarm::posix::CntReqType::DUP, "DUP", &handleDup);
+	add(managarm::posix::CntReqType::DUP2, "DUP2", &handleDup2);
+	add(managarm::posix::CntReqType::IS_TTY, "IS_TTY", &handleIsTty);
+	add(managarm::posix::CntReqType::TTY_NAME, "TTY_NAME", &handleTtyName);
+	add(managarm::posix::CntReqType::GETCWD, "GETCWD", &handleGetcwd);
+	add(managarm::posix::CntReqType::UNLINKAT, "UNLINKAT", &handleUnlinkat);
+	add(managarm::posix::CntReqType::FD_GET_FLAGS, "FD_GET_FLAGS", &handleFdGetFlags);
+	add(managarm::posix::CntReqType::FD_SET_FLAGS, "FD_SET_FLAGS", &handleFdSetFlags);
+	add(managarm::posix::CntReqType::SIG_ACTION, "SIG_ACTION", &handleSigAction);
+	add(managarm::posix::CntReqType::PIPE_CREATE, "PIPE_CREATE", &handlePipeCreate);
+	add(managarm::posix::CntReqType::SETSID, "SETSID", &handleSetsid);
+	add(managarm::posix::CntReqType::SOCKET, "SOCKET", &handleSocket);
+	add(managarm::posix::CntReqType::SOCKPAIR, "SOCKPAIR", &handleSockpair);
+	add(managarm::posix::CntReqType::ACCEPT, "ACCEPT", &handleAccept);
+	add(managarm::posix::CntReqType::EPOLL_CALL, "EPOLL_CALL", &handleEpollCall);
+	add(managarm::posix::CntReqType::EPOLL_CREATE, "EPOLL_CREATE", &handleEpollCreate);
+	add(managarm::posix::CntReqType::EPOLL_ADD, "EPOLL_ADD", &handleEpollAdd);
+	add(managarm::posix::CntReqType::EPOLL_MODIFY, "EPOLL_MODIFY", &handleEpollModify);
+	add(managarm::posix::CntReqType::EPOLL_DELETE, "EPOLL_DELETE", &handleEpollDelete);
+	add(managarm::posix::CntReqType::EPOLL_WAIT, "EPOLL_WAIT", &handleEpollWait);
+	add(managarm::posix::CntReqType::TIMERFD_CREATE, "TIMERFD_CREATE", &handleTimerfdCreate);
+	add(managarm::posix::CntReqType::TIMERFD_SETTIME, "TIMERFD_SETTIME", &handleTimerfdSettime);
+	add(managarm::posix::CntReqType::SIGNALFD_CREATE, "SIGNALFD_CREATE", &handleSignalfdCreate);
+	add(managarm::posix::CntReqType::INOTIFY_CREATE, "INOTIFY_CREATE", &handleInotifyCreate);
+	add(managarm::posix::CntReqType::INOTIFY_ADD, "INOTIFY_ADD", &handleInotifyAdd);
+	add(managarm::posix::CntReqType::EVENTFD_CREATE, "EVENTFD_CREATE", &handleEventfdCreate);
+	return table;
+}();
 
-			resp.set_error(managarm::posix::Errors::SUCCESS);
-			resp.set_wd(wd);
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else if(req.request_type() == managarm::posix::CntReqType::EVENTFD_CREATE) {
-			if(logRequests)
-				std::cout << "posix: EVENTFD_CREATE" << std::endl;
+async::result<void> serveRequests(std::shared_ptr<Process> self,
+		std::shared_ptr<Generation> generation) {
+	async::cancellation_token cancellation = generation->cancelServe;
 
-			helix::SendBuffer send_resp;
-			managarm::posix::SvrResponse resp;
+	async::cancellation_callback cancel_callback{cancellation, [&] {
+		HEL_CHECK(helShutdownLane(generation->posixLane.getHandle()));
+	}};
 
-			if (req.flags() & ~(managarm::posix::OF_CLOEXEC | managarm::posix::OF_NONBLOCK)) {
-				std::cout << "posix: invalid flag specified (EFD_SEMAPHORE?)" << std::endl;
-				std::cout << "posix: flags specified: " << req.flags() << std::endl;
-				resp.set_error(managarm::posix::Errors::ILLEGAL_ARGUMENTS);
-			} else {
+	while(true) {
+		helix::Accept accept;
+		helix::RecvInline recv_req;
 
-				auto file = eventfd::createFile(req.initval(), req.flags() & managarm::posix::OF_NONBLOCK);
-				auto fd = self->fileContext()->attachFile(file,
-						req.flags() & managarm::posix::OF_CLOEXEC);
+		auto &&header = helix::submitAsync(generation->posixLane, helix::Dispatcher::global(),
+				helix::action(&accept));
+		co_await header.async_wait();
 
-				resp.set_error(managarm::posix::Errors::SUCCESS);
-				resp.set_fd(fd);
-			}
+		if(accept.error() == kHelErrLaneShutdown)
+			break;
+		HEL_CHECK(accept.error());
+		auto conversation = accept.descriptor();
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
-		}else{
-			std::cout << "posix: Illegal request" << std::endl;
-			helix::SendBuffer send_resp;
+		auto &&initiate = helix::submitAsync(conversation, helix::Dispatcher::global(),
+				helix::action(&recv_req));
+		co_await initiate.async_wait();
+		if(recv_req.error() == kHelErrBufferTooSmall) {
+			std::cout << "posix: Rejecting request due to RecvInline overflow" << std::endl;
+			continue;
+		}
+		HEL_CHECK(recv_req.error());
 
-			managarm::posix::SvrResponse resp;
-			resp.set_error(managarm::posix::Errors::ILLEGAL_REQUEST);
+		managarm::posix::CntRequest req;
+		req.ParseFromArray(recv_req.data(), recv_req.length());
 
-			auto ser = resp.SerializeAsString();
-			auto &&transmit = helix::submitAsync(conversation, helix::Dispatcher::global(),
-					helix::action(&send_resp, ser.data(), ser.size()));
-			co_await transmit.async_wait();
-			HEL_CHECK(send_resp.error());
+		// Dispatch the request through the table.
+		auto type = req.request_type();
+		if(type < 0 || static_cast<size_t>(type) >= requestTable.size()
+				|| !requestTable[type].handler) {
+			co_await handleIllegalRequest(self, generation, conversation, req);
+			continue;
 		}
+		auto &entry = requestTable[type];
+
+		uint64_t start;
+		HEL_CHECK(helGetClock(&start));
+		co_await entry.handler(self, generation, conversation, req);
+		uint64_t end;
+		HEL_CHECK(helGetClock(&end));
+		entry.recordLatency(end - start);
 	}
 
 	if(logCleanup)
@@ -2792,6 +3205,69 @@ struct CmdlineNode final : public procfs::RegularNode {
 	}
 };
 
+// Per-size-class counters of thor's kernel heap caches.
+struct KernelHeapNode final : public procfs::RegularNode {
+	async::result<std::string> show() override {
+		helix::Offer offer;
+		helix::SendBuffer send_req;
+		helix::RecvInline recv_resp;
+		helix::RecvInline recv_stats;
+
+		managarm::kerncfg::CntRequest req;
+		req.set_req_type(managarm::kerncfg::CntReqType::GET_HEAP_STATS);
+
+		auto ser = req.SerializeAsString();
+		auto &&transmit = helix::submitAsync(kerncfgLane, helix::Dispatcher::global(),
+				helix::action(&offer, kHelItemAncillary),
+				helix::action(&send_req, ser.data(), ser.size(), kHelItemChain),
+				helix::action(&recv_resp, kHelItemChain),
+				helix::action(&recv_stats));
+		co_await transmit.async_wait();
+		HEL_CHECK(offer.error());
+		HEL_CHECK(send_req.error());
+		HEL_CHECK(recv_resp.error());
+		HEL_CHECK(recv_stats.error());
+
+		managarm::kerncfg::SvrResponse resp;
+		resp.ParseFromArray(recv_resp.data(), recv_resp.length());
+		assert(resp.error() == managarm::kerncfg::Error::SUCCESS);
+		co_return std::string{(const char *)recv_stats.data(), recv_stats.length()};
+	}
+
+	async::result<void> store(std::string buffer) override {
+		throw std::runtime_error("Cannot store to /proc/kernel-heap");
+	}
+};
+
+// Per-request-type counters and latency histograms of serveRequests().
+struct RequestStatsNode final : public procfs::RegularNode {
+	async::result<std::string> show() override {
+		std::stringstream stream;
+		stream << std::left << std::setw(20) << "request" << std::right
+				<< std::setw(10) << "count"
+				<< std::setw(12) << "avg-us"
+				<< std::setw(12) << "max-us"
+				<< "  histogram (1us, 2us, 4us, ...)\n";
+		for(auto &entry : requestTable) {
+			if(!entry.count)
+				continue;
+			stream << std::left << std::setw(20) << entry.name << std::right
+					<< std::setw(10) << entry.count
+					<< std::setw(12) << entry.totalNanos / entry.count / 1000
+					<< std::setw(12) << entry.maxNanos / 1000
+					<< " ";
+			for(auto n : entry.latencyHistogram)
+				stream << " " << n;
+			stream << "\n";
+		}
+		co_return stream.str();
+	}
+
+	async::result<void> store(std::string buffer) override {
+		throw std::runtime_error("Cannot store to /proc/posix-requests");
+	}
+};
+
 async::result<void> enumerateKerncfg() {
 	auto root = co_await mbus::Instance::global().getRoot();
 
@@ -2812,6 +3288,7 @@ async::result<void> enumerateKerncfg() {
 
 	auto procfs_root = std::static_pointer_cast<procfs::DirectoryNode>(getProcfs()->getTarget());
 	procfs_root->directMkregular("cmdline", std::make_shared<CmdlineNode>());
+	procfs_root->directMkregular("kernel-heap", std::make_shared<KernelHeapNode>());
 }
 
 // --------------------------------------------------------
@@ -2819,6 +3296,9 @@ async::result<void> enumerateKerncfg() {
 // --------------------------------------------------------
 
 async::detached runInit() {
+	auto procfs_root = std::static_pointer_cast<procfs::DirectoryNode>(getProcfs()->getTarget());
+	procfs_root->directMkregular("posix-requests", std::make_shared<RequestStatsNode>());
+
 	co_await enumerateKerncfg();
 	co_await clk::enumerateTracker();
 	async::detach(net::enumerateNetserver());
@@ -30,36 +30,26 @@ std::shared_ptr<VmContext> VmContext::create() {
 std::shared_ptr<VmContext> VmContext::clone(std::shared_ptr<VmContext> original) {
 	auto context = std::make_shared<VmContext>();
 
+	// The kernel forks all copy-on-write areas and shares all other areas at once.
 	HelHandle space;
-	HEL_CHECK(helCreateSpace(&space));
+	HEL_CHECK(helForkSpace(original->_space.getHandle(), &space));
 	context->_space = helix::UniqueDescriptor(space);
 
+	// helForkSpace() also copies mappings that are not part of the area tree.
+	// Remove them, as the child must not share the parent's thread page etc.
+	for(auto [address, size] : original->_internalMappings)
+		HEL_CHECK(helUnmapMemory(context->_space.getHandle(),
+				reinterpret_cast<void *>(address), size));
+
 	for(const auto &entry : original->_areaTree) {
 		const auto &[address, area] = entry;
 
-		helix::UniqueDescriptor copyView;
-		if(area.copyOnWrite) {
-			HelHandle copyHandle;
-			HEL_CHECK(helForkMemory(area.copyView.getHandle(), &copyHandle));
-			copyView = helix::UniqueDescriptor{copyHandle};
-
-			void *pointer;
-			HEL_CHECK(helMapMemory(copyView.getHandle(), context->_space.getHandle(),
-					reinterpret_cast<void *>(address),
-					0, area.areaSize, area.nativeFlags, &pointer));
-		}else{
-			void *pointer;
-			HEL_CHECK(helMapMemory(area.fileView.getHandle(), context->_space.getHandle(),
-					reinterpret_cast<void *>(address),
-					area.offset, area.areaSize, area.nativeFlags, &pointer));
-		}
-
+		// The forked copy-on-write memory is only referenced by the child's space.
 		Area copy;
 		copy.copyOnWrite = area.copyOnWrite;
 		copy.areaSize = area.areaSize;
 		copy.nativeFlags = area.nativeFlags;
 		copy.fileView = area.fileView.dup();
-		copy.copyView = std::move(copyView);
 		copy.file = area.file;
 		copy.offset = area.offset;
 		context->_areaTree.emplace(address, std::move(copy));
@@ -117,6 +107,15 @@ VmContext::mapFile(uintptr_t hint, helix::UniqueDescriptor memory,
 	co_return pointer;
 }
 
+void *VmContext::mapInternal(helix::BorrowedDescriptor memory, size_t size,
+		uint32_t nativeFlags) {
+	void *pointer;
+	HEL_CHECK(helMapMemory(memory.getHandle(), _space.getHandle(),
+			nullptr, 0, size, nativeFlags, &pointer));
+	_internalMappings.emplace(reinterpret_cast<uintptr_t>(pointer), size);
+	return pointer;
+}
+
 async::result<void *> VmContext::remapFile(void *old_pointer,
 		size_t old_size, size_t new_size) {
 	size_t aligned_old_size = (old_size + 0xFFF) & ~size_t(0xFFF);
@@ -246,9 +245,9 @@ std::shared_ptr<FileContext> FileContext::create() {
 
 	HelHandle memory;
 	void *window;
-	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &memory));
+	HEL_CHECK(helAllocateMemory(fileTableSize, 0, nullptr, &memory));
 	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
-			0, 0x1000, kHelMapProtRead | kHelMapProtWrite, &window));
+			0, fileTableSize, kHelMapProtRead | kHelMapProtWrite, &window));
 	context->_fileTableMemory = helix::UniqueDescriptor(memory);
 	context->_fileTableWindow = reinterpret_cast<HelHandle *>(window);
 
@@ -270,9 +269,9 @@ std::shared_ptr<FileContext> FileContext::clone(std::shared_ptr<FileContext> ori
 
 	HelHandle memory;
 	void *window;
-	HEL_CHECK(helAllocateMemory(0x1000, 0, nullptr, &memory));
+	HEL_CHECK(helAllocateMemory(fileTableSize, 0, nullptr, &memory));
 	HEL_CHECK(helMapMemory(memory, kHelNullHandle, nullptr,
-			0, 0x1000, kHelMapProtRead | kHelMapProtWrite, &window));
+			0, fileTableSize, kHelMapProtRead | kHelMapProtWrite, &window));
 	context->_fileTableMemory = helix::UniqueDescriptor(memory);
 	context->_fileTableWindow = reinterpret_cast<HelHandle *>(window);
 
@@ -295,16 +294,16 @@ FileContext::~FileContext() {
 		std::cout << "\e[33mposix: FileContext is destructed\e[39m" << std::endl;
 }
 
-int FileContext::attachFile(smarter::shared_ptr<File, FileHandle> file,
+std::optional<int> FileContext::attachFile(smarter::shared_ptr<File, FileHandle> file,
 		bool close_on_exec) {
-	HelHandle handle;
-	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
-			_universe.getHandle(), &handle));
-
-	for(int fd = 0; ; fd++) {
+	for(int fd = 0; fd < maxFileDescriptors; fd++) {
 		if(_fileTable.find(fd) != _fileTable.end())
 			continue;
 
+		HelHandle handle;
+		HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
+				_universe.getHandle(), &handle));
+
 		if(logFileAttach)
 			std::cout << "posix: Attaching FD " << fd << std::endl;
 
@@ -312,10 +311,13 @@ int FileContext::attachFile(smarter::shared_ptr<File, FileHandle> file,
 		_fileTableWindow[fd] = handle;
 		return fd;
 	}
+
+	return std::nullopt;
 }
 
 void FileContext::attachFile(int fd, smarter::shared_ptr<File, FileHandle> file,
 		bool close_on_exec) {
+	assert(fd >= 0 && fd < maxFileDescriptors);
 	HelHandle handle;
 	HEL_CHECK(helTransferDescriptor(file->getPassthroughLane().getHandle(),
 			_universe.getHandle(), &handle));
@@ -730,18 +732,13 @@ async::result<std::shared_ptr<Process>> Process::init(std::string path) {
 			process->_fileContext->getUniverse().getHandle(), &process->_clientPosixLane));
 	client_lane.release();
 
-	HEL_CHECK(helMapMemory(process->_threadPageMemory.getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
-			&process->_clientThreadPage));
-	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
-			&process->_clientFileTable));
-	HEL_CHECK(helMapMemory(clk::trackerPageMemory().getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
-			&process->_clientClkTrackerPage));
+	process->_clientThreadPage = process->_vmContext->mapInternal(
+			process->_threadPageMemory, 0x1000, kHelMapProtRead | kHelMapProtWrite);
+	process->_clientFileTable = process->_vmContext->mapInternal(
+			process->_fileContext->fileTableMemory(), FileContext::fileTableSize,
+			kHelMapProtRead);
+	process->_clientClkTrackerPage = process->_vmContext->mapInternal(
+			clk::trackerPageMemory(), 0x1000, kHelMapProtRead);
 
 	process->_uid = 0;
 	process->_euid = 0;
@@ -794,18 +791,13 @@ std::shared_ptr<Process> Process::fork(std::shared_ptr<Process> original) {
 			process->_fileContext->getUniverse().getHandle(), &process->_clientPosixLane));
 	client_lane.release();
 
-	HEL_CHECK(helMapMemory(process->_threadPageMemory.getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
-			&process->_clientThreadPage));
-	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
-			&process->_clientFileTable));
-	HEL_CHECK(helMapMemory(clk::trackerPageMemory().getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
-			&process->_clientClkTrackerPage));
+	process->_clientThreadPage = process->_vmContext->mapInternal(
+			process->_threadPageMemory, 0x1000, kHelMapProtRead | kHelMapProtWrite);
+	process->_clientFileTable = process->_vmContext->mapInternal(
+			process->_fileContext->fileTableMemory(), FileContext::fileTableSize,
+			kHelMapProtRead);
+	process->_clientClkTrackerPage = process->_vmContext->mapInternal(
+			clk::trackerPageMemory(), 0x1000, kHelMapProtRead);
 
 	process->_uid = original->_uid;
 	process->_euid = original->_euid;
@@ -853,10 +845,8 @@ std::shared_ptr<Process> Process::clone(std::shared_ptr<Process> original, void
 			process->_fileContext->getUniverse().getHandle(), &process->_clientPosixLane));
 	client_lane.release();
 
-	HEL_CHECK(helMapMemory(process->_threadPageMemory.getHandle(),
-			process->_vmContext->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
-			&process->_clientThreadPage));
+	process->_clientThreadPage = process->_vmContext->mapInternal(
+			process->_threadPageMemory, 0x1000, kHelMapProtRead | kHelMapProtWrite);
 
 	process->_clientFileTable = original->_clientFileTable;
 	process->_clientClkTrackerPage = original->_clientClkTrackerPage;
@@ -892,21 +882,13 @@ async::result<Error> Process::exec(std::shared_ptr<Process> process,
 			process->_fileContext->getUniverse().getHandle(), &exec_posix_lane));
 	client_lane.release();
 
-	void *exec_thread_page;
-	void *exec_clk_tracker_page;
-	void *exec_client_table;
-	HEL_CHECK(helMapMemory(process->_threadPageMemory.getHandle(),
-			exec_vm_context->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead | kHelMapProtWrite,
-			&exec_thread_page));
-	HEL_CHECK(helMapMemory(clk::trackerPageMemory().getHandle(),
-			exec_vm_context->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
-			&exec_clk_tracker_page));
-	HEL_CHECK(helMapMemory(process->_fileContext->fileTableMemory().getHandle(),
-			exec_vm_context->getSpace().getHandle(),
-			nullptr, 0, 0x1000, kHelMapProtRead,
-			&exec_client_table));
+	auto exec_thread_page = exec_vm_context->mapInternal(process->_threadPageMemory,
+			0x1000, kHelMapProtRead | kHelMapProtWrite);
+	auto exec_clk_tracker_page = exec_vm_context->mapInternal(clk::trackerPageMemory(),
+			0x1000, kHelMapProtRead);
+	auto exec_client_table = exec_vm_context->mapInternal(
+			process->_fileContext->fileTableMemory(), FileContext::fileTableSize,
+			kHelMapProtRead);
 
 	// TODO: We should only do this if the execute succeeds.
 	process->_fileContext->closeOnExec();
@@ -39,6 +39,10 @@ struct VmContext {
 
 	void unmapFile(void *pointer, size_t size);
 
+	// Maps memory that posix itself provides to the process (e.g., the thread page).
+	// Unlike file mappings, such mappings are not inherited by clone().
+	void *mapInternal(helix::BorrowedDescriptor memory, size_t size, uint32_t nativeFlags);
+
 private:
 	struct Area {
 		bool copyOnWrite;
@@ -54,6 +58,9 @@ private:
 
 	std::map<uintptr_t, Area> _areaTree;
 
+	// Address and size of all mappings that were created by mapInternal().
+	std::map<uintptr_t, size_t> _internalMappings;
+
 public:
 	struct AreaAccessor {
 		AreaAccessor(std::map<uintptr_t, Area>::iterator iter)
@@ -146,6 +153,10 @@ struct FileDescriptor {
 
 struct FileContext {
 public:
+	// The file table is mapped into the client; it has one HelHandle per FD.
+	static constexpr int maxFileDescriptors = 16384;
+	static constexpr size_t fileTableSize = maxFileDescriptors * sizeof(HelHandle);
+
 	static std::shared_ptr<FileContext> create();
 	static std::shared_ptr<FileContext> clone(std::shared_ptr<FileContext> original);
 
@@ -159,7 +170,10 @@ public:
 		return _fileTableMemory;
 	}
 
-	int attachFile(smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
+	// Attaches the file to the lowest free FD.
+	// Returns std::nullopt if all FDs are in use.
+	std::optional<int> attachFile(smarter::shared_ptr<File, FileHandle> file,
+			bool close_on_exec = false);
 
 	void attachFile(int fd, smarter::shared_ptr<File, FileHandle> file, bool close_on_exec = false);
 
@@ -110,6 +110,20 @@ async::result<ReadEntriesResult> DirectoryFile::readEntries() {
 	}
 }
 
+expected<size_t> DirectoryFile::readEntryBatch(void *buffer, size_t max_length) {
+	size_t length = 0;
+	while(_iter != _node->_entries.end()) {
+		auto target = (*_iter)->getTarget();
+		if(!protocols::fs::appendEntryRecord(buffer, max_length, length,
+				0 /* FIXME */, direntType(target->getType()), (*_iter)->getName()))
+			break;
+		_iter++;
+	}
+	if(!length && _iter != _node->_entries.end())
+		co_return Error::illegalArguments;
+	co_return length;
+}
+
 helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
 	return _passthrough;
 }
@@ -59,6 +59,7 @@ public:
 	void handleClose() override;
 
 	FutureMaybe<ReadEntriesResult> readEntries() override;
+	expected<size_t> readEntryBatch(void *buffer, size_t max_length) override;
 	helix::BorrowedDescriptor getPassthroughLane() override;
 
 private:
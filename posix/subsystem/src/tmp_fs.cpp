@@ -225,6 +225,7 @@ public:
 	void handleClose() override;
 
 	FutureMaybe<ReadEntriesResult> readEntries() override;
+	expected<size_t> readEntryBatch(void *buffer, size_t max_length) override;
 	helix::BorrowedDescriptor getPassthroughLane() override;
 
 private:
@@ -274,8 +275,9 @@ private:
 	FutureMaybe<std::shared_ptr<FsLink>> link(std::string name,
 			std::shared_ptr<FsNode> target) override {
 		assert(_entries.find(name) == _entries.end());
-		auto link = std::make_shared<Link>(shared_from_this(), std::move(name), std::move(target));
+		auto link = std::make_shared<Link>(shared_from_this(), name, std::move(target));
 		_entries.insert(link);
+		notifyObservers(FsObserver::createEvent, name, 0);
 		co_return link;
 	}
 
@@ -461,9 +463,14 @@ struct Superblock final : FsSuperblock {
 			dest_dir->_entries.erase(dest_it);
 
 		auto new_link = std::make_shared<Link>(dest_dir->shared_from_this(),
-				std::move(dest_name), src_link->getTarget());
+				dest_name, src_link->getTarget());
+		auto src_name = src_link->getName();
 		src_dir->_entries.erase(it);
 		dest_dir->_entries.insert(new_link);
+
+		auto cookie = ++_renameCookie;
+		src_dir->notifyObservers(FsObserver::moveFromEvent, src_name, cookie);
+		dest_dir->notifyObservers(FsObserver::moveToEvent, dest_name, cookie);
 		co_return new_link;
 	}
 
@@ -473,6 +480,9 @@ struct Superblock final : FsSuperblock {
 
 private:
 	int64_t _inodeCounter = 1;
+
+	// Cookies that associate the two inotify events of a rename.
+	uint32_t _renameCookie = 0;
 };
 
 // ----------------------------------------------------------------------------
@@ -591,6 +601,21 @@ DirectoryFile::readEntries() {
 	}
 }
 
+expected<size_t> DirectoryFile::readEntryBatch(void *buffer, size_t max_length) {
+	size_t length = 0;
+	while(_iter != _node->_entries.end()) {
+		// All nodes that are linked into a tmpfs directory belong to the tmpfs.
+		auto target = static_cast<Node *>((*_iter)->getTarget().get());
+		if(!protocols::fs::appendEntryRecord(buffer, max_length, length,
+				target->inodeNumber(), direntType(target->getType()), (*_iter)->getName()))
+			break;
+		_iter++;
+	}
+	if(!length && _iter != _node->_entries.end())
+		co_return Error::illegalArguments;
+	co_return length;
+}
+
 helix::BorrowedDescriptor DirectoryFile::getPassthroughLane() {
 	return _passthrough;
 }
@@ -647,9 +672,10 @@ DirectoryNode::mkdir(std::string name) {
 	assert(_entries.find(name) == _entries.end());
 	auto node = std::make_shared<DirectoryNode>(static_cast<Superblock *>(superblock()));
 	auto the_node = node.get();
-	auto link = std::make_shared<Link>(shared_from_this(), std::move(name), std::move(node));
+	auto link = std::make_shared<Link>(shared_from_this(), name, std::move(node));
 	the_node->_treeLink = link;
 	_entries.insert(link);
+	notifyObservers(FsObserver::createEvent, name, 0);
 	co_return link;
 }
 
@@ -658,8 +684,9 @@ DirectoryNode::symlink(std::string name, std::string path) {
 	assert(_entries.find(name) == _entries.end());
 	auto node = std::make_shared<SymlinkNode>(static_cast<Superblock *>(superblock()),
 			std::move(path));
-	auto link = std::make_shared<Link>(shared_from_this(), std::move(name), std::move(node));
+	auto link = std::make_shared<Link>(shared_from_this(), name, std::move(node));
 	_entries.insert(link);
+	notifyObservers(FsObserver::createEvent, name, 0);
 	co_return link;
 }
 
@@ -668,8 +695,9 @@ DirectoryNode::mkdev(std::string name, VfsType type, DeviceId id) {
 	assert(_entries.find(name) == _entries.end());
 	auto node = std::make_shared<DeviceNode>(static_cast<Superblock *>(superblock()),
 			type, id);
-	auto link = std::make_shared<Link>(shared_from_this(), std::move(name), std::move(node));
+	auto link = std::make_shared<Link>(shared_from_this(), name, std::move(node));
 	_entries.insert(link);
+	notifyObservers(FsObserver::createEvent, name, 0);
 	co_return link;
 }
 
@@ -677,8 +705,9 @@ async::result<std::shared_ptr<FsLink>>
 DirectoryNode::mkfifo(std::string name, mode_t mode) {
 	assert(_entries.find(name) == _entries.end());
 	auto node = std::make_shared<FifoNode>(static_cast<Superblock *>(superblock()), mode);
-	auto link = std::make_shared<Link>(shared_from_this(), std::move(name), std::move(node));
+	auto link = std::make_shared<Link>(shared_from_this(), name, std::move(node));
 	_entries.insert(link);
+	notifyObservers(FsObserver::createEvent, name, 0);
 	co_return link;
 }
 
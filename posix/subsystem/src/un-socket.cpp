@@ -164,12 +164,23 @@ public:
 		}
 
 		if(!packet->files.empty()) {
-			if(ctrl.message(SOL_SOCKET, SCM_RIGHTS, sizeof(int) * packet->files.size())) {
-				for(auto &file : packet->files)
-					ctrl.write<int>(process->fileContext()->attachFile(std::move(file),
-							flags & MSG_CMSG_CLOEXEC));
-			}else{
-				throw std::runtime_error("posix: CMSG truncation is not implemented");
+			// Files that do not fit into the receiver's file table are discarded.
+			std::vector<int> fds;
+			for(auto &file : packet->files) {
+				auto fd = process->fileContext()->attachFile(std::move(file),
+						flags & MSG_CMSG_CLOEXEC);
+				if(!fd)
+					break;
+				fds.push_back(*fd);
+			}
+
+			if(!fds.empty()) {
+				if(ctrl.message(SOL_SOCKET, SCM_RIGHTS, sizeof(int) * fds.size())) {
+					for(auto fd : fds)
+						ctrl.write<int>(fd);
+				}else{
+					throw std::runtime_error("posix: CMSG truncation is not implemented");
+				}
 			}
 
 			packet->files.clear();
@@ -228,7 +239,7 @@ public:
 		co_return;
 	}
 
-	async::result<AcceptResult> accept(Process *process) override {
+	expected<AcceptResult> accept(Process *process) override {
 		assert(!_acceptQueue.empty());
 
 		auto remote = std::move(_acceptQueue.front());
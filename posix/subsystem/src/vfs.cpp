@@ -4,6 +4,8 @@
 #include <unistd.h>
 #include <experimental/coroutine>
 #include <future>
+#include <list>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "fs.pb.h"
@@ -183,6 +185,105 @@ private:
 	std::vector<std::string> _components;
 };
 
+// --------------------------------------------------------
+// Dentry cache.
+// --------------------------------------------------------
+
+namespace {
+
+// Caches the results of FsNode::getLink() for the path resolver, including negative results.
+// Only directories that support observers are cached: entries are invalidated
+// by the FsObserver notifications that the file system emits when it modifies a directory.
+struct DentryCache {
+	static constexpr size_t maxDirectories = 1024;
+	static constexpr size_t maxEntriesPerDirectory = 256;
+
+	struct Directory final : FsObserver {
+		void observeNotification(uint32_t, const std::string &name, uint32_t) override {
+			entries.erase(name);
+			sequence++;
+		}
+
+		std::shared_ptr<FsNode> node;
+
+		// Null links represent negative entries (i.e., the name does not exist).
+		std::unordered_map<std::string, std::shared_ptr<FsLink>> entries;
+
+		// Incremented on every notification; used to detect races with getLink().
+		uint64_t sequence = 0;
+
+		bool evicted = false;
+		std::list<FsNode *>::iterator lruIterator;
+	};
+
+	async::result<std::shared_ptr<FsLink>> getLink(std::shared_ptr<FsNode> node,
+			std::string name) {
+		if(!node->supportsObservers())
+			co_return co_await node->getLink(std::move(name));
+
+		auto directory = _getDirectory(node);
+		if(auto it = directory->entries.find(name); it != directory->entries.end())
+			co_return it->second;
+
+		// Do not insert the result if the directory was modified while we were waiting.
+		auto sequence = directory->sequence;
+		auto link = co_await node->getLink(name);
+		if(!directory->evicted && directory->sequence == sequence) {
+			if(directory->entries.size() >= maxEntriesPerDirectory)
+				directory->entries.clear();
+			directory->entries.insert({std::move(name), link});
+		}
+		co_return link;
+	}
+
+private:
+	std::shared_ptr<Directory> _getDirectory(const std::shared_ptr<FsNode> &node) {
+		if(auto it = _directories.find(node.get()); it != _directories.end()) {
+			auto directory = it->second;
+			_lru.splice(_lru.begin(), _lru, directory->lruIterator);
+			return directory;
+		}
+
+		if(_directories.size() >= maxDirectories)
+			_evict();
+
+		auto directory = std::make_shared<Directory>();
+		directory->node = node;
+		_lru.push_front(node.get());
+		directory->lruIterator = _lru.begin();
+		_directories.insert({node.get(), directory});
+		node->addObserver(directory);
+		return directory;
+	}
+
+	void _evict() {
+		assert(!_lru.empty());
+		auto it = _directories.find(_lru.back());
+		assert(it != _directories.end());
+		_lru.pop_back();
+
+		auto directory = std::move(it->second);
+		_directories.erase(it);
+		directory->evicted = true;
+		directory->entries.clear();
+		directory->node->removeObserver(directory.get());
+	}
+
+	// Cached directories keep their FsNode alive; hence, the pointers stay valid.
+	std::unordered_map<FsNode *, std::shared_ptr<Directory>> _directories;
+
+	// Most recently used directories are at the front.
+	std::list<FsNode *> _lru;
+};
+
+DentryCache globalDentryCache;
+
+} // anonymous namespace
+
+// --------------------------------------------------------
+// PathResolver implementation.
+// --------------------------------------------------------
+
 void PathResolver::setup(ViewPath root, ViewPath workdir, std::string string) {
 	_rootPath = std::move(root);
 
@@ -236,7 +337,8 @@ async::result<void> PathResolver::resolve(ResolveFlags flags) {
 				_currentPath = ViewPath{_currentPath.first, owner->treeLink()};
 			}
 		}else{
-			auto child = co_await _currentPath.second->getTarget()->getLink(std::move(name));
+			auto child = co_await globalDentryCache.getLink(_currentPath.second->getTarget(),
+					std::move(name));
 
 			if(!child) {
 				// TODO: Return an error code.
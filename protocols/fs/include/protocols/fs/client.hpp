@@ -28,7 +28,12 @@ struct File {
 	
 	async::result<void> seekAbsolute(int64_t offset);
 
-	async::result<size_t> readSome(void *data, size_t max_length);
+	// Seeks relative to the end of the file and returns the new offset.
+	async::result<int64_t> seekEof(int64_t offset);
+
+	async::result<ReadResult> readSome(void *data, size_t max_length);
+
+	async::result<ReadResult> readEntryBatch(void *data, size_t max_length);
 
 	async::result<PollResult> poll(uint64_t sequence, async::cancellation_token cancellation);
 
@@ -1,7 +1,12 @@
 #ifndef LIBFS_COMMON_HPP
 #define LIBFS_COMMON_HPP
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -26,12 +31,52 @@ enum class Error {
 	insufficientPermissions = 14,
 	addressInUse = 15,
 	addressNotAvailable = 16,
+	ioError = 17,
 };
 
 using ReadResult = std::variant<Error, size_t>;
 
+// Number of bytes that were written; this can be less than the requested size.
+using WriteResult = std::variant<Error, size_t>;
+
 using ReadEntriesResult = std::optional<std::string>;
 
+// PT_READ_ENTRY_BATCH fills a buffer with records that consist of this header,
+// followed by the name of the entry (without a null terminator).
+// Each record is padded to a multiple of 8 bytes.
+struct EntryRecord {
+	uint64_t inode;
+	uint16_t recordLength;
+	uint16_t nameLength;
+	uint8_t type; // One of the DT_* constants from <dirent.h>.
+	uint8_t reserved[3];
+};
+
+static_assert(sizeof(EntryRecord) == 16);
+
+// Appends a record to a PT_READ_ENTRY_BATCH buffer.
+// Returns false (and leaves the buffer unchanged) if the record does not fit.
+inline bool appendEntryRecord(void *buffer, size_t max_length, size_t &offset,
+		uint64_t inode, uint8_t type, std::string_view name) {
+	size_t length = (sizeof(EntryRecord) + name.size() + 7) & ~size_t(7);
+	if(length > UINT16_MAX || offset + length > max_length)
+		return false;
+
+	EntryRecord record{};
+	record.inode = inode;
+	record.recordLength = length;
+	record.nameLength = name.size();
+	record.type = type;
+
+	auto p = static_cast<char *>(buffer) + offset;
+	memcpy(p, &record, sizeof(EntryRecord));
+	memcpy(p + sizeof(EntryRecord), name.data(), name.size());
+	memset(p + sizeof(EntryRecord) + name.size(), 0,
+			length - sizeof(EntryRecord) - name.size());
+	offset += length;
+	return true;
+}
+
 using PollResult = std::tuple<uint64_t, int, int>;
 
 struct RecvData {
@@ -45,6 +45,9 @@ using GetLinkResult = std::tuple<std::shared_ptr<void>, int64_t, FileType>;
 using OpenResult = std::pair<helix::UniqueLane, helix::UniqueLane>;
 
 using MkdirResult = std::pair<std::shared_ptr<void>, int64_t>;
+
+// Lane that serves the passthrough protocol for the accepted socket.
+using AcceptResult = std::variant<Error, helix::UniqueLane>;
 using SymlinkResult = std::pair<std::shared_ptr<void>, int64_t>;
 
 struct FileOperations {
@@ -68,7 +71,7 @@ struct FileOperations {
 		read = f;
 		return *this;
 	}
-	constexpr FileOperations &withWrite(async::result<void> (*f)(void *object,
+	constexpr FileOperations &withWrite(async::result<WriteResult> (*f)(void *object,
 			const char *, const void *buffer, size_t length)) {
 		write = f;
 		return *this;
@@ -77,6 +80,11 @@ struct FileOperations {
 		readEntries = f;
 		return *this;
 	}
+	constexpr FileOperations &withReadEntryBatch(async::result<ReadResult> (*f)(void *object,
+			void *buffer, size_t max_length)) {
+		readEntryBatch = f;
+		return *this;
+	}
 	constexpr FileOperations &withAccessMemory(async::result<helix::BorrowedDescriptor>(*f)(void *object)) {
 		accessMemory = f;
 		return *this;
@@ -139,9 +147,12 @@ struct FileOperations {
 			void *buffer, size_t length);
 	async::result<ReadResult> (*pread)(void *object, int64_t offset, const char *credentials,
 			void *buffer, size_t length);
-	async::result<void> (*write)(void *object, const char *credentials,
+	async::result<WriteResult> (*write)(void *object, const char *credentials,
 			const void *buffer, size_t length);
 	async::result<ReadEntriesResult> (*readEntries)(void *object);
+	// Fills the buffer with EntryRecords. Returns zero at the end of the directory
+	// and Error::illegalArguments if the buffer cannot hold a single record.
+	async::result<ReadResult> (*readEntryBatch)(void *object, void *buffer, size_t max_length);
 	async::result<helix::BorrowedDescriptor>(*accessMemory)(void *object);
 	async::result<void> (*truncate)(void *object, size_t size);
 	async::result<void> (*fallocate)(void *object, int64_t offset, size_t size);
@@ -155,6 +166,7 @@ struct FileOperations {
 	async::result<Error> (*bind)(void *object, const char *credentials,
 			const void *addr_ptr, size_t addr_length);
 	async::result<void> (*listen)(void *object);
+	async::result<AcceptResult> (*accept)(void *object);
 	async::result<Error> (*connect)(void *object, const char *credentials,
 			const void *addr_ptr, size_t addr_length);
 	async::result<size_t> (*sockname)(void *object, void *addr_ptr, size_t max_addr_length);
@@ -36,7 +36,34 @@ async::result<void> File::seekAbsolute(int64_t offset) {
 	assert(resp.error() == managarm::fs::Errors::SUCCESS);
 }
 
-async::result<size_t> File::readSome(void *data, size_t max_length) {
+async::result<int64_t> File::seekEof(int64_t offset) {
+	managarm::fs::CntRequest req;
+	req.set_req_type(managarm::fs::CntReqType::SEEK_EOF);
+	req.set_rel_offset(offset);
+
+	auto ser = req.SerializeAsString();
+	uint8_t buffer[128];
+
+	auto [offer, send_req, recv_resp] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::recvBuffer(buffer, 128)
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_resp.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(buffer, recv_resp.actualLength());
+	assert(resp.error() == managarm::fs::Errors::SUCCESS);
+	co_return resp.offset();
+}
+
+async::result<ReadResult> File::readSome(void *data, size_t max_length) {
 	managarm::fs::CntRequest req;
 	req.set_req_type(managarm::fs::CntReqType::READ);
 	req.set_size(max_length);
@@ -64,12 +91,45 @@ async::result<size_t> File::readSome(void *data, size_t max_length) {
 	managarm::fs::SvrResponse resp;
 	resp.ParseFromArray(buffer, recv_resp.actualLength());
 	if(resp.error() == managarm::fs::Errors::END_OF_FILE) {
-		co_return 0;
+		co_return size_t{0};
+	}else if(resp.error() == managarm::fs::Errors::IO_ERROR) {
+		co_return Error::ioError;
 	}
 	assert(resp.error() == managarm::fs::Errors::SUCCESS);
 	co_return recv_data.actualLength();
 }
 
+async::result<ReadResult> File::readEntryBatch(void *data, size_t max_length) {
+	managarm::fs::CntRequest req;
+	req.set_req_type(managarm::fs::CntReqType::PT_READ_ENTRY_BATCH);
+	req.set_size(max_length);
+
+	auto ser = req.SerializeAsString();
+	uint8_t buffer[128];
+
+	auto [offer, send_req, recv_resp, recv_data] =
+		co_await helix_ng::exchangeMsgs(
+			_lane,
+			helix_ng::offer(
+				helix_ng::sendBuffer(ser.data(), ser.size()),
+				helix_ng::recvBuffer(buffer, 128),
+				helix_ng::recvBuffer(data, max_length)
+			)
+		);
+
+	HEL_CHECK(offer.error());
+	HEL_CHECK(send_req.error());
+	HEL_CHECK(recv_resp.error());
+	HEL_CHECK(recv_data.error());
+
+	managarm::fs::SvrResponse resp;
+	resp.ParseFromArray(buffer, recv_resp.actualLength());
+	if(resp.error() == managarm::fs::Errors::ILLEGAL_ARGUMENT)
+		co_return Error::illegalArguments;
+	assert(resp.error() == managarm::fs::Errors::SUCCESS);
+	co_return recv_data.actualLength();
+}
+
 async::result<PollResult> File::poll(uint64_t sequence,
 		async::cancellation_token cancellation) {
 	HelHandle cancel_handle;
@@ -93,6 +93,15 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		}else if(error && *error == Error::illegalArguments) {
 			resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
 
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+		}else if(error && *error == Error::ioError) {
+			resp.set_error(managarm::fs::Errors::IO_ERROR);
+
 			auto ser = resp.SerializeAsString();
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
 				conversation,
@@ -139,6 +148,15 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		}else if(error && *error == Error::illegalArguments) {
 			resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
 
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+		}else if(error && *error == Error::ioError) {
+			resp.set_error(managarm::fs::Errors::IO_ERROR);
+
 			auto ser = resp.SerializeAsString();
 			auto [send_resp] = co_await helix_ng::exchangeMsgs(
 				conversation,
@@ -171,11 +189,22 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 		HEL_CHECK(recv_buffer.error());
 
 		assert(file_ops->write);
-		co_await file_ops->write(file.get(), extract_creds.credentials(),
+		auto res = co_await file_ops->write(file.get(), extract_creds.credentials(),
 				buffer.data(), recv_buffer.actualLength());
 
 		managarm::fs::SvrResponse resp;
-		resp.set_error(managarm::fs::Errors::SUCCESS);
+		auto error = std::get_if<Error>(&res);
+		if(error && *error == Error::wouldBlock) {
+			resp.set_error(managarm::fs::Errors::WOULD_BLOCK);
+		}else if(error && *error == Error::illegalArguments) {
+			resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
+		}else if(error && *error == Error::brokenPipe) {
+			resp.set_error(managarm::fs::Errors::BROKEN_PIPE);
+		}else{
+			assert(!error);
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+			resp.set_size(std::get<size_t>(res));
+		}
 
 		auto ser = resp.SerializeAsString();
 		auto [send_resp] = co_await helix_ng::exchangeMsgs(
@@ -219,6 +248,33 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			conversation,
 			helix_ng::sendBuffer(ser.data(), ser.size()));
 		HEL_CHECK(send_resp.error());
+	}else if(req.req_type() == managarm::fs::CntReqType::PT_READ_ENTRY_BATCH) {
+		std::string data;
+		data.resize(req.size());
+		assert(file_ops->readEntryBatch);
+		auto res = co_await file_ops->readEntryBatch(file.get(), data.data(), req.size());
+
+		// We always send the data buffer, even if it is empty.
+		// A successful response without data indicates the end of the directory.
+		managarm::fs::SvrResponse resp;
+		size_t length = 0;
+		auto error = std::get_if<Error>(&res);
+		if(error) {
+			assert(*error == Error::illegalArguments);
+			resp.set_error(managarm::fs::Errors::ILLEGAL_ARGUMENT);
+		}else{
+			resp.set_error(managarm::fs::Errors::SUCCESS);
+			length = std::get<size_t>(res);
+		}
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp, send_data] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()),
+			helix_ng::sendBuffer(data.data(), length)
+		);
+		HEL_CHECK(send_resp.error());
+		HEL_CHECK(send_data.error());
 	}else if(req.req_type() == managarm::fs::CntReqType::MMAP) {
 		assert(file_ops->accessMemory);
 		auto memory = co_await file_ops->accessMemory(file.get());
@@ -359,6 +415,47 @@ async::detached handlePassthrough(smarter::shared_ptr<void> file,
 			helix_ng::sendBuffer(ser.data(), ser.size())
 		);
 		HEL_CHECK(send_resp.error());
+	}else if(req.req_type() == managarm::fs::CntReqType::PT_LISTEN) {
+		assert(file_ops->listen);
+		co_await file_ops->listen(file.get());
+
+		managarm::fs::SvrResponse resp;
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size())
+		);
+		HEL_CHECK(send_resp.error());
+	}else if(req.req_type() == managarm::fs::CntReqType::PT_ACCEPT) {
+		assert(file_ops->accept);
+		auto result = co_await file_ops->accept(file.get());
+
+		managarm::fs::SvrResponse resp;
+		auto error = std::get_if<Error>(&result);
+		if(error) {
+			resp.set_error(static_cast<int32_t>(*error));
+
+			auto ser = resp.SerializeAsString();
+			auto [send_resp] = co_await helix_ng::exchangeMsgs(
+				conversation,
+				helix_ng::sendBuffer(ser.data(), ser.size())
+			);
+			HEL_CHECK(send_resp.error());
+			co_return;
+		}
+
+		resp.set_error(managarm::fs::Errors::SUCCESS);
+
+		auto ser = resp.SerializeAsString();
+		auto [send_resp, push_lane] = co_await helix_ng::exchangeMsgs(
+			conversation,
+			helix_ng::sendBuffer(ser.data(), ser.size()),
+			helix_ng::pushDescriptor(std::get<helix::UniqueLane>(result))
+		);
+		HEL_CHECK(send_resp.error());
+		HEL_CHECK(push_lane.error());
 	}else if(req.req_type() == managarm::fs::CntReqType::PT_SOCKNAME) {
 		std::vector<char> addr;
 		addr.resize(req.size());
@@ -34,8 +34,44 @@ enum EtherType : uint16_t {
 	ETHER_TYPE_ARP = 0x0806,
 };
 
-// TODO(arsen): Expose interface for csum offloading, constructing frames, and
-// other features of NICs
+// Optional features of a NIC. Links that do not support a feature
+// leave the corresponding member at its default value.
+struct Capabilities {
+	// The NIC can compute TCP/UDP checksums of outgoing frames (see TxOffload).
+	bool transmitChecksum = false;
+	// The NIC verifies TCP/UDP checksums of incoming frames
+	// and reports this via ReceivedFrame::checksumValid.
+	bool receiveChecksum = false;
+	// The NIC can split TCP segments that exceed the MTU (TSO).
+	// Requires transmitChecksum.
+	bool tcpSegmentation = false;
+	// Maximal size of a frame that is passed to send() with TxOffload::segmentSize set.
+	size_t maxSegmentationSize = 0;
+};
+
+// Offloads that are requested for a single outgoing frame.
+// All offsets are relative to the start of the frame.
+struct TxOffload {
+	// If set, the NIC computes the Internet checksum from checksumStart to the end
+	// of the frame and stores it at checksumStart + checksumOffset. The checksum field
+	// must contain the (non-inverted) checksum of the pseudo header.
+	bool needsChecksum = false;
+	uint16_t checksumStart = 0;
+	uint16_t checksumOffset = 0;
+	// If non-zero, the NIC splits the TCP payload into segments of this size.
+	// headerLength is the size of all headers up to and including the TCP header.
+	uint16_t segmentSize = 0;
+	uint16_t headerLength = 0;
+};
+
+struct ReceivedFrame {
+	// Owns the memory that frame points into.
+	arch::dma_buffer buffer;
+	arch::dma_buffer_view frame;
+	// The NIC already verified the TCP/UDP checksum.
+	bool checksumValid = false;
+};
+
 struct Link {
 	struct AllocatedBuffer {
 		arch::dma_buffer frame;
@@ -45,18 +81,25 @@ struct Link {
 		: mtu(mtu), dmaPool_(dmaPool) {}
 	virtual ~Link() = default;
 	//! Receives an entire frame from the network
-	virtual async::result<void> receive(arch::dma_buffer_view) = 0;
+	virtual async::result<ReceivedFrame> receive() = 0;
+	//! Sends an entire ethernet frame, applying the requested offloads
+	virtual async::result<void> send(const arch::dma_buffer_view,
+		const TxOffload &offload) = 0;
 	//! Sends an entire ethernet frame
-	virtual async::result<void> send(const arch::dma_buffer_view) = 0;
+	async::result<void> send(const arch::dma_buffer_view);
 	arch::dma_pool *dmaPool();
 	AllocatedBuffer allocateFrame(MacAddress to, EtherType type,
 		size_t payloadSize);
 
 	MacAddress deviceMac();
+	const Capabilities &capabilities() const {
+		return caps_;
+	}
 	unsigned int mtu;
 protected:
 	arch::dma_pool *dmaPool_;
 	MacAddress mac_;
+	Capabilities caps_;
 };
 
 async::detached runDevice(std::shared_ptr<Link> dev);
@@ -1,6 +1,205 @@
 #include "checksum.hpp"
 
 #include <arch/bit.hpp>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// All implementations below sum the buffer in native byte order and in units larger
+// than 16 bits. This is valid since the one's complement sum is independent of the
+// byte order (RFC 1071) and 2^16 is congruent to 1 modulo 0xFFFF. The result is
+// swapped to network byte order only once, in addNative().
+
+namespace {
+
+using SumFunction = uint64_t (*)(const unsigned char *, size_t);
+using CopySumFunction = uint64_t (*)(unsigned char *, const unsigned char *, size_t);
+
+inline uint64_t addCarry(uint64_t acc, uint64_t value) {
+	acc += value;
+	return acc + (acc < value);
+}
+
+// Sums up the remaining (less than 8) bytes of a buffer.
+inline uint64_t sumTail(const unsigned char *p, size_t size, uint64_t acc) {
+	if (size >= 4) {
+		uint32_t v;
+		std::memcpy(&v, p, 4);
+		acc = addCarry(acc, v);
+		p += 4;
+		size -= 4;
+	}
+	if (size >= 2) {
+		uint16_t v;
+		std::memcpy(&v, p, 2);
+		acc = addCarry(acc, v);
+		p += 2;
+		size -= 2;
+	}
+	if (size) {
+		// An odd byte is padded with a zero byte at the end.
+		uint16_t v = 0;
+		std::memcpy(&v, p, 1);
+		acc = addCarry(acc, v);
+	}
+	return acc;
+}
+
+uint64_t sumGeneric(const unsigned char *p, size_t size) {
+	uint64_t acc = 0;
+	while (size >= 8) {
+		uint64_t v;
+		std::memcpy(&v, p, 8);
+		acc = addCarry(acc, v);
+		p += 8;
+		size -= 8;
+	}
+	return sumTail(p, size, acc);
+}
+
+uint64_t copySumGeneric(unsigned char *dest, const unsigned char *src, size_t size) {
+	uint64_t acc = 0;
+	while (size >= 8) {
+		uint64_t v;
+		std::memcpy(&v, src, 8);
+		std::memcpy(dest, &v, 8);
+		acc = addCarry(acc, v);
+		src += 8;
+		dest += 8;
+		size -= 8;
+	}
+	std::memcpy(dest, src, size);
+	return sumTail(src, size, acc);
+}
+
+#if defined(__x86_64__)
+// The SIMD versions add zero-extended 32-bit words to 64-bit lanes.
+// The lanes cannot overflow unless the buffer is larger than 16 GiB.
+
+uint64_t sumSse2(const unsigned char *p, size_t size) {
+	auto zero = _mm_setzero_si128();
+	auto acc = zero;
+	while (size >= 16) {
+		auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+		p += 16;
+		size -= 16;
+	}
+
+	uint64_t lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+	return addCarry(addCarry(lanes[0], lanes[1]), sumGeneric(p, size));
+}
+
+uint64_t copySumSse2(unsigned char *dest, const unsigned char *src, size_t size) {
+	auto zero = _mm_setzero_si128();
+	auto acc = zero;
+	while (size >= 16) {
+		auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dest), v);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+		src += 16;
+		dest += 16;
+		size -= 16;
+	}
+
+	uint64_t lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+	return addCarry(addCarry(lanes[0], lanes[1]), copySumGeneric(dest, src, size));
+}
+
+[[gnu::target("avx2")]]
+uint64_t sumAvx2(const unsigned char *p, size_t size) {
+	auto zero = _mm256_setzero_si256();
+	auto acc0 = zero;
+	auto acc1 = zero;
+	while (size >= 64) {
+		auto v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		auto v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+		p += 64;
+		size -= 64;
+	}
+
+	uint64_t lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), _mm256_add_epi64(acc0, acc1));
+	uint64_t acc = addCarry(addCarry(lanes[0], lanes[1]), addCarry(lanes[2], lanes[3]));
+	return addCarry(acc, sumGeneric(p, size));
+}
+
+[[gnu::target("avx2")]]
+uint64_t copySumAvx2(unsigned char *dest, const unsigned char *src, size_t size) {
+	auto zero = _mm256_setzero_si256();
+	auto acc = zero;
+	while (size >= 32) {
+		auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), v);
+		acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+		acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+		src += 32;
+		dest += 32;
+		size -= 32;
+	}
+
+	uint64_t lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), acc);
+	uint64_t result = addCarry(addCarry(lanes[0], lanes[1]), addCarry(lanes[2], lanes[3]));
+	return addCarry(result, copySumGeneric(dest, src, size));
+}
+
+bool cpuSupportsAvx2() {
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+	// The kernel must have enabled the YMM state.
+	if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+		return false;
+	}
+	uint32_t xcr0, xcr0High;
+	asm volatile ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0));
+	if ((xcr0 & 6) != 6) {
+		return false;
+	}
+
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+	return ebx & bit_AVX2;
+}
+#endif
+
+struct Implementation {
+	SumFunction sum;
+	CopySumFunction copySum;
+};
+
+Implementation selectImplementation() {
+#if defined(__x86_64__)
+	if (cpuSupportsAvx2()) {
+		return {&sumAvx2, &copySumAvx2};
+	}
+	// SSE2 is part of the x86_64 baseline.
+	return {&sumSse2, &copySumSse2};
+#else
+	return {&sumGeneric, &copySumGeneric};
+#endif
+}
+
+const Implementation &implementation() {
+	static const Implementation impl = selectImplementation();
+	return impl;
+}
+
+} // namespace
 
 void Checksum::update(uint16_t word)  {
 	state_ += word;
@@ -9,23 +208,27 @@ void Checksum::update(uint16_t word)  {
 	}
 }
 
+void Checksum::addNative(uint64_t sum) {
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	update(arch::convert_endian<arch::endian::big>(static_cast<uint16_t>(sum)));
+}
+
 void Checksum::update(const void *data, size_t size) {
-	using namespace arch;
-	auto iter = static_cast<const unsigned char*>(data);
-	if (size % 2 != 0) {
-		size--;
-		update(iter[size] << 8);
-	}
-	auto end = iter + size;
-	for (; iter < end; iter += 2) {
-		update(iter[0] << 8 | iter[1]);
-	}
+	addNative(implementation().sum(static_cast<const unsigned char *>(data), size));
 }
 
 void Checksum::update(arch::dma_buffer_view view) {
 	update(view.data(), view.size());
 }
 
+void Checksum::updateCopy(void *dest, const void *src, size_t size) {
+	addNative(implementation().copySum(static_cast<unsigned char *>(dest),
+		static_cast<const unsigned char *>(src), size));
+}
+
 uint16_t Checksum::finalize() {
 	auto state_ = this->state_;
 	return ~state_;
@@ -7,8 +7,13 @@ struct Checksum {
 	void update(uint16_t word);
 	void update(const void *mem, size_t size);
 	void update(arch::dma_buffer_view area);
+	// Copies size bytes from src to dest and adds them to the checksum in the same pass.
+	void updateCopy(void *dest, const void *src, size_t size);
 	uint16_t finalize();
 
 private:
+	// Adds a one's complement sum of native-endian words.
+	void addNative(uint64_t sum);
+
 	uint32_t state_ = 0;
 };
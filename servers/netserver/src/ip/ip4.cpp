@@ -6,6 +6,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <iomanip>
 #include <protocols/fs/server.hpp>
@@ -13,8 +14,6 @@
 
 using namespace protocols::fs;
 
-using Route = Ip4Router::Route;
-
 Ip4Router &ip4Router() {
 	static Ip4Router inst;
 	return inst;
@@ -25,34 +24,6 @@ Ip4 &ip4() {
 	return inst;
 }
 
-bool Ip4Router::addRoute(Route r) {
-	return routes.emplace(std::move(r)).second;
-}
-
-std::optional<Route> Ip4Router::resolveRoute(uint32_t ip) {
-	for (auto i = routes.begin(); i != routes.end(); i++) {
-		const auto &r = *i;
-		if (r.network.sameNet(ip)) {
-			if (r.link.expired()) {
-				i = routes.erase(i);
-				continue;
-			}
-			return { r };
-		}
-	}
-	return {};
-}
-
-bool operator<(const CidrAddress &lhs, const CidrAddress &rhs) {
-	return std::tie(lhs.prefix, lhs.ip) < std::tie(lhs.prefix, lhs.ip);
-}
-
-bool operator<(const Route &lhs, const Route &rhs) {
-	// bigger MTU is better, and hence sorts lower
-	return std::tie(lhs.network, lhs.metric, rhs.mtu) <
-		std::tie(rhs.network, rhs.metric, lhs.mtu);
-}
-
 bool Ip4Packet::parse(arch::dma_buffer owner, arch::dma_buffer_view frame) {
 	buffer_ = std::move(owner);
 	data = frame;
@@ -244,7 +215,7 @@ bool Ip4::hasIp(uint32_t addr) {
 }
 
 async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
-		void *data, size_t len, uint16_t proto) {
+		void *data, size_t len, uint16_t proto, nic::TxOffload offload) {
 	using arch::convert_endian;
 	using arch::endian;
 
@@ -252,26 +223,24 @@ async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
 	// calculate header size
 	size_t header_size = sizeof(Ip4Packet::Header);
 	size_t packet_size = len + header_size;
-	// TODO(arsen): options
-	if (ti.route.mtu != 0 && ti.route.mtu < packet_size) {
-		std::cout << "netserver: cant fragment 1" << std::endl;
-		co_return protocols::fs::Error::messageSize;
-	}
-
 	auto &target = ti.link;
-	if (target->mtu < packet_size) {
-		std::cout << "netserver: cant fragment 2" << std::endl;
-		co_return protocols::fs::Error::messageSize;
-	}
-
-	auto macTarget = ti.remote;
-	if (ti.route.gateway != 0) {
-		macTarget = ti.route.gateway;
-	}
+	if (offload.segmentSize) {
+		// The NIC splits the packet into MTU-sized segments.
+		assert(target->capabilities().tcpSegmentation);
+		if (packet_size > 0xFFFF) {
+			co_return protocols::fs::Error::messageSize;
+		}
+	} else {
+		// TODO(arsen): options
+		if (ti.route.mtu != 0 && ti.route.mtu < packet_size) {
+			std::cout << "netserver: cant fragment 1" << std::endl;
+			co_return protocols::fs::Error::messageSize;
+		}
 
-	auto mac = co_await neigh4().tryResolve(macTarget, ti.source);
-	if (!mac) {
-		co_return protocols::fs::Error::hostUnreachable;
+		if (target->mtu < packet_size) {
+			std::cout << "netserver: cant fragment 2" << std::endl;
+			co_return protocols::fs::Error::messageSize;
+		}
 	}
 
 	Ip4Packet::Header hdr;
@@ -279,6 +248,7 @@ async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
 	hdr.ihl = 0x45;
 	hdr.tos = 0;
 	hdr.length = packet_size;
+	hdr.ident = 0;
 	// TODO(arsen): fragmentation
 	hdr.flags_offset = 0;
 	hdr.ttl = 64;
@@ -295,28 +265,81 @@ async::result<protocols::fs::Error> Ip4::sendFrame(Ip4TargetInfo ti,
 	chk.update(reinterpret_cast<void *>(&hdr), sizeof(hdr));
 	hdr.checksum = convert_endian<endian::big>(chk.finalize());
 
+	// Packets to one of our own addresses never touch the wire.
+	if (hasIp(ti.remote)) {
+		arch::dma_buffer buffer { target->dmaPool(), packet_size };
+		std::memcpy(buffer.data(), &hdr, sizeof(hdr));
+		std::memcpy(buffer.subview(header_size).byte_data(), data, len);
+		// runLoopback() marks the checksum as verified: callers may have
+		// left it to the NIC and the packet cannot be corrupted on the way.
+		loopbackQueue.push_back(std::move(buffer));
+		if (!loopbackRunning) {
+			loopbackRunning = true;
+			runLoopback();
+		}
+		loopbackBell.ring();
+		co_return protocols::fs::Error::none;
+	}
+
+	auto macTarget = ti.remote;
+	if (ti.route.gateway != 0) {
+		macTarget = ti.route.gateway;
+	}
+
+	auto mac = co_await neigh4().tryResolve(macTarget, ti.source);
+	if (!mac) {
+		co_return protocols::fs::Error::hostUnreachable;
+	}
+
 	auto fb = target->allocateFrame(*mac, nic::ETHER_TYPE_IP4, packet_size);
 
 	std::memcpy(fb.payload.data(), &hdr, sizeof(hdr));
 	std::memcpy(fb.payload.subview(header_size).byte_data(), data, len);
 
-	co_await target->send(std::move(fb.frame));
+	// Translate the offsets of the offload into offsets within the frame.
+	auto payload_offset = static_cast<char *>(fb.payload.data())
+		- static_cast<char *>(fb.frame.data()) + header_size;
+	if (offload.needsChecksum) {
+		offload.checksumStart += payload_offset;
+	}
+	if (offload.segmentSize) {
+		offload.headerLength += payload_offset;
+	}
+
+	co_await target->send(fb.frame, offload);
 	co_return protocols::fs::Error::none;
 }
 
+async::detached Ip4::runLoopback() {
+	while (true) {
+		// Packets are fed one at a time so that replies generated while
+		// handling a packet are queued instead of recursing.
+		while (loopbackQueue.empty())
+			co_await loopbackBell.async_wait();
+
+		auto buffer = std::move(loopbackQueue.front());
+		loopbackQueue.pop_front();
+		auto view = buffer.subview(0);
+		feedPacket({}, {}, std::move(buffer), view, true);
+	}
+}
+
 void Ip4::feedPacket(nic::MacAddress dest, nic::MacAddress src,
-		arch::dma_buffer owner, arch::dma_buffer_view frame) {
+		arch::dma_buffer owner, arch::dma_buffer_view frame,
+		bool checksumValid) {
 	Ip4Packet hdr;
 	if (!hdr.parse(std::move(owner), frame)) {
 		std::cout << "netserver: runt, or otherwise invalid, ip4 frame received"
 			<< std::endl;
 		return;
 	}
+	hdr.checksumValid = checksumValid;
 	auto proto = hdr.header.protocol;
 
 	auto begin = sockets.lower_bound(proto);
 	if (begin == sockets.end()
-		&& proto != static_cast<uint16_t>(IpProto::udp)) {
+		&& proto != static_cast<uint16_t>(IpProto::udp)
+		&& proto != static_cast<uint16_t>(IpProto::tcp)) {
 		return;
 	}
 
@@ -324,6 +347,7 @@ void Ip4::feedPacket(nic::MacAddress dest, nic::MacAddress src,
 
 	switch (static_cast<IpProto>(proto)) {
 	case IpProto::udp: udp.feedDatagram(hdrs); break;
+	case IpProto::tcp: tcp.feedDatagram(hdrs); break;
 	default: break;
 	}
 
@@ -386,6 +410,9 @@ managarm::fs::Errors Ip4::serveSocket(helix::UniqueLane lane, int type, int prot
 	case SOCK_DGRAM:
 		udp.serveSocket(std::move(lane));
 		return managarm::fs::Errors::SUCCESS;
+	case SOCK_STREAM:
+		tcp.serveSocket(std::move(lane));
+		return managarm::fs::Errors::SUCCESS;
 	default:
 		return managarm::fs::Errors::ILLEGAL_ARGUMENT;
 	}
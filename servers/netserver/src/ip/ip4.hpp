@@ -2,6 +2,8 @@
 
 #include <arch/bit.hpp>
 #include <arch/dma_structs.hpp>
+#include <async/basic.hpp>
+#include <async/doorbell.hpp>
 #include <helix/ipc.hpp>
 #include <map>
 #include <smarter.hpp>
@@ -9,9 +11,12 @@
 #include <protocols/fs/common.hpp>
 #include <set>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <optional>
 
+#include "router.hpp"
+#include "tcp4.hpp"
 #include "udp4.hpp"
 
 #include <netserver/nic.hpp>
@@ -23,44 +28,6 @@ enum class IpProto : uint16_t {
 	udp = 17,
 };
 
-struct CidrAddress {
-	uint32_t ip;
-	uint8_t prefix;
-
-	inline uint32_t mask() const {
-		return (uint64_t(0xFFFFFFFF) << (32 - prefix))
-			& 0xFFFFFFFF;
-	}
-
-	inline bool sameNet(uint32_t other) const {
-		return (other & mask()) == (ip & mask());
-	}
-
-	friend bool operator<(const CidrAddress &, const CidrAddress &);
-};
-
-struct Ip4Router {
-	struct Route {
-		inline Route(CidrAddress net, std::weak_ptr<nic::Link> link)
-			: network(net), link(link) {}
-
-		CidrAddress network;
-		std::weak_ptr<nic::Link> link;
-		unsigned int mtu = 0;
-		uint32_t gateway = 0;
-		unsigned int metric = 0;
-		uint32_t source = 0;
-
-		friend bool operator<(const Route &, const Route &);
-	};
-
-	// false if insertion fails
-	bool addRoute(Route r);
-	std::optional<Route> resolveRoute(uint32_t ip);
-private:
-	std::set<Route> routes;
-};
-
 class Ip4Packet {
 	arch::dma_buffer buffer_;
 public:
@@ -95,6 +62,8 @@ public:
 	} header;
 	static_assert(sizeof(header) == 20, "bad header size");
 	arch::dma_buffer_view data;
+	// The TCP/UDP checksum was already verified by the NIC.
+	bool checksumValid = false;
 
 	inline arch::dma_buffer_view payload() const {
 		return data.subview(header.ihl * 4);
@@ -120,7 +89,8 @@ struct Ip4 {
 	managarm::fs::Errors serveSocket(helix::UniqueLane lane, int type, int proto);
 	// frame is a view into the owner buffer, stripping away eth bits
 	void feedPacket(nic::MacAddress dest, nic::MacAddress src,
-		arch::dma_buffer owner, arch::dma_buffer_view frame);
+		arch::dma_buffer owner, arch::dma_buffer_view frame,
+		bool checksumValid = false);
 
 	bool hasIp(uint32_t ip);
 	std::shared_ptr<nic::Link> getLink(uint32_t ip);
@@ -128,14 +98,23 @@ struct Ip4 {
 	std::optional<uint32_t> findLinkIp(uint32_t ipOnNet, nic::Link *link);
 
 	async::result<std::optional<Ip4TargetInfo>> targetByRemote(uint32_t);
+	// Offsets in offload are relative to the start of the IP payload.
 	async::result<protocols::fs::Error> sendFrame(Ip4TargetInfo,
 		void*, size_t,
-		uint16_t);
+		uint16_t, nic::TxOffload offload = {});
 private:
 	std::multimap<int, smarter::shared_ptr<Ip4Socket>> sockets;
 	std::map<CidrAddress, std::weak_ptr<nic::Link>> ips;
 
+	// Packets addressed to one of our own IPs are delivered from here.
+	async::detached runLoopback();
+
+	std::deque<arch::dma_buffer> loopbackQueue;
+	async::doorbell loopbackBell;
+	bool loopbackRunning = false;
+
 	Udp4 udp;
+	Tcp4 tcp;
 };
 
 Ip4 &ip4();
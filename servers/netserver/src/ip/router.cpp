@@ -0,0 +1,144 @@
+#include "router.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace {
+// Returns bit i of the address, counting from the most significant bit.
+inline int bitAt(uint32_t ip, int i) {
+	return (ip >> (31 - i)) & 1;
+}
+
+inline uint32_t maskOf(int prefix) {
+	return (uint64_t(0xFFFFFFFF) << (32 - prefix)) & 0xFFFFFFFF;
+}
+
+// Number of leading bits that two networks have in common.
+int commonPrefix(CidrAddress a, CidrAddress b) {
+	int limit = std::min(a.prefix, b.prefix);
+	auto diff = (a.ip ^ b.ip) & maskOf(limit);
+	if (!diff) {
+		return limit;
+	}
+	return __builtin_clz(diff);
+}
+
+// Fibonacci hashing; spreads consecutive addresses over the cache.
+inline size_t cacheSlot(uint32_t ip, int bits) {
+	return (ip * uint32_t(2654435769)) >> (32 - bits);
+}
+
+// Orders the routes of a single network: lower metric first, then bigger MTU.
+bool betterRoute(const Ip4Router::Route &lhs, const Ip4Router::Route &rhs) {
+	return std::tie(lhs.metric, rhs.mtu) < std::tie(rhs.metric, lhs.mtu);
+}
+} // namespace
+
+bool operator<(const CidrAddress &lhs, const CidrAddress &rhs) {
+	return std::tie(lhs.prefix, lhs.ip) < std::tie(rhs.prefix, rhs.ip);
+}
+
+auto Ip4Router::insertNode(std::unique_ptr<Node> &slot, CidrAddress key) -> Node * {
+	auto node = slot.get();
+	if (!node) {
+		slot = std::make_unique<Node>();
+		slot->key = key;
+		return slot.get();
+	}
+
+	auto common = commonPrefix(node->key, key);
+	if (common == node->key.prefix) {
+		if (common == key.prefix) {
+			return node;
+		}
+		// The new network is more specific; descend.
+		return insertNode(node->children[bitAt(key.ip, common)], key);
+	}
+
+	// The new network diverges from the node (or is less specific than it).
+	// Insert a node above the existing one.
+	std::unique_ptr<Node> parent;
+	Node *result;
+	if (common == key.prefix) {
+		parent = std::make_unique<Node>();
+		parent->key = key;
+		result = parent.get();
+	} else {
+		parent = std::make_unique<Node>();
+		parent->key = {key.ip & maskOf(common), static_cast<uint8_t>(common)};
+		auto leaf = std::make_unique<Node>();
+		leaf->key = key;
+		result = leaf.get();
+		parent->children[bitAt(key.ip, common)] = std::move(leaf);
+	}
+	parent->children[bitAt(node->key.ip, common)] = std::move(slot);
+	slot = std::move(parent);
+	return result;
+}
+
+bool Ip4Router::addRoute(Route r) {
+	r.network.ip &= r.network.mask();
+	auto node = insertNode(root_, r.network);
+
+	auto it = std::lower_bound(node->routes.begin(), node->routes.end(), r, betterRoute);
+	if (it != node->routes.end() && !betterRoute(r, *it)) {
+		// There already is a route with the same metric and MTU.
+		return false;
+	}
+	node->routes.insert(it, std::move(r));
+	numRoutes_++;
+	invalidateCache();
+	return true;
+}
+
+std::optional<Ip4Router::Route> Ip4Router::lookup(uint32_t ip) {
+	// Collect all nodes that match, from the least to the most specific one.
+	Node *matches[33];
+	int numMatches = 0;
+	for (auto node = root_.get(); node; ) {
+		if (!node->key.sameNet(ip)) {
+			break;
+		}
+		if (!node->routes.empty()) {
+			matches[numMatches++] = node;
+		}
+		if (node->key.prefix == 32) {
+			break;
+		}
+		node = node->children[bitAt(ip, node->key.prefix)].get();
+	}
+
+	while (numMatches) {
+		auto &routes = matches[--numMatches]->routes;
+		for (auto it = routes.begin(); it != routes.end(); ) {
+			if (!it->link.expired()) {
+				return *it;
+			}
+			it = routes.erase(it);
+			numRoutes_--;
+			invalidateCache();
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<Ip4Router::Route> Ip4Router::resolveRoute(uint32_t ip) {
+	auto &entry = cache_[cacheSlot(ip, cacheBits)];
+	if (entry.generation == cacheGeneration_ && entry.ip == ip
+			&& !entry.route->link.expired()) {
+		return entry.route;
+	}
+
+	auto route = lookup(ip);
+	if (route) {
+		// lookup() can invalidate the cache; use the generation after the walk.
+		entry.ip = ip;
+		entry.generation = cacheGeneration_;
+		entry.route = route;
+	}
+	return route;
+}
+
+void Ip4Router::invalidateCache() {
+	cacheGeneration_++;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace nic {
+struct Link;
+} // namespace nic
+
+struct CidrAddress {
+	uint32_t ip;
+	uint8_t prefix;
+
+	inline uint32_t mask() const {
+		return (uint64_t(0xFFFFFFFF) << (32 - prefix))
+			& 0xFFFFFFFF;
+	}
+
+	inline bool sameNet(uint32_t other) const {
+		return (other & mask()) == (ip & mask());
+	}
+
+	friend bool operator<(const CidrAddress &, const CidrAddress &);
+};
+
+// Routing table with longest-prefix-match lookups. Routes are stored in a
+// path-compressed binary trie keyed by their network prefix; the results of
+// lookups are kept in a direct-mapped cache until the table changes.
+struct Ip4Router {
+	struct Route {
+		inline Route(CidrAddress net, std::weak_ptr<nic::Link> link)
+			: network(net), link(link) {}
+
+		CidrAddress network;
+		std::weak_ptr<nic::Link> link;
+		unsigned int mtu = 0;
+		uint32_t gateway = 0;
+		unsigned int metric = 0;
+		uint32_t source = 0;
+	};
+
+	// false if insertion fails
+	bool addRoute(Route r);
+	std::optional<Route> resolveRoute(uint32_t ip);
+
+	size_t numRoutes() const {
+		return numRoutes_;
+	}
+
+private:
+	struct Node {
+		// Only the first prefix bits of key.ip are significant.
+		CidrAddress key;
+		// Routes to exactly this network, best route first. Empty for nodes
+		// that only exist to branch.
+		std::vector<Route> routes;
+		std::array<std::unique_ptr<Node>, 2> children;
+	};
+
+	// Finds the node for the given network, creating it if necessary.
+	Node *insertNode(std::unique_ptr<Node> &slot, CidrAddress key);
+
+	// Performs the trie walk. Routes of expired links are removed on the way.
+	std::optional<Route> lookup(uint32_t ip);
+
+	void invalidateCache();
+
+	std::unique_ptr<Node> root_;
+	size_t numRoutes_ = 0;
+
+	struct CacheEntry {
+		uint32_t ip = 0;
+		// The entry is only valid if this matches cacheGeneration_.
+		uint64_t generation = 0;
+		std::optional<Route> route;
+	};
+
+	static constexpr int cacheBits = 12;
+
+	// Each destination can only be cached in the slot that its hash selects.
+	std::vector<CacheEntry> cache_ = std::vector<CacheEntry>(size_t{1} << cacheBits);
+	uint64_t cacheGeneration_ = 1;
+};
@@ -0,0 +1,1463 @@
+#include "tcp4.hpp"
+
+#include "ip4.hpp"
+#include "checksum.hpp"
+
+#include <async/basic.hpp>
+#include <async/doorbell.hpp>
+#include <async/result.hpp>
+#include <arch/bit.hpp>
+#include <helix/timer.hpp>
+#include <protocols/fs/server.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+namespace {
+constexpr bool logTcp = false;
+
+template<typename T>
+void maybeFlip(T &x) {
+	x = arch::convert_endian<arch::endian::big, arch::endian::native>(x);
+}
+
+struct PseudoHeader {
+	uint32_t src;
+	uint32_t dst;
+
+	uint8_t zero = 0;
+	uint8_t proto = static_cast<uint8_t>(IpProto::tcp);
+	uint16_t len;
+
+	void ensureEndian() {
+		maybeFlip(src);
+		maybeFlip(dst);
+		maybeFlip(len);
+	}
+};
+
+constexpr uint8_t flagFin = 0x01;
+constexpr uint8_t flagSyn = 0x02;
+constexpr uint8_t flagRst = 0x04;
+constexpr uint8_t flagPsh = 0x08;
+constexpr uint8_t flagAck = 0x10;
+
+constexpr size_t sendBufferSize = 256 * 1024;
+constexpr size_t receiveBufferSize = 256 * 1024;
+// Scale factor that we announce for our receive window (RFC 7323).
+constexpr uint8_t receiveWindowShift = 3;
+constexpr size_t acceptBacklog = 128;
+
+constexpr uint32_t defaultMss = 536;
+constexpr uint32_t initialWindowSegments = 10;
+constexpr int dupAckThreshold = 3;
+constexpr int maxRetransmits = 12;
+
+constexpr uint64_t msToNs = 1'000'000;
+constexpr uint64_t initialRto = 1'000 * msToNs;
+constexpr uint64_t minRto = 200 * msToNs;
+constexpr uint64_t maxRto = 60'000 * msToNs;
+constexpr uint64_t delayedAckTimeout = 40 * msToNs;
+constexpr uint64_t timeWaitTimeout = 60'000 * msToNs;
+
+// Sequence number comparisons modulo 2^32.
+bool seqLt(uint32_t a, uint32_t b) {
+	return static_cast<int32_t>(a - b) < 0;
+}
+
+bool seqLe(uint32_t a, uint32_t b) {
+	return static_cast<int32_t>(a - b) <= 0;
+}
+
+bool seqGt(uint32_t a, uint32_t b) {
+	return seqLt(b, a);
+}
+
+bool seqGe(uint32_t a, uint32_t b) {
+	return seqLe(b, a);
+}
+
+struct SeqLess {
+	bool operator() (uint32_t a, uint32_t b) const {
+		return seqLt(a, b);
+	}
+};
+
+uint64_t clockNow() {
+	uint64_t now;
+	HEL_CHECK(helGetClock(&now));
+	return now;
+}
+
+uint32_t generateIss() {
+	// RFC 793 suggests a clock that ticks every 4 microseconds.
+	static uint32_t counter = 0;
+	return static_cast<uint32_t>(clockNow() / 4000) + (counter += 64000);
+}
+
+auto checkAddress(const void *addr_ptr, size_t addr_len, Endpoint &e) {
+	struct sockaddr_in addr;
+	if (addr_len < sizeof(addr)) {
+		return protocols::fs::Error::illegalArguments;
+	}
+	std::memcpy(&addr, addr_ptr, sizeof(addr));
+	if (addr.sin_family != AF_INET) {
+		return protocols::fs::Error::afNotSupported;
+	}
+	e = addr;
+	return protocols::fs::Error::none;
+}
+} // namespace
+
+struct TcpHeader {
+	uint16_t srcPort;
+	uint16_t destPort;
+	uint32_t seqNumber;
+	uint32_t ackNumber;
+	// Header length in 32-bit words, stored in the upper four bits.
+	uint8_t dataOffset;
+	uint8_t flags;
+	uint16_t window;
+	uint16_t checksum;
+	uint16_t urgentPointer;
+
+	void ensureEndian() {
+		maybeFlip(srcPort);
+		maybeFlip(destPort);
+		maybeFlip(seqNumber);
+		maybeFlip(ackNumber);
+		maybeFlip(window);
+		maybeFlip(checksum);
+		maybeFlip(urgentPointer);
+	}
+};
+static_assert(sizeof(TcpHeader) == 20, "tcp header size wrong");
+
+struct Tcp {
+	TcpHeader header;
+	// Options that we understand. They are only meaningful on SYN segments.
+	uint32_t mss = 0;
+	int windowShift = -1;
+
+	bool has(uint8_t flag) const {
+		return header.flags & flag;
+	}
+
+	// Length of the segment in sequence space.
+	uint32_t seqLength() const {
+		return payload.size() + has(flagSyn) + has(flagFin);
+	}
+
+	bool parse(smarter::shared_ptr<const Ip4Packet> packet) {
+		auto data = packet->payload();
+		if (data.size() < sizeof(header)) {
+			return false;
+		}
+
+		if (!packet->checksumValid) {
+			Checksum chk;
+			PseudoHeader phdr {
+				.src = packet->header.source,
+				.dst = packet->header.destination,
+				.len = static_cast<uint16_t>(data.size())
+			};
+			phdr.ensureEndian();
+			chk.update(&phdr, sizeof(phdr));
+			chk.update(data);
+			if (chk.finalize() != 0) {
+				return false;
+			}
+		}
+
+		std::memcpy(&header, data.data(), sizeof(header));
+		header.ensureEndian();
+		size_t header_size = (header.dataOffset >> 4) * 4;
+		if (header_size < sizeof(header) || header_size > data.size()) {
+			return false;
+		}
+
+		auto options = reinterpret_cast<const uint8_t *>(data.data());
+		size_t i = sizeof(header);
+		while (i < header_size) {
+			auto kind = options[i];
+			if (kind == 0) {
+				break;
+			} else if (kind == 1) {
+				i++;
+				continue;
+			}
+			if (i + 1 >= header_size || options[i + 1] < 2
+					|| i + options[i + 1] > header_size) {
+				return false;
+			}
+			auto len = options[i + 1];
+			if (kind == 2 && len == 4) {
+				mss = options[i + 2] << 8 | options[i + 3];
+			} else if (kind == 3 && len == 3) {
+				windowShift = std::min(options[i + 2], uint8_t{14});
+			}
+			i += len;
+		}
+
+		payload = data.subview(header_size);
+		this->packet = std::move(packet);
+		return true;
+	}
+
+	smarter::shared_ptr<const Ip4Packet> packet;
+	arch::dma_buffer_view payload;
+};
+
+namespace {
+// Builds a segment with room for payload_size bytes after the header and options.
+std::vector<char> makeSegment(Endpoint local, Endpoint remote,
+		uint32_t seq, uint32_t ack, uint8_t flags, uint16_t window,
+		const std::vector<uint8_t> &options, size_t payload_size) {
+	assert(!(options.size() & 3));
+	TcpHeader header {
+		.srcPort = local.port,
+		.destPort = remote.port,
+		.seqNumber = seq,
+		.ackNumber = ack,
+		.dataOffset = static_cast<uint8_t>(((sizeof(TcpHeader) + options.size()) / 4) << 4),
+		.flags = flags,
+		.window = window,
+		.checksum = 0,
+		.urgentPointer = 0
+	};
+	header.ensureEndian();
+
+	std::vector<char> segment(sizeof(header) + options.size() + payload_size);
+	std::memcpy(segment.data(), &header, sizeof(header));
+	std::memcpy(segment.data() + sizeof(header), options.data(), options.size());
+	return segment;
+}
+
+// Fills in the checksum of the segment. If the NIC computes the checksum,
+// only the sum over the pseudo header is stored.
+void finishSegment(Endpoint local, Endpoint remote, std::vector<char> &segment,
+		bool offload) {
+	PseudoHeader phdr {
+		.src = local.addr,
+		.dst = remote.addr,
+		.len = static_cast<uint16_t>(segment.size())
+	};
+	phdr.ensureEndian();
+
+	Checksum chk;
+	chk.update(&phdr, sizeof(phdr));
+	uint16_t result;
+	if (offload) {
+		result = ~chk.finalize();
+	} else {
+		chk.update(segment.data(), segment.size());
+		result = chk.finalize();
+	}
+	auto sum = arch::convert_endian<arch::endian::big>(result);
+	std::memcpy(segment.data() + offsetof(TcpHeader, checksum), &sum, sizeof(sum));
+}
+
+// Checksums and sends a segment. If segmentSize is non-zero, the segment
+// is split into segments of that size by the NIC.
+async::detached transmit(Endpoint local, Endpoint remote, std::vector<char> segment,
+		uint16_t segmentSize = 0) {
+	auto ti = co_await ip4().targetByRemote(remote.addr);
+	if (!ti) {
+		co_return;
+	}
+
+	auto &caps = ti->link->capabilities();
+	if (segmentSize && !caps.tcpSegmentation) {
+		// The route changed since the connection was set up.
+		// Drop the segment; it is retransmitted in MSS-sized pieces.
+		co_return;
+	}
+
+	nic::TxOffload offload;
+	if (caps.transmitChecksum) {
+		offload.needsChecksum = true;
+		offload.checksumStart = 0;
+		offload.checksumOffset = offsetof(TcpHeader, checksum);
+	}
+	if (segmentSize) {
+		offload.segmentSize = segmentSize;
+		offload.headerLength = (static_cast<uint8_t>(segment[12]) >> 4) * 4;
+	}
+	finishSegment(local, remote, segment, offload.needsChecksum);
+
+	auto error = co_await ip4().sendFrame(std::move(*ti),
+		segment.data(), segment.size(),
+		static_cast<uint16_t>(IpProto::tcp), offload);
+	if (logTcp && error != protocols::fs::Error::none) {
+		std::cout << "netserver: failed to send tcp segment" << std::endl;
+	}
+}
+
+// Answers a segment that does not belong to any connection (RFC 793, page 36).
+void sendReset(const Tcp &seg, Endpoint local, Endpoint remote) {
+	std::vector<char> segment;
+	if (seg.has(flagAck)) {
+		segment = makeSegment(local, remote, seg.header.ackNumber, 0,
+			flagRst, 0, {}, 0);
+	} else {
+		segment = makeSegment(local, remote, 0,
+			seg.header.seqNumber + seg.seqLength(),
+			flagRst | flagAck, 0, {}, 0);
+	}
+	transmit(local, remote, std::move(segment));
+}
+
+// Received payload. Holds on to the frame so that recvmsg() copies
+// straight out of the receive buffer.
+struct ReceivedData {
+	smarter::shared_ptr<const Ip4Packet> packet;
+	arch::dma_buffer_view data;
+};
+} // namespace
+
+using namespace protocols::fs;
+
+struct Tcp4Socket {
+	enum class State {
+		closed,
+		listen,
+		synSent,
+		synReceived,
+		established,
+		finWait1,
+		finWait2,
+		closeWait,
+		closing,
+		lastAck,
+		timeWait
+	};
+
+	Tcp4Socket(Tcp4 *parent) : parent_(parent) {}
+
+	~Tcp4Socket() {
+		if (bound_) {
+			parent_->unbind(bindKey_);
+		}
+	}
+
+	static auto makeSocket(Tcp4 *parent) {
+		auto s = smarter::make_shared<Tcp4Socket>(parent);
+		s->holder_ = s;
+		return s;
+	}
+
+	static void serve(helix::UniqueLane lane, smarter::shared_ptr<Tcp4Socket> socket) {
+		async::detach(servePassthrough(std::move(lane), socket, &ops),
+			[socket] {
+				socket->userClose();
+			});
+	}
+
+	static async::result<Error> bind(void *obj,
+			const char *creds,
+			const void *addr_ptr, size_t addr_size) {
+		auto self = static_cast<Tcp4Socket *>(obj);
+		Endpoint local;
+
+		if (self->bound_) {
+			co_return Error::illegalArguments;
+		}
+
+		if (auto e = checkAddress(addr_ptr, addr_size, local);
+			e != Error::none) {
+			co_return e;
+		}
+
+		if (local.addr != INADDR_ANY && !ip4().hasIp(local.addr)) {
+			co_return Error::addressNotAvailable;
+		}
+
+		if (local.port == 0) {
+			if (!self->parent_->bindEphemeral(self, local)) {
+				co_return Error::addressInUse;
+			}
+		} else if (!self->parent_->tryBind(self, local)) {
+			co_return Error::addressInUse;
+		}
+
+		self->bound_ = true;
+		self->bindKey_ = local;
+		self->local_ = local;
+		co_return Error::none;
+	}
+
+	static async::result<void> listen(void *obj) {
+		auto self = static_cast<Tcp4Socket *>(obj);
+		if (self->state_ != State::closed) {
+			co_return;
+		}
+
+		if (!self->bound_) {
+			Endpoint local;
+			if (!self->parent_->bindEphemeral(self, local)) {
+				co_return;
+			}
+			self->bound_ = true;
+			self->bindKey_ = local;
+			self->local_ = local;
+		}
+		self->state_ = State::listen;
+	}
+
+	static async::result<AcceptResult> accept(void *obj) {
+		auto self = static_cast<Tcp4Socket *>(obj);
+		while (self->acceptQueue_.empty()) {
+			if (self->state_ != State::listen) {
+				co_return Error::illegalArguments;
+			}
+			co_await self->acceptBell_.async_wait();
+		}
+
+		auto child = std::move(self->acceptQueue_.front());
+		self->acceptQueue_.pop_front();
+
+		auto [local_lane, remote_lane] = helix::createStream();
+		serve(std::move(local_lane), std::move(child));
+		co_return std::move(remote_lane);
+	}
+
+	static async::result<Error> connect(void *obj,
+			const char *creds,
+			const void *addr_ptr, size_t addr_size) {
+		auto self = static_cast<Tcp4Socket *>(obj);
+		Endpoint remote;
+
+		if (auto e = checkAddress(addr_ptr, addr_size, remote);
+			e != Error::none) {
+			co_return e;
+		}
+
+		if (self->state_ != State::closed) {
+			co_return Error::illegalArguments;
+		}
+
+		if (remote.addr == INADDR_BROADCAST || remote.addr == INADDR_ANY
+				|| remote.port == 0) {
+			co_return Error::accessDenied;
+		}
+
+		auto ti = co_await ip4().targetByRemote(remote.addr);
+		if (!ti) {
+			co_return Error::netUnreachable;
+		}
+
+		if (!self->bound_) {
+			Endpoint local { ti->source, 0 };
+			if (!self->parent_->bindEphemeral(self, local)) {
+				std::cout << "netserver: no source port" << std::endl;
+				co_return Error::addressNotAvailable;
+			}
+			self->bound_ = true;
+			self->bindKey_ = local;
+			self->local_ = local;
+		}
+		if (self->local_.addr == INADDR_ANY) {
+			self->local_.addr = ti->source;
+		}
+		self->remote_ = remote;
+
+		if (!self->parent_->connections.emplace(
+				std::make_pair(self->local_, self->remote_),
+				self->holder_.lock()).second) {
+			co_return Error::addressInUse;
+		}
+
+		self->setupConnection(ti->link.get());
+		self->sendWindowScale_ = true;
+		self->state_ = State::synSent;
+		self->emitSyn();
+		self->armRto();
+
+		while (self->state_ == State::synSent
+				|| self->state_ == State::synReceived) {
+			co_await self->stateBell_.async_wait();
+		}
+
+		if (self->reset_ || self->state_ == State::closed) {
+			co_return Error::hostUnreachable;
+		}
+		co_return Error::none;
+	}
+
+	static async::result<size_t> sockname(void *obj, void *addr_ptr,
+			size_t max_addr_length) {
+		using arch::convert_endian;
+		using arch::endian;
+		auto self = static_cast<Tcp4Socket *>(obj);
+		sockaddr_in addr {
+			.sin_family = AF_INET,
+			.sin_port = convert_endian<endian::big>(self->local_.port),
+			.sin_addr = { convert_endian<endian::big>(self->local_.addr) }
+		};
+		std::memcpy(addr_ptr, &addr, std::min(max_addr_length, sizeof(addr)));
+		co_return sizeof(addr);
+	}
+
+	static async::result<RecvResult> recvmsg(void *obj,
+			const char *creds,
+			uint32_t flags, void *data, size_t len,
+			void *addr_buf, size_t addr_size, size_t max_ctrl_len) {
+		auto self = static_cast<Tcp4Socket *>(obj);
+		while (self->receiveQueue_.empty() && self->canReceive()) {
+			if (flags & MSG_DONTWAIT) {
+				co_return Error::wouldBlock;
+			}
+			co_await self->receiveBell_.async_wait();
+		}
+
+		// Copy directly out of the received frames.
+		auto dest = static_cast<char *>(data);
+		size_t copied = 0;
+		while (copied < len && !self->receiveQueue_.empty()) {
+			auto &front = self->receiveQueue_.front();
+			auto chunk = std::min(len - copied, front.data.size());
+			std::memcpy(dest + copied, front.data.data(), chunk);
+			copied += chunk;
+			if (chunk == front.data.size()) {
+				self->receiveQueue_.pop_front();
+			} else {
+				front.data = front.data.subview(chunk);
+			}
+		}
+		self->receivedBytes_ -= copied;
+
+		self->maybeSendWindowUpdate();
+		co_return RecvData { copied, 0, {} };
+	}
+
+	static async::result<SendResult> sendmsg(void *obj,
+			const char *creds, uint32_t flags,
+			void *data, size_t len,
+			void *addr_ptr, size_t addr_size,
+			std::vector<uint32_t> fds) {
+		auto self = static_cast<Tcp4Socket *>(obj);
+		auto src = static_cast<const char *>(data);
+		size_t progress = 0;
+		while (progress < len) {
+			if (!self->canSend()) {
+				if (progress) {
+					break;
+				}
+				co_return Error::brokenPipe;
+			}
+
+			auto space = sendBufferSize - self->sendBuffer_.size();
+			if (!space) {
+				if (flags & MSG_DONTWAIT) {
+					if (progress) {
+						break;
+					}
+					co_return Error::wouldBlock;
+				}
+				co_await self->sendBell_.async_wait();
+				continue;
+			}
+
+			auto chunk = std::min(space, len - progress);
+			self->sendBuffer_.insert(self->sendBuffer_.end(),
+				src + progress, src + progress + chunk);
+			progress += chunk;
+			self->flushOutput();
+		}
+		co_return progress;
+	}
+
+	constexpr static FileOperations ops {
+		.bind = &bind,
+		.listen = &listen,
+		.accept = &accept,
+		.connect = &connect,
+		.sockname = &sockname,
+		.recvMsg = &recvmsg,
+		.sendMsg = &sendmsg,
+	};
+
+private:
+	friend struct Tcp4;
+
+	// ----------------------------------------------------------------
+	// Connection setup and teardown.
+	// ----------------------------------------------------------------
+
+	void setupConnection(const nic::Link *link) {
+		auto mtu = link ? link->mtu : defaultMss + 40;
+		ourMss_ = mtu > 40 ? mtu - 40 : defaultMss;
+		mss_ = ourMss_;
+		if (link && link->capabilities().tcpSegmentation) {
+			// Stay within the maximal IP packet size; we assume an Ethernet header.
+			auto limit = std::min<size_t>(link->capabilities().maxSegmentationSize - 14,
+				0xFFFF);
+			segmentationLimit_ = limit - 40;
+		}
+		iss_ = generateIss();
+		sndUna_ = iss_;
+		sndNxt_ = iss_ + 1;
+		sndMax_ = sndNxt_;
+		bufferSeq_ = iss_ + 1;
+		runTimers(holder_.lock());
+	}
+
+	void applySynOptions(const Tcp &seg) {
+		mss_ = std::min(seg.mss ? seg.mss : defaultMss, ourMss_);
+		if (sendWindowScale_ && seg.windowShift >= 0) {
+			sndShift_ = seg.windowShift;
+			rcvShift_ = receiveWindowShift;
+		} else {
+			sendWindowScale_ = false;
+			sndShift_ = 0;
+			rcvShift_ = 0;
+		}
+		cwnd_ = initialWindowSegments * mss_;
+	}
+
+	// Called on a listening socket for segments without a connection.
+	void handleIncomingSyn(const Tcp &seg, Endpoint local, Endpoint remote) {
+		if (seg.has(flagRst)) {
+			return;
+		}
+		if (seg.has(flagAck)) {
+			sendReset(seg, local, remote);
+			return;
+		}
+		if (!seg.has(flagSyn) || acceptQueue_.size() >= acceptBacklog) {
+			return;
+		}
+
+		auto link = ip4().getLink(local.addr);
+		auto child = makeSocket(parent_);
+		child->local_ = local;
+		child->remote_ = remote;
+		child->listener_ = holder_;
+		child->setupConnection(link.get());
+		child->sendWindowScale_ = seg.windowShift >= 0;
+		child->applySynOptions(seg);
+		child->rcvNxt_ = seg.header.seqNumber + 1;
+		child->sndWnd_ = seg.header.window;
+		child->sndWl1_ = seg.header.seqNumber;
+		child->sndWl2_ = child->iss_;
+		child->state_ = State::synReceived;
+		parent_->connections.emplace(std::make_pair(local, remote), child);
+
+		child->emitSyn();
+		child->armRto();
+	}
+
+	void handleSynSent(const Tcp &seg) {
+		auto &h = seg.header;
+		bool ack_ok = false;
+		if (seg.has(flagAck)) {
+			if (seqLe(h.ackNumber, iss_) || seqGt(h.ackNumber, sndNxt_)) {
+				if (!seg.has(flagRst)) {
+					sendReset(seg, local_, remote_);
+				}
+				return;
+			}
+			ack_ok = true;
+		}
+
+		if (seg.has(flagRst)) {
+			// The connection was refused.
+			if (ack_ok) {
+				abort(false);
+			}
+			return;
+		}
+		if (!seg.has(flagSyn)) {
+			return;
+		}
+
+		rcvNxt_ = h.seqNumber + 1;
+		applySynOptions(seg);
+		if (ack_ok) {
+			sndUna_ = h.ackNumber;
+			sndWnd_ = h.window;
+			sndWl1_ = h.seqNumber;
+			sndWl2_ = h.ackNumber;
+			retransmits_ = 0;
+			rtoDeadline_ = 0;
+			state_ = State::established;
+			stateBell_.ring();
+			sendAck();
+			flushOutput();
+		} else {
+			// Simultaneous open.
+			state_ = State::synReceived;
+			emitSyn();
+		}
+	}
+
+	void establish() {
+		state_ = State::established;
+		stateBell_.ring();
+
+		if (auto listener = listener_.lock(); listener) {
+			if (listener->state_ == State::listen) {
+				listener->acceptQueue_.push_back(holder_.lock());
+				listener->acceptBell_.ring();
+			} else {
+				abort(true);
+			}
+			listener_ = {};
+		}
+	}
+
+	void enterTimeWait() {
+		state_ = State::timeWait;
+		rtoDeadline_ = 0;
+		timeWaitDeadline_ = clockNow() + timeWaitTimeout;
+		timerBell_.ring();
+	}
+
+	void abort(bool send_reset) {
+		if (send_reset) {
+			emit(sndNxt_, flagRst, 0, 0);
+		}
+		reset_ = true;
+		destroy();
+	}
+
+	// Removes the connection. Wakes up everybody who waits for it.
+	void destroy() {
+		auto self = holder_.lock();
+		auto was_listening = state_ == State::listen;
+		state_ = State::closed;
+		rtoDeadline_ = 0;
+		delAckDeadline_ = 0;
+		timeWaitDeadline_ = 0;
+		timersDead_ = true;
+		timerBell_.ring();
+		receiveBell_.ring();
+		sendBell_.ring();
+		stateBell_.ring();
+		acceptBell_.ring();
+		if (!was_listening) {
+			auto it = parent_->connections.find(std::make_pair(local_, remote_));
+			if (it != parent_->connections.end() && it->second.get() == this) {
+				parent_->connections.erase(it);
+			}
+		}
+	}
+
+	// Called when the last user reference (i.e., the file) goes away.
+	void userClose() {
+		if (bound_) {
+			parent_->unbind(bindKey_);
+			bound_ = false;
+		}
+
+		switch (state_) {
+		case State::listen:
+			state_ = State::closed;
+			for (auto &child : acceptQueue_) {
+				child->abort(true);
+			}
+			acceptQueue_.clear();
+			acceptBell_.ring();
+			break;
+		case State::synSent:
+			destroy();
+			break;
+		case State::synReceived:
+			abort(true);
+			break;
+		case State::established:
+			finPending_ = true;
+			state_ = State::finWait1;
+			flushOutput();
+			break;
+		case State::closeWait:
+			finPending_ = true;
+			state_ = State::lastAck;
+			flushOutput();
+			break;
+		default:
+			break;
+		}
+	}
+
+	// ----------------------------------------------------------------
+	// Input processing (RFC 793, "SEGMENT ARRIVES").
+	// ----------------------------------------------------------------
+
+	uint32_t receiveWindow() {
+		auto used = receivedBytes_ + outOfOrderBytes_;
+		return used < receiveBufferSize ? receiveBufferSize - used : 0;
+	}
+
+	bool acceptable(const Tcp &seg) {
+		auto wnd = receiveWindow();
+		auto len = seg.seqLength();
+		auto seq = seg.header.seqNumber;
+		auto inWindow = [&] (uint32_t s) {
+			return seqLe(rcvNxt_, s) && seqLt(s, rcvNxt_ + wnd);
+		};
+		if (!len) {
+			return wnd ? inWindow(seq) : seq == rcvNxt_;
+		}
+		if (!wnd) {
+			return false;
+		}
+		return inWindow(seq) || inWindow(seq + len - 1);
+	}
+
+	void handleSegment(const Tcp &seg) {
+		auto &h = seg.header;
+		if (state_ == State::synSent) {
+			handleSynSent(seg);
+			return;
+		}
+		if (state_ == State::closed || state_ == State::listen) {
+			return;
+		}
+
+		if (!acceptable(seg)) {
+			if (!seg.has(flagRst)) {
+				sendAck();
+			}
+			// ACKs still need to be processed if our receive window is closed.
+			if (seg.has(flagAck) && !receiveWindow() && processAck(seg)) {
+				flushOutput();
+			}
+			return;
+		}
+
+		if (seg.has(flagRst)) {
+			abort(false);
+			return;
+		}
+		if (seg.has(flagSyn)) {
+			abort(true);
+			return;
+		}
+		if (!seg.has(flagAck)) {
+			return;
+		}
+
+		if (state_ == State::synReceived) {
+			if (!(seqLt(sndUna_, h.ackNumber) && seqLe(h.ackNumber, sndNxt_))) {
+				sendReset(seg, local_, remote_);
+				return;
+			}
+			establish();
+			if (state_ != State::established) {
+				return;
+			}
+		}
+
+		if (!processAck(seg)) {
+			return;
+		}
+
+		if (finAcked()) {
+			if (state_ == State::finWait1) {
+				state_ = State::finWait2;
+			} else if (state_ == State::closing) {
+				enterTimeWait();
+			} else if (state_ == State::lastAck) {
+				destroy();
+				return;
+			}
+		}
+
+		if (seg.payload.size() && (state_ == State::established
+				|| state_ == State::finWait1 || state_ == State::finWait2)) {
+			receiveData(seg);
+		}
+
+		if (seg.has(flagFin) && h.seqNumber + seg.payload.size() == rcvNxt_
+				&& !finReceived_) {
+			rcvNxt_++;
+			finReceived_ = true;
+			receiveBell_.ring();
+			sendAck();
+
+			switch (state_) {
+			case State::established:
+				state_ = State::closeWait;
+				break;
+			case State::finWait1:
+				if (finAcked()) {
+					enterTimeWait();
+				} else {
+					state_ = State::closing;
+				}
+				break;
+			case State::finWait2:
+				enterTimeWait();
+				break;
+			default:
+				break;
+			}
+		}
+
+		flushOutput();
+	}
+
+	// Returns false if the segment acknowledges data that we never sent.
+	bool processAck(const Tcp &seg) {
+		auto ack = seg.header.ackNumber;
+		if (seqGt(ack, sndNxt_)) {
+			sendAck();
+			return false;
+		}
+
+		auto window = static_cast<uint32_t>(seg.header.window) << sndShift_;
+		if (seqGt(ack, sndUna_)) {
+			auto acked = ack - sndUna_;
+			if (seqGt(ack, bufferSeq_)) {
+				auto n = std::min<size_t>(ack - bufferSeq_, sendBuffer_.size());
+				sendBuffer_.erase(sendBuffer_.begin(), sendBuffer_.begin() + n);
+				bufferSeq_ += n;
+				sendBell_.ring();
+			}
+			sndUna_ = ack;
+			retransmits_ = 0;
+
+			// Karn's algorithm: only time segments that were not retransmitted.
+			if (rttTiming_ && seqGe(ack, rttSeq_)) {
+				updateRtt(clockNow() - rttStart_);
+				rttTiming_ = false;
+			}
+
+			onNewAck(acked, ack);
+
+			if (sndUna_ == sndNxt_) {
+				rtoDeadline_ = 0;
+			} else {
+				armRto();
+			}
+		} else if (ack == sndUna_ && sndUna_ != sndNxt_ && !seg.payload.size()
+				&& !seg.has(flagSyn | flagFin) && window == sndWnd_) {
+			onDuplicateAck();
+		}
+
+		if (seqLt(sndWl1_, seg.header.seqNumber)
+				|| (sndWl1_ == seg.header.seqNumber && seqLe(sndWl2_, ack))) {
+			sndWnd_ = window;
+			sndWl1_ = seg.header.seqNumber;
+			sndWl2_ = ack;
+		}
+		return true;
+	}
+
+	void receiveData(const Tcp &seg) {
+		auto seq = seg.header.seqNumber;
+		auto data = seg.payload;
+		if (seqLt(seq, rcvNxt_)) {
+			auto skip = rcvNxt_ - seq;
+			if (skip >= data.size()) {
+				return;
+			}
+			data = data.subview(skip);
+			seq = rcvNxt_;
+		}
+
+		auto limit = rcvNxt_ + receiveWindow() - seq;
+		if (data.size() > limit) {
+			data = data.subview(0, limit);
+		}
+		if (!data.size()) {
+			return;
+		}
+
+		if (seq != rcvNxt_) {
+			// Keep the frame around and ACK immediately to trigger a fast retransmit.
+			if (outOfOrder_.emplace(seq, ReceivedData{seg.packet, data}).second) {
+				outOfOrderBytes_ += data.size();
+			}
+			sendAck();
+			return;
+		}
+
+		receiveQueue_.push_back({seg.packet, data});
+		rcvNxt_ += data.size();
+		receivedBytes_ += data.size();
+
+		// Pull in segments that are now in order.
+		bool filled = false;
+		while (!outOfOrder_.empty()) {
+			auto it = outOfOrder_.begin();
+			if (seqGt(it->first, rcvNxt_)) {
+				break;
+			}
+			auto start = it->first;
+			auto item = std::move(it->second);
+			outOfOrderBytes_ -= item.data.size();
+			outOfOrder_.erase(it);
+			if (seqLe(start + item.data.size(), rcvNxt_)) {
+				continue;
+			}
+			item.data = item.data.subview(rcvNxt_ - start);
+			rcvNxt_ += item.data.size();
+			receivedBytes_ += item.data.size();
+			receiveQueue_.push_back(std::move(item));
+			filled = true;
+		}
+		receiveBell_.ring();
+
+		// Delayed ACKs (RFC 1122): acknowledge at least every second segment.
+		if (filled || ++unackedSegments_ >= 2) {
+			sendAck();
+		} else if (!delAckDeadline_) {
+			delAckDeadline_ = clockNow() + delayedAckTimeout;
+			timerBell_.ring();
+		}
+	}
+
+	// ----------------------------------------------------------------
+	// Congestion control (NewReno, RFC 5681 and RFC 6582).
+	// ----------------------------------------------------------------
+
+	uint32_t flightSize() {
+		return sndNxt_ - sndUna_;
+	}
+
+	void onNewAck(uint32_t acked, uint32_t ack) {
+		if (inRecovery_) {
+			if (seqGe(ack, recover_)) {
+				cwnd_ = std::min(ssthresh_, flightSize() + mss_);
+				inRecovery_ = false;
+				dupAcks_ = 0;
+			} else {
+				// Partial ACK: retransmit the next hole and deflate the window.
+				retransmitFirst();
+				cwnd_ = (cwnd_ > acked ? cwnd_ - acked : 0) + mss_;
+			}
+			return;
+		}
+
+		dupAcks_ = 0;
+		if (cwnd_ < ssthresh_) {
+			cwnd_ += std::min(acked, mss_);
+		} else {
+			cwnd_ += std::max(uint32_t{1}, mss_ * mss_ / cwnd_);
+		}
+	}
+
+	void onDuplicateAck() {
+		dupAcks_++;
+		if (inRecovery_) {
+			cwnd_ += mss_;
+			return;
+		}
+		if (dupAcks_ == dupAckThreshold) {
+			ssthresh_ = std::max(flightSize() / 2, 2 * mss_);
+			retransmitFirst();
+			cwnd_ = ssthresh_ + 3 * mss_;
+			recover_ = sndNxt_;
+			inRecovery_ = true;
+		}
+	}
+
+	void retransmitFirst() {
+		if (sndUna_ == bufferSeq_ && !sendBuffer_.empty()) {
+			emit(sndUna_, flagAck, 0, std::min<size_t>(mss_, sendBuffer_.size()));
+		} else if (finSent_ && sndUna_ == finSeq_) {
+			emit(finSeq_, flagFin | flagAck, 0, 0);
+		}
+		rttTiming_ = false;
+		armRto();
+	}
+
+	void updateRtt(uint64_t sample) {
+		// RFC 6298.
+		if (!srtt_) {
+			srtt_ = sample;
+			rttvar_ = sample / 2;
+		} else {
+			auto delta = srtt_ > sample ? srtt_ - sample : sample - srtt_;
+			rttvar_ = (3 * rttvar_ + delta) / 4;
+			srtt_ = (7 * srtt_ + sample) / 8;
+		}
+		rto_ = std::clamp(srtt_ + std::max(4 * rttvar_, msToNs), minRto, maxRto);
+	}
+
+	// ----------------------------------------------------------------
+	// Output processing.
+	// ----------------------------------------------------------------
+
+	bool canReceive() {
+		return state_ == State::synSent || state_ == State::synReceived
+			|| state_ == State::established || state_ == State::finWait1
+			|| state_ == State::finWait2;
+	}
+
+	bool canSend() {
+		return !finPending_ && (state_ == State::synSent || state_ == State::synReceived
+			|| state_ == State::established || state_ == State::closeWait);
+	}
+
+	// States in which we may transmit data.
+	bool synchronized() {
+		return state_ == State::established || state_ == State::finWait1
+			|| state_ == State::closeWait || state_ == State::closing
+			|| state_ == State::lastAck;
+	}
+
+	bool finAcked() {
+		return finSent_ && seqGt(sndUna_, finSeq_);
+	}
+
+	void flushOutput() {
+		if (!synchronized()) {
+			return;
+		}
+
+		while (true) {
+			size_t offset = sndNxt_ - bufferSeq_;
+			if (offset >= sendBuffer_.size()) {
+				break;
+			}
+			auto available = sendBuffer_.size() - offset;
+			auto window = std::min(sndWnd_, cwnd_);
+			auto flight = flightSize();
+			if (flight >= window) {
+				break;
+			}
+			// Hand multiple segments at once to NICs that support TSO.
+			size_t maxLength = mss_;
+			if (segmentationLimit_ > mss_) {
+				maxLength = segmentationLimit_ / mss_ * mss_;
+			}
+			auto length = std::min<size_t>({available, window - flight, maxLength});
+			// Nagle's algorithm: no small segments while data is in flight.
+			if (length < mss_ && flight) {
+				break;
+			}
+
+			uint8_t flags = flagAck;
+			if (length == available) {
+				flags |= flagPsh;
+			}
+			emit(sndNxt_, flags, offset, length);
+			if (!rttTiming_ && seqGe(sndNxt_, sndMax_)) {
+				rttTiming_ = true;
+				rttSeq_ = sndNxt_ + length;
+				rttStart_ = clockNow();
+			}
+			sndNxt_ += length;
+			if (seqGt(sndNxt_, sndMax_)) {
+				sndMax_ = sndNxt_;
+			}
+			if (!rtoDeadline_) {
+				armRto();
+			}
+		}
+
+		if (finPending_ && !finSent_ && sndNxt_ == bufferSeq_ + sendBuffer_.size()) {
+			finSeq_ = sndNxt_;
+			emit(finSeq_, flagFin | flagAck, 0, 0);
+			sndNxt_++;
+			if (seqGt(sndNxt_, sndMax_)) {
+				sndMax_ = sndNxt_;
+			}
+			finSent_ = true;
+			if (!rtoDeadline_) {
+				armRto();
+			}
+		}
+
+		// Persist timer: probe a zero window.
+		if (!sndWnd_ && sndUna_ == sndNxt_ && sendBuffer_.size() && !rtoDeadline_) {
+			armRto();
+		}
+	}
+
+	void maybeSendWindowUpdate() {
+		if (!synchronized() && state_ != State::finWait2) {
+			return;
+		}
+		// Announce the window once it opened up by a reasonable amount.
+		auto edge = rcvNxt_ + receiveWindow();
+		auto threshold = std::min<uint32_t>(2 * mss_, receiveBufferSize / 2);
+		if (seqGe(edge, advertisedEdge_ + threshold)) {
+			sendAck();
+		}
+	}
+
+	// Sends a segment at sequence number seq. If length is non-zero, the payload
+	// is taken from the send buffer at the given offset.
+	void emit(uint32_t seq, uint8_t flags, size_t offset, size_t length) {
+		std::vector<uint8_t> options;
+		uint32_t window = receiveWindow();
+		if (flags & flagSyn) {
+			options = {2, 4, static_cast<uint8_t>(ourMss_ >> 8),
+				static_cast<uint8_t>(ourMss_ & 0xFF)};
+			if (sendWindowScale_) {
+				options.insert(options.end(), {1, 3, 3, receiveWindowShift});
+			}
+			window = std::min<uint32_t>(window, 0xFFFF);
+		} else {
+			window = std::min<uint32_t>(window >> rcvShift_, 0xFFFF);
+		}
+		auto segment = makeSegment(local_, remote_, seq,
+			(flags & flagAck) ? rcvNxt_ : 0, flags, window, options, length);
+		if (length) {
+			std::copy_n(sendBuffer_.begin() + offset, length, segment.end() - length);
+		}
+		transmit(local_, remote_, std::move(segment), length > mss_ ? mss_ : 0);
+
+		if (flags & flagAck) {
+			unackedSegments_ = 0;
+			delAckDeadline_ = 0;
+			advertisedEdge_ = rcvNxt_ + (window << ((flags & flagSyn) ? 0 : rcvShift_));
+		}
+	}
+
+	void sendAck() {
+		emit(sndNxt_, flagAck, 0, 0);
+	}
+
+	void emitSyn() {
+		emit(iss_, state_ == State::synReceived ? (flagSyn | flagAck) : flagSyn, 0, 0);
+	}
+
+	// ----------------------------------------------------------------
+	// Timers.
+	// ----------------------------------------------------------------
+
+	void armRto() {
+		rtoDeadline_ = clockNow() + rto_;
+		timerBell_.ring();
+	}
+
+	void onRetransmitTimeout() {
+		rtoDeadline_ = 0;
+
+		// Zero window probe. This does not count as a retransmission.
+		if (synchronized() && !sndWnd_ && sndUna_ == sndNxt_
+				&& sndNxt_ - bufferSeq_ < sendBuffer_.size()) {
+			emit(sndNxt_, flagAck, sndNxt_ - bufferSeq_, 1);
+			sndNxt_++;
+			if (seqGt(sndNxt_, sndMax_)) {
+				sndMax_ = sndNxt_;
+			}
+			rto_ = std::min(rto_ * 2, maxRto);
+			armRto();
+			return;
+		}
+
+		if (++retransmits_ > maxRetransmits) {
+			abort(true);
+			return;
+		}
+		rto_ = std::min(rto_ * 2, maxRto);
+		rttTiming_ = false;
+
+		if (state_ == State::synSent || state_ == State::synReceived) {
+			emitSyn();
+			armRto();
+			return;
+		}
+		if (sndUna_ == sndNxt_) {
+			return;
+		}
+
+		ssthresh_ = std::max(flightSize() / 2, 2 * mss_);
+		cwnd_ = mss_;
+		inRecovery_ = false;
+		dupAcks_ = 0;
+
+		// Go back to the first unacknowledged byte.
+		sndNxt_ = sndUna_;
+		if (finSent_ && seqLe(sndNxt_, finSeq_)) {
+			finSent_ = false;
+		}
+		flushOutput();
+		if (!rtoDeadline_) {
+			armRto();
+		}
+	}
+
+	uint64_t nextDeadline() {
+		uint64_t deadline = 0;
+		for (auto d : {rtoDeadline_, delAckDeadline_, timeWaitDeadline_}) {
+			if (d && (!deadline || d < deadline)) {
+				deadline = d;
+			}
+		}
+		return deadline;
+	}
+
+	static async::detached runTimers(smarter::shared_ptr<Tcp4Socket> self) {
+		while (!self->timersDead_) {
+			auto deadline = self->nextDeadline();
+			if (!deadline) {
+				co_await self->timerBell_.async_wait();
+				continue;
+			}
+
+			auto now = clockNow();
+			if (now < deadline) {
+				async::cancellation_event ev;
+				helix::TimeoutCancellation timer { deadline - now, ev };
+				co_await self->timerBell_.async_wait(ev);
+				co_await timer.retire();
+				continue;
+			}
+
+			if (self->timeWaitDeadline_ && now >= self->timeWaitDeadline_) {
+				self->destroy();
+				continue;
+			}
+			if (self->delAckDeadline_ && now >= self->delAckDeadline_) {
+				self->sendAck();
+			}
+			if (self->rtoDeadline_ && now >= self->rtoDeadline_) {
+				self->onRetransmitTimeout();
+			}
+		}
+	}
+
+	Tcp4 *parent_;
+	smarter::weak_ptr<Tcp4Socket> holder_;
+	State state_ = State::closed;
+
+	bool bound_ = false;
+	Endpoint bindKey_;
+	Endpoint local_;
+	Endpoint remote_;
+
+	// Listening sockets: connections that completed the handshake.
+	std::deque<smarter::shared_ptr<Tcp4Socket>> acceptQueue_;
+	async::doorbell acceptBell_;
+	// Passive connections: the socket that received the SYN.
+	smarter::weak_ptr<Tcp4Socket> listener_;
+
+	async::doorbell stateBell_;
+	bool reset_ = false;
+
+	// Send sequence space (RFC 793, section 3.2).
+	uint32_t iss_ = 0;
+	uint32_t sndUna_ = 0;
+	uint32_t sndNxt_ = 0;
+	uint32_t sndMax_ = 0;
+	uint32_t sndWnd_ = 0;
+	uint32_t sndWl1_ = 0;
+	uint32_t sndWl2_ = 0;
+	int sndShift_ = 0;
+	uint32_t mss_ = defaultMss;
+	uint32_t ourMss_ = defaultMss;
+	// Maximal TCP payload that the NIC segments for us (zero without TSO).
+	size_t segmentationLimit_ = 0;
+	bool sendWindowScale_ = false;
+
+	// Data that is not yet acknowledged. bufferSeq_ is the sequence number of the first byte.
+	std::deque<char> sendBuffer_;
+	uint32_t bufferSeq_ = 0;
+	async::doorbell sendBell_;
+	bool finPending_ = false;
+	bool finSent_ = false;
+	uint32_t finSeq_ = 0;
+
+	// Receive sequence space.
+	uint32_t rcvNxt_ = 0;
+	int rcvShift_ = 0;
+	uint32_t advertisedEdge_ = 0;
+	std::deque<ReceivedData> receiveQueue_;
+	std::map<uint32_t, ReceivedData, SeqLess> outOfOrder_;
+	size_t receivedBytes_ = 0;
+	size_t outOfOrderBytes_ = 0;
+	async::doorbell receiveBell_;
+	bool finReceived_ = false;
+	int unackedSegments_ = 0;
+
+	// Congestion control.
+	uint32_t cwnd_ = initialWindowSegments * defaultMss;
+	uint32_t ssthresh_ = UINT32_MAX;
+	int dupAcks_ = 0;
+	bool inRecovery_ = false;
+	uint32_t recover_ = 0;
+
+	// Round trip time estimation.
+	bool rttTiming_ = false;
+	uint32_t rttSeq_ = 0;
+	uint64_t rttStart_ = 0;
+	uint64_t srtt_ = 0;
+	uint64_t rttvar_ = 0;
+	uint64_t rto_ = initialRto;
+	int retransmits_ = 0;
+
+	// Absolute deadlines in nanoseconds. Zero if the timer is not armed.
+	uint64_t rtoDeadline_ = 0;
+	uint64_t delAckDeadline_ = 0;
+	uint64_t timeWaitDeadline_ = 0;
+	async::doorbell timerBell_;
+	bool timersDead_ = false;
+};
+
+void Tcp4::feedDatagram(smarter::shared_ptr<const Ip4Packet> packet) {
+	Tcp tcp;
+	if (!tcp.parse(std::move(packet))) {
+		std::cout << "netserver: broken tcp received" << std::endl;
+		return;
+	}
+
+	Endpoint local { tcp.packet->header.destination, tcp.header.destPort };
+	Endpoint remote { tcp.packet->header.source, tcp.header.srcPort };
+
+	if (auto it = connections.find(std::make_pair(local, remote));
+			it != connections.end()) {
+		// Keep the socket alive, processing might remove it from the map.
+		auto socket = it->second;
+		socket->handleSegment(tcp);
+		return;
+	}
+
+	auto i = binds.lower_bound({ 0, local.port });
+	for (; i != binds.end() && i->first.port == local.port; i++) {
+		auto ep = i->first;
+		if ((ep.addr == local.addr || ep.addr == INADDR_ANY)
+				&& i->second->state_ == Tcp4Socket::State::listen) {
+			i->second->handleIncomingSyn(tcp, local, remote);
+			return;
+		}
+	}
+
+	if (!tcp.has(flagRst)) {
+		sendReset(tcp, local, remote);
+	}
+}
+
+bool Tcp4::tryBind(Tcp4Socket *socket, Endpoint addr) {
+	auto i = binds.lower_bound({ 0, addr.port });
+	for (; i != binds.end() && i->first.port == addr.port; i++) {
+		auto ep = i->first;
+		if (ep.addr == INADDR_ANY || addr.addr == INADDR_ANY
+			|| ep.addr == addr.addr) {
+			return false;
+		}
+	}
+	binds.emplace(addr, socket);
+	return true;
+}
+
+bool Tcp4::bindEphemeral(Tcp4Socket *socket, Endpoint &addr) {
+	for (int i = 0; i < 65536 - 49152; i++) {
+		addr.port = nextEphemeral;
+		nextEphemeral = nextEphemeral == 65535 ? 49152 : nextEphemeral + 1;
+		if (tryBind(socket, addr)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Tcp4::unbind(Endpoint e) {
+	return binds.erase(e) != 0;
+}
+
+void Tcp4::serveSocket(helix::UniqueLane lane) {
+	Tcp4Socket::serve(std::move(lane), Tcp4Socket::makeSocket(this));
+}
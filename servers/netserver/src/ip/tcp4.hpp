@@ -0,0 +1,27 @@
+#pragma once
+
+#include <helix/ipc.hpp>
+#include <smarter.hpp>
+#include <map>
+
+#include "udp4.hpp"
+
+class Ip4Packet;
+
+struct Tcp4Socket;
+struct Tcp4 {
+	void feedDatagram(smarter::shared_ptr<const Ip4Packet>);
+	bool tryBind(Tcp4Socket *socket, Endpoint addr);
+	// Binds the socket to an unused port in the ephemeral range.
+	bool bindEphemeral(Tcp4Socket *socket, Endpoint &addr);
+	bool unbind(Endpoint local);
+	void serveSocket(helix::UniqueLane lane);
+private:
+	friend struct Tcp4Socket;
+
+	// Sockets that own a local port (explicitly bound, listening or connecting).
+	std::map<Endpoint, Tcp4Socket *> binds;
+	// Synchronized connections, keyed by (local, remote).
+	std::map<std::pair<Endpoint, Endpoint>, smarter::shared_ptr<Tcp4Socket>> connections;
+	uint16_t nextEphemeral = 49152;
+};
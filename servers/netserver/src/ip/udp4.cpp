@@ -78,7 +78,7 @@ struct Udp {
 		if (payload.size() < header.len) {
 			return false;
 		}
-		if (header.chk != 0) {
+		if (header.chk != 0 && !packet->checksumValid) {
 			PseudoHeader phdr;
 			phdr.src = packet->header.source;
 			phdr.dst = packet->header.destination;
@@ -304,7 +304,7 @@ struct Udp4Socket {
 		};
 		chk.update(&psh, sizeof(psh));
 		chk.update(&header, sizeof(header));
-		chk.update(data, len);
+		chk.updateCopy(buf.data() + sizeof(header), data, len);
 		header.chk = convert_endian<endian::big>(chk.finalize());
 
 		std::cout << "netserver:" << std::endl << std::hex
@@ -322,7 +322,6 @@ struct Udp4Socket {
 		}
 
 		std::memcpy(buf.data(), &header, sizeof(header));
-		std::memcpy(buf.data() + sizeof(header), data, len);
 
 		auto error = co_await ip4().sendFrame(std::move(*ti),
 			buf.data(), buf.size(),
@@ -35,6 +35,10 @@ async::result<void> doBind(mbus::Entity base_entity, virtio_core::DiscoverMode d
 	if (baseDeviceMap.empty()) {
 		ip4Router().addRoute({ { 0 }, device });
 		ip4().setLink({ 0x0a0a020f, 24 }, device);
+		// There is no loopback device; packets to our own addresses are
+		// looped back by Ip4::sendFrame() anyway.
+		ip4Router().addRoute({ { 0x7f000000, 8 }, device });
+		ip4().setLink({ 0x7f000001, 8 }, device);
 	}
 	baseDeviceMap.insert({base_entity.getId(), device});
 	nic::runDevice(device);
@@ -27,6 +27,10 @@ MacAddress Link::deviceMac() {
 	return mac_;
 }
 
+async::result<void> Link::send(const arch::dma_buffer_view frame) {
+	return send(frame, TxOffload{});
+}
+
 arch::dma_pool *Link::dmaPool() {
 	return dmaPool_;
 }
@@ -53,10 +57,12 @@ Link::AllocatedBuffer Link::allocateFrame(MacAddress to, EtherType type,
 async::detached runDevice(std::shared_ptr<nic::Link> dev) {
 	using namespace arch;
 	while(true) {
-		dma_buffer frameBuffer { dev->dmaPool(), 1514 };
-		co_await dev->receive(frameBuffer);
-		auto capsule = frameBuffer.subview(14);
-		auto data = reinterpret_cast<uint8_t*>(frameBuffer.data());
+		auto frame = co_await dev->receive();
+		if (frame.frame.size() < 14) {
+			continue;
+		}
+		auto capsule = frame.frame.subview(14);
+		auto data = reinterpret_cast<uint8_t*>(frame.frame.data());
 		uint16_t ethertype = data[12] << 8 | data[13];
 		nic::MacAddress dstsrc[2];
 		std::memcpy(dstsrc, data, sizeof(dstsrc));
@@ -64,7 +70,7 @@ async::detached runDevice(std::shared_ptr<nic::Link> dev) {
 		switch (ethertype) {
 		case ETHER_TYPE_IP4:
 			ip4().feedPacket(dstsrc[0], dstsrc[1],
-				std::move(frameBuffer), capsule);
+				std::move(frame.buffer), capsule, frame.checksumValid);
 			break;
 		case ETHER_TYPE_ARP:
 			neigh4().feedArp(dstsrc[0], capsule);
@@ -0,0 +1,172 @@
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <async/result.hpp>
+#include <hel.h>
+#include <hel-syscalls.h>
+#include <helix/ipc.hpp>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr int numRoundTrips = 100'000;
+}
+
+// Echo server that runs until the client closes its lane.
+static void serveEcho(HelHandle lane) {
+	char buffer[kHelMaxInlineCall];
+	size_t length = 0;
+	while(true) {
+		auto error = helReplyAndWait(lane, buffer, length, buffer, sizeof(buffer), &length);
+		if(error == kHelErrEndOfLane)
+			break;
+		HEL_CHECK(error);
+	}
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, lane));
+}
+
+DEFINE_TEST(sync_call_echo, ([] {
+	HelHandle client, server;
+	HEL_CHECK(helCreateStream(&client, &server));
+	std::thread thread{serveEcho, server};
+
+	char response[kHelMaxInlineCall];
+	size_t length;
+	HEL_CHECK(helCall(client, "hello", 5, response, sizeof(response), &length));
+	assert(length == 5);
+	assert(!memcmp(response, "hello", 5));
+
+	// Responses that do not fit into the buffer are reported as errors.
+	auto error = helCall(client, "hello", 5, response, 2, &length);
+	assert(error == kHelErrBufferTooSmall);
+	assert(length == 5);
+
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, client));
+	thread.join();
+}))
+
+// Echo server that only accepts requests of up to 8 bytes.
+static void serveSmallEcho(HelHandle lane) {
+	char buffer[8];
+	size_t length = 0;
+	while(true) {
+		auto error = helReplyAndWait(lane, buffer, length, buffer, sizeof(buffer), &length);
+		if(error == kHelErrEndOfLane)
+			break;
+		if(error == kHelErrBufferTooSmall) {
+			// The call was failed by the kernel; there is nothing to reply to.
+			length = 0;
+			continue;
+		}
+		HEL_CHECK(error);
+	}
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, lane));
+}
+
+DEFINE_TEST(sync_call_request_too_large, ([] {
+	HelHandle client, server;
+	HEL_CHECK(helCreateStream(&client, &server));
+	std::thread thread{serveSmallEcho, server};
+
+	// The server cannot receive the request; the call fails instead of staying pending.
+	char response[kHelMaxInlineCall];
+	size_t length;
+	auto error = helCall(client, "0123456789abcdef", 16, response, sizeof(response), &length);
+	assert(error == kHelErrBufferTooSmall);
+
+	// The next reply must belong to the next call.
+	HEL_CHECK(helCall(client, "hello", 5, response, sizeof(response), &length));
+	assert(length == 5);
+	assert(!memcmp(response, "hello", 5));
+
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, client));
+	thread.join();
+}))
+
+// Measures the latency of small request/response pairs.
+DEFINE_TEST(sync_call_latency, ([] {
+	HelHandle client, server;
+	HEL_CHECK(helCreateStream(&client, &server));
+	std::thread thread{serveEcho, server};
+
+	uint64_t request = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < numRoundTrips; i++) {
+		uint64_t response;
+		size_t length;
+		HEL_CHECK(helCall(client, &request, sizeof(request),
+				&response, sizeof(response), &length));
+		assert(length == sizeof(response) && response == request);
+		request++;
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(
+			std::chrono::steady_clock::now() - start);
+	std::cout << "kernel-tests: helCall() round trip took "
+			<< static_cast<uint64_t>(elapsed.count() / numRoundTrips) << " ns" << std::endl;
+
+	HEL_CHECK(helCloseDescriptor(kHelThisUniverse, client));
+	thread.join();
+}))
+
+// Submits conversations of different shapes on multiple lanes with a single
+// helSubmitAsyncBatch() call and checks that each of them completes correctly.
+DEFINE_TEST(submit_async_batch, ([] {
+	auto [sendLane, sendPeer] = helix::createStream();
+	auto [offerLane, offerPeer] = helix::createStream();
+	auto [closedLane, closedPeer] = helix::createStream();
+	closedPeer = helix::UniqueLane{};
+
+	async::run([] (helix::BorrowedLane sendLane, helix::BorrowedLane sendPeer,
+			helix::BorrowedLane offerLane, helix::BorrowedLane offerPeer,
+			helix::BorrowedLane closedLane) -> async::result<void> {
+		helix_ng::SubmitBatch batch;
+		auto send = helix_ng::exchangeMsgs(batch, sendLane,
+				helix_ng::sendBuffer("first", 5));
+		// The receiving side of the first conversation is part of the same batch.
+		auto recv = helix_ng::exchangeMsgs(batch, sendPeer,
+				helix_ng::recvInline());
+		auto offer = helix_ng::exchangeMsgs(batch, offerLane,
+				helix_ng::offer(
+					helix_ng::sendBuffer("second", 6),
+					helix_ng::recvInline())
+				);
+		auto closed = helix_ng::exchangeMsgs(batch, closedLane,
+				helix_ng::sendBuffer("third", 5));
+		batch.submit();
+
+		auto [sendResult] = co_await send;
+		HEL_CHECK(sendResult.error());
+
+		auto [recvResult] = co_await recv;
+		HEL_CHECK(recvResult.error());
+		assert(recvResult.length() == 5);
+		assert(!memcmp(recvResult.data(), "first", 5));
+
+		auto [accept, recvRequest] = co_await helix_ng::exchangeMsgs(offerPeer,
+				helix_ng::accept(
+					helix_ng::recvInline())
+				);
+		HEL_CHECK(accept.error());
+		HEL_CHECK(recvRequest.error());
+		assert(recvRequest.length() == 6);
+		assert(!memcmp(recvRequest.data(), "second", 6));
+
+		auto conversation = accept.descriptor();
+		auto [sendResponse] = co_await helix_ng::exchangeMsgs(conversation,
+				helix_ng::sendBuffer("reply", 5));
+		HEL_CHECK(sendResponse.error());
+
+		auto [offerResult, recvResponse] = co_await offer;
+		HEL_CHECK(offerResult.error());
+		HEL_CHECK(recvResponse.error());
+		assert(recvResponse.length() == 5);
+		assert(!memcmp(recvResponse.data(), "reply", 5));
+
+		// Errors are reported per conversation.
+		auto [closedResult] = co_await closed;
+		assert(closedResult.error() == kHelErrEndOfLane);
+	}(sendLane, sendPeer, offerLane, offerPeer, closedLane), helix::currentDispatcher);
+}))
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "testsuite.hpp"
+
+namespace {
+	// Number of loop iterations that each worker performs.
+	constexpr uint64_t workPerThread = uint64_t{1} << 28;
+
+	uint64_t spin(uint64_t n) {
+		// Make sure that the compiler cannot remove the loop.
+		volatile uint64_t x = 0;
+		for(uint64_t i = 0; i < n; i++)
+			x = x + i;
+		return x;
+	}
+}
+
+// Runs an increasing number of CPU-bound threads and checks the total throughput.
+// With working load balancing, the throughput should scale with the number of CPUs
+// (even if the kernel initially places the threads on the same CPU) and threads
+// that perform the same amount of work should finish at roughly the same time.
+DEFINE_TEST(scheduler_scaling, ([] {
+	unsigned int numCpus = std::thread::hardware_concurrency();
+	if(!numCpus)
+		numCpus = 1;
+
+	double baseline = 0;
+	for(unsigned int n = 1; n <= 2 * numCpus; n *= 2) {
+		std::atomic<uint64_t> sink{0};
+		std::vector<double> finishTimes(n);
+		std::vector<std::thread> workers;
+
+		auto start = std::chrono::steady_clock::now();
+		for(unsigned int i = 0; i < n; i++)
+			workers.emplace_back([&, i] {
+				sink.fetch_add(spin(workPerThread), std::memory_order_relaxed);
+				finishTimes[i] = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - start).count();
+			});
+		for(auto &worker : workers)
+			worker.join();
+		auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+		assert(sink.load());
+
+		auto throughput = (n * workPerThread) / elapsed.count();
+		if(n == 1)
+			baseline = throughput;
+		auto speedup = throughput / baseline;
+		auto [fastest, slowest] = std::minmax_element(finishTimes.begin(), finishTimes.end());
+		std::cout << "kernel-tests: " << n << " thread(s): "
+				<< static_cast<uint64_t>(throughput / 1'000'000) << " Mops/s, speedup "
+				<< speedup << "x, slowest/fastest thread " << *slowest / *fastest
+				<< "x (" << numCpus << " CPUs)" << std::endl;
+
+		// The bounds are generous since other processes may compete for the CPUs.
+		// While there are no more threads than CPUs, at least half of the ideal
+		// speedup must be reached; this fails if all threads stay on one CPU.
+		if(n <= numCpus)
+			assert(speedup >= n / 2.0);
+		// Fairness: no thread may take more than twice as long as the fastest one.
+		assert(*slowest <= 2 * *fastest);
+	}
+}))
@@ -24,6 +24,12 @@ DEFINE_TEST(dup_badfd, ([] {
 	assert(errno == EBADF);
 }))
 
+DEFINE_TEST(dup2_bad_newfd, ([] {
+	int fd = dup2(STDIN_FILENO, BOGUS_FD);
+	assert(fd == -1);
+	assert(errno == EBADF);
+}))
+
 DEFINE_TEST(io_badfd, ([] {
 	char buf[16];
 
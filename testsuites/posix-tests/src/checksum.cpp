@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <checksum.hpp>
+
+#include "testsuite.hpp"
+
+namespace {
+	// Straightforward implementation of the RFC 1071 checksum that Checksum is compared to.
+	uint16_t referenceChecksum(const unsigned char *data, size_t size) {
+		uint32_t state = 0;
+		for (size_t i = 0; i + 1 < size; i += 2)
+			state += data[i] << 8 | data[i + 1];
+		if (size % 2)
+			state += data[size - 1] << 8;
+		while (state >> 16)
+			state = (state >> 16) + (state & 0xffff);
+		return ~state;
+	}
+
+	// Unlike assert(), this also checks in builds with NDEBUG.
+	void expect(bool condition, const char *what, size_t offset, size_t size) {
+		if (condition)
+			return;
+		std::cerr << "posix-tests: " << what << " failed at offset " << offset
+				<< " with size " << size << std::endl;
+		abort();
+	}
+}
+
+// Covers all code paths of the vectorised implementation: unaligned heads,
+// odd sizes and sizes that are (not) multiples of the vector width.
+DEFINE_TEST(checksum_matches_reference, ([] {
+	constexpr size_t maxSize = 2048;
+	constexpr size_t maxOffset = 64;
+
+	std::vector<unsigned char> source(maxSize + maxOffset);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = i * 131 + (i >> 8);
+	std::vector<unsigned char> dest(maxSize + maxOffset);
+
+	for (size_t offset = 0; offset < maxOffset; offset += 3) {
+		for (size_t size = 0; size <= maxSize; size += (size < 130) ? 1 : 61) {
+			auto data = source.data() + offset;
+			auto expected = referenceChecksum(data, size);
+
+			Checksum chk;
+			chk.update(data, size);
+			expect(chk.finalize() == expected, "update()", offset, size);
+
+			// Use a different alignment for the destination.
+			auto out = dest.data() + (maxOffset - 1 - offset);
+			memset(dest.data(), 0, dest.size());
+			Checksum copyChk;
+			copyChk.updateCopy(out, data, size);
+			expect(copyChk.finalize() == expected, "updateCopy()", offset, size);
+			expect(!memcmp(out, data, size), "updateCopy() copy", offset, size);
+		}
+	}
+}))
+
+// Splitting the data into multiple updates must not change the result
+// as long as all but the last part have an even size.
+DEFINE_TEST(checksum_split_updates, ([] {
+	std::vector<unsigned char> source(1500);
+	for (size_t i = 0; i < source.size(); i++)
+		source[i] = i * 7 + 3;
+	auto expected = referenceChecksum(source.data(), source.size());
+
+	for (size_t split = 0; split <= source.size(); split += 2) {
+		Checksum chk;
+		chk.update(source.data(), split);
+		chk.update(source.data() + split, source.size() - split);
+		expect(chk.finalize() == expected, "update() with split", split, source.size());
+	}
+}))
@@ -0,0 +1,91 @@
+#include <cassert>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	struct EpollPipe {
+		EpollPipe(uint32_t flags) {
+			int e = pipe(fds);
+			assert(!e);
+			epfd = epoll_create1(0);
+			assert(epfd >= 0);
+
+			epoll_event ev{};
+			ev.events = EPOLLIN | flags;
+			ev.data.u64 = 42;
+			e = epoll_ctl(epfd, EPOLL_CTL_ADD, fds[0], &ev);
+			assert(!e);
+		}
+
+		~EpollPipe() {
+			close(epfd);
+			close(fds[0]);
+			close(fds[1]);
+		}
+
+		void put() {
+			auto written = write(fds[1], "x", 1);
+			assert(written == 1);
+		}
+
+		int wait() {
+			epoll_event ev;
+			int n = epoll_wait(epfd, &ev, 1, 0);
+			assert(n >= 0);
+			if(n) {
+				assert(ev.events & EPOLLIN);
+				assert(ev.data.u64 == 42);
+			}
+			return n;
+		}
+
+		int fds[2];
+		int epfd;
+	};
+}
+
+DEFINE_TEST(epoll_level_triggered, ([] {
+	EpollPipe p{0};
+	assert(!p.wait());
+
+	p.put();
+	assert(p.wait() == 1);
+	assert(p.wait() == 1); // The data is still available.
+
+	char buffer[1];
+	auto chunk = read(p.fds[0], buffer, 1);
+	assert(chunk == 1);
+	assert(!p.wait());
+}))
+
+DEFINE_TEST(epoll_edge_triggered, ([] {
+	EpollPipe p{EPOLLET};
+	assert(!p.wait());
+
+	p.put();
+	assert(p.wait() == 1);
+	assert(!p.wait()); // No new edge, even though data is still available.
+
+	p.put();
+	assert(p.wait() == 1);
+}))
+
+DEFINE_TEST(epoll_oneshot, ([] {
+	EpollPipe p{EPOLLONESHOT};
+
+	p.put();
+	assert(p.wait() == 1);
+	assert(!p.wait());
+
+	p.put();
+	assert(!p.wait()); // The item stays disarmed.
+
+	epoll_event ev{};
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.u64 = 42;
+	int e = epoll_ctl(p.epfd, EPOLL_CTL_MOD, p.fds[0], &ev);
+	assert(!e);
+	assert(p.wait() == 1);
+}))
@@ -0,0 +1,46 @@
+#include <cassert>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+#if defined(__managarm__)
+#include <hel.h>
+#include <hel-syscalls.h>
+
+namespace {
+	// Layout of the data that is returned by posix' GET_PROCESS_DATA supercall.
+	struct ManagarmProcessData {
+		HelHandle posixLane;
+		void *threadPage;
+		HelHandle *fileTable;
+		void *clockTrackerPage;
+	};
+}
+
+DEFINE_TEST(fork_thread_page_private, ([] {
+	ManagarmProcessData data;
+	HEL_CHECK(helSyscall1(kHelCallSuper + 1, reinterpret_cast<HelWord>(&data)));
+
+	// Use the end of the page, which does not hold any state.
+	auto marker = reinterpret_cast<volatile unsigned long *>(
+			reinterpret_cast<char *>(data.threadPage) + 0x1000 - sizeof(unsigned long));
+	*marker = 0;
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+	if(!pid) {
+		// This either faults or hits the child's own thread page.
+		*marker = 0xDEADBEEF;
+		_exit(0);
+	}
+
+	int status;
+	pid_t waited = waitpid(pid, &status, 0);
+	assert(waited == pid);
+	assert((WIFEXITED(status) && !WEXITSTATUS(status))
+			|| (WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV));
+	assert(!*marker);
+}))
+#endif
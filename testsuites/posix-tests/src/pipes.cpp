@@ -1,6 +1,12 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <errno.h>
+#include <fcntl.h>
+#include <iostream>
+#include <thread>
+#include <vector>
 #include <unistd.h>
 #include <poll.h>
 
@@ -37,3 +43,131 @@ DEFINE_TEST(pipe_close_reader, ([] {
 	assert(pfd.revents & POLLERR);
 	assert(!(pfd.revents & POLLHUP));
 }))
+
+DEFINE_TEST(pipe_partial_read, ([] {
+	int fds[2];
+	int e = pipe(fds);
+	assert(!e);
+
+	auto written = write(fds[1], "abcdef", 6);
+	assert(written == 6);
+
+	char buffer[4];
+	auto chunk = read(fds[0], buffer, 4);
+	assert(chunk == 4);
+	assert(!memcmp(buffer, "abcd", 4));
+	chunk = read(fds[0], buffer, 4);
+	assert(chunk == 2);
+	assert(!memcmp(buffer, "ef", 2));
+
+	close(fds[0]);
+	close(fds[1]);
+}))
+
+// Writes more data than the pipe can buffer; the writer has to wait for the reader.
+DEFINE_TEST(pipe_large_write, ([] {
+	int fds[2];
+	int e = pipe(fds);
+	assert(!e);
+
+	constexpr size_t size = 1024 * 1024;
+	std::vector<char> in(size);
+	for (size_t i = 0; i < size; i++)
+		in[i] = i * 7;
+
+	std::thread writer{[&] {
+		auto written = write(fds[1], in.data(), size);
+		assert(written == static_cast<ssize_t>(size));
+		close(fds[1]);
+	}};
+
+	std::vector<char> out(size);
+	size_t progress = 0;
+	while (true) {
+		auto chunk = read(fds[0], out.data() + progress, size - progress);
+		assert(chunk >= 0);
+		if (!chunk)
+			break;
+		progress += chunk;
+	}
+	writer.join();
+	assert(progress == size);
+	assert(in == out);
+	close(fds[0]);
+}))
+
+// Non-blocking writes that do not fit into the pipe are cut short instead of waiting.
+DEFINE_TEST(pipe_nonblock_large_write, ([] {
+	int fds[2];
+	int e = pipe2(fds, O_NONBLOCK);
+	assert(!e);
+
+	constexpr size_t size = 256 * 1024;
+	std::vector<char> in(size);
+	for (size_t i = 0; i < size; i++)
+		in[i] = i * 7;
+
+	auto written = write(fds[1], in.data(), size);
+	assert(written > 0);
+	assert(written < static_cast<ssize_t>(size));
+
+	// The pipe is full now.
+	auto again = write(fds[1], in.data(), 1);
+	assert(again == -1);
+	assert(errno == EAGAIN);
+
+	std::vector<char> out(size);
+	size_t progress = 0;
+	while (true) {
+		auto chunk = read(fds[0], out.data() + progress, size - progress);
+		if (chunk < 0) {
+			assert(errno == EAGAIN);
+			break;
+		}
+		assert(chunk > 0);
+		progress += chunk;
+	}
+	assert(progress == static_cast<size_t>(written));
+	assert(!memcmp(in.data(), out.data(), progress));
+
+	close(fds[0]);
+	close(fds[1]);
+}))
+
+// Not a correctness test: reports the throughput of a pipe.
+DEFINE_TEST(pipe_throughput, ([] {
+	int fds[2];
+	int e = pipe(fds);
+	assert(!e);
+
+	constexpr size_t chunkSize = 64 * 1024;
+	constexpr size_t totalSize = 64 * 1024 * 1024;
+
+	auto start = std::chrono::steady_clock::now();
+	std::thread writer{[&] {
+		std::vector<char> buffer(chunkSize);
+		for (size_t progress = 0; progress < totalSize; progress += chunkSize) {
+			auto written = write(fds[1], buffer.data(), chunkSize);
+			assert(written == static_cast<ssize_t>(chunkSize));
+		}
+		close(fds[1]);
+	}};
+
+	std::vector<char> buffer(chunkSize);
+	size_t progress = 0;
+	while (true) {
+		auto chunk = read(fds[0], buffer.data(), chunkSize);
+		assert(chunk >= 0);
+		if (!chunk)
+			break;
+		progress += chunk;
+	}
+	writer.join();
+	assert(progress == totalSize);
+	close(fds[0]);
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start);
+	std::cout << "posix-tests: pipe_throughput: "
+			<< (totalSize / std::max<int64_t>(elapsed.count(), 1)) << " MB/s" << std::endl;
+}))
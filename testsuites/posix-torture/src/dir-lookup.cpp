@@ -0,0 +1,98 @@
+#include <cassert>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr const char *directory = "posix-torture-dir";
+	constexpr int numFiles = 100000;
+
+	std::string fileName(int n) {
+		return std::string{directory} + "/f" + std::to_string(n);
+	}
+
+	void createFile(int n) {
+		auto path = fileName(n);
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+		assert(fd >= 0);
+		close(fd);
+	}
+
+	// Removes the directory and all files in it, e.g., those left behind by
+	// an earlier run that was interrupted.
+	void removeDirectory() {
+		DIR *dir = opendir(directory);
+		if(!dir) {
+			assert(errno == ENOENT);
+			return;
+		}
+
+		while(auto entry = readdir(dir)) {
+			if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+				continue;
+			auto path = std::string{directory} + "/" + entry->d_name;
+			if(unlink(path.c_str()))
+				assert(!"unlink() failed");
+		}
+		closedir(dir);
+
+		if(rmdir(directory))
+			assert(!"rmdir() failed");
+	}
+
+	// Starts out with an empty directory and removes it again after the run.
+	struct DirectoryFixture {
+		DirectoryFixture() {
+			removeDirectory();
+			if(mkdir(directory, 0755))
+				assert(!"mkdir() failed");
+		}
+
+		~DirectoryFixture() {
+			removeDirectory();
+		}
+
+		// Number of files that were created in the directory so far.
+		int numCreated = 0;
+	};
+
+	struct FullDirectoryFixture : DirectoryFixture {
+		FullDirectoryFixture() {
+			for(; numCreated < numFiles; numCreated++)
+				createFile(numCreated);
+		}
+
+		uint32_t seed = 1;
+	};
+}
+
+// Fills a directory with up to 100k files. Once it is full, files are unlinked
+// and re-created. The result is the time per created file.
+DEFINE_FIXTURE_TEST(dir_create_100k, DirectoryFixture, ([] (DirectoryFixture &f) {
+	if(f.numCreated >= numFiles) {
+		auto path = fileName(f.numCreated % numFiles);
+		if(unlink(path.c_str()))
+			assert(!"unlink() failed");
+	}
+
+	createFile(f.numCreated % numFiles);
+	f.numCreated++;
+}))
+
+// Looks up random files in a directory of 100k files.
+DEFINE_FIXTURE_TEST(dir_lookup_100k, FullDirectoryFixture, ([] (FullDirectoryFixture &f) {
+	f.seed = f.seed * 1103515245 + 12345;
+	auto path = fileName((f.seed >> 8) % numFiles);
+
+	struct stat st;
+	if(stat(path.c_str(), &st))
+		assert(!"stat() failed");
+	assert(S_ISREG(st.st_mode));
+}))
@@ -0,0 +1,89 @@
+#include <cassert>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr int numFds = 10000;
+
+	// Registers numFds eventfds with an epoll instance. Only one of them
+	// becomes ready per iteration, i.e., almost all registered FDs are idle.
+	// The FDs are closed again after each run to stay within the FD limit.
+	struct EpollFixture {
+		EpollFixture(uint32_t flags) {
+			epfd = epoll_create1(0);
+			assert(epfd >= 0);
+			for(int i = 0; i < numFds; i++) {
+				int fd = eventfd(0, EFD_NONBLOCK);
+				assert(fd >= 0);
+				fds.push_back(fd);
+
+				epoll_event ev{};
+				ev.events = EPOLLIN | flags;
+				ev.data.u32 = i;
+				if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev))
+					assert(!"epoll_ctl() failed");
+			}
+
+			// Let epoll observe that all FDs are idle.
+			epoll_event ev;
+			auto n = epoll_wait(epfd, &ev, 1, 0);
+			assert(!n);
+		}
+
+		EpollFixture(const EpollFixture &) = delete;
+
+		~EpollFixture() {
+			close(epfd);
+			for(int fd : fds)
+				close(fd);
+		}
+
+		EpollFixture &operator= (const EpollFixture &) = delete;
+
+		void signalAndWait() {
+			uint64_t value = 1;
+			auto written = write(fds[next], &value, sizeof(uint64_t));
+			assert(written == sizeof(uint64_t));
+
+			epoll_event ev;
+			auto n = epoll_wait(epfd, &ev, 1, -1);
+			assert(n == 1);
+			assert(ev.data.u32 == static_cast<uint32_t>(next));
+
+			auto read_bytes = read(fds[next], &value, sizeof(uint64_t));
+			assert(read_bytes == sizeof(uint64_t));
+			next = (next + 1) % numFds;
+		}
+
+		int epfd;
+		std::vector<int> fds;
+		int next = 0;
+	};
+
+	struct LevelTriggeredFixture : EpollFixture {
+		LevelTriggeredFixture()
+		: EpollFixture{0} { }
+	};
+
+	struct EdgeTriggeredFixture : EpollFixture {
+		EdgeTriggeredFixture()
+		: EpollFixture{EPOLLET} { }
+	};
+}
+
+// Signals one of 10k registered FDs and waits for it. The result is the time per
+// epoll_wait() round trip; it should not depend on the number of registered FDs.
+DEFINE_FIXTURE_TEST(epoll_wait_10k_fds, LevelTriggeredFixture,
+		([] (LevelTriggeredFixture &f) {
+	f.signalAndWait();
+}))
+
+DEFINE_FIXTURE_TEST(epoll_wait_10k_fds_edge_triggered, EdgeTriggeredFixture,
+		([] (EdgeTriggeredFixture &f) {
+	f.signalAndWait();
+}))
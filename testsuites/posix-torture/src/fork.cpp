@@ -0,0 +1,33 @@
+#include <cassert>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+// Measures the cost of cloning the address space; the child exits immediately.
+DEFINE_TEST(fork_exit, ([] {
+	auto pid = fork();
+	assert(pid >= 0);
+	if(!pid)
+		_exit(0);
+
+	int status;
+	if(waitpid(pid, &status, 0) != pid)
+		assert(!"waitpid() failed");
+	assert(WIFEXITED(status) && !WEXITSTATUS(status));
+}))
+
+// Measures the latency of spawning a process, as done by shells.
+DEFINE_TEST(fork_exec, ([] {
+	auto pid = fork();
+	assert(pid >= 0);
+	if(!pid) {
+		execl("/bin/true", "true", nullptr);
+		_exit(127);
+	}
+
+	int status;
+	if(waitpid(pid, &status, 0) != pid)
+		assert(!"waitpid() failed");
+	assert(WIFEXITED(status) && !WEXITSTATUS(status));
+}))
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <iostream>
 #include <vector>
 
@@ -18,8 +19,15 @@ int main() {
 		for(abstract_test_case *tcp : test_case_ptrs()) {
 			std::cout << "posix-torture: Running " << tcp->name()
 					<< " for " << n << " iterations" << std::endl;
+			tcp->setUp();
+			auto start = std::chrono::steady_clock::now();
 			for(int i = 0; i < n; i++)
 				tcp->run();
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - start);
+			tcp->tearDown();
+			std::cout << "posix-torture: " << tcp->name() << " took "
+					<< elapsed.count() / n << " us per iteration" << std::endl;
 		}
 	}
 }
@@ -0,0 +1,35 @@
+#include <cassert>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr int numThreads = 4;
+	constexpr size_t pagesPerThread = 64;
+}
+
+// Each thread faults in its own anonymous mapping.
+// This stresses the physical page allocator from multiple CPUs at the same time.
+DEFINE_TEST(parallel_anonymous_faults, ([] {
+	long pageSize = sysconf(_SC_PAGESIZE);
+	assert(pageSize > 0);
+	size_t size = pagesPerThread * pageSize;
+
+	std::vector<std::thread> threads;
+	for(int i = 0; i < numThreads; i++)
+		threads.emplace_back([=] {
+			auto window = static_cast<char *>(mmap(nullptr, size, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			assert(window != MAP_FAILED);
+			for(size_t off = 0; off < size; off += pageSize) {
+				assert(!window[off]);
+				window[off] = 1;
+			}
+			munmap(window, size);
+		});
+	for(auto &thread : threads)
+		thread.join();
+}))
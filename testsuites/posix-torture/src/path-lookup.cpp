@@ -0,0 +1,45 @@
+#include <cassert>
+#include <cerrno>
+#include <string>
+#include <sys/stat.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr const char *deepPath = "posix-torture-dcache/a/b/c/d/e/f/g/h";
+
+	void setupTree() {
+		static bool done = false;
+		if(done)
+			return;
+
+		std::string prefix;
+		for(const char *p = deepPath; ; p++) {
+			if(*p == '/' || !*p) {
+				if(mkdir(prefix.c_str(), 0755))
+					assert(errno == EEXIST);
+			}
+			if(!*p)
+				break;
+			prefix += *p;
+		}
+		done = true;
+	}
+}
+
+DEFINE_TEST(path_lookup_deep, ([] {
+	setupTree();
+
+	struct stat st;
+	if(stat(deepPath, &st))
+		assert(!"stat() failed");
+	assert(S_ISDIR(st.st_mode));
+}))
+
+DEFINE_TEST(path_lookup_negative, ([] {
+	setupTree();
+
+	struct stat st;
+	auto e = stat("posix-torture-dcache/a/b/c/d/e/f/g/h/nonexistent", &st);
+	assert(e == -1 && errno == ENOENT);
+}))
@@ -0,0 +1,69 @@
+#include <cassert>
+#include <fcntl.h>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr size_t blockSize = 4096;
+	constexpr int maxThreads = 4;
+	constexpr int readsPerIteration = 64;
+
+	// Reads go to the raw partition. Unlike regular files, it is not backed
+	// by the page cache, hence every read reaches the disk.
+	struct DeviceFixture {
+		DeviceFixture() {
+			for(int i = 0; i < maxThreads; i++) {
+				fds[i] = open("/dev/sda0", O_RDONLY);
+				assert(fds[i] >= 0);
+			}
+
+			auto size = lseek(fds[0], 0, SEEK_END);
+			assert(size >= static_cast<off_t>(blockSize));
+			numBlocks = size / blockSize;
+		}
+
+		~DeviceFixture() {
+			for(int i = 0; i < maxThreads; i++)
+				close(fds[i]);
+		}
+
+		// Each thread uses its own file descriptor, so that the threads do not
+		// contend for the file offset.
+		int fds[maxThreads];
+		size_t numBlocks;
+	};
+
+	// Performs a fixed number of 4 KiB reads at random offsets,
+	// spread over the given number of threads (similar to fio's randread job).
+	void randomRead(DeviceFixture &f, int numThreads) {
+		assert(numThreads <= maxThreads);
+
+		std::vector<std::thread> threads;
+		for(int i = 0; i < numThreads; i++)
+			threads.emplace_back([&f, i, numThreads] {
+				thread_local std::minstd_rand prng{std::random_device{}()};
+				std::uniform_int_distribution<size_t> dist{0, f.numBlocks - 1};
+				char buffer[blockSize];
+				for(int k = 0; k < readsPerIteration / numThreads; k++) {
+					auto result = pread(f.fds[i], buffer, blockSize, dist(prng) * blockSize);
+					assert(result == static_cast<ssize_t>(blockSize));
+				}
+			});
+		for(auto &thread : threads)
+			thread.join();
+	}
+}
+
+// Both tests perform the same amount of I/O per iteration. Comparing their times
+// shows how well the block layer scales with the number of concurrent requests.
+DEFINE_FIXTURE_TEST(random_read_1_thread, DeviceFixture, ([] (DeviceFixture &f) {
+	randomRead(f, 1);
+}))
+
+DEFINE_FIXTURE_TEST(random_read_4_threads, DeviceFixture, ([] (DeviceFixture &f) {
+	randomRead(f, 4);
+}))
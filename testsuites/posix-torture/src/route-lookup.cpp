@@ -0,0 +1,57 @@
+#include <cassert>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <router.hpp>
+
+#include "testsuite.hpp"
+
+// posix-torture does not link the NIC layer of netserver.
+// The router only checks whether the links of its routes are still alive.
+namespace nic {
+	struct Link { };
+}
+
+namespace {
+	constexpr int numRoutes = 4096;
+	constexpr int lookupsPerIteration = 1024;
+	constexpr int numHotDestinations = 64;
+
+	struct RouterFixture {
+		RouterFixture() {
+			router.addRoute({{0, 0}, link});
+			while (router.numRoutes() < numRoutes) {
+				CidrAddress network{static_cast<uint32_t>(prng()),
+					static_cast<uint8_t>(8 + prng() % 25)};
+				router.addRoute({network, link});
+			}
+
+			for (int i = 0; i < numHotDestinations; i++)
+				hotDestinations.push_back(prng());
+		}
+
+		std::mt19937 prng{42};
+		std::shared_ptr<nic::Link> link = std::make_shared<nic::Link>();
+		Ip4Router router;
+		std::vector<uint32_t> hotDestinations;
+	};
+}
+
+// Both tests perform 1024 lookups per iteration in a table of 4096 routes.
+// Random destinations are drawn anew for each lookup; hence they (almost) always
+// miss the route cache and walk the trie. With a small set of hot destinations,
+// lookups are served from the cache.
+DEFINE_FIXTURE_TEST(route_lookup_random, RouterFixture, ([] (RouterFixture &f) {
+	for (int i = 0; i < lookupsPerIteration; i++) {
+		auto route = f.router.resolveRoute(f.prng());
+		assert(route);
+	}
+}))
+
+DEFINE_FIXTURE_TEST(route_lookup_cached, RouterFixture, ([] (RouterFixture &f) {
+	for (int i = 0; i < lookupsPerIteration; i++) {
+		auto route = f.router.resolveRoute(f.hotDestinations[i % numHotDestinations]);
+		assert(route);
+	}
+}))
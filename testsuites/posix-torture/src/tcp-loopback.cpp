@@ -0,0 +1,60 @@
+#include <arpa/inet.h>
+#include <cassert>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	// Small enough that the largest runs of the harness finish in reasonable time.
+	constexpr size_t transferSize = 4 * 1024;
+	constexpr uint16_t port = 8717;
+	constexpr const char *hostAddress = "127.0.0.1";
+}
+
+// Pushes data through a TCP connection over the loopback address. The result is
+// the time per 4 KiB transfer, i.e., it measures the throughput of the TCP stack.
+DEFINE_TEST(tcp_loopback, ([] {
+	static int client = -1;
+	static int server = -1;
+	static char buffer[transferSize];
+
+	if(client == -1) {
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(port);
+		if(inet_pton(AF_INET, hostAddress, &addr.sin_addr) != 1)
+			assert(!"inet_pton() failed");
+
+		int listener = socket(AF_INET, SOCK_STREAM, 0);
+		assert(listener >= 0);
+		if(bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)))
+			assert(!"bind() failed");
+		if(listen(listener, 1))
+			assert(!"listen() failed");
+
+		client = socket(AF_INET, SOCK_STREAM, 0);
+		assert(client >= 0);
+		if(connect(client, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)))
+			assert(!"connect() failed");
+
+		server = accept(listener, nullptr, nullptr);
+		assert(server >= 0);
+		close(listener);
+	}
+
+	size_t written = 0;
+	while(written < transferSize) {
+		auto n = write(client, buffer + written, transferSize - written);
+		assert(n > 0);
+		written += n;
+	}
+
+	size_t received = 0;
+	while(received < transferSize) {
+		auto n = read(server, buffer + received, transferSize - received);
+		assert(n > 0);
+		received += n;
+	}
+}))
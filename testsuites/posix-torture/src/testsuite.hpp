@@ -1,10 +1,17 @@
 #pragma once
 
+#include <optional>
 #include <utility>
 
 #define DEFINE_TEST(s, f) \
 	static test_case test_ ## s{#s, f};
 
+// Like DEFINE_TEST, but f takes a reference to a fixture of type T.
+// The fixture is constructed before and destroyed after each batch of iterations;
+// this is not included in the measured time.
+#define DEFINE_FIXTURE_TEST(s, T, f) \
+	static auto test_ ## s = make_fixture_test_case<T>(#s, f);
+
 struct abstract_test_case {
 private:
 	static void register_case(abstract_test_case *tcp);
@@ -25,8 +32,12 @@ public:
 		return name_;
 	}
 
+	virtual void setUp() { }
+
 	virtual void run() = 0;
 
+	virtual void tearDown() { }
+
 private:
 	const char *name_;
 };
@@ -43,3 +54,30 @@ struct test_case : abstract_test_case {
 private:
 	F functor_;
 };
+
+template<typename T, typename F>
+struct fixture_test_case : abstract_test_case {
+	fixture_test_case(const char *name, F functor)
+	: abstract_test_case{name}, functor_{std::move(functor)} { }
+
+	void setUp() override {
+		fixture_.emplace();
+	}
+
+	void run() override {
+		functor_(*fixture_);
+	}
+
+	void tearDown() override {
+		fixture_.reset();
+	}
+
+private:
+	F functor_;
+	std::optional<T> fixture_;
+};
+
+template<typename T, typename F>
+fixture_test_case<T, F> make_fixture_test_case(const char *name, F functor) {
+	return {name, std::move(functor)};
+}
@@ -0,0 +1,34 @@
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "testsuite.hpp"
+
+namespace {
+	constexpr size_t chunkSize = 4096;
+	// Stay within the direct and single-indirect blocks of the file.
+	constexpr size_t fileLimit = 256 * 1024;
+}
+
+// Appends to a file and truncates it once it is full. This exercises block allocation
+// and the release of blocks on truncation; the result is the time per 4 KiB chunk.
+DEFINE_TEST(write_sequential, ([] {
+	static int fd = -1;
+	static off_t offset = 0;
+	static char buffer[chunkSize];
+
+	if(fd == -1) {
+		fd = open("posix-torture-write", O_RDWR | O_CREAT | O_TRUNC, 0644);
+		assert(fd >= 0);
+	}
+
+	if(offset == fileLimit) {
+		if(ftruncate(fd, 0))
+			assert(!"ftruncate() failed");
+		offset = 0;
+	}
+
+	auto written = pwrite(fd, buffer, chunkSize, offset);
+	assert(written == static_cast<ssize_t>(chunkSize));
+	offset += chunkSize;
+}))